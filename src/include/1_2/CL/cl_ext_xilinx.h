@@ -431,6 +431,74 @@ xclGetComputeUnitInfo(cl_kernel             kernel,
 #define XCL_COMPUTE_UNIT_INDEX       0x1321 // scheduler index of CU
 #define XCL_COMPUTE_UNIT_CONNECTIONS 0x1322 // connectivity
 
+/**
+ * Argument value of one launch in xclEnqueueKernelBatch
+ *
+ * @arg_index: index of kernel argument to set
+ * @arg_size:  size of argument value, per clSetKernelArg
+ * @arg_value: pointer to argument value, per clSetKernelArg
+ */
+typedef struct {
+  cl_uint     arg_index;
+  size_t      arg_size;
+  const void* arg_value;
+} xcl_kernel_arg;
+
+/**
+ * One launch in xclEnqueueKernelBatch
+ *
+ * @num_args: number of argument values in @args
+ * @args:     argument values set before the launch
+ */
+typedef struct {
+  cl_uint               num_args;
+  const xcl_kernel_arg* args;
+} xcl_kernel_launch;
+
+/**
+ * Enqueue a batch of task launches of a kernel as one command
+ *
+ * Each launch sets the argument values listed for it, per
+ * clSetKernelArg, and is then enqueued as by clEnqueueTask.  All
+ * launches are represented by one event and are submitted to the
+ * device back to back.  Launches within a batch are not ordered with
+ * respect to each other: they run concurrently on the compute units
+ * of the kernel, even in an in-order command queue.  Argument values
+ * carry over from one launch to the next, after the call the kernel
+ * arguments are those of the last launch.
+ *
+ * The argument values of all launches are validated before any is
+ * set, an invalid value leaves the kernel arguments unchanged.  If
+ * the call fails after that, e.g. on connectivity of a buffer
+ * argument or on device allocation, the kernel arguments are
+ * unspecified and must be set again before the kernel is launched.
+ *
+ * @command_queue
+ *   Command queue to enqueue the launches in
+ * @kernel
+ *   Kernel to launch, must not use printf
+ * @num_launches
+ *   Number of launches in @launches
+ * @launches
+ *   Argument values per launch
+ * @num_events_in_wait_list, @event_wait_list, @event
+ *   Per clEnqueueTask.  The event completes when all launches
+ *   have completed.
+ *
+ * CL_INVALID_VALUE     : if num_launches is 0 or launches is NULL
+ * CL_INVALID_VALUE     : if a launch has arguments but args is NULL
+ * CL_INVALID_KERNEL    : if kernel is not valid or uses printf
+ * Plus all errors of clSetKernelArg and clEnqueueTask.
+ */
+extern CL_API_ENTRY cl_int CL_API_CALL
+xclEnqueueKernelBatch(cl_command_queue         command_queue,
+                      cl_kernel                kernel,
+                      cl_uint                  num_launches,
+                      const xcl_kernel_launch* launches,
+                      cl_uint                  num_events_in_wait_list,
+                      const cl_event*          event_wait_list,
+                      cl_event*                event);
+
 /*
   Host Accessible Program Scope Globals
 */
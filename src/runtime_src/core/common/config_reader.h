@@ -149,6 +149,27 @@ get_timeline_trace()
   return value;
 }
 
+/**
+ * Format of the timeline trace file, one of csv, binary
+ */
+inline std::string
+get_timeline_trace_format()
+{
+  static std::string value = detail::get_string_value("Debug.timeline_trace_format","csv");
+  return value;
+}
+
+/**
+ * Capture host function calls into per-thread buffers that are
+ * processed by a background thread rather than on the API thread
+ */
+inline bool
+get_profile_buffered_capture()
+{
+  static bool value = get_profile() && detail::get_bool_value("Debug.profile_buffered_capture",false);
+  return value;
+}
+
 inline bool
 get_api_checks()
 {
@@ -177,6 +198,33 @@ get_dma_threads()
   return value;
 }
 
+/**
+ * Merge pending asynchronous syncs of the same buffer object and
+ * direction with overlapping or adjacent ranges into one transfer.
+ * Only hal2 async syncs are affected; OpenCL buffer transfers sync
+ * synchronously and are never coalesced.
+ */
+inline bool
+get_dma_coalesce()
+{
+  static bool value = detail::get_bool_value("Runtime.dma_coalesce",false);
+  return value;
+}
+
+/**
+ * In-order command queues order events by their memory object
+ * read/write sets rather than by submission order.  Blocking
+ * enqueues, clWaitForEvents and clFinish still wait for all events
+ * queued before them, so completion as observed by the host is in
+ * order.
+ */
+inline bool
+get_hazard_tracking()
+{
+  static bool value = detail::get_bool_value("Runtime.hazard_tracking",false);
+  return value;
+}
+
 inline unsigned int
 get_polling_throttle()
 {
@@ -184,6 +232,57 @@ get_polling_throttle()
   return value;
 }
 
+/**
+ * Software scheduler idle backoff.  Number of idle scheduler loop
+ * iterations spent spinning, then yielding, before the scheduler
+ * blocks until the next CU poll deadline.
+ */
+inline unsigned int
+get_sws_spin_count()
+{
+  static unsigned int value = detail::get_uint_value("Runtime.sws_spin_count",100);
+  return value;
+}
+
+inline unsigned int
+get_sws_yield_count()
+{
+  static unsigned int value = detail::get_uint_value("Runtime.sws_yield_count",100);
+  return value;
+}
+
+/**
+ * Max interval in microseconds between polls of a busy CU
+ */
+inline unsigned int
+get_sws_max_poll_interval()
+{
+  static unsigned int value = detail::get_uint_value("Runtime.sws_max_poll_interval",100);
+  return value;
+}
+
+/**
+ * CU selection policy for the software scheduler, one of
+ * first_fit, round_robin, least_loaded
+ */
+inline std::string
+get_sws_cu_policy()
+{
+  static std::string value = detail::get_string_value("Runtime.sws_cu_policy","first_fit");
+  return value;
+}
+
+/**
+ * Pin each per device software scheduler thread to one of the
+ * cpus specified in Runtime.cpu_affinity
+ */
+inline bool
+get_sws_pin_scheduler()
+{
+  static bool value = detail::get_bool_value("Runtime.sws_pin_scheduler",false);
+  return value;
+}
+
 inline std::string
 get_hal_logging()
 {
@@ -204,6 +303,18 @@ get_xclbin_programming()
   return get_xclbin_programing();
 }
 
+/**
+ * Directory for the on-disk cache of parsed xclbin meta data.
+ * Cache files are keyed by xclbin uuid.  Caching is disabled
+ * unless a directory is specified.
+ */
+inline std::string
+get_xclbin_cache_dir()
+{
+  static std::string value = detail::get_string_value("Runtime.xclbin_cache_dir","null");
+  return value;
+}
+
 /**
  * Enable / Disable kernel driver scheduling when running in hardware.
  * If disabled, xrt will be scheduling either using the software scheduler
@@ -317,6 +428,30 @@ get_sw_em_driver()
   return value;
 }
 
+/**
+ * Reset printf buffers between launches with a device side copy
+ * from an initialized buffer rather than a host write
+ */
+inline bool
+get_printf_device_reset()
+{
+  static bool value = detail::get_bool_value("Runtime.printf_device_reset",false);
+  return value;
+}
+
+/**
+ * Number of asynchronous QDMA stream requests to accumulate before
+ * they are submitted with one io_submit.  Pending requests are also
+ * submitted when completions are polled.  1 submits every
+ * xclWriteQueue / xclReadQueue call right away.
+ */
+inline unsigned int
+get_qdma_aio_batch()
+{
+  static unsigned int value = detail::get_uint_value("Runtime.qdma_aio_batch",1);
+  return value;
+}
+
 }}
 
 #endif
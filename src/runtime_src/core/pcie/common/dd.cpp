@@ -21,7 +21,7 @@
 #include <iostream>
 
 namespace dd {
-const char *ddOptString = "i:o:b:c:p:e:";
+const char *ddOptString = "i:o:b:c:p:e:q:t";
 
 static const struct option longOpts[] = {
     { "if",    required_argument, NULL, 'i' },
@@ -29,7 +29,10 @@ static const struct option longOpts[] = {
     { "bs",    required_argument, 0,    'b' },
     { "count", required_argument, 0,    'c' },
     { "skip",  required_argument, 0,    'p' },
-    { "seek",  required_argument, 0,    'e' }
+    { "seek",  required_argument, 0,    'e' },
+    { "depth", required_argument, 0,    'q' },
+    { "direct", no_argument,      0,    't' },
+    { 0,       0,                 0,    0 }
 };
 
 
@@ -85,6 +88,16 @@ ddArgs_t parse_dd_options( int argc, char *argv[] )
             std::cout << "seek found: " << args.seek << std::endl;
             break;
 
+        case 'q':
+            args.depth = atoi( optarg );
+            std::cout << "depth found: " << args.depth << std::endl;
+            break;
+
+        case 't':
+            args.direct = true;
+            std::cout << "direct found" << std::endl;
+            break;
+
         default:
             break;
         }
@@ -119,7 +132,7 @@ ddArgs_t parse_dd_options( int argc, char *argv[] )
     }
 
     // Test for legal count value; must be specified for dir==deviceToFile
-    if( args.dir == deviceToFile && args.count < 0 ) {
+    if( args.dir == deviceToFile && args.count <= 0 ) {
         args.isValid = false;
     }
 
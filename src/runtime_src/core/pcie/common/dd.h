@@ -40,6 +40,8 @@ struct ddArgs_t {
     int count = -1;
     int skip = -1;
     int seek = -1;
+    int depth = 0;       // transfer pipeline depth, 0 for default
+    bool direct = false; // use O_DIRECT for file I/O
 };
 /*
  * parse_dd_options
@@ -0,0 +1,491 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef DMABENCH_H
+#define DMABENCH_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstring>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include "xclhal2.h"
+#include "xclbin.h"
+
+namespace xcldev {
+    /*
+     * LatencyHistogram
+     *
+     * Log-linear histogram of latencies in nanoseconds.  Each power of
+     * two range is split into 8 linear sub-buckets, so percentiles are
+     * accurate to within 12.5%.
+     */
+    class LatencyHistogram {
+        static constexpr unsigned sub_bits = 3;
+        static constexpr unsigned sub_count = 1 << sub_bits;
+        std::array<uint64_t, 64 * sub_count> mBuckets {};
+        uint64_t mCount = 0;
+        uint64_t mMin = ~0ULL;
+        uint64_t mMax = 0;
+
+        static unsigned bucket(uint64_t ns) {
+            if (ns < sub_count)
+                return ns;
+            unsigned msb = 63 - __builtin_clzll(ns);
+            return (msb - sub_bits + 1) * sub_count + ((ns >> (msb - sub_bits)) & (sub_count - 1));
+        }
+
+        // Smallest value of a bucket
+        static uint64_t lower(unsigned idx) {
+            if (idx < sub_count)
+                return idx;
+            unsigned msb = idx / sub_count + sub_bits - 1;
+            return (1ULL << msb) + (uint64_t(idx % sub_count) << (msb - sub_bits));
+        }
+
+    public:
+        void record(uint64_t ns) {
+            ++mBuckets[bucket(ns)];
+            ++mCount;
+            mMin = std::min(mMin, ns);
+            mMax = std::max(mMax, ns);
+        }
+
+        void merge(const LatencyHistogram& other) {
+            for (size_t i = 0; i < mBuckets.size(); ++i)
+                mBuckets[i] += other.mBuckets[i];
+            mCount += other.mCount;
+            mMin = std::min(mMin, other.mMin);
+            mMax = std::max(mMax, other.mMax);
+        }
+
+        uint64_t count() const {
+            return mCount;
+        }
+
+        uint64_t min() const {
+            return mCount ? mMin : 0;
+        }
+
+        uint64_t max() const {
+            return mMax;
+        }
+
+        // Value below which aPercent of the samples fall, reported as
+        // the upper bound of the bucket holding that sample
+        uint64_t percentile(double aPercent) const {
+            if (!mCount)
+                return 0;
+            uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(aPercent / 100.0 * mCount + 0.5));
+            uint64_t seen = 0;
+            for (unsigned i = 0; i < mBuckets.size(); ++i) {
+                seen += mBuckets[i];
+                if (seen >= rank)
+                    return std::min(mMax, lower(i + 1) - 1);
+            }
+            return mMax;
+        }
+
+        // Non-empty buckets as (upper bound ns, count)
+        std::vector<std::pair<uint64_t, uint64_t>> buckets() const {
+            std::vector<std::pair<uint64_t, uint64_t>> result;
+            for (unsigned i = 0; i < mBuckets.size(); ++i) {
+                if (mBuckets[i])
+                    result.emplace_back(lower(i + 1) - 1, mBuckets[i]);
+            }
+            return result;
+        }
+    };
+
+    /*
+     * DMABench
+     *
+     * DMA benchmark sweeping transfer sizes and thread counts over the
+     * memory banks of mem_topology.  Each point moves at least 'bytes'
+     * bytes host to device and back with xclSyncBO and records bandwidth
+     * and per request latency.
+     *
+     * xclSyncBO is synchronous, so the number of outstanding requests
+     * of a point is its thread count.  Each thread syncs its own buffer
+     * and takes requests from the point's shared request count.
+     */
+    class DMABench {
+    public:
+        struct config {
+            std::vector<size_t> sizes {0x1000, 0x10000, 0x100000, 0x1000000};
+            std::vector<unsigned> threads {1, 2, 4};
+            unsigned writeThreads = 0;       // cap on write threads, 0 for none
+            std::vector<int> banks;          // mem_topology indices, empty for all
+            size_t bytes = 0x10000000;       // minimum bytes per point and direction
+            bool verify = true;
+        };
+
+        struct bank {
+            int index;
+            std::string tag;
+            uint64_t size;                   // bytes
+            unsigned flags;                  // xclAllocBO flags
+        };
+
+        struct result {
+            bank mem;
+            std::string direction;
+            size_t size;
+            unsigned threads;
+            uint64_t bytes = 0;
+            double seconds = 0;
+            LatencyHistogram latency;
+            std::string error;
+
+            result(const bank& aMem, const std::string& aDirection, size_t aSize, unsigned aThreads)
+                : mem(aMem), direction(aDirection), size(aSize), threads(aThreads) {}
+
+            double mbps() const {
+                return seconds > 0 ? bytes / (double)0x100000 / seconds : 0;
+            }
+        };
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        xclDeviceHandle mHandle;
+        config mConfig;
+
+        struct bo {
+            xclDeviceHandle handle;
+            unsigned handleBO = NULLBO;
+            bo(xclDeviceHandle aHandle, size_t aSize, unsigned aFlags) : handle(aHandle) {
+                handleBO = xclAllocBO(handle, aSize, 0, aFlags);
+            }
+            ~bo() {
+                if (handleBO != NULLBO)
+                    xclFreeBO(handle, handleBO);
+            }
+        };
+
+        // One outstanding request: sync aBOs round robin until the shared
+        // request count is exhausted or any worker of the point failed
+        int runWorker(const std::vector<unsigned>& aBOs, size_t aSize, xclBOSyncDirection aDir,
+                      std::atomic<long long>& aRemaining, std::atomic<bool>& aFailed,
+                      LatencyHistogram& aLatency) const {
+            for (size_t i = 0; !aFailed && aRemaining.fetch_sub(1) > 0; i = (i + 1) % aBOs.size()) {
+                auto start = clock::now();
+                int ret = xclSyncBO(mHandle, aBOs[i], aDir, aSize, 0);
+                if (ret) {
+                    aFailed = true;
+                    return ret < 0 ? ret : -ret;
+                }
+                aLatency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+            }
+            return 0;
+        }
+
+        // aResult.threads workers are started once per point and share
+        // the buffers, every buffer is synced at least once
+        void runPoint(const std::vector<unsigned>& aBOs, size_t aSize,
+                      xclBOSyncDirection aDir, result& aResult) const {
+            long long requests = std::max<long long>((mConfig.bytes + aSize - 1) / aSize, aBOs.size());
+            std::vector<std::vector<unsigned>> slots(aResult.threads);
+            for (size_t i = 0; i < aBOs.size(); ++i)
+                slots[i % slots.size()].push_back(aBOs[i]);
+
+            std::atomic<long long> remaining(requests);
+            std::atomic<bool> failed(false);
+            std::vector<LatencyHistogram> latency(slots.size());
+            std::vector<int> rets(slots.size(), 0);
+            std::vector<std::thread> workers;
+
+            auto start = clock::now();
+            for (size_t i = 0; i < slots.size(); ++i)
+                workers.emplace_back([&, i] {
+                    rets[i] = runWorker(slots[i], aSize, aDir, remaining, failed, latency[i]);
+                });
+            for (auto& w : workers)
+                w.join();
+            aResult.seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+            int ret = 0;
+            for (size_t i = 0; i < slots.size(); ++i) {
+                aResult.latency.merge(latency[i]);
+                if (rets[i] && !ret)
+                    ret = rets[i];
+            }
+            aResult.bytes = aResult.latency.count() * aSize;
+            if (ret)
+                aResult.error = std::string("xclSyncBO failed: ") + strerror(-ret);
+        }
+
+        int verify(const std::vector<unsigned>& aBOs, size_t aSize, const char* aPattern) const {
+            std::unique_ptr<char[]> buf(new char[aSize]);
+            for (auto boh : aBOs) {
+                std::memset(buf.get(), 0, aSize);
+                ssize_t ret = xclReadBO(mHandle, boh, buf.get(), aSize, 0);
+                if (ret < 0 || std::memcmp(buf.get(), aPattern, aSize))
+                    return -EIO;
+            }
+            return 0;
+        }
+
+    public:
+        DMABench(xclDeviceHandle aHandle, const config& aConfig) : mHandle(aHandle), mConfig(aConfig) {}
+
+        const config& getConfig() const {
+            return mConfig;
+        }
+
+        /*
+         * getBanks()
+         *
+         * Memory banks of mem_topology that can be used for DMA,
+         * restricted to the configured bank indices if any
+         */
+        std::vector<bank> getBanks(const mem_topology* aTopology) const {
+            std::vector<bank> banks;
+            for (int i = 0; aTopology && i < aTopology->m_count; ++i) {
+                auto& mem = aTopology->m_mem_data[i];
+                if (!mem.m_used || mem.m_type == MEM_STREAMING || mem.m_type == MEM_STREAMING_CONNECTION)
+                    continue;
+                if (!mConfig.banks.empty()
+                    && std::find(mConfig.banks.begin(), mConfig.banks.end(), i) == mConfig.banks.end())
+                    continue;
+                banks.push_back({i, reinterpret_cast<const char*>(mem.m_tag), mem.m_size << 10, static_cast<unsigned>(i)});
+            }
+            return banks;
+        }
+
+        /*
+         * run()
+         *
+         * Sweep all configured points on one bank.  Points that fail are
+         * recorded with an error and do not stop the sweep.
+         * Returns 0, or -EIO if any point failed data verification
+         */
+        int run(const bank& aBank, std::vector<result>& aResults, bool aVerbose = true) const {
+            int ret = 0;
+            for (auto size : mConfig.sizes) {
+                std::unique_ptr<char[]> pattern(new char[size]);
+                std::memset(pattern.get(), 'x', size);
+                for (auto threads : mConfig.threads) {
+                    unsigned writeThreads = mConfig.writeThreads ? std::min(threads, mConfig.writeThreads) : threads;
+                    result write(aBank, "write", size, writeThreads);
+                    result read(aBank, "read", size, threads);
+
+                    // One buffer per read thread
+                    std::vector<std::unique_ptr<bo>> owned;
+                    std::vector<unsigned> bos;
+                    for (unsigned t = 0; t < threads && write.error.empty(); ++t) {
+                        owned.emplace_back(new bo(mHandle, size, aBank.flags));
+                        auto boh = owned.back()->handleBO;
+                        if (boh == NULLBO || xclWriteBO(mHandle, boh, pattern.get(), size, 0))
+                            write.error = "failed to allocate buffer";
+                        bos.push_back(boh);
+                    }
+
+                    if (write.error.empty())
+                        runPoint(bos, size, XCL_BO_SYNC_BO_TO_DEVICE, write);
+                    if (write.error.empty())
+                        runPoint(bos, size, XCL_BO_SYNC_BO_FROM_DEVICE, read);
+                    else
+                        read.error = write.error;
+                    if (read.error.empty() && mConfig.verify && verify(bos, size, pattern.get())) {
+                        read.error = "data integrity check failed";
+                        ret = -EIO;
+                    }
+
+                    if (aVerbose) {
+                        print(std::cout, write);
+                        print(std::cout, read);
+                    }
+                    aResults.push_back(std::move(write));
+                    aResults.push_back(std::move(read));
+                }
+            }
+            return ret;
+        }
+
+        static void printHeader(std::ostream& aOstr) {
+            aOstr << std::left << std::setw(16) << "Bank" << std::setw(7) << "Dir" << std::right
+                  << std::setw(10) << "Size" << std::setw(9) << "Threads"
+                  << std::setw(12) << "MB/s" << std::setw(12) << "p50(us)" << std::setw(12) << "p99(us)" << "\n";
+        }
+
+        static void print(std::ostream& aOstr, const result& aResult) {
+            std::ios_base::fmtflags f(aOstr.flags());
+            std::streamsize p(aOstr.precision());
+            aOstr << std::left << std::setw(16) << aResult.mem.tag << std::setw(7) << aResult.direction << std::right
+                  << std::setw(10) << aResult.size << std::setw(9) << aResult.threads;
+            if (!aResult.error.empty()) {
+                aOstr << "  ERROR: " << aResult.error << "\n";
+            }
+            else {
+                aOstr << std::fixed << std::setprecision(1) << std::setw(12) << aResult.mbps()
+                      << std::setw(12) << aResult.latency.percentile(50) / 1000.0
+                      << std::setw(12) << aResult.latency.percentile(99) / 1000.0 << "\n";
+            }
+            aOstr.flags(f);
+            aOstr.precision(p);
+        }
+
+        /*
+         * toPtree()
+         *
+         * Machine readable results, written by the caller with
+         * boost::property_tree::write_json
+         */
+        static boost::property_tree::ptree toPtree(const std::vector<result>& aResults) {
+            boost::property_tree::ptree ptResults;
+            for (auto& r : aResults) {
+                boost::property_tree::ptree pt;
+                pt.put("bank.index", r.mem.index);
+                pt.put("bank.tag", r.mem.tag);
+                pt.put("direction", r.direction);
+                pt.put("size", r.size);
+                pt.put("threads", r.threads);
+                if (!r.error.empty()) {
+                    pt.put("error", r.error);
+                    ptResults.push_back(std::make_pair("", pt));
+                    continue;
+                }
+                pt.put("requests", r.latency.count());
+                pt.put("bytes", r.bytes);
+                pt.put("seconds", r.seconds);
+                pt.put("mbps", r.mbps());
+                pt.put("latency_ns.min", r.latency.min());
+                pt.put("latency_ns.p50", r.latency.percentile(50));
+                pt.put("latency_ns.p99", r.latency.percentile(99));
+                pt.put("latency_ns.max", r.latency.max());
+                boost::property_tree::ptree ptHist;
+                for (auto& b : r.latency.buckets()) {
+                    boost::property_tree::ptree ptBucket;
+                    ptBucket.put("le", b.first);
+                    ptBucket.put("count", b.second);
+                    ptHist.push_back(std::make_pair("", ptBucket));
+                }
+                pt.add_child("latency_ns.histogram", ptHist);
+                ptResults.push_back(std::make_pair("", pt));
+            }
+            return ptResults;
+        }
+
+        /*
+         * parseOption()
+         *
+         * Benchmark options shared by xbutil dmabench and xbdmabench
+         *  -s sizes    comma separated transfer sizes, K/M/G suffix allowed
+         *  -t threads  comma separated thread counts
+         *  -m banks    comma separated mem_topology indices
+         *  -n bytes    minimum bytes per point and direction
+         *  -x          skip data verification
+         * Returns 1 if aOpt was consumed, 0 if not a benchmark option,
+         * -1 if the value is invalid
+         */
+        static int parseOption(int aOpt, const char* aArg, config& aConfig) {
+            auto parseSize = [](const std::string& str, size_t& value) {
+                size_t idx = 0;
+                try {
+                    value = std::stoull(str, &idx, 0);
+                }
+                catch (const std::exception&) {
+                    return false;
+                }
+                std::string suffix = str.substr(idx);
+                if (suffix == "K" || suffix == "k")
+                    value <<= 10;
+                else if (suffix == "M" || suffix == "m")
+                    value <<= 20;
+                else if (suffix == "G" || suffix == "g")
+                    value <<= 30;
+                else if (!suffix.empty())
+                    return false;
+                return value != 0;
+            };
+            auto parseList = [&parseSize](const char* arg, std::vector<size_t>& values) {
+                values.clear();
+                std::stringstream ss(arg);
+                std::string item;
+                while (std::getline(ss, item, ',')) {
+                    size_t value = 0;
+                    if (!parseSize(item, value))
+                        return false;
+                    values.push_back(value);
+                }
+                return !values.empty();
+            };
+
+            std::vector<size_t> values;
+            switch (aOpt) {
+            case 's':
+                if (!parseList(aArg, values))
+                    return -1;
+                aConfig.sizes = values;
+                return 1;
+            case 't':
+                if (!parseList(aArg, values))
+                    return -1;
+                aConfig.threads.assign(values.begin(), values.end());
+                return 1;
+            case 'm': {
+                // bank 0 is a valid index but not a valid size
+                std::stringstream ss(aArg);
+                std::string item;
+                aConfig.banks.clear();
+                while (std::getline(ss, item, ',')) {
+                    size_t idx = 0;
+                    try {
+                        aConfig.banks.push_back(std::stoi(item, &idx, 0));
+                    }
+                    catch (const std::exception&) {
+                        return -1;
+                    }
+                    if (idx < item.size())
+                        return -1;
+                }
+                return aConfig.banks.empty() ? -1 : 1;
+            }
+            case 'n':
+                if (!parseSize(aArg, aConfig.bytes))
+                    return -1;
+                return 1;
+            case 'x':
+                aConfig.verify = false;
+                return 1;
+            default:
+                return 0;
+            }
+        }
+
+        static const char* options() {
+            return "s:t:m:n:x";
+        }
+
+        static const char* usage() {
+            return "[-s sizes] [-t threads] [-m banks] [-n bytes] [-x] [-j json_file]";
+        }
+    };
+}
+
+#endif /* DMABENCH_H */
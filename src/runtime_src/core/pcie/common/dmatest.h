@@ -19,13 +19,14 @@
 #ifndef DMATEST_H
 #define DMATEST_H
 
+#include <algorithm>
 #include <chrono>
-#include <future>
 #include <vector>
 #include <cstring>
 #include <iostream>
 
 #include "xclhal2.h"
+#include "core/pcie/common/dmabench.h"
 
 namespace xcldev {
     class Timer {
@@ -43,109 +44,50 @@ namespace xcldev {
         }
     };
 
+    /*
+     * DMARunner
+     *
+     * Single point DMA bandwidth test of one bank used by dmatest,
+     * see DMABench for the full sweep.
+     */
     class DMARunner {
-        std::vector<unsigned int> mBOList;
         xclDeviceHandle mHandle;
         size_t mSize;
         unsigned mFlags;
 
-        int runSyncWorker(std::vector<unsigned>::const_iterator b,
-                          std::vector<unsigned>::const_iterator e,
-                          xclBOSyncDirection dir) const {
-            int result = 0;
-            while (b < e) {
-                result = xclSyncBO(mHandle, *b, dir, mSize, 0);
-                if (result != 0)
-                    break;
-                ++b;
-            }
-            return result;
-        }
-
-        int runSync(xclBOSyncDirection dir, bool mt) const {
-            const std::vector<unsigned>::const_iterator b = mBOList.begin();
-            const std::vector<unsigned>::const_iterator e = mBOList.end();
-            if (mt) {
-                auto len = e - b;
-                auto mid = b + len/2;
-                auto future0 = std::async(std::launch::async, &DMARunner::runSyncWorker, this, b, mid, dir);
-                auto future1 = std::async(std::launch::async, &DMARunner::runSyncWorker, this, mid, e, dir);
-                return (future0.get() + future1.get());
-            }
-            else {
-                auto future0 = std::async(std::launch::async, &DMARunner::runSyncWorker, this, b, e, dir);
-                return future0.get();
-            }
-        }
-
     public:
-        DMARunner(xclDeviceHandle handle, size_t size, unsigned flags=0) : mHandle(handle), mSize(size), mFlags(flags) {
-            long long count = 0x100000000/size;
-            if (count > 0x40000)
-                count = 0x40000;
-
-            for (long long i = 0; i < count; i++) {
-                unsigned bo = xclAllocBO(mHandle, mSize, 0, mFlags);
-                if (bo == 0xffffffff)
-                    break;
-                mBOList.push_back(bo);
-            }
-        }
-
-        ~DMARunner() {
-            for (auto i : mBOList)
-                xclFreeBO(mHandle, i);
-        }
-
-        int validate(const char *buf) const {
-            std::unique_ptr<char[]> bufCmp(new char[mSize]);
-            int result = 0;
-            for (auto i : mBOList) {
-                //Clear out the host buffer
-                std::memset(bufCmp.get(), 0, mSize);
-                result = xclReadBO(mHandle, i, bufCmp.get(), mSize, 0);
-                if (result < 0)
-                    break;
-                if (std::memcmp(buf, bufCmp.get(), mSize)) {
-                    result = -EIO;
-                    std::cout << "DMA Test data integrity check failed\n";
-                    break;
-                }
-            }
-            return result;
-        }
+        DMARunner(xclDeviceHandle handle, size_t size, unsigned flags=0) : mHandle(handle), mSize(size), mFlags(flags) {}
 
         int run() const {
-            std::unique_ptr<char[]> buf(new char[mSize]);
-            std::memset(buf.get(), 'x', mSize);
-
-            int result = 0;
-            for (auto i : mBOList)
-                result += xclWriteBO(mHandle, i, buf.get(), mSize, 0);
+            // Same volume and threads as before: up to 4GB moved in at
+            // most 256K transfers, written by one thread, read by two
+            DMABench::config config;
+            config.sizes = {mSize};
+            config.threads = {2};
+            config.writeThreads = 1;
+            config.bytes = std::min<size_t>(0x100000000, mSize * 0x40000);
+
+            std::vector<DMABench::result> results;
+            DMABench bench(mHandle, config);
+            int result = bench.run({static_cast<int>(mFlags), "", 0, mFlags}, results, false);
+
+            const auto& write = results[0];
+            const auto& read = results[1];
+            if (!write.error.empty()) {
+                std::cout << "DMA Test failed: " << write.error << "\n";
+                return -1;
+            }
+            std::cout << "Host -> PCIe -> FPGA write bandwidth = " << write.mbps() << " MB/s\n";
 
-            if (result)
+            if (result == -EIO) {
+                std::cout << "DMA Test data integrity check failed\n";
                 return result;
-
-            Timer timer;
-            result = runSync(XCL_BO_SYNC_BO_TO_DEVICE, false);
-            double timer_stop = timer.stop();
-            double rate = mBOList.size() * mSize;
-            rate /= 0x100000; // MB
-            rate /= timer_stop;
-            rate *= 1000000; // s
-            std::cout << "Host -> PCIe -> FPGA write bandwidth = " << rate << " MB/s\n";
-
-            timer.reset();
-            result += runSync(XCL_BO_SYNC_BO_FROM_DEVICE, true);
-            timer_stop = timer.stop();
-            rate = mBOList.size() * mSize;
-            rate /= 0x100000; // MB
-            rate /= timer_stop;
-            rate *= 1000000; //
-            std::cout << "Host <- PCIe <- FPGA read bandwidth = " << rate << " MB/s\n";
-
-            // data integrity check: compare with initialized value 'x'
-            result = validate(buf.get());
+            }
+            if (!read.error.empty()) {
+                std::cout << "DMA Test failed: " << read.error << "\n";
+                return -1;
+            }
+            std::cout << "Host <- PCIe <- FPGA read bandwidth = " << read.mbps() << " MB/s\n";
             return result;
         }
     };
@@ -19,6 +19,7 @@
 #define MEMACCESS_H
 
 #include "core/pcie/common/dmatest.h"
+#include "core/pcie/common/memtransfer.h"
 
 #include <string>
 #include <iostream>
@@ -26,6 +27,7 @@
 #include <sstream>
 #include <vector>
 #include <numeric>
+#include <functional>
 
 #include <cstring>
 #include <cstddef>
@@ -34,6 +36,7 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 
 #include "core/common/memalign.h"
 
@@ -92,9 +95,12 @@ namespace xcldev {
     xclDeviceHandle mHandle;
     size_t mDDRSize, mDataAlignment;
     std::string mDevUserName;
+    memtransfer::options mXferOpts;
   public:
-    memaccess(xclDeviceHandle aHandle, size_t aDDRSize, size_t aDataAlignment, std::string& aDevUserName) :
-              mHandle(aHandle), mDDRSize(aDDRSize), mDataAlignment (aDataAlignment), mDevUserName(aDevUserName) {}
+    memaccess(xclDeviceHandle aHandle, size_t aDDRSize, size_t aDataAlignment, std::string& aDevUserName,
+              const memtransfer::options& aXferOpts = memtransfer::options()) :
+              mHandle(aHandle), mDDRSize(aDDRSize), mDataAlignment (aDataAlignment), mDevUserName(aDevUserName),
+              mXferOpts(aXferOpts) {}
 
     struct mem_bank_t {
       uint64_t m_base_address;
@@ -160,42 +166,17 @@ namespace xcldev {
     /*
      * readBank()
      *
-     * Read from specified address, specified size within a bank
+     * Read from specified address, specified size within a bank into file
+     * descriptor at specified file offset using the pipelined transfer engine
      * Caller's responsibility to do sanity checks. No sanity checks done here
      */
-    int readBank(std::ofstream& aOutFile, unsigned long long aStartAddr, unsigned long long aSize) {
-      char *buf = 0;
-      unsigned long long blockSize = 0x20000;
-      if (xrt_core::posix_memalign((void**)&buf, getpagesize(), blockSize))
-        return -1;
-      std::memset(buf, 0, blockSize);
-
-      size_t count = aSize;
-      uint64_t incr;
-      for (uint64_t phy = aStartAddr; phy < aStartAddr+aSize; phy += incr) {
-        incr = (count >= blockSize) ? blockSize : count;
-        //std::cout << "Reading from addr " << std::hex << phy << " aSize = " << std::hex << incr << std::dec << std::endl;
-        if (xclUnmgdPread(mHandle, 0, buf, incr, phy) < 0) {
-          //error
-          std::cout << "Error (" << strerror (errno) << ") reading 0x" << std::hex << incr << " bytes from DDR at offset 0x" << std::hex << phy << std::dec << "\n";
-          free(buf);
-          return -1;
-        }
-        count -= incr;
-        if (incr) {
-          aOutFile.write((const char*)buf, incr);
-          if ((aOutFile.rdstate() & std::ifstream::failbit) != 0) {
-            std::cout << "Error writing to file at offset " << aSize-count << "\n";
-          }
-        }
-        std::cout << "INFO: Read size 0x" << std::hex << incr << " B. Total Read so far 0x" << aSize-count << std::endl;
-      }
-      free(buf);
-      if (count != 0) {
-        std::cout << "Error! Read " << std::dec << aSize-count << " bytes, requested " << aSize << std::endl;
+    int readBank(memtransfer& aXfer, int aFd, uint64_t aFileOffset, unsigned long long aStartAddr, unsigned long long aSize) {
+      auto count = aXfer.deviceToFile(aFd, aFileOffset, aStartAddr, aSize);
+      if (count < 0 || static_cast<unsigned long long>(count) != aSize) {
+        std::cout << "Error! Read " << std::dec << (count < 0 ? 0 : count) << " bytes, requested " << aSize << std::endl;
         return -1;
       }
-      return count;
+      return 0;
     }
 
     int runDMATest(size_t blocksize, unsigned int aPattern) 
@@ -209,8 +190,9 @@ namespace xcldev {
           return -1;
         }
 
+        memtransfer xfer(mHandle, mXferOpts);
         for(const auto& itr : mems) {
-            if( writeBank(itr.m_base_address, itr.m_size, aPattern) == -1) 
+            if( writeBank(xfer, itr.m_base_address, itr.m_size, aPattern) == -1) 
                 return -1;
             result = readCompare(itr.m_base_address, itr.m_size, aPattern, false);
             if(result < 0)
@@ -305,10 +287,48 @@ namespace xcldev {
         return bankcnt;
     }
 
+    /*
+     * forEachBank()
+     *
+     * Split an access checked by readWriteHelper at bank boundaries and call
+     * aAccess(offset, address, size) for each piece, where offset is the
+     * position of the piece within the access.
+     * Returns the number of bytes not accessed, -1 if aAccess fails
+     */
+    int forEachBank(unsigned long long aStartAddr, unsigned long long aSize,
+                    std::vector<mem_bank_t>& vec_banks, std::vector<mem_bank_t>::iterator startbank,
+                    std::function<int(uint64_t, unsigned long long, unsigned long long)> aAccess) {
+      unsigned long long startAddr = aStartAddr;
+      unsigned long long size = aSize;
+      for(auto it = startbank; it!=vec_banks.end(); ++it) {
+        unsigned long long available_bank_size;
+        if (it != startbank) {
+          startAddr = it->m_base_address;
+          available_bank_size = it->m_size;
+        }
+        else {
+          available_bank_size = it->m_size - (startAddr - it->m_base_address);
+        }
+        if (size != 0) {
+          unsigned long long accesssize = (size > available_bank_size) ? (unsigned long long) available_bank_size : size;
+          if (aAccess(aSize - size, startAddr, accesssize) == -1) {
+            return -1;
+          }
+          size -= accesssize;
+        }
+        else {
+          break;
+        }
+      }
+      return size;
+    }
+
     /*
      * read()
+     *
+     * Read device memory into file, framed by START/END markers unless aRaw
      */
-    int read(std::string aFilename, unsigned long long aStartAddr = 0, unsigned long long aSize = 0) {
+    int read(std::string aFilename, unsigned long long aStartAddr = 0, unsigned long long aSize = 0, bool aRaw = false) {
       std::vector<mem_bank_t> vec_banks;
       unsigned long long startAddr = aStartAddr;
       unsigned long long size = aSize;
@@ -328,39 +348,95 @@ namespace xcldev {
         std::cout << "INFO: Reading from single bank, " << std::dec << size << " bytes from DDR address 0x"  << std::hex << startAddr
                                     << std::dec << std::endl;
       }
-      std::ofstream outFile(aFilename, std::ofstream::out | std::ofstream::binary);
+      memtransfer xfer(mHandle, mXferOpts);
+      int fd = xfer.open(aFilename, O_WRONLY | O_CREAT | O_TRUNC);
+      if (fd < 0) {
+        std::cout << "ERROR: Failed to open " << aFilename << ": " << strerror(errno) << std::endl;
+        return -1;
+      }
       char temp[32] = "====START of DDR Data=========\n";
-      outFile.write(temp, sizeof(temp));
+      uint64_t offset = 0;
+      if (!aRaw) {
+        if (memtransfer::writeFile(fd, temp, sizeof(temp), offset)) {
+          close(fd);
+          return -1;
+        }
+        offset += sizeof(temp);
+      }
 
       size_t count = size;
-      for(auto it = startbank; it!=vec_banks.end(); ++it) {
-        unsigned long long available_bank_size;
-        if (it != startbank) {
-          startAddr = it->m_base_address;
-          available_bank_size = it->m_size;
-        }
-        else {
-          //startAddr = startAddr;
-          available_bank_size = it->m_size - (startAddr - it->m_base_address);
-        }
-        if (size != 0) {
-          unsigned long long readsize = (size > available_bank_size) ? (unsigned long long) available_bank_size : size;
-          if( readBank(outFile, startAddr, readsize) == -1) {
-            return -1;
-          }
-          size -= readsize;
-        }
-        else {
-          break;
+      int remaining = forEachBank(startAddr, size, vec_banks, startbank,
+        [this, &xfer, fd, offset](uint64_t pos, unsigned long long addr, unsigned long long readsize) {
+          return readBank(xfer, fd, offset + pos, addr, readsize);
+        });
+      if (remaining == -1) {
+        close(fd);
+        return -1;
+      }
+      size = remaining;
+      if (!aRaw) {
+        strncpy(temp, "\n=====END of DDR Data=========\n", sizeof(temp));
+        if (memtransfer::writeFile(fd, temp, sizeof(temp), offset + count - size)) {
+          close(fd);
+          return -1;
         }
       }
-      strncpy(temp, "\n=====END of DDR Data=========\n", sizeof(temp));
-      outFile.write(temp, sizeof(temp));
-      outFile.close();
+      close(fd);
+      xfer.report("Read");
       std::cout << "INFO: Read data saved in file: " << aFilename << "; Num of bytes: " << std::dec << count-size << " bytes " << std::endl;
       return size;
     }
 
+    /*
+     * load()
+     *
+     * Write contents of file starting at aFileOffset to device memory.
+     * If aSize is 0 the remainder of the file is written
+     */
+    int load(std::string aFilename, unsigned long long aFileOffset = 0, unsigned long long aStartAddr = 0, unsigned long long aSize = 0) {
+      std::vector<mem_bank_t> vec_banks;
+      std::vector<mem_bank_t>::iterator startbank;
+      memtransfer xfer(mHandle, mXferOpts);
+
+      int fd = xfer.open(aFilename, O_RDONLY);
+      if (fd < 0) {
+        std::cout << "ERROR: Failed to open " << aFilename << ": " << strerror(errno) << std::endl;
+        return -1;
+      }
+      struct stat sb;
+      if (fstat(fd, &sb) < 0 || static_cast<unsigned long long>(sb.st_size) <= aFileOffset) {
+        std::cout << "ERROR: Nothing to write from " << aFilename << " at offset " << aFileOffset << std::endl;
+        close(fd);
+        return -1;
+      }
+      unsigned long long size = sb.st_size - aFileOffset;
+      if (aSize != 0 && aSize < size)
+        size = aSize;
+
+      unsigned long long startAddr = aStartAddr;
+      if (readWriteHelper(startAddr, size, vec_banks, startbank) == -1) {
+        close(fd);
+        return -1;
+      }
+
+      std::cout << "INFO: Writing DDR with " << std::dec << size << " bytes from file " << aFilename
+                << " from address 0x" << std::hex << startAddr << std::dec << std::endl;
+      size_t count = size;
+      int remaining = forEachBank(startAddr, size, vec_banks, startbank,
+        [&xfer, fd, aFileOffset](uint64_t pos, unsigned long long addr, unsigned long long writesize) {
+          auto done = xfer.fileToDevice(fd, aFileOffset + pos, addr, writesize);
+          return (done < 0 || static_cast<unsigned long long>(done) != writesize) ? -1 : 0;
+        });
+      close(fd);
+      if (remaining == -1) {
+        std::cout << "Error! Written " << std::dec << xfer.bytes() << " bytes, requested " << count << std::endl;
+        return -1;
+      }
+      size = remaining;
+      xfer.report("Wrote");
+      return size;
+    }
+
     /*
      * readCompare()
      */
@@ -442,43 +518,16 @@ namespace xcldev {
      * Write to the specified address within a bank
      * Caller's responsibility to do sanity checks. No sanity checks done here
      */
-    int writeBank(unsigned long long aStartAddr, unsigned long long aSize, unsigned int aPattern) {
-      char *buf = 0;
-      unsigned long long endAddr;
-      unsigned long long size;
-      unsigned long long blockSize = 0x20000;//128KB
-      if (xrt_core::posix_memalign((void**)&buf, getpagesize(), blockSize))
-        return -1;
-
-      endAddr = aStartAddr + aSize;
-      size = endAddr-aStartAddr;
-
-      // Use plain POSIX open/pwrite/close.
-
-      std::cout << "INFO: Writing DDR with " << std::dec << size << " bytes of pattern: 0x"
-         << std::hex << aPattern << " from address 0x" <<std::hex << aStartAddr << std::endl;
+    int writeBank(memtransfer& aXfer, unsigned long long aStartAddr, unsigned long long aSize, unsigned int aPattern) {
+      std::cout << "INFO: Writing DDR with " << std::dec << aSize << " bytes of pattern: 0x"
+         << std::hex << aPattern << " from address 0x" <<std::hex << aStartAddr << std::dec << std::endl;
 
-      unsigned long long count = size;
-      uint64_t incr = 0;
-      std::memset(buf, aPattern, blockSize);
-      for(uint64_t phy=aStartAddr; phy<endAddr; phy+=incr) {
-        incr = (count >= blockSize) ? blockSize : count;
-        //std::cout << "Writing to addr " << std::hex << phy << " size = " << std::hex << incr << std::dec << std::endl;
-        if (xclUnmgdPwrite(mHandle, 0, buf, incr, phy) < 0) {
-          //error
-          std::cout << "Error (" << strerror (errno) << ") writing 0x" << std::hex << incr << " bytes to DDR at offset 0x" << std::hex << phy << std::dec << "\n";
-          free(buf);
-          return -1;
-        }
-        count -= incr;
-      }
-
-      free(buf);
-      if (count != 0) {
-        std::cout << "Error! Written " << std::dec << size-count << " bytes, requested " << size << std::endl;
+      auto count = aXfer.fillDevice(aStartAddr, aSize, aPattern);
+      if (count < 0 || static_cast<unsigned long long>(count) != aSize) {
+        std::cout << "Error! Written " << std::dec << (count < 0 ? 0 : count) << " bytes, requested " << aSize << std::endl;
         return -1;
       }
-      return count;
+      return 0;
     }
 
     /*
@@ -504,27 +553,16 @@ namespace xcldev {
         std::cout << "INFO: Writing to single bank, " << std::dec << size << " bytes from DDR address 0x"  << std::hex << startAddr
                                     << std::dec << std::endl;
       }
-      for(auto it = startbank; it!=vec_banks.end(); ++it) {
-        unsigned long long available_bank_size;
-        if (it != startbank) {
-          startAddr = it->m_base_address;
-          available_bank_size = it->m_size;
-        }
-        else {
-          //startAddr = startAddr;
-          available_bank_size = it->m_size - (startAddr - it->m_base_address);
-        }
-        if (size != 0) {
-          unsigned long long writesize = (size > available_bank_size) ? (unsigned long long) available_bank_size : size;
-          if( writeBank(startAddr, writesize, aPattern) == -1) {
-            return -1;
-          }
-          size -= writesize;
-        }
-        else {
-          break;
-        }
+      memtransfer xfer(mHandle, mXferOpts);
+      int remaining = forEachBank(startAddr, size, vec_banks, startbank,
+        [this, &xfer, aPattern](uint64_t, unsigned long long addr, unsigned long long writesize) {
+          return writeBank(xfer, addr, writesize, aPattern);
+        });
+      if (remaining == -1) {
+        return -1;
       }
+      size = remaining;
+      xfer.report("Wrote");
       return size;
     }
 
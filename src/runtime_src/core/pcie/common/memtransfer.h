@@ -0,0 +1,374 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef MEMTRANSFER_H
+#define MEMTRANSFER_H
+
+#include "core/pcie/common/dmatest.h"
+#include "core/common/memalign.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "xclhal2.h"
+
+namespace xcldev {
+    /*
+     * memtransfer
+     *
+     * Pipelined transfer engine between device memory and a file.
+     * A producer thread fills a ring of 'depth' aligned buffers of
+     * 'block_size' bytes while the calling thread drains them, so
+     * device DMA overlaps with file I/O.  Bytes and time are
+     * accumulated across calls and reported once by report().
+     */
+    class memtransfer {
+    public:
+        struct options {
+            size_t block_size = 0x200000; // 2MB
+            unsigned depth = 4;
+            bool direct = false;          // open files with O_DIRECT
+        };
+
+        // Fill buf with at most len bytes at pipeline offset pos.
+        // Returns bytes produced, 0 at end of data, < 0 on error.
+        using producer = std::function<ssize_t(char* buf, size_t len, uint64_t pos)>;
+        // Drain len bytes of buf at pipeline offset pos, 0 on success.
+        using consumer = std::function<int(const char* buf, size_t len, uint64_t pos)>;
+
+    private:
+        struct block {
+            char* buf = nullptr;
+            size_t len = 0;
+            uint64_t pos = 0;
+        };
+
+        xclDeviceHandle mHandle;
+        options mOpts;
+        std::vector<block> mBlocks;
+
+        std::mutex mMutex;
+        std::condition_variable mWork;
+        std::queue<block*> mFree;
+        std::queue<block*> mFull;   // nullptr marks end of data
+        bool mAbort = false;
+
+        uint64_t mBytes = 0;
+        long long mUsecs = 0;
+
+        static constexpr size_t alignment = 4096;
+
+        block* pop(std::queue<block*>& q) {
+            std::unique_lock<std::mutex> lk(mMutex);
+            mWork.wait(lk, [&q, this] { return !q.empty() || mAbort; });
+            if (mAbort)
+                return nullptr;
+            auto b = q.front();
+            q.pop();
+            return b;
+        }
+
+        void push(std::queue<block*>& q, block* b) {
+            std::lock_guard<std::mutex> lk(mMutex);
+            q.push(b);
+            mWork.notify_all();
+        }
+
+        void abort() {
+            std::lock_guard<std::mutex> lk(mMutex);
+            mAbort = true;
+            mWork.notify_all();
+        }
+
+        // O_DIRECT requires aligned buffer, length and offset.  The
+        // buffers are aligned, unaligned head and tail transfers
+        // fall back to buffered I/O for just that transfer.  File I/O
+        // is done by one thread only, so toggling the flag is safe.
+        static bool unaligned(size_t len, uint64_t off) {
+            return (len | off) & (alignment - 1);
+        }
+
+        // Clear O_DIRECT, returns the flags to restore or -1 if unchanged
+        static int buffered(int fd) {
+            int flags = fcntl(fd, F_GETFL);
+            if (flags == -1 || !(flags & O_DIRECT))
+                return -1;
+            if (fcntl(fd, F_SETFL, flags & ~O_DIRECT) == -1)
+                return -1;
+            return flags;
+        }
+
+        static void restore(int fd, int flags) {
+            if (flags != -1)
+                fcntl(fd, F_SETFL, flags);
+        }
+
+        int allocate() {
+            if (!mBlocks.empty())
+                return 0;
+            mBlocks.resize(mOpts.depth);
+            for (auto& b : mBlocks) {
+                if (xrt_core::posix_memalign((void**)&b.buf, alignment, mOpts.block_size)) {
+                    std::cout << "ERROR: Failed to allocate " << mOpts.block_size << " byte transfer buffer\n";
+                    for (auto& f : mBlocks)
+                        free(f.buf);
+                    mBlocks.clear();
+                    return -1;
+                }
+            }
+            return 0;
+        }
+
+    public:
+        memtransfer(xclDeviceHandle aHandle, const options& aOpts) : mHandle(aHandle), mOpts(aOpts) {
+            if (mOpts.block_size == 0)
+                mOpts.block_size = options().block_size;
+            mOpts.block_size = (mOpts.block_size + alignment - 1) & ~(alignment - 1);
+            if (mOpts.depth < 2)
+                mOpts.depth = 2;
+        }
+
+        ~memtransfer() {
+            for (auto& b : mBlocks)
+                free(b.buf);
+        }
+
+        memtransfer(const memtransfer&) = delete;
+        memtransfer& operator=(const memtransfer&) = delete;
+
+        const options& getOptions() const {
+            return mOpts;
+        }
+
+        /*
+         * open()
+         *
+         * Open a file honoring the O_DIRECT option.  Falls back to
+         * buffered I/O if the file system does not support O_DIRECT.
+         */
+        int open(const std::string& aFilename, int aFlags, mode_t aMode = 0644) const {
+            if (mOpts.direct) {
+                int fd = ::open(aFilename.c_str(), aFlags | O_DIRECT, aMode);
+                if (fd >= 0 || errno != EINVAL)
+                    return fd;
+                std::cout << "WARNING: O_DIRECT not supported for " << aFilename << ", using buffered I/O\n";
+            }
+            return ::open(aFilename.c_str(), aFlags, aMode);
+        }
+
+        /*
+         * run()
+         *
+         * Move up to aSize bytes from producer to consumer through the
+         * buffer ring.  Returns bytes transferred or -1 on error.
+         */
+        long long run(uint64_t aSize, producer aProduce, consumer aConsume) {
+            if (allocate())
+                return -1;
+
+            mFree = std::queue<block*>();
+            mFull = std::queue<block*>();
+            mAbort = false;
+            for (auto& b : mBlocks)
+                mFree.push(&b);
+
+            Timer timer;
+            std::thread producerThread([&] {
+                for (uint64_t pos = 0; pos < aSize; ) {
+                    auto b = pop(mFree);
+                    if (!b)
+                        return;
+                    size_t len = std::min<uint64_t>(mOpts.block_size, aSize - pos);
+                    auto n = aProduce(b->buf, len, pos);
+                    if (n < 0) {
+                        abort();
+                        return;
+                    }
+                    if (n == 0) {
+                        push(mFree, b);
+                        break;
+                    }
+                    b->len = n;
+                    b->pos = pos;
+                    push(mFull, b);
+                    pos += n;
+                    if (static_cast<size_t>(n) < len)
+                        break;
+                }
+                push(mFull, nullptr);
+            });
+
+            long long done = 0;
+            while (auto b = pop(mFull)) {
+                if (aConsume(b->buf, b->len, b->pos)) {
+                    abort();
+                    break;
+                }
+                done += b->len;
+                push(mFree, b);
+            }
+            producerThread.join();
+
+            mUsecs += timer.stop();
+            if (mAbort)
+                return -1;
+            mBytes += done;
+            return done;
+        }
+
+        /*
+         * deviceToFile()
+         *
+         * Read aSize bytes of device memory at aAddr into file at aOffset.
+         */
+        long long deviceToFile(int fd, uint64_t aOffset, uint64_t aAddr, uint64_t aSize) {
+            return run(aSize,
+                [this, aAddr](char* buf, size_t len, uint64_t pos) -> ssize_t {
+                    if (xclUnmgdPread(mHandle, 0, buf, len, aAddr + pos) < 0) {
+                        std::cout << "Error (" << strerror(errno) << ") reading 0x" << std::hex << len
+                                  << " bytes from DDR at offset 0x" << aAddr + pos << std::dec << "\n";
+                        return -1;
+                    }
+                    return len;
+                },
+                [fd, aOffset](const char* buf, size_t len, uint64_t pos) {
+                    return writeFile(fd, buf, len, aOffset + pos);
+                });
+        }
+
+        /*
+         * fileToDevice()
+         *
+         * Write up to aSize bytes of file at aOffset to device memory at
+         * aAddr.  Stops early at end of file.
+         */
+        long long fileToDevice(int fd, uint64_t aOffset, uint64_t aAddr, uint64_t aSize) {
+            return run(aSize,
+                [fd, aOffset](char* buf, size_t len, uint64_t pos) {
+                    return readFile(fd, buf, len, aOffset + pos);
+                },
+                [this, aAddr](const char* buf, size_t len, uint64_t pos) {
+                    return writeDevice(buf, len, aAddr + pos);
+                });
+        }
+
+        /*
+         * fillDevice()
+         *
+         * Write aSize bytes of aPattern to device memory at aAddr.
+         * Only the device side is pipelined, buffers are filled once.
+         */
+        long long fillDevice(uint64_t aAddr, uint64_t aSize, unsigned char aPattern) {
+            if (allocate())
+                return -1;
+            for (auto& b : mBlocks)
+                std::memset(b.buf, aPattern, mOpts.block_size);
+            return run(aSize,
+                [](char*, size_t len, uint64_t) -> ssize_t {
+                    return len;
+                },
+                [this, aAddr](const char* buf, size_t len, uint64_t pos) {
+                    return writeDevice(buf, len, aAddr + pos);
+                });
+        }
+
+        int writeDevice(const char* buf, size_t len, uint64_t addr) {
+            if (xclUnmgdPwrite(mHandle, 0, buf, len, addr) < 0) {
+                std::cout << "Error (" << strerror(errno) << ") writing 0x" << std::hex << len
+                          << " bytes to DDR at offset 0x" << addr << std::dec << "\n";
+                return -1;
+            }
+            return 0;
+        }
+
+        static int writeFile(int fd, const char* buf, size_t len, uint64_t off) {
+            int flags = unaligned(len, off) ? buffered(fd) : -1;
+            int rc = 0;
+            while (len) {
+                auto n = pwrite(fd, buf, len, off);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0) {
+                    std::cout << "Error (" << strerror(errno) << ") writing to file at offset " << off << "\n";
+                    rc = -1;
+                    break;
+                }
+                buf += n;
+                len -= n;
+                off += n;
+            }
+            restore(fd, flags);
+            return rc;
+        }
+
+        static ssize_t readFile(int fd, char* buf, size_t len, uint64_t off) {
+            int flags = unaligned(len, off) ? buffered(fd) : -1;
+            ssize_t total = 0;
+            while (len) {
+                auto n = pread(fd, buf, len, off);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n < 0) {
+                    std::cout << "Error (" << strerror(errno) << ") reading from file at offset " << off << "\n";
+                    total = -1;
+                    break;
+                }
+                if (n == 0)
+                    break;
+                buf += n;
+                len -= n;
+                off += n;
+                total += n;
+            }
+            restore(fd, flags);
+            return total;
+        }
+
+        uint64_t bytes() const {
+            return mBytes;
+        }
+
+        /*
+         * report()
+         *
+         * Print aggregate throughput of all transfers so far.
+         */
+        void report(const std::string& aWhat) const {
+            double secs = mUsecs / 1000000.0;
+            double rate = secs > 0 ? (mBytes / (double)0x100000) / secs : 0;
+            std::ios_base::fmtflags f(std::cout.flags());
+            std::cout << "INFO: " << aWhat << " " << std::dec << mBytes << " bytes in "
+                      << secs << " s (" << rate << " MB/s, block size 0x" << std::hex << mOpts.block_size
+                      << std::dec << ", depth " << mOpts.depth << (mOpts.direct ? ", O_DIRECT" : "") << ")\n";
+            std::cout.flags(f);
+        }
+    };
+}
+
+#endif /* MEMTRANSFER_H */
@@ -17,6 +17,8 @@
 #include "config.h"
 #include "core/common/config_reader.h"
 
+#include <cerrno>
+
 namespace xclemulation{
 
   DDRBank::DDRBank()
@@ -782,4 +784,37 @@ namespace xclemulation{
     ifs.close();
     return false;
   }
+
+  template <typename SectionType, typename EntryType>
+  static int copySectionEntry(const std::vector<char>& section, const EntryType* entries, int index, void* info, size_t* size)
+  {
+    if (section.size() < sizeof(SectionType))
+      return -EINVAL;
+    auto count = reinterpret_cast<const SectionType*>(section.data())->m_count;
+    if (index < 0 || index >= count)
+      return -EINVAL;
+    size_t end = (reinterpret_cast<const char*>(entries) - section.data()) + (index + 1) * sizeof(EntryType);
+    if (end > section.size())
+      return -EINVAL;
+    std::memcpy(info, &entries[index], sizeof(EntryType));
+    *size = sizeof(EntryType);
+    return 0;
+  }
+
+  int getSectionInfo(const std::vector<char>& section, enum axlf_section_kind kind, int index, void* info, size_t* size)
+  {
+    if (!info || !size || section.empty())
+      return -EINVAL;
+
+    switch (kind) {
+    case MEM_TOPOLOGY:
+      return copySectionEntry<mem_topology>(section, reinterpret_cast<const mem_topology*>(section.data())->m_mem_data, index, info, size);
+    case CONNECTIVITY:
+      return copySectionEntry<connectivity>(section, reinterpret_cast<const connectivity*>(section.data())->m_connection, index, info, size);
+    case IP_LAYOUT:
+      return copySectionEntry<ip_layout>(section, reinterpret_cast<const ip_layout*>(section.data())->m_ip_data, index, info, size);
+    default:
+      return -EINVAL;
+    }
+  }
 }
@@ -1,6 +1,7 @@
 #ifndef __EM_CONFIG_READER__
 #define __EM_CONFIG_READER__
 
+#include <cstdint>
 #include <cstring>
 #include <sstream>
 #include <list>
@@ -170,6 +171,11 @@ namespace xclemulation{
   std::string getEmDebugLogFile();
   bool isXclEmulationModeHwEmuOrSwEmu();
   std::string getRunDirectory();
+
+  // Copy entry index of a MEM_TOPOLOGY, CONNECTIVITY or IP_LAYOUT
+  // section of the loaded xclbin, as xclGetSectionInfo returns it.
+  // Returns 0 on success or -EINVAL.
+  int getSectionInfo(const std::vector<char>& section, enum axlf_section_kind kind, int index, void* info, size_t* size);
   
   std::map<std::string,std::string> getEnvironmentByReadingIni();
 }
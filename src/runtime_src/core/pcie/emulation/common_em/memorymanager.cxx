@@ -16,13 +16,15 @@
 
 #include "memorymanager.h"
 
+#include <iterator>
+
 namespace xclemulation {
   MemoryManager::MemoryManager(uint64_t size, uint64_t start,
       unsigned alignment) : mSize(size), mStart(start), mAlignment(alignment),
-  mCoalesceThreshold(4), mFreeSize(0)
+  mFreeSize(0)
   {
     assert(start % alignment == 0);
-    mFreeBufferList.push_back(std::make_pair(mStart, mSize));
+    insertFree(mStart, mSize);
     mFreeSize = mSize;
   }
 
@@ -31,12 +33,23 @@ namespace xclemulation {
 
   }
 
+  void MemoryManager::insertFree(uint64_t addr, uint64_t size)
+  {
+    mFreeByAddr.emplace(addr, size);
+    mFreeBySize.emplace(size, addr);
+  }
+
+  void MemoryManager::eraseFree(std::map<uint64_t, uint64_t>::iterator it)
+  {
+    mFreeBySize.erase(std::make_pair(it->second, it->first));
+    mFreeByAddr.erase(it);
+  }
+
   uint64_t MemoryManager::alloc(size_t& origSize, unsigned int paddingFactor)
   {
     if (origSize == 0)
       origSize = mAlignment;
 
-    uint64_t result = mNull;
     const size_t mod_size = origSize % mAlignment;
     const size_t pad = (mod_size > 0) ? (mAlignment - mod_size) : 0;
     origSize += pad;
@@ -45,100 +58,68 @@ namespace xclemulation {
 
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
 
-    for (PairList::iterator i = mFreeBufferList.begin(), e = mFreeBufferList.end(); i != e; ++i) 
+    // Smallest free block that fits, lowest address on ties
+    auto fit = mFreeBySize.lower_bound(std::make_pair(static_cast<uint64_t>(size), static_cast<uint64_t>(0)));
+    if (fit == mFreeBySize.end())
+      return mNull;
+
+    uint64_t result = fit->second;
+    uint64_t blockSize = fit->first;
+    eraseFree(mFreeByAddr.find(result));
+    if (blockSize > size) 
     {
-      if (i->second < size)
-        continue;
-      result = i->first;
-      if (i->second > size) 
-      {
-        // Resize the existing entry in freelist
-        i->first += size;
-        i->second -= size;
-      }
-      else 
-      {
-        // remove the exact match found
-        mFreeBufferList.erase(i);
-      }
-      mBusyBufferList.push_back(std::make_pair(result, size));
-      mFreeSize -= size;
-      break;
+      // Return the tail of the block to the free lists
+      insertFree(result + size, blockSize - size);
     }
+    mBusyBuffers.emplace(result, size);
+    mFreeSize -= size;
     return result;
   }
 
   void MemoryManager::free(uint64_t buf)
   {
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
-    PairList::iterator i = find(buf);
-    if (i == mBusyBufferList.end())
+    auto busy = mBusyBuffers.find(buf);
+    if (busy == mBusyBuffers.end())
       return;
-    mFreeSize += i->second;
-    mFreeBufferList.push_back(std::make_pair(i->first, i->second));
-    mBusyBufferList.erase(i);
-    if (mFreeBufferList.size() > mCoalesceThreshold) {
-      coalesce();
-    }
-  }
-
 
-  void MemoryManager::coalesce()
-  {
-    // First sort the free buffers and then attempt to coalesce the neighbors
-    mFreeBufferList.sort();
-
-    PairList::iterator curr = mFreeBufferList.begin();
-    PairList::iterator next = curr;
-    ++next;
-    PairList::iterator last = mFreeBufferList.end();
-    while (next != last) {
-      if ((curr->first + curr->second) != next->first) {
-        // Non contiguous blocks
-        curr = next;
-        ++next;
-        continue;
+    uint64_t addr = busy->first;
+    uint64_t size = busy->second;
+    mBusyBuffers.erase(busy);
+    mFreeSize += size;
+
+    // Merge with the free neighbors on either side
+    auto next = mFreeByAddr.lower_bound(addr);
+    if (next != mFreeByAddr.begin()) {
+      auto prev = std::prev(next);
+      if (prev->first + prev->second == addr) {
+        addr = prev->first;
+        size += prev->second;
+        eraseFree(prev);
       }
-      // Coalesce curr and next
-      curr->second += next->second;
-      mFreeBufferList.erase(next);
-      next = curr;
-      ++next;
     }
-  }
-
-
-  MemoryManager::PairList::iterator MemoryManager::find(uint64_t buf)
-  {
-#if GCC_VERSION >= 40800
-    PairList::iterator i = std::find_if(mBusyBufferList.begin(), mBusyBufferList.end(), [&] (const PairList::value_type& s)
-        { return s.first == buf; });
-#else
-    PairList::iterator i = mBusyBufferList.begin();
-    PairList::iterator last  = mBusyBufferList.end();
-    while(i != last) {
-      if (i->first == buf)
-        break;
-      ++i;
+    if (next != mFreeByAddr.end() && addr + size == next->first) {
+      size += next->second;
+      eraseFree(next);
     }
-#endif
-    return i;
+    insertFree(addr, size);
   }
 
   void MemoryManager::reset()
   {
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
-    mFreeBufferList.clear();
-    mBusyBufferList.clear();
-    mFreeBufferList.push_back(std::make_pair(mStart, mSize));
-    mFreeSize = 0;
+    mFreeByAddr.clear();
+    mFreeBySize.clear();
+    mBusyBuffers.clear();
+    insertFree(mStart, mSize);
+    mFreeSize = mSize;
   }
 
   std::pair<uint64_t, uint64_t> MemoryManager::lookup(uint64_t buf)
   {
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
-    PairList::iterator i = find(buf);
-    if (i != mBusyBufferList.end())
+    auto i = mBusyBuffers.find(buf);
+    if (i != mBusyBuffers.end())
       return *i;
     // Compiler bug -- Some versions of GCC C++11 compiler do not
     // like mNull directly inside std::make_pair, so capture mNull
@@ -147,4 +128,3 @@ namespace xclemulation {
     return std::make_pair(v, v);
   }
 }
-
@@ -18,7 +18,9 @@
 #define _HWEM_MEMORY_MANAGER_H_
 
 #include <mutex>
-#include <list>
+#include <map>
+#include <set>
+#include <unordered_map>
 #include <cassert>
 #include <algorithm>
 
@@ -27,19 +29,27 @@
 
 namespace xclemulation
 {
+    /**
+     * Device memory allocator for emulation.
+     *
+     * Free blocks are indexed both by address and by (size,address).
+     * Allocation is best fit, the smallest free block that fits with
+     * ties going to the lowest address, found with one ordered lookup.
+     * A freed block is merged with its free neighbors right away using
+     * the address index, so the free lists never need sorting.  Busy
+     * blocks are kept in a hash map for constant time free and lookup.
+     */
     class MemoryManager 
     {
         std::mutex mMemManagerMutex;
-        std::list<std::pair<uint64_t, uint64_t> > mFreeBufferList;
-        std::list<std::pair<uint64_t, uint64_t> > mBusyBufferList;
+        std::map<uint64_t, uint64_t> mFreeByAddr;                // addr -> size
+        std::set<std::pair<uint64_t, uint64_t> > mFreeBySize;    // (size,addr)
+        std::unordered_map<uint64_t, uint64_t> mBusyBuffers;     // addr -> size
         uint64_t mSize;
         uint64_t mStart;
         uint64_t mAlignment;
-        const unsigned mCoalesceThreshold;
         uint64_t mFreeSize;
 
-        typedef std::list<std::pair<uint64_t, uint64_t> > PairList;
-
     public:
         static const uint64_t mNull = 0xffffffffffffffffull;
 
@@ -58,8 +68,8 @@ namespace xclemulation
         std::pair<uint64_t, uint64_t>lookup(uint64_t buf);
 
     private:
-        void coalesce();
-        PairList::iterator find(uint64_t buf);
+        void insertFree(uint64_t addr, uint64_t size);
+        void eraseFree(std::map<uint64_t, uint64_t>::iterator it);
     };
 }
 
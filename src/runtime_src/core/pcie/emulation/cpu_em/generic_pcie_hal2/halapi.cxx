@@ -83,6 +83,15 @@ int xclGetDeviceInfo2(xclDeviceHandle handle, xclDeviceInfo2 *info)
   return drv->xclGetDeviceInfo2(info);
 }
 
+int xclGetSectionInfo(xclDeviceHandle handle, void* info, size_t* size,
+                      enum axlf_section_kind kind, int index)
+{
+  xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
+  if (!drv)
+    return -ENODEV;
+  return drv->xclGetSectionInfo(info, size, kind, index);
+}
+
 int xclLoadXclBin(xclDeviceHandle handle, const xclBin *buffer)
 {
   xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
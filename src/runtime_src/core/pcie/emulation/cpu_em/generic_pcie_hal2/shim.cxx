@@ -501,6 +501,11 @@ namespace xclcpuemhal2 {
           memTopology = new char[memTopologySize];
           memcpy(memTopology, xclbininmemory + sec->m_sectionOffset, memTopologySize);
         }
+        mXclbinSections.clear();
+        for (auto kind : {MEM_TOPOLOGY, CONNECTIVITY, IP_LAYOUT}) {
+          if (auto sec = xclbin::get_axlf_section(top, kind))
+            mXclbinSections[kind].assign(xclbininmemory + sec->m_sectionOffset, xclbininmemory + sec->m_sectionOffset + sec->m_sectionSize);
+        }
       }
       else
       {
@@ -604,6 +609,14 @@ namespace xclcpuemhal2 {
     return 0;
   }
 
+  int CpuemShim::xclGetSectionInfo(void* info, size_t* size, enum axlf_section_kind kind, int index)
+  {
+    auto it = mXclbinSections.find(kind);
+    if (it == mXclbinSections.end())
+      return -EINVAL;
+    return xclemulation::getSectionInfo(it->second, kind, index, info, size);
+  }
+
   int CpuemShim::xclGetDeviceInfo2(xclDeviceInfo2 *info) 
   {
     std::memset(info, 0, sizeof(xclDeviceInfo2));
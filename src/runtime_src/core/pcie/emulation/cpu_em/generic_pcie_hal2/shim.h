@@ -88,6 +88,7 @@ namespace xclcpuemhal2 {
       //Configuration
       void xclOpen(const char* logfileName);
       int xclLoadXclBin(const xclBin *buffer);
+      int xclGetSectionInfo(void* info, size_t* size, enum axlf_section_kind kind, int index);
       //int xclLoadBitstream(const char *fileName);
       int xclUpgradeFirmware(const char *fileName);
       int xclBootFPGA();
@@ -153,6 +154,9 @@ namespace xclcpuemhal2 {
     private:
       std::mutex mMemManagerMutex;
 
+      // Sections of the loaded xclbin returned by xclGetSectionInfo
+      std::map<enum axlf_section_kind, std::vector<char>> mXclbinSections;
+
       // Performance monitoring helper functions
       bool isDSAVersion(double checkVersion, bool onlyThisVersion);
       uint64_t getHostTraceTimeNsec();
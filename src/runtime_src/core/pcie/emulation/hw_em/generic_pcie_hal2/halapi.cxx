@@ -346,6 +346,15 @@ int xclGetDeviceInfo2(xclDeviceHandle handle, xclDeviceInfo2 *info)
   return drv->xclGetDeviceInfo2(info);
 }
 
+int xclGetSectionInfo(xclDeviceHandle handle, void* info, size_t* size,
+                      enum axlf_section_kind kind, int index)
+{
+  xclhwemhal2::HwEmShim *drv = xclhwemhal2::HwEmShim::handleCheck(handle);
+  if (!drv)
+    return -ENODEV;
+  return drv->xclGetSectionInfo(info, size, kind, index);
+}
+
 unsigned int xclVersion ()
 {
   return 2;
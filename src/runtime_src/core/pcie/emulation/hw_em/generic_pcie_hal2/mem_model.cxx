@@ -16,12 +16,55 @@
 
 #include "mem_model.h"
 
+#include <algorithm>
+#include <sys/mman.h>
+
+mem_model::chunk::chunk()
+  : base(nullptr), present(CHUNKPAGES,false)
+{
+  // Reserve address space only, pages are backed on first touch
+  void* addr = mmap(NULL, CHUNKSIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (addr == MAP_FAILED)
+  {
+    // Strict overcommit accounting charges the whole reservation,
+    // allocate pages one at a time instead
+    pages.resize(CHUNKPAGES,nullptr);
+    return;
+  }
+  base = static_cast<unsigned char*>(addr);
+}
+
+mem_model::chunk::~chunk()
+{
+  if (base)
+    munmap(base, CHUNKSIZE);
+  for (auto p : pages)
+    free(p);
+}
+
+unsigned char* mem_model::chunk::page(uint64_t idx)
+{
+  if (base)
+    return base + (idx << ADDRBITS);
+  if (!pages[idx])
+  {
+    pages[idx] = static_cast<unsigned char*>(calloc(1,PAGESIZE));
+    if (!pages[idx])
+    {
+      std::cerr << "Out of Memory. DDR model could not allocate page\n";
+      exit(1);
+    }
+  }
+  return pages[idx];
+}
+
 mem_model::~ mem_model()
 {
   serialize();
 }
 
 mem_model::mem_model(std::string deviceName):
+  mNumPages(0),
   mDeviceName(deviceName),
   module_name("dr_wrapper_dr_i_sdaccel_generic_pcie_0.sdaccel_generic_pcie_model.ddrx_top_tlm_model_0.axi_app_tlm_model_0")
 {
@@ -35,26 +78,10 @@ mem_model::mem_model(std::string deviceName):
       uint64_t written_bytes = 0;
       uint64_t addr = offset;
       while(written_bytes < size){
-          uint64_t src_offset = written_bytes;
-
-          unsigned char* page_ptr  = get_page(addr);
-          uint64_t       page_addr = addr & ~(-1 << ADDRBITS);
-
-          unsigned char* dest_buf_ptr = page_ptr + page_addr;
-          unsigned char* src_buf_ptr  = (unsigned char*)(src)      + src_offset;
-
-          uint64_t remaining_bytes_to_write = size - written_bytes;
-          uint64_t unaligned_bytes_in_addr = (addr & ~(-1 << ADDRBITS));
-          uint64_t bytes_upto_next_alignment = (0x1 << ADDRBITS) - unaligned_bytes_in_addr;
-
-          uint64_t buf_size = 0;
-          if(bytes_upto_next_alignment > remaining_bytes_to_write)
-          {
-              buf_size = remaining_bytes_to_write;
-          }else{
-              buf_size = bytes_upto_next_alignment;
-          }
-
+          // One memcpy per contiguous range the transfer spans
+          uint64_t buf_size = size - written_bytes;
+          unsigned char* dest_buf_ptr = get_range(addr, buf_size);
+          const unsigned char* src_buf_ptr = static_cast<const unsigned char*>(src) + written_bytes;
           memcpy(dest_buf_ptr,src_buf_ptr,buf_size);
 
           written_bytes += buf_size;
@@ -82,26 +109,11 @@ mem_model::mem_model(std::string deviceName):
 	  uint64_t read_bytes = 0;
 	  uint64_t addr = offset;
 	  while(read_bytes < size){
-		  uint64_t dest_offset = read_bytes;
-
-		  unsigned char* page_ptr  = get_page(addr);
-		  uint64_t       page_addr = addr & ~(-1 << ADDRBITS);
+		  uint64_t buf_size = size - read_bytes;
+		  unsigned char* src_buf_ptr = get_range(addr, buf_size);
+		  unsigned char* dest_buf_ptr  = static_cast<unsigned char*>(dest) + read_bytes;
+		  memcpy(dest_buf_ptr,src_buf_ptr,buf_size);
 
-		  unsigned char* src_buf_ptr = page_ptr + page_addr;
-		  unsigned char* dest_buf_ptr  = (unsigned char*)(dest)      + dest_offset;
-
-		  uint64_t remaining_bytes_to_read = size - read_bytes;
-		  uint64_t unaligned_bytes_in_addr = (addr & ~(-1 << ADDRBITS));
-		  uint64_t bytes_upto_next_alignment = (0x1 << ADDRBITS) - unaligned_bytes_in_addr;
-
-		  uint64_t buf_size = 0;
-		  if(bytes_upto_next_alignment > remaining_bytes_to_read)
-		  {
-			  buf_size = remaining_bytes_to_read;
-		  }else{
-			  buf_size = bytes_upto_next_alignment;
-		  }
-	  memcpy(dest_buf_ptr,src_buf_ptr,buf_size);
 		  read_bytes += buf_size;
 		  addr += buf_size;
 	  }
@@ -118,45 +130,68 @@ mem_model::mem_model(std::string deviceName):
 
 	  return 0;
   }
-  unsigned char* mem_model::get_page(uint64_t offset) {
-	  uint64_t page_idx = offset >> ADDRBITS;
-	  std::string file_name = get_mem_file_name(page_idx);
-	  if(pageCache.size() > N_1MBARRAYS)
-	  {
-		  std::cerr << "Out of Memory. DDR model does not support this much of memory\n";
-		  exit(1);
-	  } else {
-      FILE* pFile = NULL;
-		  if(pageCache.find(page_idx) != pageCache.end())
-		  {
-			  return pageCache[page_idx];
-		  } else if(((pFile = fopen(file_name.c_str(),"r")) != NULL)) {
-			  int fhandle = fileno(pFile);
 
-			  if (deserialize_msg.ParseFromFileDescriptor(fhandle) == false)
-        {
-          fclose(pFile);
-          exit(1);
-        }
-			  pageCache[page_idx] = new unsigned char[PAGESIZE];
-
-			  memcpy(pageCache[page_idx],deserialize_msg.data().c_str(),PAGESIZE);
-			  fclose(pFile);
-			  return pageCache[page_idx];
-		  } else {
-			  pageCache[page_idx] = new unsigned char[PAGESIZE];
-			  return pageCache[page_idx];
+  // Host pointer to [offset,offset+size).  size is clamped to the end
+  // of the chunk, or of the page if the chunk is not contiguous.  Pages
+  // in the range that are touched for the first time are loaded from
+  // their mem file if one exists.
+  unsigned char* mem_model::get_range(uint64_t offset, uint64_t& size) {
+	  uint64_t chunk_idx = offset >> (ADDRBITS + CHUNKBITS);
+	  if (chunk_idx >= mChunks.size())
+		  mChunks.resize(chunk_idx + 1);
+	  auto& c = mChunks[chunk_idx];
+	  if (!c)
+		  c.reset(new chunk);
+
+	  uint64_t chunk_offset = offset & (CHUNKSIZE - 1);
+	  uint64_t limit = c->base ? CHUNKSIZE - chunk_offset : PAGESIZE - (offset & (PAGESIZE - 1));
+	  size = std::min(size, limit);
+	  uint64_t first = chunk_offset >> ADDRBITS;
+	  uint64_t last = (chunk_offset + size - 1) >> ADDRBITS;
+	  for (uint64_t page = first; page <= last; ++page) {
+		  if (c->present[page])
+			  continue;
+		  if (++mNumPages > N_1MBARRAYS)
+		  {
+			  std::cerr << "Out of Memory. DDR model does not support this much of memory\n";
+			  exit(1);
 		  }
+		  load_page((chunk_idx << CHUNKBITS) + page, c->page(page));
+		  c->present[page] = true;
 	  }
+	  return c->page(first) + (chunk_offset & (PAGESIZE - 1));
+  }
+
+  void mem_model::load_page(uint64_t pageIdx, unsigned char* page) {
+	  std::string file_name = get_mem_file_name(pageIdx);
+	  FILE* pFile = fopen(file_name.c_str(),"r");
+	  if (!pFile)
+		  return;
+
+	  int fhandle = fileno(pFile);
+	  if (deserialize_msg.ParseFromFileDescriptor(fhandle) == false)
+	  {
+		  fclose(pFile);
+		  exit(1);
+	  }
+	  memcpy(page,deserialize_msg.data().c_str(),PAGESIZE);
+	  fclose(pFile);
   }
 
 
   void mem_model::serialize() {
      FILE *pFile;
      int fhandle;
-     for (pageCacheItr=pageCache.begin(); pageCacheItr != pageCache.end(); ++pageCacheItr)
+     for (uint64_t chunk_idx = 0; chunk_idx < mChunks.size(); ++chunk_idx)
      {
-        std::string file_name = get_mem_file_name(pageCacheItr->first);
+       auto& c = mChunks[chunk_idx];
+       if (!c)
+         continue;
+       for (uint64_t page = 0; page < CHUNKPAGES; ++page)
+       {
+        if (!c->present[page])
+          continue;
+        std::string file_name = get_mem_file_name((chunk_idx << CHUNKBITS) + page);
         pFile = fopen(file_name.c_str(),"w+");
         if(!pFile)
           continue;
@@ -167,13 +202,14 @@ mem_model::mem_model(std::string deviceName):
           exit(1);
         }
 
-        serialize_msg.set_data(reinterpret_cast<const char*>(pageCacheItr->second),PAGESIZE);
+        serialize_msg.set_data(reinterpret_cast<const char*>(c->page(page)),PAGESIZE);
         if(serialize_msg.SerializeToFileDescriptor(fhandle) == false)
         {
           fclose(pFile);
           exit(1);
         }
         fclose(pFile);
+       }
      }
   }
 
@@ -22,7 +22,8 @@
 #include <string.h> // memcpy
 #include <sstream> // memcpy
 #include <stdlib.h> //realloc
-#include <map> //realloc
+#include <memory>
+#include <vector>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -35,6 +36,15 @@
 #define ADDRBITS (20)
 #define N_1MBARRAYS 4096
 
+// Pages are grouped in chunks of 2^CHUNKBITS pages (4GB).  Each chunk
+// is one sparse anonymous mapping, so consecutive pages are contiguous
+// in host memory and a transfer within a chunk is a single memcpy.
+// If the mapping cannot be reserved (e.g. vm.overcommit_memory=2) the
+// chunk falls back to allocating its pages individually.
+#define CHUNKBITS (12)
+#define CHUNKPAGES (1ull << CHUNKBITS)
+#define CHUNKSIZE (CHUNKPAGES << ADDRBITS)
+
 class mem_model{
 public:
 unsigned int writeDevMem(uint64_t offset, const void* src, unsigned int size);
@@ -42,10 +52,24 @@ unsigned int readDevMem(uint64_t offset, void* dest, unsigned int size);
 
 protected:
 private:
-  unsigned char* get_page(uint64_t offset);
+  // Flat two level page table: mChunks is indexed by page index
+  // >> CHUNKBITS, a chunk tracks which of its pages are resident.
+  // base is null when the chunk uses individually allocated pages.
+  struct chunk
+  {
+    unsigned char* base;
+    std::vector<unsigned char*> pages;
+    std::vector<bool> present;
+    chunk();
+    ~chunk();
+    unsigned char* page(uint64_t idx);
+  };
+  std::vector<std::unique_ptr<chunk>> mChunks;
+  uint64_t mNumPages;
+
+  unsigned char* get_range(uint64_t offset, uint64_t& size);
+  void load_page(uint64_t pageIdx, unsigned char* page);
   std::string get_mem_file_name(uint64_t pageIdx);
-  std::map<uint64_t,unsigned char*> pageCache;
-  std::map<uint64_t,unsigned char*>::iterator pageCacheItr;
 
   ddr_mem_msg serialize_msg;
   ddr_mem_msg deserialize_msg;
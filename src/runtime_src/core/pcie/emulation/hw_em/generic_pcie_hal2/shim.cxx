@@ -194,6 +194,11 @@ namespace xclhwemhal2 {
       emuData = new char[emuDataSize];
       memcpy(emuData, bitstreambin + sec->m_sectionOffset, emuDataSize);
     }
+    mXclbinSections.clear();
+    for (auto kind : {MEM_TOPOLOGY, CONNECTIVITY, IP_LAYOUT}) {
+      if (auto sec = xclbin::get_axlf_section(top, kind))
+        mXclbinSections[kind].assign(bitstreambin + sec->m_sectionOffset, bitstreambin + sec->m_sectionOffset + sec->m_sectionSize);
+    }
 
     if(!zipFile || !xmlFile)
     {
@@ -1682,6 +1687,14 @@ uint32_t HwEmShim::getAddressSpace (uint32_t topology)
     return size;
   }
 
+  int HwEmShim::xclGetSectionInfo(void* info, size_t* size, enum axlf_section_kind kind, int index)
+  {
+    auto it = mXclbinSections.find(kind);
+    if (it == mXclbinSections.end())
+      return -EINVAL;
+    return xclemulation::getSectionInfo(it->second, kind, index, info, size);
+  }
+
   int HwEmShim::xclGetDeviceInfo2(xclDeviceInfo2 *info)
   {
     std::memset(info, 0, sizeof(xclDeviceInfo2));
@@ -131,6 +131,7 @@ using addr_type = uint64_t;
       
       // Bitstreams
       int xclLoadXclBin(const xclBin *buffer);
+      int xclGetSectionInfo(void* info, size_t* size, enum axlf_section_kind kind, int index);
       //int xclLoadBitstream(const char *fileName);
       int xclLoadBitstreamWorker(bitStreamArg);
       bool isUltraScale() const;
@@ -252,6 +253,8 @@ using addr_type = uint64_t;
       std::map<uint64_t,uint64_t> mAddrMap;
       std::map<std::string,std::string> mBinaryDirectories;
       std::map<uint64_t , std::ofstream*> mOffsetInstanceStreamMap;
+      // Sections of the loaded xclbin returned by xclGetSectionInfo
+      std::map<enum axlf_section_kind, std::vector<char>> mXclbinSections;
 
       //mutex to control parellel RPC calls
       std::mutex mtx;
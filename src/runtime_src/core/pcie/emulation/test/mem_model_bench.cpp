@@ -0,0 +1,76 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+// hw_emu mem_model throughput benchmark
+//
+// Writes and reads back transfers from 4KB to 256MB through the DDR
+// model, checks the data, and reports MB/s for each size.  Build from
+// src/runtime_src with rpc_messages.pb.cc generated from
+// core/pcie/emulation/common_em/rpc_messages.proto into <pb>:
+//
+//  % g++ -std=c++14 -O2 -I<pb> -Icore/pcie/emulation/hw_em/generic_pcie_hal2
+//      core/pcie/emulation/test/mem_model_bench.cpp
+//      core/pcie/emulation/hw_em/generic_pcie_hal2/mem_model.cxx
+//      <pb>/rpc_messages.pb.cc -lprotobuf -o memmodelbench
+
+#include "mem_model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using clock_type = std::chrono::steady_clock;
+
+int
+main()
+{
+  const uint64_t max_size = 256 * ONE_MB;
+  const uint64_t base = 0x4000000000ull - ONE_KB; // unaligned, crosses chunk boundary
+
+  std::vector<unsigned char> src(max_size);
+  std::vector<unsigned char> dst(max_size);
+  for (uint64_t i=0; i<max_size; ++i)
+    src[i] = static_cast<unsigned char>(i * 7);
+
+  mem_model model("bench");
+
+  for (uint64_t size = 4 * ONE_KB; size <= max_size; size *= 4) {
+    // enough iterations to move at least 1GB each way
+    auto iterations = std::max<uint64_t>(1, 1024 * ONE_MB / size);
+
+    auto start = clock_type::now();
+    for (uint64_t i=0; i<iterations; ++i)
+      model.writeDevMem(base, src.data(), size);
+    auto write_s = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    start = clock_type::now();
+    for (uint64_t i=0; i<iterations; ++i)
+      model.readDevMem(base, dst.data(), size);
+    auto read_s = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    if (!std::equal(src.begin(), src.begin() + size, dst.begin())) {
+      std::cout << "data mismatch at size " << size << "\n";
+      return 1;
+    }
+
+    std::cout << "size " << size / ONE_KB << "KB"
+              << " write " << (iterations * size) / (write_s * ONE_MB) << " MB/s"
+              << " read " << (iterations * size) / (read_s * ONE_MB) << " MB/s\n";
+  }
+  return 0;
+}
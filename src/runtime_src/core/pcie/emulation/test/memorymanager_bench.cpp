@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Emulation MemoryManager benchmark
+//
+// Allocates 100k buffers of mixed sizes, frees a random half, allocates
+// again, then frees everything, checking that the allocator ends up with
+// a single free block.  Build from src/runtime_src:
+//
+//  % g++ -std=c++14 -O2 -Icore/include -Icore/pcie/emulation/common_em
+//      core/pcie/emulation/test/memorymanager_bench.cpp
+//      core/pcie/emulation/common_em/memorymanager.cxx -o mmbench
+
+#include "memorymanager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using clock_type = std::chrono::steady_clock;
+
+static double
+elapsed_ms(clock_type::time_point start)
+{
+  return std::chrono::duration<double,std::milli>(clock_type::now() - start).count();
+}
+
+int
+main()
+{
+  const size_t count = 100000;
+  const uint64_t ddr = 64ull << 30;
+  const unsigned page = 4096;
+
+  xclemulation::MemoryManager mm(ddr, 0, page);
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<size_t> small(1, 16*1024);
+  std::uniform_int_distribution<size_t> large(64*1024, 4*1024*1024);
+
+  auto random_size = [&]() { return (rng() % 8) ? small(rng) : large(rng); };
+
+  std::vector<uint64_t> bufs;
+  bufs.reserve(count);
+
+  auto start = clock_type::now();
+  for (size_t i=0; i<count; ++i) {
+    size_t sz = random_size();
+    auto addr = mm.alloc(sz);
+    if (addr == xclemulation::MemoryManager::mNull) {
+      std::cout << "allocation " << i << " failed\n";
+      return 1;
+    }
+    bufs.push_back(addr);
+  }
+  std::cout << "alloc " << count << ": " << elapsed_ms(start) << " ms\n";
+
+  start = clock_type::now();
+  std::shuffle(bufs.begin(), bufs.end(), rng);
+  for (size_t i=0; i<count/2; ++i) {
+    mm.lookup(bufs[i]);
+    mm.free(bufs[i]);
+  }
+  for (size_t i=0; i<count/2; ++i) {
+    size_t sz = random_size();
+    bufs[i] = mm.alloc(sz);
+  }
+  std::cout << "free/realloc " << count/2 << ": " << elapsed_ms(start) << " ms\n";
+
+  start = clock_type::now();
+  for (auto addr : bufs)
+    mm.free(addr);
+  std::cout << "free " << count << ": " << elapsed_ms(start) << " ms\n";
+
+  if (mm.freeSize() != ddr) {
+    std::cout << "leaked " << ddr - mm.freeSize() << " bytes\n";
+    return 1;
+  }
+
+  // Fully coalesced, the whole range must be allocatable again
+  size_t sz = ddr;
+  if (mm.alloc(sz) != 0) {
+    std::cout << "free blocks not coalesced\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,211 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "aio.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace {
+
+inline int io_setup(unsigned nr, aio_context_t *ctxp)
+{
+  return syscall(__NR_io_setup, nr, ctxp);
+}
+
+inline int io_destroy(aio_context_t ctx)
+{
+  return syscall(__NR_io_destroy, ctx);
+}
+
+inline int io_submit(aio_context_t ctx, long nr,  struct iocb **iocbpp)
+{
+  return syscall(__NR_io_submit, ctx, nr, iocbpp);
+}
+
+inline int io_getevents(aio_context_t ctx, long min_nr, long max_nr,
+                struct io_event *events, struct timespec *timeout)
+{
+  return syscall(__NR_io_getevents, ctx, min_nr, max_nr, events, timeout);
+}
+
+} // namespace
+
+namespace xocl {
+
+aio_queue::aio_queue(unsigned int nr_events, unsigned int batch)
+    : mContext(0), mBatch(batch)
+{
+    mEnabled = (io_setup(nr_events, &mContext) == 0);
+    mPending.reserve(mBatch);
+}
+
+aio_queue::~aio_queue()
+{
+    if (!mEnabled)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lk(mMutex);
+        flush_locked();
+    }
+    io_destroy(mContext);
+}
+
+/*
+ * flush_locked()
+ *
+ * Requests the kernel did not take, whatever the reason, are moved
+ * to mFailed with the io_submit error.  Caller must hold mMutex.
+ */
+int aio_queue::flush_locked()
+{
+    if (mPending.empty())
+        return 0;
+
+    mSubmit.clear();
+    for (auto& req : mPending) {
+        req.iov[0].iov_base = &req.header;
+        req.iov[0].iov_len = sizeof(req.header);
+        req.cb.aio_buf = (uint64_t)req.iov;
+        mSubmit.push_back(&req.cb);
+    }
+
+    // The driver copies header and iovecs during io_submit, so the
+    // pending requests can be reused as soon as it returns
+    size_t submitted = 0;
+    int err = 0;
+    while (submitted < mSubmit.size()) {
+        int n = io_submit(mContext, mSubmit.size() - submitted,
+            mSubmit.data() + submitted);
+        if (n <= 0) {
+            err = n ? -errno : -EAGAIN;
+            break;
+        }
+        submitted += n;
+    }
+
+    if (submitted < mSubmit.size()) {
+        std::cerr << "ERROR: async stream request submission failed: " << err
+                  << ", " << mSubmit.size() - submitted
+                  << " requests completed with error" << std::endl;
+        for (size_t i = submitted; i < mSubmit.size(); i++)
+            mFailed.push_back({mSubmit[i]->aio_data, err});
+    }
+
+    mPending.clear();
+    return submitted ? submitted : err;
+}
+
+int aio_queue::flush()
+{
+    std::lock_guard<std::mutex> lk(mMutex);
+    return flush_locked();
+}
+
+ssize_t aio_queue::queue(int fd, xclQueueRequest *wr, bool write)
+{
+    ssize_t rc = 0;
+
+    std::lock_guard<std::mutex> lk(mMutex);
+    for (unsigned i = 0; i < wr->buf_num; i++) {
+        if (write && !(wr->flag & XCL_QUEUE_REQ_EOT) && (wr->bufs[i].len & 0xfff)) {
+            std::cerr << "ERROR: write without EOT has to be multiple of 4k" << std::endl;
+            break;
+        }
+
+        mPending.emplace_back();
+        request& req = mPending.back();
+        memset(&req, 0, sizeof(req));
+        req.header.flags = wr->flag;
+        req.iov[1].iov_base = (void *)wr->bufs[i].va;
+        req.iov[1].iov_len = wr->bufs[i].len;
+        req.cb.aio_fildes = fd;
+        req.cb.aio_lio_opcode = write ? IOCB_CMD_PWRITEV : IOCB_CMD_PREADV;
+        req.cb.aio_offset = 0;
+        req.cb.aio_nbytes = 2;
+        req.cb.aio_data = (uint64_t)wr->priv_data;
+        rc++;
+    }
+
+    // Accepted requests that fail submission are reported by poll()
+    if (mPending.size() >= mBatch)
+        flush_locked();
+
+    return rc;
+}
+
+int aio_queue::poll(int min_compl, int max_compl, xclReqCompletion *comps, int timeout)
+{
+    struct timespec time, *ptime = NULL;
+    int nfailed;
+
+    {
+        // Requests still accumulating in a batch would never complete
+        std::lock_guard<std::mutex> lk(mMutex);
+        flush_locked();
+
+        nfailed = std::min<int>(mFailed.size(), max_compl);
+        for (int i = 0; i < nfailed; i++) {
+            comps[i].priv_data = (void *)mFailed[i].data;
+            comps[i].nbytes = 0;
+            comps[i].err_code = mFailed[i].err;
+        }
+        mFailed.erase(mFailed.begin(), mFailed.begin() + nfailed);
+    }
+
+    if (nfailed == max_compl)
+        return nfailed;
+
+    if (timeout > 0) {
+        memset(&time, 0, sizeof(time));
+        time.tv_sec = timeout / 1000;
+        time.tv_nsec = (timeout % 1000) * 1000000;
+        ptime = &time;
+    }
+
+    // io_event is smaller than xclReqCompletion, so the events are read
+    // into the completions array and converted starting from the last
+    struct io_event *events = (struct io_event *)(comps + nfailed);
+    int num_evt = io_getevents(mContext, std::max(0, min_compl - nfailed),
+        max_compl - nfailed, events, ptime);
+    if (num_evt < 0)
+        return nfailed ? nfailed : -errno;
+
+    for (int i = num_evt - 1; i >= 0; i--) {
+        struct io_event ev = events[i];
+        struct xclReqCompletion& comp = comps[nfailed + i];
+        comp.priv_data = (void *)ev.data;
+        if (ev.res < 0) {
+            /* error returned by AIO framework */
+            comp.nbytes = 0;
+            comp.err_code = ev.res;
+        } else {
+            comp.nbytes = ev.res;
+            comp.err_code = ev.res2;
+        }
+    }
+
+    return nfailed + num_evt;
+}
+
+} /* xocl */
@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _XCL_AIO_H_
+#define _XCL_AIO_H_
+
+#include "xrt.h"
+#include "core/pcie/driver/linux/include/qdma_ioctl.h"
+
+#include <linux/aio_abi.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <mutex>
+#include <vector>
+
+namespace xocl {
+
+/*
+ * Asynchronous stream requests of one device
+ *
+ * Requests accumulate until the batch size is reached and are then
+ * submitted with as few io_submit calls as the kernel allows.  A
+ * request that cannot be submitted completes with the io_submit
+ * error and is returned by poll() like any other completion, so
+ * every accepted request completes exactly once.
+ */
+class aio_queue
+{
+public:
+    // batch must be at least 1
+    aio_queue(unsigned int nr_events, unsigned int batch);
+    ~aio_queue();
+
+    aio_queue(const aio_queue&) = delete;
+    aio_queue& operator=(const aio_queue&) = delete;
+
+    // false if the aio context could not be created
+    bool enabled() const { return mEnabled; }
+
+    // Add one request per buffer of wr and submit pending requests once
+    // the batch is reached.  Returns number of buffers accepted.
+    ssize_t queue(int fd, xclQueueRequest *wr, bool write);
+
+    // Submit all pending requests.  Returns number of requests
+    // submitted, or negative errno if the submission failed.
+    int flush();
+
+    // Flush, then return up to max_compl completions, waiting up to
+    // timeout ms (forever if <= 0) for at least min_compl.  Returns
+    // number of completions or negative errno.
+    int poll(int min_compl, int max_compl, xclReqCompletion *comps, int timeout);
+
+private:
+    // The iovec and iocb pointers are fixed up at submission since the
+    // vector may reallocate while requests accumulate.
+    struct request {
+        struct xocl_qdma_req_header header;
+        struct iovec iov[2];
+        struct iocb cb;
+    };
+
+    // Request that failed submission, reported by poll()
+    struct failure {
+        uint64_t data;
+        int err;
+    };
+
+    int flush_locked();
+
+    aio_context_t mContext;
+    bool mEnabled;
+    unsigned int mBatch;
+
+    std::mutex mMutex;
+    std::vector<request> mPending;
+    std::vector<struct iocb *> mSubmit;
+    std::vector<failure> mFailed;
+};
+
+} /* xocl */
+
+#endif
@@ -27,6 +27,8 @@
 #include <unistd.h>
 #include <algorithm>
 #include <mutex>
+#include <atomic>
+#include <thread>
 #include <sys/stat.h>
 #include <sys/file.h>
 #include <poll.h>
@@ -545,14 +547,14 @@ private:
     // ready-for-use boards since xclProbe returns num_user_ready, not the size
     // of the full list.
     std::vector<std::shared_ptr<pcidev::pci_device>> user_list;
-    size_t num_user_ready;
+    size_t num_user_ready = 0;
 
     // Full list of discovered mgmt devices. Index 0 ~ (num_mgmt_ready - 1) are
     // boards ready for use. The rest, if any, are not ready, according to what
     // is indicated by driver's "ready" sysfs entry. Application does not see
     // mgmt devices.
     std::vector<std::shared_ptr<pcidev::pci_device>> mgmt_list;
-    size_t num_mgmt_ready;
+    size_t num_mgmt_ready = 0;
 
     std::mutex lock;
     void rescan_nolock();
@@ -583,6 +585,8 @@ void pci_device_scanner::pci_device_scanner::rescan_nolock()
 
     user_list.clear();
     mgmt_list.clear();
+    num_user_ready = 0;
+    num_mgmt_ready = 0;
 
     dir = opendir(sysfs_root.c_str());
     if(!dir) {
@@ -590,9 +594,31 @@ void pci_device_scanner::pci_device_scanner::rescan_nolock()
         return;
     }
 
+    std::vector<std::string> names;
     while((entry = readdir(dir))) {
-        auto pf = std::make_shared<pcidev::pci_device>(
-            std::string(entry->d_name));
+        if (entry->d_name[0] != '.')
+            names.emplace_back(entry->d_name);
+    }
+    (void) closedir(dir);
+
+    // Probing a PCIE function reads several sysfs entries, so probe all
+    // functions concurrently, but build the lists in directory order.
+    std::vector<std::shared_ptr<pcidev::pci_device>> pfs(names.size());
+    std::atomic<size_t> next(0);
+    auto probe = [&names, &pfs, &next] {
+        for (size_t i = next++; i < names.size(); i = next++)
+            pfs[i] = std::make_shared<pcidev::pci_device>(names[i]);
+    };
+    size_t nthreads = std::min<size_t>(names.size(),
+        std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < nthreads; t++)
+        threads.emplace_back(probe);
+    probe();
+    for (auto& t : threads)
+        t.join();
+
+    for (auto& pf : pfs) {
         if(pf->domain == INVALID_ID)
             continue;
 
@@ -605,8 +631,6 @@ void pci_device_scanner::pci_device_scanner::rescan_nolock()
             list->push_back(pf);
         }
     }
-
-    (void) closedir(dir);
 }
 
 
@@ -21,6 +21,7 @@
 #include "scan.h"
 #include "core/common/message.h"
 #include "core/common/scheduler.h"
+#include "core/common/config_reader.h"
 #include "xclbin.h"
 #include "ert.h"
 
@@ -77,27 +78,6 @@ inline unsigned numClocks(const std::string& name)
     return name.compare(0, 15, "xilinx_adm-pcie", 15) ? 2 : 1;
 }
 
-inline int io_setup(unsigned nr, aio_context_t *ctxp)
-{
-  return syscall(__NR_io_setup, nr, ctxp);
-}
-
-inline int io_destroy(aio_context_t ctx)
-{
-  return syscall(__NR_io_destroy, ctx);
-}
-
-inline int io_submit(aio_context_t ctx, long nr,  struct iocb **iocbpp)
-{
-  return syscall(__NR_io_submit, ctx, nr, iocbpp);
-}
-
-inline int io_getevents(aio_context_t ctx, long min_nr, long max_nr,
-                struct io_event *events, struct timespec *timeout)
-{
-  return syscall(__NR_io_getevents, ctx, min_nr, max_nr, events, timeout);
-}
-
 namespace xocl {
 
 /*
@@ -151,8 +131,8 @@ int shim::dev_init()
 
     (void) xclGetDeviceInfo2(&mDeviceInfo);
 
-    memset(&mAioContext, 0, sizeof(mAioContext));
-    mAioEnabled = (io_setup(SHIM_QDMA_AIO_EVT_MAX, &mAioContext) == 0);
+    mAio.reset(new aio_queue(SHIM_QDMA_AIO_EVT_MAX,
+        std::max(1u, xrt_core::config::get_qdma_aio_batch())));
 
     return 0;
 }
@@ -164,10 +144,7 @@ void shim::dev_fini()
         mStreamHandle = 0;
     }
 
-    if (mAioEnabled) {
-        io_destroy(mAioContext);
-            mAioEnabled = false;
-    }
+    mAio.reset();
 }
 
 /*
@@ -1153,45 +1130,41 @@ int shim::xclFreeQDMABuf(uint64_t buf_hdl)
  */
 int shim::xclPollCompletion(int min_compl, int max_compl, struct xclReqCompletion *comps, int* actual, int timeout /*ms*/)
 {
-    /* TODO: populate actual and timeout args correctly */
-    struct timespec time, *ptime = NULL;
-    int num_evt, i;
+    int num_evt;
 
     *actual = 0;
-    if (!mAioEnabled) {
-        num_evt = -EINVAL;
+    if (!mAio || !mAio->enabled()) {
         std::cout << __func__ << "ERROR: async io is not enabled" << std::endl;
-        goto done;
-    }
-    if (timeout > 0) {
-        memset(&time, 0, sizeof(time));
-        time.tv_sec = timeout / 1000;
-        time.tv_nsec = (timeout % 1000) * 1000000;
-        ptime = &time;
+        return -EINVAL;
     }
 
-    num_evt = io_getevents(mAioContext, min_compl, max_compl, (struct io_event *)comps, ptime);
+    num_evt = mAio->poll(min_compl, max_compl, comps, timeout);
     if (num_evt < min_compl) {
         std::cout << __func__ << " ERROR: failed to poll Queue Completions" << std::endl;
-        goto done;
+        // Completions returned so far are not reported again
+        *actual = std::max(num_evt, 0);
+        return num_evt;
     }
     *actual = num_evt;
 
-    for (i = num_evt - 1; i >= 0; i--) {
-        comps[i].priv_data = (void *)((struct io_event *)comps)[i].data;
-    if (((struct io_event *)comps)[i].res < 0){
-            /* error returned by AIO framework */
-            comps[i].nbytes = 0;
-        comps[i].err_code = ((struct io_event *)comps)[i].res;
-    } else {
-            comps[i].nbytes = ((struct io_event *)comps)[i].res;
-        comps[i].err_code = ((struct io_event *)comps)[i].res2;
-    }
+    return 0;
+}
+
+/*
+ * queueAio()
+ *
+ * Hand nonblocking stream requests to the batching aio queue.
+ *
+ * Returns number of buffers accepted.
+ */
+ssize_t shim::queueAio(uint64_t q_hdl, xclQueueRequest *wr, bool write)
+{
+    if (!mAio || !mAio->enabled()) {
+        std::cout << __func__ << "ERROR: async io is not enabled" << std::endl;
+        return 0;
     }
-    num_evt = 0;
 
-done:
-    return num_evt;
+    return mAio->queue((int)q_hdl, wr, write);
 }
 
 /*
@@ -1201,6 +1174,9 @@ ssize_t shim::xclWriteQueue(uint64_t q_hdl, xclQueueRequest *wr)
 {
     ssize_t rc = 0;
 
+    if (wr->flag & XCL_QUEUE_REQ_NONBLOCKING)
+        return queueAio(q_hdl, wr, true);
+
     for (unsigned i = 0; i < wr->buf_num; i++) {
         void *buf = (void *)wr->bufs[i].va;
         struct iovec iov[2];
@@ -1212,51 +1188,20 @@ ssize_t shim::xclWriteQueue(uint64_t q_hdl, xclQueueRequest *wr)
         iov[1].iov_base = buf;
         iov[1].iov_len = wr->bufs[i].len;
 
-        if (wr->flag & XCL_QUEUE_REQ_NONBLOCKING) {
-            struct iocb cb;
-            struct iocb *cbs[1];
-
-            if (!mAioEnabled) {
-                std::cout << __func__ << "ERROR: async io is not enabled" << std::endl;
-                break;
-            }
-
-            if (!(wr->flag & XCL_QUEUE_REQ_EOT) && (wr->bufs[i].len & 0xfff)) {
-                std::cerr << "ERROR: write without EOT has to be multiple of 4k" << std::endl;
-                break;
-            }
-
-            memset(&cb, 0, sizeof(cb));
-            cb.aio_fildes = (int)q_hdl;
-            cb.aio_lio_opcode = IOCB_CMD_PWRITEV;
-            cb.aio_buf = (uint64_t)iov;
-            cb.aio_offset = 0;
-            cb.aio_nbytes = 2;
-            cb.aio_data = (uint64_t)wr->priv_data;
-
-            cbs[0] = &cb;
-            if (io_submit(mAioContext, 1, cbs) > 0)
-                rc++;
-            else {
-                std::cerr << "ERROR: async write stream failed" << std::endl;
-                break;
-            }
-        } else {
-            if (!(wr->flag & XCL_QUEUE_REQ_EOT) && (wr->bufs[i].len & 0xfff)) {
-                std::cerr << "ERROR: write without EOT has to be multiple of 4k" << std::endl;
-                rc = -EINVAL;
-                break;
-            }
+        if (!(wr->flag & XCL_QUEUE_REQ_EOT) && (wr->bufs[i].len & 0xfff)) {
+            std::cerr << "ERROR: write without EOT has to be multiple of 4k" << std::endl;
+            rc = -EINVAL;
+            break;
+        }
 
-            rc = writev((int)q_hdl, iov, 2);
-            if (rc < 0) {
-                std::cerr << "ERROR: write stream failed: " << rc << std::endl;
-                break;
-            } else if ((size_t)rc != wr->bufs[i].len) {
-                std::cerr << "ERROR: only " << rc << "/" << wr->bufs[i].len;
-                std::cerr << " bytes is written" << std::endl;
-                break;
-            }
+        rc = writev((int)q_hdl, iov, 2);
+        if (rc < 0) {
+            std::cerr << "ERROR: write stream failed: " << rc << std::endl;
+            break;
+        } else if ((size_t)rc != wr->bufs[i].len) {
+            std::cerr << "ERROR: only " << rc << "/" << wr->bufs[i].len;
+            std::cerr << " bytes is written" << std::endl;
+            break;
         }
     }
     return rc;
@@ -1269,6 +1214,9 @@ ssize_t shim::xclReadQueue(uint64_t q_hdl, xclQueueRequest *wr)
 {
     ssize_t rc = 0;
 
+    if (wr->flag & XCL_QUEUE_REQ_NONBLOCKING)
+        return queueAio(q_hdl, wr, false);
+
     for (unsigned i = 0; i < wr->buf_num; i++) {
         void *buf = (void *)wr->bufs[i].va;
         struct iovec iov[2];
@@ -1280,36 +1228,10 @@ ssize_t shim::xclReadQueue(uint64_t q_hdl, xclQueueRequest *wr)
         iov[1].iov_base = buf;
         iov[1].iov_len = wr->bufs[i].len;
 
-        if (wr->flag & XCL_QUEUE_REQ_NONBLOCKING) {
-            struct iocb cb;
-            struct iocb *cbs[1];
-
-            if (!mAioEnabled) {
-                std::cout << __func__ << "ERROR: async io is not enabled" << std::endl;
-                break;
-            }
-
-            memset(&cb, 0, sizeof(cb));
-            cb.aio_fildes = (int)q_hdl;
-            cb.aio_lio_opcode = IOCB_CMD_PREADV;
-            cb.aio_buf = (uint64_t)iov;
-            cb.aio_offset = 0;
-            cb.aio_nbytes = 2;
-            cb.aio_data = (uint64_t)wr->priv_data;
-
-            cbs[0] = &cb;
-            if (io_submit(mAioContext, 1, cbs) > 0)
-                rc++;
-            else {
-                std::cerr << "ERROR: async read stream failed" << std::endl;
-                break;
-            }
-        } else {
-            rc = readv((int)q_hdl, iov, 2);
-            if (rc < 0) {
-                std::cerr << "ERROR: read stream failed: " << rc << std::endl;
-                break;
-            }
+        rc = readv((int)q_hdl, iov, 2);
+        if (rc < 0) {
+            std::cerr << "ERROR: read stream failed: " << rc << std::endl;
+            break;
         }
     }
     return rc;
@@ -23,17 +23,20 @@
  */
 
 #include "scan.h"
+#include "aio.h"
 #include "xclhal2.h"
 #include "core/pcie/driver/linux/include/xocl_ioctl.h"
 #include "core/pcie/driver/linux/include/qdma_ioctl.h"
 
 #include <linux/aio_abi.h>
+#include <sys/uio.h>
 #include <libdrm/drm.h>
 
 #include <mutex>
 #include <fstream>
 #include <list>
 #include <map>
+#include <memory>
 #include <cassert>
 #include <vector>
 
@@ -243,8 +246,9 @@ private:
     uint8_t mStreammonMinorVersions[XSSPM_MAX_NUMBER_SLOTS] = {};
 
     // QDMA AIO
-    aio_context_t mAioContext;
-    bool mAioEnabled;
+    std::unique_ptr<aio_queue> mAio;
+
+    ssize_t queueAio(uint64_t q_hdl, xclQueueRequest *wr, bool write);
 }; /* shim */
 
 } /* xocl */
@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Exercise the shim's batching of nonblocking stream requests
+// (xocl::aio_queue behind xclWriteQueue/xclPollCompletion) and compare
+// one io_submit per buffer with one io_submit per Runtime.qdma_aio_batch
+// buffers.
+//
+// A regular file stands in for the QDMA queue fd, each request is a
+// PWRITEV of a request header and a small packet just like the shim.
+// Requests on a read-only fd fail submission and must complete with
+// an error.
+//
+//   g++ -std=c++14 -O2 -I../../../.. -I../../../include -o aio_batch main.cpp ../../linux/aio.cpp
+//   ./aio_batch [packets] [packet_size] [batch] [file]
+
+#include "core/pcie/linux/aio.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using clock_type = std::chrono::high_resolution_clock;
+
+// Reap completions until all of count are back, check each once
+void
+reap(xocl::aio_queue& aio, std::vector<int>& seen, size_t count, int expect_err)
+{
+  std::vector<xclReqCompletion> comps(count);
+  for (size_t reaped = 0; reaped < count; ) {
+    int n = aio.poll(1, count - reaped, comps.data(), 1000);
+    if (n <= 0)
+      throw std::runtime_error("poll failed: " + std::to_string(n));
+    for (int i = 0; i < n; ++i) {
+      auto idx = (uintptr_t)comps[i].priv_data;
+      if (idx >= seen.size() || seen[idx]++)
+        throw std::runtime_error("unexpected completion " + std::to_string(idx));
+      if (comps[i].err_code != expect_err)
+        throw std::runtime_error("completion " + std::to_string(idx) + " error "
+                                 + std::to_string(comps[i].err_code));
+    }
+    reaped += n;
+  }
+}
+
+// Queue packets requests, one buffer each, reaping every batch
+double
+run(int fd, std::vector<char>& packet, size_t packets, unsigned int batch, int expect_err)
+{
+  xocl::aio_queue aio(batch, batch);
+  if (!aio.enabled())
+    throw std::runtime_error("io_setup failed");
+
+  std::vector<int> seen(packets, 0);
+  xclReqBuffer buf = {};
+  buf.buf = packet.data();
+  buf.len = packet.size();
+
+  auto start = clock_type::now();
+  for (size_t done = 0; done < packets; ) {
+    size_t n = std::min<size_t>(batch, packets - done);
+    for (size_t i = 0; i < n; ++i) {
+      xclQueueRequest wr = {};
+      wr.op_code = XCL_QUEUE_WRITE;
+      wr.bufs = &buf;
+      wr.buf_num = 1;
+      wr.flag = XCL_QUEUE_REQ_EOT | XCL_QUEUE_REQ_NONBLOCKING;
+      wr.priv_data = (void *)(uintptr_t)(done + i);
+      if (aio.queue(fd, &wr, true) != 1)
+        throw std::runtime_error("request not accepted");
+    }
+    reap(aio, seen, n, expect_err);
+    done += n;
+  }
+  auto end = clock_type::now();
+
+  auto usec = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  return usec ? packets * 1000000.0 / usec : 0;
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+  try {
+    size_t packets = (argc > 1) ? std::stoul(argv[1]) : 100000;
+    size_t packet_size = (argc > 2) ? std::stoul(argv[2]) : 64;
+    unsigned int batch = (argc > 3) ? std::stoul(argv[3]) : 64;
+    std::string fnm = (argc > 4) ? argv[4] : "/tmp/aio_batch.dat";
+
+    if (batch == 0)
+      throw std::invalid_argument("batch must be at least 1");
+
+    int fd = open(fnm.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      throw std::runtime_error("failed to open " + fnm);
+    int rdfd = open(fnm.c_str(), O_RDONLY);
+    if (rdfd < 0)
+      throw std::runtime_error("failed to open " + fnm);
+
+    std::vector<char> packet(packet_size, 'x');
+    auto single = run(fd, packet, packets, 1, 0);
+    auto batched = run(fd, packet, packets, batch, 0);
+
+    // Every request that cannot be submitted completes with the error
+    run(rdfd, packet, batch * 2 + 1, batch, -EBADF);
+
+    std::cout << "packets: " << packets << " x " << packet_size << " bytes\n";
+    std::cout << "io_submit per packet:          " << single << " packets/sec\n";
+    std::cout << "io_submit per " << batch << " packets: " << batched << " packets/sec\n";
+
+    close(rdfd);
+    close(fd);
+    unlink(fnm.c_str());
+    std::cout << "TEST SUCCESS\n";
+    return 0;
+  }
+  catch (const std::exception& ex) {
+    std::cout << "TEST FAILED: " << ex.what() << "\n";
+  }
+  return 1;
+}
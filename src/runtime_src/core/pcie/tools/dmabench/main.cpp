@@ -0,0 +1,196 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+////////////////////////////////////////////////////////////////
+// Standalone DMA benchmark, same sweep as 'xbutil dmabench'.
+// Links against the hardware shim or one of the emulation shims,
+// the memory banks are taken from the xclbin given with -k or
+// else from the xclbin already loaded on the device.
+//
+//  % xbdmabench [-d index] [-k xclbin] [-s sizes] [-t threads]
+//               [-m banks] [-n bytes] [-x] [-j json_file]
+////////////////////////////////////////////////////////////////
+#include "core/pcie/common/dmabench.h"
+
+#include <boost/property_tree/json_parser.hpp>
+
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+
+namespace {
+
+// mem_topology of xclbin file
+static std::vector<char>
+topology_from_xclbin(const std::vector<char>& xclbin)
+{
+  auto top = reinterpret_cast<const axlf*>(xclbin.data());
+  if (xclbin.size() < sizeof(axlf) || std::strncmp(top->m_magic, "xclbin2", 8))
+    throw std::runtime_error("not a valid xclbin");
+  auto hdr = xclbin::get_axlf_section(top, MEM_TOPOLOGY);
+  if (!hdr)
+    throw std::runtime_error("xclbin has no mem_topology");
+  auto begin = xclbin.data() + hdr->m_sectionOffset;
+  return std::vector<char>(begin, begin + hdr->m_sectionSize);
+}
+
+// mem_topology of loaded xclbin, one entry at a time
+static std::vector<char>
+topology_from_device(xclDeviceHandle handle)
+{
+  std::vector<mem_data> entries;
+  mem_data entry;
+  size_t size = sizeof(entry);
+  while (!xclGetSectionInfo(handle, &entry, &size, MEM_TOPOLOGY, entries.size()))
+    entries.push_back(entry);
+  if (entries.empty())
+    throw std::runtime_error("no mem_topology, load an xclbin or use -k");
+
+  std::vector<char> buf(offsetof(mem_topology, m_mem_data) + entries.size() * sizeof(mem_data));
+  auto topology = reinterpret_cast<mem_topology*>(buf.data());
+  topology->m_count = entries.size();
+  std::copy(entries.begin(), entries.end(), topology->m_mem_data);
+  return buf;
+}
+
+static std::vector<char>
+read_file(const std::string& fnm)
+{
+  std::ifstream stream(fnm, std::ios::binary);
+  if (!stream)
+    throw std::runtime_error("could not open " + fnm);
+  return std::vector<char>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+static void
+usage()
+{
+  std::cout << "usage: xbdmabench [-d index] [-k xclbin] " << xcldev::DMABench::usage() << "\n";
+  std::cout << "  -s  comma separated transfer sizes, K/M/G suffix allowed\n";
+  std::cout << "  -t  comma separated thread counts\n";
+  std::cout << "  -m  comma separated mem_topology bank indices, default all\n";
+  std::cout << "  -n  minimum bytes per point and direction\n";
+  std::cout << "  -x  skip data verification\n";
+  std::cout << "  -j  write JSON results to file, '-' for stdout\n";
+}
+
+static int
+run(int argc, char** argv)
+{
+  unsigned index = 0;
+  std::string xclbin;
+  std::string json;
+  xcldev::DMABench::config config;
+  const std::string short_options = std::string("d:k:j:h") + xcldev::DMABench::options();
+
+  int c;
+  while ((c = getopt(argc, argv, short_options.c_str())) != -1) {
+    switch (c) {
+    case 'd':
+      index = std::stoul(optarg);
+      break;
+    case 'k':
+      xclbin = optarg;
+      break;
+    case 'j':
+      json = optarg;
+      break;
+    case 'h':
+      usage();
+      return 0;
+    default:
+      if (xcldev::DMABench::parseOption(c, optarg, config) != 1) {
+        usage();
+        return 1;
+      }
+    }
+  }
+  if (optind != argc) {
+    usage();
+    return 1;
+  }
+
+  if (index >= xclProbe())
+    throw std::runtime_error("device index " + std::to_string(index) + " not found");
+  auto handle = xclOpen(index, nullptr, XCL_QUIET);
+  if (!handle)
+    throw std::runtime_error("could not open device " + std::to_string(index));
+
+  int ret = 0;
+  try {
+    std::vector<char> topology;
+    if (!xclbin.empty()) {
+      auto data = read_file(xclbin);
+      topology = topology_from_xclbin(data);
+      if (xclLockDevice(handle) || xclLoadXclBin(handle, reinterpret_cast<const axlf*>(data.data())))
+        throw std::runtime_error("could not load " + xclbin);
+    }
+    else {
+      topology = topology_from_device(handle);
+    }
+
+    xcldev::DMABench bench(handle, config);
+    auto banks = bench.getBanks(reinterpret_cast<const mem_topology*>(topology.data()));
+    if (banks.empty())
+      throw std::runtime_error("no memory bank available for DMA");
+
+    std::vector<xcldev::DMABench::result> results;
+    xcldev::DMABench::printHeader(std::cout);
+    for (auto& bank : banks) {
+      int err = bench.run(bank, results);
+      if (err && !ret)
+        ret = err;
+    }
+
+    if (!json.empty()) {
+      boost::property_tree::ptree root;
+      root.put("device", index);
+      if (!xclbin.empty())
+        root.put("xclbin", xclbin);
+      root.add_child("results", xcldev::DMABench::toPtree(results));
+      if (json == "-")
+        boost::property_tree::json_parser::write_json(std::cout, root);
+      else
+        boost::property_tree::json_parser::write_json(json, root);
+    }
+  }
+  catch (...) {
+    xclClose(handle);
+    throw;
+  }
+
+  xclClose(handle);
+  return ret ? 1 : 0;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  try {
+    return run(argc, argv);
+  }
+  catch (const std::exception& ex) {
+    std::cerr << "xbdmabench: " << ex.what() << "\n";
+  }
+  return 1;
+}
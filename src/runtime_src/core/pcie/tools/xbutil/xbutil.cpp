@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <getopt.h>
 #include <sys/mman.h>
+#include <boost/property_tree/json_parser.hpp>
 
 #include "xbutil.h"
 #include "base.h"
@@ -126,6 +127,7 @@ int main(int argc, char *argv[])
     std::string mcsFile1, mcsFile2;
     std::string xclbin;
     size_t blockSize = 0;
+    xcldev::memtransfer::options xferOpts;
     int c;
     dd::ddArgs_t ddArgs;
 
@@ -170,6 +172,8 @@ int main(int argc, char *argv[])
         return xcldev::xclReset(argc, argv);
     } else if( std::strcmp( argv[1], "p2p" ) == 0 ) {
         return xcldev::xclP2p(argc, argv);
+    } else if( std::strcmp( argv[1], "dmabench" ) == 0 ) {
+        return xcldev::xclDmaBench(argc, argv);
     }
     optind--;
 
@@ -205,6 +209,7 @@ int main(int argc, char *argv[])
         {"monitorfifofull", no_argument, 0, xcldev::STATUS_UNSUPPORTED},
         {"accelmonitor", no_argument, 0, xcldev::STATUS_UNSUPPORTED},
         {"stream", no_argument, 0, xcldev::STREAM},
+        {"depth", required_argument, 0, xcldev::MEM_DEPTH},
         {0, 0, 0, 0}
     };
 
@@ -286,6 +291,20 @@ int main(int argc, char *argv[])
             subcmd = xcldev::STREAM;
             break;
         }
+        case xcldev::MEM_DEPTH: {
+            //--depth
+            if (cmd != xcldev::MEM) {
+                std::cout << "ERROR: Option '" << long_options[long_index].name << "' cannot be used with command " << cmdname << "\n";
+                return -1;
+            }
+            int depth = std::atoi(optarg);
+            if (depth < 2) {
+                std::cout << "ERROR: Value supplied to --depth option must be at least 2\n";
+                return -1;
+            }
+            xferOpts.depth = depth;
+            break;
+        }
         //short options are dealt here
         case 'a':{
             if (cmd != xcldev::MEM) {
@@ -419,8 +438,8 @@ int main(int argc, char *argv[])
             break;
         case 'b':
         {
-            if (cmd != xcldev::DMATEST) {
-                std::cout << "ERROR: '-b' only allowed with 'dmatest' command\n";
+            if (cmd != xcldev::DMATEST && cmd != xcldev::MEM) {
+                std::cout << "ERROR: '-b' only allowed with 'dmatest' and 'mem' commands\n";
                 return -1;
             }
             std::string tmp(optarg);
@@ -575,10 +594,11 @@ int main(int argc, char *argv[])
         result = deviceVec[index]->dmatest(blockSize, true);
         break;
     case xcldev::MEM:
+        xferOpts.block_size = blockSize;
         if (subcmd == xcldev::MEM_READ) {
-            result = deviceVec[index]->memread(outMemReadFile, startAddr, sizeInBytes);
+            result = deviceVec[index]->memread(outMemReadFile, startAddr, sizeInBytes, xferOpts);
         } else if (subcmd == xcldev::MEM_WRITE) {
-            result = deviceVec[index]->memwrite(startAddr, sizeInBytes, pattern_byte);
+            result = deviceVec[index]->memwrite(startAddr, sizeInBytes, pattern_byte, xferOpts);
         }
         break;
     case xcldev::DD:
@@ -629,11 +649,12 @@ void xcldev::printHelp(const std::string& exe)
     std::cout << "Command and option summary:\n";
     std::cout << "  clock   [-d card] [-r region] [-f clock1_freq_MHz] [-g clock2_freq_MHz] [-h clock3_freq_MHz]\n";
     std::cout << "  dmatest [-d card] [-b [0x]block_size_KB]\n";
+    std::cout << "  dmabench [-d card] " << xcldev::DMABench::usage() << "\n";
     std::cout << "  dump\n";
     std::cout << "  help\n";
     std::cout << "  m2mtest\n";
-    std::cout << "  mem --read [-d card] [-a [0x]start_addr] [-i size_bytes] [-o output filename]\n";
-    std::cout << "  mem --write [-d card] [-a [0x]start_addr] [-i size_bytes] [-e pattern_byte]\n";
+    std::cout << "  mem --read [-d card] [-a [0x]start_addr] [-i size_bytes] [-o output filename] [-b [0x]block_size_KB] [--depth blocks]\n";
+    std::cout << "  mem --write [-d card] [-a [0x]start_addr] [-i size_bytes] [-e pattern_byte] [-b [0x]block_size_KB] [--depth blocks]\n";
     std::cout << "  program [-d card] [-r region] -p xclbin\n";
     std::cout << "  query   [-d card [-r region]]\n";
     std::cout << "  status [-d card] [--debug_ip_name]\n";
@@ -660,12 +681,16 @@ void xcldev::printHelp(const std::string& exe)
     std::cout << "  " << exe << " program -d 2 -p a.xclbin\n";
     std::cout << "Run DMA test on card 1 with 32 KB blocks of buffer\n";
     std::cout << "  " << exe << " dmatest -d 1 -b 0x2000\n";
+    std::cout << "Sweep 64 KB and 2 MB DMA with 1 and 4 threads on card 0, save results as JSON\n";
+    std::cout << "  " << exe << " dmabench -s 64K,2M -t 1,4 -j dmabench.json\n";
     std::cout << "Read 256 bytes from DDR starting at 0x1000 into file read.out\n";
     std::cout << "  " << exe << " mem --read -a 0x1000 -i 256 -o read.out\n";
     std::cout << "  " << "Default values for address is 0x0, size is DDR size and file is memread.out\n";
     std::cout << "Write 256 bytes to DDR starting at 0x1000 with byte 0xaa \n";
     std::cout << "  " << exe << " mem --write -a 0x1000 -i 256 -e 0xaa\n";
     std::cout << "  " << "Default values for address is 0x0, size is DDR size and pattern is 0x0\n";
+    std::cout << "Dump 1 GB from DDR starting at 0x0 into file dump.bin with 4 MB transfers, 8 in flight\n";
+    std::cout << "  " << exe << " mem --read -i 0x40000000 -o dump.bin -b 0x1000 --depth 8\n";
     std::cout << "List the debug IPs available on the platform\n";
     std::cout << "  " << exe << " status \n";
     std::cout << "Validate installation on card 1\n";
@@ -1647,3 +1672,102 @@ int xcldev::device::testM2m()
     }
     return ret;
 }
+
+/*
+ * dmabench
+ */
+int xcldev::device::dmaBench(const DMABench::config& config, const std::string& jsonFile)
+{
+    std::string errmsg;
+    std::vector<char> buf;
+
+    pcidev::get_dev(m_idx)->sysfs_get("icap", "mem_topology", errmsg, buf);
+    if (!errmsg.empty()) {
+        std::cout << errmsg << std::endl;
+        return -EINVAL;
+    }
+    const mem_topology *map = (mem_topology *)buf.data();
+    if (buf.empty() || map->m_count == 0) {
+        std::cout << "WARNING: 'mem_topology' invalid, "
+            << "unable to perform DMA benchmark. Has the bitstream been loaded? "
+            << "See 'xbutil program'." << std::endl;
+        return -EINVAL;
+    }
+
+    DMABench bench(m_handle, config);
+    auto banks = bench.getBanks(map);
+    if (banks.empty()) {
+        std::cout << "ERROR: No memory bank available for DMA benchmark" << std::endl;
+        return -EINVAL;
+    }
+
+    int ret = 0;
+    std::vector<DMABench::result> results;
+    DMABench::printHeader(std::cout);
+    for (auto& bank : banks) {
+        int err = bench.run(bank, results);
+        if (err && !ret)
+            ret = err;
+    }
+
+    if (!jsonFile.empty()) {
+        boost::property_tree::ptree root, os_pt, xrt_pt;
+        osInfo(os_pt);
+        xrtInfo(xrt_pt);
+        root.add_child("system", os_pt);
+        root.add_child("runtime", xrt_pt);
+        root.put("device", name());
+        root.add_child("results", DMABench::toPtree(results));
+        try {
+            if (jsonFile == "-")
+                boost::property_tree::json_parser::write_json(std::cout, root);
+            else
+                boost::property_tree::json_parser::write_json(jsonFile, root);
+        }
+        catch (const std::exception& ex) {
+            std::cout << "ERROR: " << ex.what() << std::endl;
+            return -EIO;
+        }
+    }
+    return ret;
+}
+
+int xcldev::xclDmaBench(int argc, char *argv[])
+{
+    int c;
+    unsigned index = 0;
+    std::string jsonFile;
+    DMABench::config config;
+    const std::string usage = std::string("Options: [-d index] ") + DMABench::usage();
+    const std::string short_options = std::string("d:j:") + DMABench::options();
+
+    while ((c = getopt(argc, argv, short_options.c_str())) != -1) {
+        switch (c) {
+        case 'd': {
+            int ret = str2index(optarg, index);
+            if (ret != 0)
+                return ret;
+            break;
+        }
+        case 'j':
+            jsonFile = optarg;
+            break;
+        default:
+            if (DMABench::parseOption(c, optarg, config) != 1) {
+                std::cerr << usage << std::endl;
+                return -EINVAL;
+            }
+            break;
+        }
+    }
+    if (optind != argc) {
+        std::cerr << usage << std::endl;
+        return -EINVAL;
+    }
+
+    std::unique_ptr<device> d = xclGetDevice(index);
+    if (!d)
+        return -EINVAL;
+
+    return d->dmaBench(config, jsonFile);
+}
@@ -30,6 +30,7 @@
 #include "xclperf.h"
 #include "xcl_axi_checker_codes.h"
 #include "core/pcie/common/dmatest.h"
+#include "core/pcie/common/dmabench.h"
 #include "core/pcie/common/memaccess.h"
 #include "core/pcie/common/dd.h"
 #include "core/pcie/common/utils.h"
@@ -87,6 +88,7 @@ enum subcommand {
     STATUS_SPC,
     STREAM,
     STATUS_UNSUPPORTED,
+    MEM_DEPTH,
 };
 enum statusmask {
     STATUS_NONE_MASK = 0x0,
@@ -1226,7 +1228,8 @@ public:
         return result;
     }
 
-    int memread(std::string aFilename, unsigned long long aStartAddr = 0, unsigned long long aSize = 0) {
+    int memread(std::string aFilename, unsigned long long aStartAddr = 0, unsigned long long aSize = 0,
+                const memtransfer::options& aXferOpts = memtransfer::options()) {
         std::ios_base::fmtflags f(std::cout.flags());
         if (strstr(m_devinfo.mName, "-xare")) {//This is ARE device
           if (aStartAddr > m_devinfo.mDDRSize) {
@@ -1241,7 +1244,7 @@ public:
         std::cout.flags(f);
 
         return memaccess(m_handle, m_devinfo.mDDRSize, m_devinfo.mDataAlignment,
-            pcidev::get_dev(m_idx)->sysfs_name).read(
+            pcidev::get_dev(m_idx)->sysfs_name, aXferOpts).read(
             aFilename, aStartAddr, aSize);
     }
 
@@ -1258,7 +1261,8 @@ public:
             aStartAddr, aSize, aPattern, checks);
     }
 
-    int memwrite(unsigned long long aStartAddr, unsigned long long aSize, unsigned int aPattern = 'J') {
+    int memwrite(unsigned long long aStartAddr, unsigned long long aSize, unsigned int aPattern = 'J',
+                 const memtransfer::options& aXferOpts = memtransfer::options()) {
         std::ios_base::fmtflags f(std::cout.flags());
         if (strstr(m_devinfo.mName, "-xare")) {//This is ARE device
             if (aStartAddr > m_devinfo.mDDRSize) {
@@ -1272,7 +1276,7 @@ public:
         }
         std::cout.flags(f);
         return memaccess(m_handle, m_devinfo.mDDRSize, m_devinfo.mDataAlignment,
-            pcidev::get_dev(m_idx)->sysfs_name).write(
+            pcidev::get_dev(m_idx)->sysfs_name, aXferOpts).write(
             aStartAddr, aSize, aPattern);
     }
 
@@ -1331,6 +1335,8 @@ public:
      *           REQUIRED for deviceToFile
      * --skip : specify the source offset (in block counts) OPTIONAL defaults to 0
      * --seek : specify the destination offset (in block counts) OPTIONAL defaults to 0
+     * --depth : specify the number of blocks in flight OPTIONAL
+     * --direct : use O_DIRECT for file I/O OPTIONAL
      */
     int do_dd(dd::ddArgs_t args )
     {
@@ -1339,55 +1345,35 @@ public:
         }
         if( args.dir == dd::unset ) {
             return -1; // direction invalid
-        } else if( args.dir == dd::deviceToFile ) {
-            unsigned long long addr = args.skip; // ddr read offset
-            while( args.count-- > 0 ) { // writes all full blocks
-                memread( args.file, addr, args.blockSize ); // returns 0 on complete read.
-                // how to check for partial reads when device is empty?
-                addr += args.blockSize;
-            }
-        } else if( args.dir == dd::fileToDevice ) {
-            // write entire contents of file to device DDR at seek offset.
-            unsigned long long addr = args.seek; // ddr write offset
-            std::ifstream iStream( args.file.c_str(), std::ifstream::binary );
-            if( !iStream ) {
-                perror( "open input file" );
-                return errno;
-            }
-            // If unspecified count, calculate the count from the full file size.
-            if( args.count <= 0 ) {
-                iStream.seekg( 0, iStream.end );
-                int length = iStream.tellg();
-                args.count = length / args.blockSize + 1; // round up
-                iStream.seekg( 0, iStream.beg );
-            }
-            iStream.seekg( 0, iStream.beg );
-
-            char *buf;
-            static char *inBuf;
-            size_t inSize;
+        }
+        if( args.blockSize <= 0 ) {
+            args.blockSize = dd::defaultBS;
+        }
 
-            inBuf = (char*)malloc( args.blockSize );
-            if( !inBuf ) {
-                perror( "malloc block size" );
-                return errno;
-            }
+        // Each block is one transfer of the pipeline
+        memtransfer::options opts;
+        opts.block_size = args.blockSize;
+        if( args.depth > 0 ) {
+            opts.depth = args.depth;
+        }
+        opts.direct = args.direct;
+        memaccess mem(m_handle, m_devinfo.mDDRSize, m_devinfo.mDataAlignment,
+            pcidev::get_dev(m_idx)->sysfs_name, opts);
 
-            while( args.count-- > 0 ) { // writes all full blocks
-                buf = inBuf;
-                inSize = iStream.read( inBuf, args.blockSize ).gcount();
-                if( (int)inSize == args.blockSize ) {
-                    // full read
-                } else {
-                    // Partial read--write size specified greater than read size. Writing remainder of input file.
-                    args.count = 0; // force break
-                }
-                memwrite( addr, inSize, buf );
-                addr += inSize;
+        if( args.dir == dd::deviceToFile ) {
+            if( args.count <= 0 ) {
+                return -1; // count is required, a size of 0 means all of DDR to memaccess
             }
-            iStream.close();
+            unsigned long long addr = args.skip > 0 ? args.skip : 0; // ddr read offset
+            unsigned long long size = (unsigned long long)args.count * args.blockSize;
+            return mem.read( args.file, addr, size, true );
         }
-        return 0;
+
+        // write contents of file to device DDR at seek offset, the
+        // entire file if count is unspecified
+        unsigned long long addr = args.seek > 0 ? args.seek : 0; // ddr write offset
+        unsigned long long size = args.count > 0 ? (unsigned long long)args.count * args.blockSize : 0;
+        return mem.load( args.file, 0, addr, size );
     }
 
     int usageInfo(xclDeviceUsage& devstat) const {
@@ -1404,6 +1390,7 @@ public:
     int setP2p(bool enable, bool force);
     int testP2p(void);
     int testM2m(void);
+    int dmaBench(const DMABench::config& config, const std::string& jsonFile);
 
 private:
     // Run a test case as <exe> <xclbin> [-d index] on this device and collect
@@ -1425,6 +1412,7 @@ int xclReset(int argc, char *argv[]);
 int xclValidate(int argc, char *argv[]);
 std::unique_ptr<xcldev::device> xclGetDevice(unsigned index);
 int xclP2p(int argc, char *argv[]);
+int xclDmaBench(int argc, char *argv[]);
 } // end namespace xcldev
 
 #endif /* XBUTIL_H */
@@ -1103,6 +1103,9 @@ namespace awsbwhal {
 
 xclDeviceHandle xclOpen(unsigned deviceIndex, const char *logFileName, xclVerbosityLevel level)
 {
+    // Devices may be opened concurrently, the rescan below rebuilds the
+    // global device list that every open reads
+    std::lock_guard<std::mutex> lock(awsbwhal::deviceListMutex);
     if(xcldev::pci_device_scanner::device_list.size() <= deviceIndex) {
         printf("Cannot find index %d \n", deviceIndex);
         return nullptr;
@@ -114,9 +114,9 @@ namespace xdp {
       DeviceKernelWriteSummaryStats[name].log(size, duration, bitWidth, clockFreqMhz);
   }
 
-  void ProfileCounters::logFunctionCallStart(const std::string& functionName, double timePoint)
+  void ProfileCounters::logFunctionCallStart(const std::string& functionName, double timePoint,
+                                             std::thread::id threadId)
   {
-    auto threadId = std::this_thread::get_id() ;
     auto key      = std::make_pair(functionName, threadId) ;
     auto value    = std::make_pair(timePoint, (double)0.0) ;
 
@@ -132,9 +132,9 @@ namespace xdp {
     }
   }
 
-  void ProfileCounters::logFunctionCallEnd(const std::string& functionName, double timePoint)
+  void ProfileCounters::logFunctionCallEnd(const std::string& functionName, double timePoint,
+                                           std::thread::id threadId)
   {
-    auto threadId = std::this_thread::get_id() ;
     auto key = std::make_pair(functionName, threadId) ;
 
     CallCount[key].back().second = timePoint ;
@@ -25,6 +25,7 @@
 #include <map>
 #include <list>
 #include <string>
+#include <thread>
 
 // Use this class to build run time user services functions
 // such as debugging and profiling
@@ -77,8 +78,10 @@ namespace xdp {
     void logDeviceKernel(size_t size, double duration);
     void logDeviceKernelTransfer(std::string& deviceName, std::string& kernelName, size_t size, double duration,
                                  uint32_t bitWidth, double clockFreqMhz, bool isRead);
-    void logFunctionCallStart(const std::string& functionName, double timePoint);
-    void logFunctionCallEnd(const std::string& functionName, double timePoint);
+    void logFunctionCallStart(const std::string& functionName, double timePoint,
+                              std::thread::id threadId = std::this_thread::get_id());
+    void logFunctionCallEnd(const std::string& functionName, double timePoint,
+                            std::thread::id threadId = std::this_thread::get_id());
     void logKernelExecutionStart(const std::string& kernelName, const std::string& deviceName, double timePoint);
     void logKernelExecutionEnd(const std::string& kernelName, const std::string& deviceName, double timePoint);
     void logComputeUnitDeviceStart(const std::string& deviceName, double timePoint);
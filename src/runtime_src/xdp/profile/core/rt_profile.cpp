@@ -226,6 +226,7 @@ namespace xdp {
     if (!isApplicationProfileOn())
       return;
 
+    mLogger->flush();
     mWriter->writeProfileSummary(this);
   }
 
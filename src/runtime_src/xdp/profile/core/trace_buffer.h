@@ -0,0 +1,164 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __XDP_CORE_TRACE_BUFFER_H
+#define __XDP_CORE_TRACE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace xdp {
+
+  // **************************************************************************
+  // Fixed size record of a host function call start or end
+  // **************************************************************************
+  struct FunctionCallRecord {
+    double timeStamp;
+    long long queueAddress;
+    std::thread::id threadId;
+    uint32_t nameId;
+    uint32_t functionID;
+    bool isStart;
+  };
+
+  // **************************************************************************
+  // Lock-free single producer single consumer ring of function call records.
+  // The producer is the API thread owning the ring, the consumer is whoever
+  // holds the trace logger drain lock.
+  // **************************************************************************
+  class FunctionCallRing {
+  public:
+    static const size_t CAPACITY = 1024;
+
+  public:
+    // Return false if the ring is full
+    bool push(const FunctionCallRecord& record)
+    {
+      auto tail = mTail.load(std::memory_order_relaxed);
+      if (tail - mHead.load(std::memory_order_acquire) == CAPACITY)
+        return false;
+      mRecords[tail % CAPACITY] = record;
+      mTail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    // True if more than half of the ring is in use, producer only
+    bool isHalfFull() const
+    {
+      return (mTail.load(std::memory_order_relaxed)
+              - mHead.load(std::memory_order_relaxed)) > CAPACITY / 2;
+    }
+
+    // Pop all published records, return number of records popped
+    template <typename Callable>
+    size_t drain(Callable&& fn)
+    {
+      auto head = mHead.load(std::memory_order_relaxed);
+      auto tail = mTail.load(std::memory_order_acquire);
+      for (auto idx = head; idx != tail; ++idx)
+        fn(mRecords[idx % CAPACITY]);
+      mHead.store(tail, std::memory_order_release);
+      return tail - head;
+    }
+
+    // Producer brackets taking the timestamp of a record and pushing it
+    // with beginPush/setPendingTime/endPush.  The consumer must not emit
+    // records later than pendingTime() before draining the ring again,
+    // since a record with that timestamp may not be published yet.
+    void beginPush()
+    {
+      mPendingTime.store(0.0);
+    }
+
+    void setPendingTime(double timeStamp)
+    {
+      mPendingTime.store(timeStamp);
+    }
+
+    void endPush()
+    {
+      mPendingTime.store(std::numeric_limits<double>::max());
+    }
+
+    double pendingTime() const
+    {
+      return mPendingTime.load();
+    }
+
+    // Called by the producer when it will push no more records
+    void detach()
+    {
+      mDetached.store(true, std::memory_order_release);
+    }
+
+    // True once the producer has detached, all its records are then
+    // visible to the consumer
+    bool isDetached() const
+    {
+      return mDetached.load(std::memory_order_acquire);
+    }
+
+  private:
+    // Consumer and producer indices on separate cache lines
+    std::atomic<size_t> mHead{0};
+    char mPad0[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> mTail{0};
+    char mPad1[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<bool> mDetached{false};
+    std::atomic<double> mPendingTime{std::numeric_limits<double>::max()};
+    std::array<FunctionCallRecord, CAPACITY> mRecords;
+  };
+
+  // **************************************************************************
+  // Interned strings, ids and string references are stable for the
+  // lifetime of the table
+  // **************************************************************************
+  class StringTable {
+  public:
+    uint32_t intern(const char* str)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      auto itr = mIds.find(str);
+      if (itr != mIds.end())
+        return itr->second;
+      uint32_t id = mStrings.size();
+      mStrings.emplace_back(str);
+      mIds.emplace(mStrings.back(), id);
+      return id;
+    }
+
+    const std::string& lookup(uint32_t id) const
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      return mStrings.at(id);
+    }
+
+  private:
+    mutable std::mutex mMutex;
+    std::deque<std::string> mStrings;
+    std::unordered_map<std::string, uint32_t> mIds;
+  };
+
+} // xdp
+
+#endif
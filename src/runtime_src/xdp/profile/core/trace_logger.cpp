@@ -22,6 +22,7 @@
 #include "xdp/profile/device/trace_parser.h"
 #include "xdp/profile/writer/base_profile.h"
 #include "xdp/profile/writer/base_trace.h"
+#include "xrt/util/config_reader.h"
 
 #include <iostream>
 #include <sstream>
@@ -30,6 +31,29 @@
 #include <algorithm>
 #include <ctime>
 #include <cassert>
+#include <chrono>
+#include <unordered_map>
+
+namespace {
+
+  // Per thread state of buffered function call capture.  The ring is
+  // shared with the logger that created it, identified by instance id.
+  struct ThreadCapture {
+    uint32_t instanceId = 0;
+    std::shared_ptr<xdp::FunctionCallRing> ring;
+    std::unordered_map<const char*, std::pair<uint32_t, const std::string*>> names;
+
+    ~ThreadCapture()
+    {
+      if (ring)
+        ring->detach();
+    }
+  };
+
+  thread_local ThreadCapture tCapture;
+  std::atomic<uint32_t> sInstanceCount{0};
+
+} // namespace
 
 namespace xdp {
   // ************************
@@ -44,10 +68,25 @@ namespace xdp {
     mTraceParserHandle(TraceParserHandle),
     mPluginHandle(Plugin)
   {
+    mBufferedCapture = xrt_core::config::get_profile_buffered_capture();
+    if (mBufferedCapture) {
+      mInstanceId = ++sInstanceCount;
+      mDrainThread = std::thread(&TraceLogger::drainLoop, this);
+    }
   }
 
   TraceLogger::~TraceLogger()
   {
+    if (mBufferedCapture) {
+      {
+        std::lock_guard<std::mutex> lock(mDrainWaitMutex);
+        mDrainStop = true;
+      }
+      mDrainCond.notify_one();
+      mDrainThread.join();
+      drainFunctionCalls(true);
+    }
+
     mKernelTraceMap.clear();
     mBufferTraceMap.clear();
     mDeviceTraceMap.clear();
@@ -84,6 +123,9 @@ namespace xdp {
   // Detach new trace writer
   void TraceLogger::detach(TraceWriterI* writer)
   {
+    // Writer must see all captured function calls
+    flush();
+
     std::lock_guard < std::mutex > lock(mLogMutex);
     auto itr = std::find(mTraceWriters.begin(), mTraceWriters.end(), writer);
     if (itr != mTraceWriters.end())
@@ -169,19 +211,16 @@ namespace xdp {
 
   void TraceLogger::logFunctionCallStart(const char* functionName, long long queueAddress, unsigned int functionID)
   {
-    double timeStamp = mPluginHandle->getTraceTime();
+    if (mBufferedCapture) {
+      bufferFunctionCall(functionName, queueAddress, functionID, true);
+      mFunctionStartLogged = true;
+      return;
+    }
 
-    std::string name(functionName);
-    if (name.find("MigrateMem") != std::string::npos)
-      mMigrateMemCalls++;
+    double timeStamp = mPluginHandle->getTraceTime();
 
-    if (queueAddress == 0)
-      name += "|General";
-    else
-      (name += "|") +=std::to_string(queueAddress);
     std::lock_guard<std::mutex> lock(mLogMutex);
-    mProfileCounters->logFunctionCallStart(functionName, timeStamp);
-    writeTimelineTrace(timeStamp, name.c_str(), "START", functionID);
+    processFunctionCall(functionName, queueAddress, functionID, true, timeStamp, std::this_thread::get_id());
     mFunctionStartLogged = true;
 
 #if 0
@@ -201,17 +240,15 @@ namespace xdp {
     if (!mFunctionStartLogged)
       logFunctionCallStart(functionName, queueAddress, functionID);
 
-    double timeStamp = mPluginHandle->getTraceTime();
+    if (mBufferedCapture) {
+      bufferFunctionCall(functionName, queueAddress, functionID, false);
+      return;
+    }
 
-    std::string name(functionName);
-    if (queueAddress == 0)
-      name += "|General";
-    else
-      (name += "|") +=std::to_string(queueAddress);
+    double timeStamp = mPluginHandle->getTraceTime();
 
     std::lock_guard<std::mutex> lock(mLogMutex);
-    mProfileCounters->logFunctionCallEnd(functionName, timeStamp);
-    writeTimelineTrace(timeStamp, name.c_str(), "END", functionID);
+    processFunctionCall(functionName, queueAddress, functionID, false, timeStamp, std::this_thread::get_id());
 
 #if 0
     // Write host event to trace buffer
@@ -223,6 +260,140 @@ namespace xdp {
 #endif
   }
 
+  void TraceLogger::processFunctionCall(const std::string& functionName, long long queueAddress,
+      unsigned int functionID, bool isStart, double timeStamp, std::thread::id threadId)
+  {
+    std::string name(functionName);
+    if (queueAddress == 0)
+      name += "|General";
+    else
+      (name += "|") +=std::to_string(queueAddress);
+
+    if (isStart) {
+      if (functionName.find("MigrateMem") != std::string::npos)
+        mMigrateMemCalls++;
+      mProfileCounters->logFunctionCallStart(functionName, timeStamp, threadId);
+      writeTimelineTrace(timeStamp, name.c_str(), "START", functionID);
+    }
+    else {
+      mProfileCounters->logFunctionCallEnd(functionName, timeStamp, threadId);
+      writeTimelineTrace(timeStamp, name.c_str(), "END", functionID);
+    }
+  }
+
+  // ***************************************************************************
+  // Buffered capture of host function calls
+  // ***************************************************************************
+
+  // Append a fixed size record to the ring of the calling thread.
+  // Function names are interned once per thread, the name pointer is
+  // cached but verified since callers are not required to pass literals.
+  // The timestamp is taken while the ring advertises a pending push, see
+  // drainFunctionCalls.
+  void TraceLogger::bufferFunctionCall(const char* functionName, long long queueAddress,
+      unsigned int functionID, bool isStart)
+  {
+    auto& capture = tCapture;
+    if (capture.instanceId != mInstanceId) {
+      if (capture.ring)
+        capture.ring->detach();
+      capture.ring = std::make_shared<FunctionCallRing>();
+      capture.names.clear();
+      capture.instanceId = mInstanceId;
+      std::lock_guard<std::mutex> lock(mRingsMutex);
+      mRings.push_back(capture.ring);
+    }
+
+    uint32_t nameId = 0;
+    auto itr = capture.names.find(functionName);
+    if (itr != capture.names.end() && *itr->second.second == functionName) {
+      nameId = itr->second.first;
+    }
+    else {
+      nameId = mFunctionNames.intern(functionName);
+      capture.names[functionName] = std::make_pair(nameId, &mFunctionNames.lookup(nameId));
+    }
+
+    capture.ring->beginPush();
+    double timeStamp = mPluginHandle->getTraceTime();
+    capture.ring->setPendingTime(timeStamp);
+    FunctionCallRecord record {timeStamp, queueAddress, std::this_thread::get_id(), nameId, functionID, isStart};
+    while (!capture.ring->push(record)) {
+      mDrainCond.notify_one();
+      std::this_thread::yield();
+    }
+    capture.ring->endPush();
+
+    if (capture.ring->isHalfFull())
+      mDrainCond.notify_one();
+  }
+
+  // Drain all rings and process the records in time order.  Rings of
+  // exited threads are released once drained.
+  //
+  // A thread may take its timestamp before a drain and push the record
+  // after it, so only records up to a horizon are processed: the time
+  // the drain started, lowered to the timestamp of any push in flight.
+  // Later records are held back and merged with the next drain.  With
+  // all set everything is processed, used when capture has stopped.
+  void TraceLogger::drainFunctionCalls(bool all)
+  {
+    std::lock_guard<std::mutex> drainLock(mDrainMutex);
+
+    double horizon = mPluginHandle->getTraceTime();
+    {
+      std::lock_guard<std::mutex> lock(mRingsMutex);
+      auto itr = mRings.begin();
+      while (itr != mRings.end()) {
+        auto& ring = *itr;
+        bool detached = ring->isDetached();
+        horizon = std::min(horizon, ring->pendingTime());
+        ring->drain([this](const FunctionCallRecord& record) {
+          mDrainRecords.push_back(record);
+        });
+        itr = detached ? mRings.erase(itr) : itr + 1;
+      }
+    }
+
+    if (mDrainRecords.empty())
+      return;
+
+    std::stable_sort(mDrainRecords.begin(), mDrainRecords.end(),
+      [](const FunctionCallRecord& a, const FunctionCallRecord& b) {
+        return a.timeStamp < b.timeStamp;
+      });
+
+    auto end = all ? mDrainRecords.end()
+      : std::upper_bound(mDrainRecords.begin(), mDrainRecords.end(), horizon,
+          [](double t, const FunctionCallRecord& record) {
+            return t < record.timeStamp;
+          });
+
+    std::lock_guard<std::mutex> lock(mLogMutex);
+    for (auto itr = mDrainRecords.begin(); itr != end; ++itr) {
+      processFunctionCall(mFunctionNames.lookup(itr->nameId), itr->queueAddress,
+          itr->functionID, itr->isStart, itr->timeStamp, itr->threadId);
+    }
+    mDrainRecords.erase(mDrainRecords.begin(), end);
+  }
+
+  void TraceLogger::drainLoop()
+  {
+    std::unique_lock<std::mutex> lock(mDrainWaitMutex);
+    while (!mDrainStop) {
+      mDrainCond.wait_for(lock, std::chrono::milliseconds(10));
+      lock.unlock();
+      drainFunctionCalls(false);
+      lock.lock();
+    }
+  }
+
+  void TraceLogger::flush()
+  {
+    if (mBufferedCapture)
+      drainFunctionCalls(true);
+  }
+
   // ***************************************************************************
   // Log Host Data Transfers
   // ***************************************************************************
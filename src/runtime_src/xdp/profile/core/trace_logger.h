@@ -18,6 +18,7 @@
 #define __XDP_CORE_LOGGER_H
 
 #include "rt_util.h"
+#include "trace_buffer.h"
 #include "xdp/profile/collection/counters.h"
 #include "xdp/profile/collection/results.h"
 #include "xdp/profile/plugin/base_plugin.h"
@@ -26,11 +27,16 @@
 #include "xclperf.h"
 
 #include <limits>
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
 #include <map>
 #include <queue>
+#include <vector>
 
 namespace xdp {
   class ProfileCounters;
@@ -103,6 +109,11 @@ namespace xdp {
         const std::string& stageString, const std::string& eventString,
         const std::string& dependString) const;
 
+  public:
+    // Process all host function calls captured so far
+    // NOTE: no-op unless buffered capture is enabled
+    void flush();
+
   public:
     int getMigrateMemCalls() const { return mMigrateMemCalls;}
     int getHostP2PTransfers() const { return mHostP2PTransfers;}
@@ -116,9 +127,19 @@ namespace xdp {
       mThreadIdSet.insert(threadId);
     }
 
+    // Host function calls, mLogMutex must be held
+    void processFunctionCall(const std::string& functionName, long long queueAddress,
+        unsigned int functionID, bool isStart, double timeStamp, std::thread::id threadId);
+
+    // Buffered capture of host function calls
+    void bufferFunctionCall(const char* functionName, long long queueAddress,
+        unsigned int functionID, bool isStart);
+    void drainFunctionCalls(bool all);
+    void drainLoop();
+
   private:
     bool mGetFirstCUTimestamp = true;
-    bool mFunctionStartLogged = false;
+    std::atomic<bool> mFunctionStartLogged{false};
     int mMigrateMemCalls;
     int mHostP2PTransfers;
     uint32_t mCurrentContextId;
@@ -138,6 +159,21 @@ namespace xdp {
     ProfileCounters* mProfileCounters;
     std::vector<TraceWriterI*> mTraceWriters;
 
+    // Buffered capture, each API thread owns a ring that is drained
+    // by a background thread under mDrainMutex.  mDrainRecords holds
+    // records drained but not yet processed.
+    bool mBufferedCapture = false;
+    uint32_t mInstanceId = 0;
+    StringTable mFunctionNames;
+    std::mutex mRingsMutex;
+    std::vector<std::shared_ptr<FunctionCallRing>> mRings;
+    std::mutex mDrainMutex;
+    std::vector<FunctionCallRecord> mDrainRecords;
+    std::mutex mDrainWaitMutex;
+    std::condition_variable mDrainCond;
+    bool mDrainStop = false;
+    std::thread mDrainThread;
+
   private:
       TraceParser * mTraceParserHandle;
       XDPPluginI * mPluginHandle;
@@ -226,9 +226,16 @@ namespace xdp {
       timelineFile = "timeline_trace";
       ProfileMgr->turnOnFile(xdp::RTUtil::FILE_TIMELINE_TRACE);
     }
-    xdp::CSVTraceWriter* csvTraceWriter = new xdp::CSVTraceWriter(timelineFile, "Xilinx", Plugin.get());
-    TraceWriters.push_back(csvTraceWriter);
-    ProfileMgr->attach(csvTraceWriter);
+    if (!timelineFile.empty() && xrt::config::get_timeline_trace_format() == "binary") {
+      xdp::BinaryTraceWriter* binaryTraceWriter = new xdp::BinaryTraceWriter(timelineFile, "Xilinx", Plugin.get());
+      TraceWriters.push_back(binaryTraceWriter);
+      ProfileMgr->attach(binaryTraceWriter);
+    }
+    else {
+      xdp::CSVTraceWriter* csvTraceWriter = new xdp::CSVTraceWriter(timelineFile, "Xilinx", Plugin.get());
+      TraceWriters.push_back(csvTraceWriter);
+      ProfileMgr->attach(csvTraceWriter);
+    }
 
 #if 0
     // Not Used
@@ -26,6 +26,7 @@
 #include "xdp/profile/core/rt_util.h"
 #include "xdp/profile/writer/csv_profile.h"
 #include "xdp/profile/writer/csv_trace.h"
+#include "xdp/profile/writer/binary_trace.h"
 #include "xdp/profile/writer/unified_csv_profile.h"
 #include "xdp/profile/plugin/ocl/ocl_power_profile.h"
 
@@ -0,0 +1,578 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+////////////////////////////////////////////////////////////////
+// Convert a binary timeline trace (.xtrace) written by
+// xdp::BinaryTraceWriter to the CSV timeline trace format or to
+// Chrome/Perfetto trace event JSON.
+//
+//  % xdp_trace_convert [-f csv|json] [-o <output>] timeline_trace.xtrace
+////////////////////////////////////////////////////////////////
+#include "xdp/profile/writer/binary_trace_format.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using xdp::BinaryTraceHeader;
+using xdp::BinaryTraceRecord;
+using xdp::BinaryTraceString;
+
+// Read only mapping of a file
+class mapped_file
+{
+  int m_fd = -1;
+  size_t m_size = 0;
+  const char* m_base = nullptr;
+
+public:
+  explicit
+  mapped_file(const std::string& fnm)
+  {
+    m_fd = open(fnm.c_str(), O_RDONLY);
+    if (m_fd < 0)
+      throw std::runtime_error("could not open " + fnm);
+
+    struct stat st;
+    if (fstat(m_fd, &st))
+      throw std::runtime_error("could not stat " + fnm);
+    m_size = st.st_size;
+    if (!m_size)
+      return;
+
+    auto addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (addr == MAP_FAILED)
+      throw std::runtime_error("could not map " + fnm);
+    m_base = static_cast<const char*>(addr);
+  }
+
+  ~mapped_file()
+  {
+    if (m_base)
+      munmap(const_cast<char*>(m_base), m_size);
+    if (m_fd >= 0)
+      close(m_fd);
+  }
+
+  const char*
+  data() const
+  {
+    return m_base;
+  }
+
+  size_t
+  size() const
+  {
+    return m_size;
+  }
+};
+
+// Binary trace file and its string file
+//
+// Records are accessed by index.  Strings are accessed by id through
+// the offset index written when the trace was closed.  A file that was
+// not closed properly is read up to its last complete record, and the
+// string offsets are recovered by reading the string file in order.
+class trace_file
+{
+  std::string m_name;
+  mapped_file m_trace;
+  std::unique_ptr<mapped_file> m_strings;
+  uint64_t m_count = 0;
+  const uint64_t* m_index = nullptr;
+  uint64_t m_index_size = 0;
+  std::vector<uint64_t> m_scanned;
+
+  void
+  warning(const std::string& msg) const
+  {
+    std::cerr << "xdp_trace_convert: warning: " << m_name << " " << msg << "\n";
+  }
+
+  // Offsets of the strings in order of id, up to the first incomplete
+  // or unexpected string
+  void
+  scan_strings(size_t end)
+  {
+    auto base = m_strings->data();
+    size_t offset = 0;
+    while (offset + sizeof(BinaryTraceString) <= end) {
+      auto def = reinterpret_cast<const BinaryTraceString*>(base + offset);
+      if (def->id != m_scanned.size() + 1)
+        break;
+      size_t size = sizeof(BinaryTraceString) + ((def->length + 7) & ~size_t(7));
+      if (offset + size > end)
+        break;
+      m_scanned.push_back(offset);
+      offset += size;
+    }
+    if (offset != end)
+      warning("has an incomplete string file, strings after id "
+              + std::to_string(m_scanned.size()) + " are empty");
+    m_index = m_scanned.data();
+    m_index_size = m_scanned.size();
+  }
+
+public:
+  explicit
+  trace_file(const std::string& fnm)
+    : m_name(fnm), m_trace(fnm)
+  {
+    if (m_trace.size() < sizeof(BinaryTraceHeader))
+      throw std::runtime_error(fnm + " is not a binary trace file");
+
+    auto& hdr = header();
+    if (std::memcmp(hdr.magic, xdp::BINARY_TRACE_MAGIC, sizeof(hdr.magic)))
+      throw std::runtime_error(fnm + " is not a binary trace file");
+    if (hdr.version != xdp::BINARY_TRACE_VERSION)
+      throw std::runtime_error(fnm + " has unsupported version " + std::to_string(hdr.version));
+    if (hdr.recordSize != sizeof(BinaryTraceRecord) || hdr.headerSize != sizeof(BinaryTraceHeader))
+      throw std::runtime_error(fnm + " has unexpected record layout");
+
+    bool closed = hdr.flags & xdp::BT_HEADER_CLOSED;
+    auto available = (m_trace.size() - hdr.headerSize) / hdr.recordSize;
+    if (!closed) {
+      warning("was not closed properly, converting the events written before that");
+      if ((m_trace.size() - hdr.headerSize) % hdr.recordSize)
+        warning("ends with an incomplete record, ignored");
+      m_count = available;
+    }
+    else if (hdr.recordCount > available) {
+      warning("is truncated");
+      m_count = available;
+    }
+    else
+      m_count = hdr.recordCount;
+
+    try {
+      m_strings.reset(new mapped_file(fnm + xdp::BINARY_TRACE_STRINGS));
+    }
+    catch (const std::exception&) {
+      warning("has no string file, all names are empty");
+      return;
+    }
+
+    auto index_end = hdr.stringIndex + hdr.stringCount * sizeof(uint64_t);
+    if (closed && hdr.stringIndex && !(hdr.stringIndex % sizeof(uint64_t))
+        && index_end <= m_strings->size()) {
+      m_index = reinterpret_cast<const uint64_t*>(m_strings->data() + hdr.stringIndex);
+      m_index_size = hdr.stringCount;
+    }
+    else
+      scan_strings(closed && hdr.stringIndex <= m_strings->size() ? hdr.stringIndex : m_strings->size());
+  }
+
+  const BinaryTraceHeader&
+  header() const
+  {
+    return *reinterpret_cast<const BinaryTraceHeader*>(m_trace.data());
+  }
+
+  // Number of complete records
+  uint64_t
+  size() const
+  {
+    return m_count;
+  }
+
+  const BinaryTraceRecord&
+  record(uint64_t idx) const
+  {
+    auto offset = header().headerSize + idx * header().recordSize;
+    return *reinterpret_cast<const BinaryTraceRecord*>(m_trace.data() + offset);
+  }
+
+  // Visit all complete records in file order
+  template <typename Visitor>
+  void
+  for_each(Visitor&& visit) const
+  {
+    for (uint64_t idx = 0; idx < m_count; ++idx)
+      visit(record(idx));
+  }
+
+  // Document header lines
+  std::string
+  doc_header() const
+  {
+    return str(header().docHeader);
+  }
+
+  std::string
+  str(uint64_t id) const
+  {
+    if (!id || id > m_index_size)
+      return "";
+    auto offset = m_index[id - 1];
+    auto size = m_strings->size();
+    if (offset + sizeof(BinaryTraceString) > size)
+      return "";
+    auto def = reinterpret_cast<const BinaryTraceString*>(m_strings->data() + offset);
+    if (def->id != id || offset + sizeof(BinaryTraceString) + def->length > size)
+      return "";
+    return std::string(m_strings->data() + offset + sizeof(BinaryTraceString), def->length);
+  }
+};
+
+// Object ids are formatted as std::showbase|std::uppercase hex,
+// addresses as 0X prefixed lower case hex
+static std::string
+hex_id(uint64_t value)
+{
+  if (!value)
+    return "0";
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "0X%llX", static_cast<unsigned long long>(value));
+  return buf;
+}
+
+static std::string
+hex(uint64_t value, int width=0)
+{
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "0X%0*llx", width, static_cast<unsigned long long>(value));
+  return buf;
+}
+
+static std::string
+num(double value)
+{
+  std::stringstream str;
+  str << std::setprecision(10) << value;
+  return str.str();
+}
+
+////////////////////////////////////////////////////////////////
+// CSV, same layout as xdp::CSVTraceWriter
+////////////////////////////////////////////////////////////////
+static void
+row(std::ostream& ostr, std::initializer_list<std::string> cells)
+{
+  for (auto& cell : cells)
+    ostr << cell << ",";
+  ostr << "\n";
+}
+
+static void
+write_csv(const trace_file& trace, std::ostream& ostr)
+{
+  ostr << "Timeline Trace\n";
+  ostr << trace.doc_header();
+  ostr << "\n\n";
+  row(ostr, {"Time_msec", "Name", "Event", "Address_Port", "Size",
+        "Latency_cycles", "Start_cycles", "End_cycles",
+        "Latency_usec", "Start_msec", "End_msec"});
+
+  trace.for_each([&](const BinaryTraceRecord& r) {
+    auto name = trace.str(r.name);
+    auto stage = trace.str(r.stage);
+
+    switch (r.type) {
+    case xdp::BT_FUNCTION:
+      row(ostr, {num(r.time), name, stage, "", "", "", "", "", "", "", "", "", "", std::to_string(r.aux)});
+      break;
+    case xdp::BT_KERNEL:
+    case xdp::BT_CU:
+      row(ostr, {num(r.time), name, stage, hex_id(r.objId), std::to_string(r.size),
+            r.type == xdp::BT_CU ? std::to_string(r.aux) : "", "", "", "", "", "",
+            trace.str(r.event), trace.str(r.depend)});
+      break;
+    case xdp::BT_TRANSFER: {
+      std::string address = hex(r.objId, 9) + "|" + trace.str(r.aux);
+      if (stage == "START" || stage == "END") {
+        address += "|" + hex(r.threadId);
+        if (r.flags & xdp::BT_FLAG_COPY)
+          address += "|" + hex(r.address, 9) + "|" + trace.str(r.aux2) + "|" + ((r.flags & xdp::BT_FLAG_P2P) ? "1" : "0");
+      }
+      row(ostr, {num(r.time), name, stage, address, std::to_string(r.size),
+            "", "", "", "", "", "", trace.str(r.event), trace.str(r.depend)});
+      break;
+    }
+    case xdp::BT_DEPENDENCY:
+      row(ostr, {num(r.time), name, stage, trace.str(r.event), trace.str(r.depend)});
+      break;
+    case xdp::BT_DEVICE:
+      if (stage == "Kernel") {
+        row(ostr, {num(r.time), name, "START", "", trace.str(r.aux2), std::to_string(r.event)});
+        row(ostr, {num(r.endTime), name, "END", "", trace.str(r.aux2), std::to_string(r.event)});
+      }
+      else {
+        // Zero length transactions last one kernel clock cycle
+        double duration = 1000.0 * (r.endTime - r.time);
+        if (!(duration > 0.0) && r.flags)
+          duration = 1.0 / r.flags;
+        row(ostr, {num(r.time), name, stage, trace.str(r.aux), std::to_string(r.size),
+              std::to_string(r.address - r.objId), std::to_string(r.objId), std::to_string(r.address),
+              num(duration), num(r.time), num(r.endTime)});
+      }
+      break;
+    default:
+      break;
+    }
+  });
+
+  ostr << "Footer,begin\n" << trace.str(trace.header().footer) << "Footer,end\n\n";
+}
+
+////////////////////////////////////////////////////////////////
+// Chrome trace event format, loadable in chrome://tracing and Perfetto.
+// Host events (pid 1) and device events (pid 2) are emitted as complete
+// events by pairing START and END records.
+////////////////////////////////////////////////////////////////
+static std::string
+quote(const std::string& str)
+{
+  std::string out = "\"";
+  for (auto c : str) {
+    switch (c) {
+    case '"':  out += "\\\""; break;
+    case '\\': out += "\\\\"; break;
+    case '\n': out += "\\n"; break;
+    case '\t': out += "\\t"; break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+        out += buf;
+      }
+      else
+        out += c;
+    }
+  }
+  return out + "\"";
+}
+
+class json_writer
+{
+  std::ostream& m_ostr;
+  bool m_first = true;
+  std::map<std::pair<int, std::string>, int> m_tracks;
+
+public:
+  explicit
+  json_writer(std::ostream& ostr)
+    : m_ostr(ostr)
+  {
+    m_ostr << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    process_name(1, "Host");
+    process_name(2, "Device");
+  }
+
+  ~json_writer()
+  {
+    m_ostr << "\n]}\n";
+  }
+
+  int
+  track(int pid, const std::string& name)
+  {
+    auto itr = m_tracks.find({pid, name});
+    if (itr != m_tracks.end())
+      return itr->second;
+    int tid = m_tracks.size() + 1;
+    m_tracks.emplace(std::make_pair(pid, name), tid);
+    event("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + std::to_string(pid)
+          + ",\"tid\":" + std::to_string(tid) + ",\"args\":{\"name\":" + quote(name) + "}}");
+    return tid;
+  }
+
+  void
+  complete(int pid, const std::string& trk, const std::string& name, double start, double end)
+  {
+    int tid = track(pid, trk);
+    std::stringstream str;
+    str << std::setprecision(15)
+        << "{\"ph\":\"X\",\"name\":" << quote(name) << ",\"pid\":" << pid << ",\"tid\":" << tid
+        << ",\"ts\":" << start * 1000.0 << ",\"dur\":" << (end - start) * 1000.0 << "}";
+    event(str.str());
+  }
+
+  void
+  instant(int pid, const std::string& trk, const std::string& name, double time)
+  {
+    int tid = track(pid, trk);
+    std::stringstream str;
+    str << std::setprecision(15)
+        << "{\"ph\":\"i\",\"s\":\"t\",\"name\":" << quote(name) << ",\"pid\":" << pid << ",\"tid\":" << tid
+        << ",\"ts\":" << time * 1000.0 << "}";
+    event(str.str());
+  }
+
+private:
+  void
+  process_name(int pid, const std::string& name)
+  {
+    event("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" + std::to_string(pid)
+          + ",\"args\":{\"name\":" + quote(name) + "}}");
+  }
+
+  void
+  event(const std::string& evt)
+  {
+    if (!m_first)
+      m_ostr << ",\n";
+    m_first = false;
+    m_ostr << evt;
+  }
+};
+
+static void
+write_json(const trace_file& trace, std::ostream& ostr)
+{
+  json_writer json(ostr);
+
+  // open START records keyed by (type, name, pairing id), the name
+  // string rather than its id since a string can have several ids
+  using key_type = std::tuple<uint16_t, std::string, uint64_t>;
+  std::map<key_type, double> starts;
+
+  trace.for_each([&](const BinaryTraceRecord& r) {
+    auto name = trace.str(r.name);
+    auto stage = trace.str(r.stage);
+
+    if (r.type == xdp::BT_DEVICE) {
+      auto trk = name.substr(0, name.find('|'));
+      json.complete(2, trk, name, r.time, r.endTime);
+      return;
+    }
+    if (r.type == xdp::BT_DEPENDENCY)
+      return;
+
+    // track and pairing id per record type
+    std::string trk;
+    std::string label = name;
+    uint64_t id = 0;
+    switch (r.type) {
+    case xdp::BT_FUNCTION: {
+      auto sep = name.find('|');
+      label = name.substr(0, sep);
+      trk = (sep == std::string::npos) ? "General" : "Queue " + name.substr(sep + 1);
+      id = r.aux;
+      break;
+    }
+    case xdp::BT_KERNEL:
+      trk = "Kernel Enqueue";
+      id = r.objId;
+      break;
+    case xdp::BT_CU:
+      trk = "CU " + std::to_string(r.aux);
+      id = r.objId;
+      break;
+    case xdp::BT_TRANSFER:
+      trk = name.substr(0, name.find('|'));
+      id = r.event;
+      break;
+    default:
+      return;
+    }
+
+    key_type key {r.type, name, id};
+    if (stage == "START") {
+      starts[key] = r.time;
+    }
+    else if (stage == "END") {
+      auto itr = starts.find(key);
+      if (itr != starts.end()) {
+        json.complete(1, trk, label, itr->second, r.time);
+        starts.erase(itr);
+      }
+      else
+        json.instant(1, trk, label + " END", r.time);
+    }
+    else {
+      json.instant(1, trk, label + " " + stage, r.time);
+    }
+  });
+}
+
+static void
+usage()
+{
+  std::cout << "usage: xdp_trace_convert [-f csv|json] [-o <output>] <trace.xtrace>\n";
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  std::string format = "csv";
+  std::string output;
+  std::string input;
+
+  for (int idx = 1; idx < argc; ++idx) {
+    std::string arg = argv[idx];
+    if (arg == "-f" && idx + 1 < argc)
+      format = argv[++idx];
+    else if (arg == "-o" && idx + 1 < argc)
+      output = argv[++idx];
+    else if (arg == "-h" || arg == "--help") {
+      usage();
+      return 0;
+    }
+    else if (input.empty() && arg[0] != '-')
+      input = arg;
+    else {
+      usage();
+      return 1;
+    }
+  }
+
+  if (input.empty() || (format != "csv" && format != "json")) {
+    usage();
+    return 1;
+  }
+
+  try {
+    trace_file trace(input);
+
+    std::ofstream ofs;
+    if (!output.empty()) {
+      ofs.open(output);
+      if (!ofs)
+        throw std::runtime_error("could not open " + output);
+    }
+    std::ostream& ostr = output.empty() ? std::cout : ofs;
+
+    if (format == "csv")
+      write_csv(trace, ostr);
+    else
+      write_json(trace, ostr);
+  }
+  catch (const std::exception& ex) {
+    std::cerr << "xdp_trace_convert: " << ex.what() << "\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -263,6 +263,98 @@ namespace xdp {
     CountersPrev = results;
   }
 
+  // Build timeline names of a device trace event
+  bool TraceWriterI::getDeviceTraceNames(const DeviceTrace& tr, std::string& deviceName,
+      const std::string& binaryName, std::string& traceName, std::string& argNames,
+      std::string& workGroupSize)
+  {
+#ifndef XDP_VERBOSE
+    if (tr.Kind == DeviceTrace::DEVICE_BUFFER)
+      return false;
+#endif
+
+    bool showKernelCUNames = true;
+    bool showPortName = false;
+    std::string memoryName;
+    std::string cuName;
+
+    // Populate trace name string
+    if (tr.Kind == DeviceTrace::DEVICE_KERNEL) {
+      if (tr.Type == "Kernel") {
+        traceName = "KERNEL";
+      } else if (tr.Type.find("Stall") != std::string::npos) {
+        traceName = "Kernel_Stall";
+        showPortName = false;
+      } else if (tr.Type == "Write") {
+        showPortName = true;
+        traceName = "Kernel_Write";
+      } else {
+        showPortName = true;
+        traceName = "Kernel_Read";
+      }
+    }
+    else if (tr.Kind == DeviceTrace::DEVICE_STREAM) {
+      traceName = tr.Name;
+      showPortName = true;
+    } else {
+      showKernelCUNames = false;
+      if (tr.Type == "Write")
+        traceName = "Host_Write";
+      else
+        traceName = "Host_Read";
+    }
+
+    traceName += ("|" + deviceName + "|" + binaryName);
+
+    if (showKernelCUNames || showPortName) {
+      std::string portName;
+      std::string cuPortName;
+      if (tr.Kind == DeviceTrace::DEVICE_KERNEL && (tr.Type == "Kernel" || tr.Type.find("Stall") != std::string::npos)) {
+        mPluginHandle->getProfileSlotName(XCL_PERF_MON_ACCEL, deviceName, tr.SlotNum, cuName);
+      }
+      else {
+        if (tr.Kind == DeviceTrace::DEVICE_STREAM){
+          mPluginHandle->getProfileSlotName(XCL_PERF_MON_STR, deviceName, tr.SlotNum, cuPortName);
+          size_t sepIndex = cuPortName.find(IP_LAYOUT_SEP);
+          // New format : "MasterName-SlaveName"
+          if (sepIndex != std::string::npos) {
+            auto slaveName = cuPortName.substr(sepIndex + 1);
+            auto masterName = cuPortName.substr(0, sepIndex);
+            auto cuFound = masterName.find_first_of("/");
+            cuPortName = (cuFound == std::string::npos) ? slaveName : masterName;
+          }
+        }
+        else {
+          mPluginHandle->getProfileSlotName(XCL_PERF_MON_MEMORY, deviceName, tr.SlotNum, cuPortName);
+        }
+        cuName = cuPortName.substr(0, cuPortName.find_first_of("/"));
+        portName = cuPortName.substr(cuPortName.find_first_of("/")+1);
+        //std::transform(portName.begin(), portName.end(), portName.begin(), ::tolower);
+      }
+      std::string kernelName;
+      mPluginHandle->getProfileKernelName(deviceName, cuName, kernelName);
+
+      if (showKernelCUNames)
+        traceName += ("|" + kernelName + "|" + cuName);
+
+      if (showPortName) {
+        mPluginHandle->getArgumentsBank(deviceName, cuName, portName, argNames, memoryName);
+        traceName += ("|" + portName + "|" + memoryName);
+      }
+    }
+
+    if (tr.Type == "Kernel") {
+      mPluginHandle->getTraceStringFromComputeUnit(deviceName, cuName, traceName);
+      if (traceName.empty())
+        return false;
+      size_t pos = traceName.find_last_of("|");
+      workGroupSize = traceName.substr(pos + 1);
+      traceName = traceName.substr(0, pos);
+    }
+
+    return true;
+  }
+
   // Functions for device trace
   void TraceWriterI::writeDeviceTrace(const TraceParser::TraceResultVector &resultVector,
       std::string deviceName, std::string binaryName)
@@ -273,10 +365,11 @@ namespace xdp {
     for (auto it = resultVector.begin(); it != resultVector.end(); it++) {
       DeviceTrace tr = *it;
 
-#ifndef XDP_VERBOSE
-      if (tr.Kind == DeviceTrace::DEVICE_BUFFER)
+      std::string traceName;
+      std::string argNames;
+      std::string workGroupSize;
+      if (!getDeviceTraceNames(tr, deviceName, binaryName, traceName, argNames, workGroupSize))
         continue;
-#endif
 
       double deviceClockDurationUsec = (1.0 / (mPluginHandle->getKernelClockFreqMHz(deviceName)));
 
@@ -285,86 +378,7 @@ namespace xdp {
       std::stringstream endStr;
       endStr << std::setprecision(10) << tr.End;
 
-      bool showKernelCUNames = true;
-      bool showPortName = false;
-      std::string memoryName;
-      std::string traceName;
-      std::string cuName;
-      std::string argNames;
-
-      // Populate trace name string
-      if (tr.Kind == DeviceTrace::DEVICE_KERNEL) {
-        if (tr.Type == "Kernel") {
-          traceName = "KERNEL";
-        } else if (tr.Type.find("Stall") != std::string::npos) {
-          traceName = "Kernel_Stall";
-          showPortName = false;
-        } else if (tr.Type == "Write") {
-          showPortName = true;
-          traceName = "Kernel_Write";
-        } else {
-          showPortName = true;
-          traceName = "Kernel_Read";
-        }
-      }
-      else if (tr.Kind == DeviceTrace::DEVICE_STREAM) {
-        traceName = tr.Name;
-        showPortName = true;
-      } else {
-        showKernelCUNames = false;
-        if (tr.Type == "Write")
-          traceName = "Host_Write";
-        else
-          traceName = "Host_Read";
-      }
-
-      traceName += ("|" + deviceName + "|" + binaryName);
-
-      if (showKernelCUNames || showPortName) {
-        std::string portName;
-        std::string cuPortName;
-        if (tr.Kind == DeviceTrace::DEVICE_KERNEL && (tr.Type == "Kernel" || tr.Type.find("Stall") != std::string::npos)) {
-          mPluginHandle->getProfileSlotName(XCL_PERF_MON_ACCEL, deviceName, tr.SlotNum, cuName);
-        }
-        else {
-          if (tr.Kind == DeviceTrace::DEVICE_STREAM){
-            mPluginHandle->getProfileSlotName(XCL_PERF_MON_STR, deviceName, tr.SlotNum, cuPortName);
-            size_t sepIndex = cuPortName.find(IP_LAYOUT_SEP);
-            // New format : "MasterName-SlaveName"
-            if (sepIndex != std::string::npos) {
-              auto slaveName = cuPortName.substr(sepIndex + 1);
-              auto masterName = cuPortName.substr(0, sepIndex);
-              auto cuFound = masterName.find_first_of("/");
-              cuPortName = (cuFound == std::string::npos) ? slaveName : masterName;
-            }
-          }
-          else {
-            mPluginHandle->getProfileSlotName(XCL_PERF_MON_MEMORY, deviceName, tr.SlotNum, cuPortName);
-          }
-          cuName = cuPortName.substr(0, cuPortName.find_first_of("/"));
-          portName = cuPortName.substr(cuPortName.find_first_of("/")+1);
-          //std::transform(portName.begin(), portName.end(), portName.begin(), ::tolower);
-        }
-        std::string kernelName;
-        mPluginHandle->getProfileKernelName(deviceName, cuName, kernelName);
-
-        if (showKernelCUNames)
-          traceName += ("|" + kernelName + "|" + cuName);
-
-        if (showPortName) {
-          mPluginHandle->getArgumentsBank(deviceName, cuName, portName, argNames, memoryName);
-          traceName += ("|" + portName + "|" + memoryName);
-        }
-      }
-
       if (tr.Type == "Kernel") {
-        std::string workGroupSize;
-        mPluginHandle->getTraceStringFromComputeUnit(deviceName, cuName, traceName);
-        if (traceName.empty()) continue;
-        size_t pos = traceName.find_last_of("|");
-        workGroupSize = traceName.substr(pos + 1);
-        traceName = traceName.substr(0, pos);
-        
         writeTableRowStart(getStream());
         writeTableCells(getStream(), startStr.str(), traceName, "START", "", workGroupSize, tr.EventID);
         writeTableRowEnd(getStream());
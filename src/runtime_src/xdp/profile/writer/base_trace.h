@@ -49,34 +49,41 @@ namespace xdp {
 
 	    // Functions for timeline trace log
 	    // Write timeline trace of a function call such as cl API call
-	    void writeFunction(double time, const std::string& functionName,
+	    virtual void writeFunction(double time, const std::string& functionName,
 	        const std::string& eventName, unsigned int functionID);
 	    // Write timeline trace of kernel execution
-	    void writeKernel(double traceTime, const std::string& commandString,
+	    virtual void writeKernel(double traceTime, const std::string& commandString,
             const std::string& stageString, const std::string& eventString,
             const std::string& dependString, uint64_t objId, size_t size);
-      void writeCu(double traceTime, const std::string& commandString,
+      virtual void writeCu(double traceTime, const std::string& commandString,
             const std::string& stageString, const std::string& eventString,
             const std::string& dependString, uint64_t objId, size_t size, uint32_t cuId);
 	    // Write timeline trace of read/write/copy data transfer
-	    void writeTransfer(double traceTime, RTUtil::e_profile_command_kind kind,
+	    virtual void writeTransfer(double traceTime, RTUtil::e_profile_command_kind kind,
 	        const std::string& commandString, const std::string& stageString,
             const std::string& eventString, const std::string& dependString, size_t size,
             uint64_t srcAddress, const std::string& srcBank,
             uint64_t dstAddress, const std::string& dstBank,
 			std::thread::id threadId);
 	    // Write timeline trace of dependency
-	    void writeDependency(double traceTime, const std::string& commandString,
+	    virtual void writeDependency(double traceTime, const std::string& commandString,
             const std::string& stageString, const std::string& eventString,
             const std::string& dependString);
 
 	    // Write device counters
-	    void writeDeviceCounters(xclPerfMonType type, xclCounterResults& results,
+	    virtual void writeDeviceCounters(xclPerfMonType type, xclCounterResults& results,
 		      double timestamp, uint32_t sampleNum, bool firstReadAfterProgram);
 	    // Write device trace
-	    void writeDeviceTrace(const TraceParser::TraceResultVector &resultVector,
+	    virtual void writeDeviceTrace(const TraceParser::TraceResultVector &resultVector,
 	          std::string deviceName, std::string binaryName);
 
+    protected:
+      // Names of a device trace event as shown in the timeline.  Returns
+      // false if the event is not shown.
+      bool getDeviceTraceNames(const DeviceTrace& tr, std::string& deviceName,
+          const std::string& binaryName, std::string& traceName, std::string& argNames,
+          std::string& workGroupSize);
+
     protected:
       // Variadic args function to take n number of any type of args and
       // stream it to a file
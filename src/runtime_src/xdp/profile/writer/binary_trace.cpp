@@ -0,0 +1,265 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "binary_trace.h"
+#include "util.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+  // Strings looked up by the writer before the lookup table is
+  // dropped, a string used again after that is stored with a new id
+  const size_t maxInternedStrings = 64 * 1024;
+
+  // Numeric value of a thread id as the CSV writer prints it
+  uint64_t threadIdValue(std::thread::id threadId)
+  {
+    std::stringstream str;
+    str << std::hex << threadId;
+    return std::strtoull(str.str().c_str(), nullptr, 16);
+  }
+
+} // namespace
+
+namespace xdp {
+
+  BinaryTraceWriter::BinaryTraceWriter(const std::string& traceFileName,
+                                       const std::string& platformName,
+                                       XDPPluginI* Plugin)
+  : TraceFileName(traceFileName)
+  {
+    mPluginHandle = Plugin;
+
+    // Same document header lines as the CSV timeline trace
+    std::stringstream docHeader;
+    docHeader << "Generated on: " << WriterI::getCurrentDateTime() << "\n";
+    docHeader << "Msec since Epoch: " << WriterI::getCurrentTimeMsec() << "\n";
+    if (!WriterI::getCurrentExecutableName().empty())
+      docHeader << "Profiled application: " << WriterI::getCurrentExecutableName() << "\n";
+    docHeader << "Target platform: " << platformName << "\n";
+    docHeader << "Tool version: " << WriterI::getToolVersion() << "\n";
+
+    if (TraceFileName != "") {
+      TraceFileName += FileExtension;
+      Trace_ofs.open(TraceFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+      String_ofs.open(TraceFileName + BINARY_TRACE_STRINGS, std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!Trace_ofs.is_open() || !String_ofs.is_open())
+        throw std::runtime_error("Unable to open timeline trace for writing");
+      // Document header is the first string, so the header written
+      // now is valid even if the file is never closed
+      DocHeader = getStringId(docHeader.str());
+      writeHeader(0, 0);
+    }
+  }
+
+  BinaryTraceWriter::~BinaryTraceWriter()
+  {
+    if (!Trace_ofs.is_open())
+      return;
+
+    std::string footer;
+    mPluginHandle->getTraceFooterString(footer);
+    Footer = getStringId(footer);
+
+    uint64_t stringIndex = String_ofs.tellp();
+    String_ofs.write(reinterpret_cast<const char*>(StringOffsets.data()),
+                     StringOffsets.size() * sizeof(uint64_t));
+    String_ofs.close();
+
+    Trace_ofs.seekp(0);
+    writeHeader(BT_HEADER_CLOSED, stringIndex);
+    Trace_ofs.close();
+  }
+
+  void BinaryTraceWriter::writeHeader(uint32_t flags, uint64_t stringIndex)
+  {
+    BinaryTraceHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(header.magic));
+    header.version = BINARY_TRACE_VERSION;
+    header.headerSize = sizeof(BinaryTraceHeader);
+    header.recordSize = sizeof(BinaryTraceRecord);
+    header.flags = flags;
+    header.recordCount = RecordCount;
+    header.stringCount = StringOffsets.size();
+    header.stringIndex = stringIndex;
+    header.footer = Footer;
+    header.docHeader = DocHeader;
+    Trace_ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+
+  uint32_t BinaryTraceWriter::getStringId(const std::string& str)
+  {
+    if (str.empty() || !Trace_ofs.is_open())
+      return 0;
+
+    auto itr = StringIds.find(str);
+    if (itr != StringIds.end())
+      return itr->second;
+
+    // Drop the lookup table rather than growing with every unique
+    // event name, ids already handed out stay valid
+    if (StringIds.size() >= maxInternedStrings)
+      StringIds.clear();
+
+    // Ids are 32 bit in records, strings past the last id are empty
+    if (StringOffsets.size() >= UINT32_MAX)
+      return 0;
+
+    uint32_t id = StringOffsets.size() + 1;
+    StringOffsets.push_back(String_ofs.tellp());
+    StringIds.emplace(str, id);
+
+    static const char padding[8] = {0};
+    BinaryTraceString def;
+    def.id = id;
+    def.length = str.size();
+    String_ofs.write(reinterpret_cast<const char*>(&def), sizeof(def));
+    String_ofs.write(str.data(), str.size());
+    String_ofs.write(padding, (sizeof(padding) - str.size() % sizeof(padding)) % sizeof(padding));
+    return id;
+  }
+
+  BinaryTraceRecord BinaryTraceWriter::makeRecord(BinaryTraceRecordType type, double time,
+      const std::string& name, const std::string& stage)
+  {
+    BinaryTraceRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.type = type;
+    record.time = time;
+    record.name = getStringId(name);
+    record.stage = getStringId(stage);
+    return record;
+  }
+
+  void BinaryTraceWriter::writeRecord(const BinaryTraceRecord& record)
+  {
+    Trace_ofs.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    ++RecordCount;
+  }
+
+  void BinaryTraceWriter::writeFunction(double time, const std::string& functionName,
+      const std::string& eventName, unsigned int functionID)
+  {
+    if (!Trace_ofs.is_open())
+      return;
+
+    auto record = makeRecord(BT_FUNCTION, time, functionName, eventName);
+    record.aux = functionID;
+    writeRecord(record);
+  }
+
+  void BinaryTraceWriter::writeKernel(double traceTime, const std::string& commandString,
+      const std::string& stageString, const std::string& eventString,
+      const std::string& dependString, uint64_t objId, size_t size)
+  {
+    if (!Trace_ofs.is_open())
+      return;
+
+    auto record = makeRecord(BT_KERNEL, traceTime, commandString, stageString);
+    record.event = getStringId(eventString);
+    record.depend = getStringId(dependString);
+    record.objId = objId;
+    record.size = size;
+    writeRecord(record);
+  }
+
+  void BinaryTraceWriter::writeCu(double traceTime, const std::string& commandString,
+      const std::string& stageString, const std::string& eventString,
+      const std::string& dependString, uint64_t objId, size_t size, uint32_t cuId)
+  {
+    if (!Trace_ofs.is_open())
+      return;
+
+    auto record = makeRecord(BT_CU, traceTime, commandString, stageString);
+    record.event = getStringId(eventString);
+    record.depend = getStringId(dependString);
+    record.objId = objId;
+    record.size = size;
+    record.aux = cuId;
+    writeRecord(record);
+  }
+
+  void BinaryTraceWriter::writeTransfer(double traceTime, RTUtil::e_profile_command_kind kind,
+      const std::string& commandString, const std::string& stageString,
+      const std::string& eventString, const std::string& dependString, size_t size,
+      uint64_t srcAddress, const std::string& srcBank,
+      uint64_t dstAddress, const std::string& dstBank,
+      std::thread::id threadId)
+  {
+    if (!Trace_ofs.is_open())
+      return;
+
+    auto record = makeRecord(BT_TRANSFER, traceTime, commandString, stageString);
+    record.kind = kind;
+    record.event = getStringId(eventString);
+    record.depend = getStringId(dependString);
+    record.size = size;
+    record.objId = srcAddress;
+    record.aux = getStringId(srcBank);
+    record.address = dstAddress;
+    record.aux2 = getStringId(dstBank);
+    record.threadId = threadIdValue(threadId);
+    if (kind == RTUtil::COPY_BUFFER || kind == RTUtil::COPY_BUFFER_P2P)
+      record.flags |= BT_FLAG_COPY;
+    if (kind == RTUtil::COPY_BUFFER_P2P)
+      record.flags |= BT_FLAG_P2P;
+    writeRecord(record);
+  }
+
+  void BinaryTraceWriter::writeDependency(double traceTime, const std::string& commandString,
+      const std::string& stageString, const std::string& eventString,
+      const std::string& dependString)
+  {
+    if (!Trace_ofs.is_open())
+      return;
+
+    auto record = makeRecord(BT_DEPENDENCY, traceTime, commandString, stageString);
+    record.event = getStringId(eventString);
+    record.depend = getStringId(dependString);
+    writeRecord(record);
+  }
+
+  void BinaryTraceWriter::writeDeviceTrace(const TraceParser::TraceResultVector &resultVector,
+      std::string deviceName, std::string binaryName)
+  {
+    if (!Trace_ofs.is_open())
+      return;
+
+    for (auto& tr : resultVector) {
+      std::string traceName;
+      std::string argNames;
+      std::string workGroupSize;
+      if (!getDeviceTraceNames(tr, deviceName, binaryName, traceName, argNames, workGroupSize))
+        continue;
+
+      auto record = makeRecord(BT_DEVICE, tr.Start, traceName, tr.Type);
+      record.endTime = tr.End;
+      record.objId = tr.StartTime;
+      record.address = tr.EndTime;
+      record.size = tr.BurstLength;
+      record.event = tr.EventID;
+      record.aux = getStringId(argNames);
+      record.aux2 = getStringId(workGroupSize);
+      record.flags = mPluginHandle->getKernelClockFreqMHz(deviceName);
+      writeRecord(record);
+    }
+  }
+
+} // xdp
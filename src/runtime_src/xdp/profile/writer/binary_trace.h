@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __XDP_BINARY_TRACE_WRITER_H
+#define __XDP_BINARY_TRACE_WRITER_H
+
+#include "base_trace.h"
+#include "binary_trace_format.h"
+
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+namespace xdp {
+
+    // Timeline trace writer producing the compact binary format described
+    // in binary_trace_format.h.  Use xdp_trace_convert to turn the file
+    // into CSV or Chrome/Perfetto JSON.
+    class BinaryTraceWriter: public TraceWriterI {
+
+    public:
+      BinaryTraceWriter(const std::string& traceFileName, const std::string& platformName,
+          XDPPluginI* Plugin);
+      ~BinaryTraceWriter();
+
+      virtual const std::string getFileName() { return TraceFileName; }
+
+    public:
+      void writeFunction(double time, const std::string& functionName,
+          const std::string& eventName, unsigned int functionID) override;
+      void writeKernel(double traceTime, const std::string& commandString,
+          const std::string& stageString, const std::string& eventString,
+          const std::string& dependString, uint64_t objId, size_t size) override;
+      void writeCu(double traceTime, const std::string& commandString,
+          const std::string& stageString, const std::string& eventString,
+          const std::string& dependString, uint64_t objId, size_t size, uint32_t cuId) override;
+      void writeTransfer(double traceTime, RTUtil::e_profile_command_kind kind,
+          const std::string& commandString, const std::string& stageString,
+          const std::string& eventString, const std::string& dependString, size_t size,
+          uint64_t srcAddress, const std::string& srcBank,
+          uint64_t dstAddress, const std::string& dstBank,
+          std::thread::id threadId) override;
+      void writeDependency(double traceTime, const std::string& commandString,
+          const std::string& stageString, const std::string& eventString,
+          const std::string& dependString) override;
+      void writeDeviceCounters(xclPerfMonType type, xclCounterResults& results,
+          double timestamp, uint32_t sampleNum, bool firstReadAfterProgram) override {}
+      void writeDeviceTrace(const TraceParser::TraceResultVector &resultVector,
+          std::string deviceName, std::string binaryName) override;
+
+    protected:
+      void writeTableHeader(std::ofstream& ofs, const std::string& caption,
+          const std::vector<std::string>& columnLabels) override {}
+
+    private:
+      uint32_t getStringId(const std::string& str);
+      BinaryTraceRecord makeRecord(BinaryTraceRecordType type, double time,
+          const std::string& name, const std::string& stage);
+      void writeRecord(const BinaryTraceRecord& record);
+      void writeHeader(uint32_t flags, uint64_t stringIndex);
+
+    private:
+      std::string TraceFileName;
+      const std::string FileExtension = ".xtrace";
+      std::ofstream String_ofs;
+      uint64_t RecordCount = 0;
+      uint32_t Footer = 0;
+      uint32_t DocHeader = 0;
+      // Offset in the string file of string id i+1
+      std::vector<uint64_t> StringOffsets;
+      // Recently used strings, bounded since event names are unique
+      std::unordered_map<std::string, uint32_t> StringIds;
+    };
+
+} // xdp
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __XDP_BINARY_TRACE_FORMAT_H
+#define __XDP_BINARY_TRACE_FORMAT_H
+
+#include <cstdint>
+
+// Layout of binary timeline trace files
+//
+//   <name>.xtrace       BinaryTraceHeader
+//                       BinaryTraceRecord[recordCount]
+//
+//   <name>.xtrace.str   BinaryTraceString followed by length bytes,
+//                       padded to 8 bytes, one per string id
+//                       uint64_t[stringCount] offsets of the strings,
+//                       starting at stringIndex
+//
+// All values are little endian as written by the host.  Records are
+// fixed size and contain nothing else, record i is at offset
+// headerSize + i * recordSize.  Strings are referenced by id, ids are
+// assigned in order starting at 1 and never reused, so an id refers
+// to the same string for the whole file.  Id 0 is always the empty
+// string.  The same string may be stored under more than one id.
+//
+// The header is written first and rewritten with the final counts
+// when the file is closed.  A file without BT_HEADER_CLOSED was not
+// closed properly, the number of records follows from the file size
+// and the string offsets from reading the string file in order.
+
+namespace xdp {
+
+  const char     BINARY_TRACE_MAGIC[8] = {'X','D','P','T','R','A','C','E'};
+  const uint32_t BINARY_TRACE_VERSION  = 2;
+  const char     BINARY_TRACE_STRINGS[] = ".str"; // string file suffix
+
+  enum BinaryTraceRecordType : uint16_t {
+    BT_FUNCTION   = 1,
+    BT_KERNEL     = 2,
+    BT_CU         = 3,
+    BT_TRANSFER   = 4,
+    BT_DEPENDENCY = 5,
+    BT_DEVICE     = 6
+  };
+
+  enum BinaryTraceRecordFlags : uint32_t {
+    BT_FLAG_COPY  = 0x1,
+    BT_FLAG_P2P   = 0x2
+  };
+
+  enum BinaryTraceHeaderFlags : uint32_t {
+    BT_HEADER_CLOSED = 0x1
+  };
+
+  struct BinaryTraceHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t headerSize;        // sizeof(BinaryTraceHeader)
+    uint32_t recordSize;        // sizeof(BinaryTraceRecord)
+    uint32_t flags;             // BinaryTraceHeaderFlags
+    uint64_t recordCount;       // 0 until closed
+    uint64_t stringCount;       // 0 until closed
+    uint64_t stringIndex;       // offset of string offsets in string file, 0 until closed
+    uint32_t footer;            // string id of timeline footer, 0 until closed
+    uint32_t docHeader;         // string id of document header lines, 0 if none
+    uint64_t reserved0;
+  };
+
+  // Field usage per record type
+  //
+  //   FUNCTION:   name=function|queue, stage, aux=function id
+  //   KERNEL:     name=command, stage, event, depend, objId, size
+  //   CU:         name=command, stage, event, depend, objId, size, aux=cu id
+  //   TRANSFER:   name=command, stage, event, depend, size, kind,
+  //               objId=src address, aux=src bank, address=dst address,
+  //               aux2=dst bank, threadId=value the CSV writer prints,
+  //               flags
+  //   DEPENDENCY: name=command, stage, event, depend
+  //   DEVICE:     name=trace name, stage=type, time=start, endTime=end,
+  //               objId=start cycle, address=end cycle, size=burst length,
+  //               aux=argument names, aux2=work group size, event=event id,
+  //               flags=kernel clock in MHz
+  struct BinaryTraceRecord {
+    uint16_t type;       // BinaryTraceRecordType
+    uint16_t kind;       // RTUtil::e_profile_command_kind
+    uint32_t name;
+    double   time;       // msec
+    double   endTime;    // msec
+    uint64_t objId;
+    uint64_t address;
+    uint64_t size;
+    uint64_t threadId;
+    uint32_t stage;
+    uint32_t event;
+    uint32_t depend;
+    uint32_t aux;
+    uint32_t aux2;
+    uint32_t flags;      // BinaryTraceRecordFlags
+  };
+
+  // String in the string file, followed by the string bytes
+  struct BinaryTraceString {
+    uint32_t id;
+    uint32_t length;
+  };
+
+  static_assert(sizeof(BinaryTraceHeader) == 64, "unexpected binary trace header size");
+  static_assert(sizeof(BinaryTraceRecord) == 80, "unexpected binary trace record size");
+  static_assert(sizeof(BinaryTraceString) == 8, "unexpected binary trace string size");
+
+} // xdp
+
+#endif
@@ -160,12 +160,36 @@ clEnqueueCopyBuffer(cl_command_queue    command_queue,
     (uevent.get(),xocl::profile::action_copy,src_buffer,dst_buffer,src_offset,dst_offset,size,true);
   xocl::appdebug::set_event_action
     (uevent.get(),xocl::appdebug::action_copybuf,src_buffer,dst_buffer,src_offset,dst_offset,size);
+  if (xrt::config::get_hazard_tracking()) {
+    uevent->add_memory_read(xocl::xocl(src_buffer));
+    uevent->add_memory_write(xocl::xocl(dst_buffer));
+  }
 
   uevent->queue();
   xocl::assign(event_parameter,uevent.get());
   return CL_SUCCESS;
 }
 
+namespace api {
+
+cl_int
+clEnqueueCopyBuffer(cl_command_queue    command_queue,
+                    cl_mem              src_buffer,
+                    cl_mem              dst_buffer,
+                    size_t              src_offset,
+                    size_t              dst_offset,
+                    size_t              size,
+                    cl_uint             num_events_in_wait_list,
+                    const cl_event *    event_wait_list,
+                    cl_event *          event_parameter)
+{
+  return ::xocl::clEnqueueCopyBuffer
+    (command_queue,src_buffer,dst_buffer,src_offset,dst_offset,size,
+     num_events_in_wait_list,event_wait_list,event_parameter);
+}
+
+} // api
+
 } // xocl
 
 cl_int
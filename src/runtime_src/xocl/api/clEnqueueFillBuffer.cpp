@@ -129,6 +129,8 @@ clEnqueueFillBuffer(cl_command_queue command_queue,
     (uevent.get(),xocl::enqueue::action_fill_buffer,buffer,pattern,pattern_size,offset,size);
   xocl::appdebug::set_event_action
     (uevent.get(),xocl::appdebug::action_fill_buffer,buffer,pattern,pattern_size,offset,size);
+  if (xrt::config::get_hazard_tracking())
+    uevent->add_memory_write(xocl::xocl(buffer));
 
   uevent->queue();
   xocl::assign(event,uevent.get());
@@ -75,7 +75,7 @@ clEnqueueMapBuffer(cl_command_queue command_queue,
 
   uevent->queue();
   if (blocking_map)
-    uevent->wait();
+    xocl(command_queue)->wait(uevent.get());
 
   xocl::assign(event_parameter,uevent.get());
   xocl::assign(errcode_ret,CL_SUCCESS);
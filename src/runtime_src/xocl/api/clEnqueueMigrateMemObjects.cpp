@@ -99,6 +99,9 @@ clEnqueueMigrateMemObjects(cl_command_queue        command_queue ,
     (uevent.get(),xocl::profile::action_migrate,num_mem_objects,mem_objects,flags);
   xocl::appdebug::set_event_action
     (uevent.get(),xocl::appdebug::action_migrate,num_mem_objects,mem_objects,flags);
+  if (xrt::config::get_hazard_tracking())
+    for (cl_uint idx=0; idx<num_mem_objects; ++idx)
+      uevent->add_memory_write(xocl::xocl(mem_objects[idx]));
 
   uevent->queue();
   xocl::assign(event_parameter,uevent.get());
@@ -37,6 +37,7 @@
 #include "printf/rt_printf.h"
 
 #include <sstream>
+#include <mutex>
 #include "plugin/xdp/appdebug.h"
 #include "plugin/xdp/profile.h"
 
@@ -53,6 +54,9 @@ static xocl::ptr<xocl::memory>
 createPrintfBuffer(cl_context context, cl_kernel kernel,
                    const std::vector<size_t>& gsz, const std::vector<size_t>& lsz);
 
+static void
+releasePrintfBuffer(cl_kernel kernel, xocl::ptr<xocl::memory>&& mem);
+
 static cl_event
 enqueueInitializePrintfBuffer(cl_kernel kernel, cl_command_queue queue,cl_mem mem);
 
@@ -91,6 +95,39 @@ getDeviceMaxWorkItemSizes(cl_device_id device)
   return sizes;
 }
 
+// Record buffers accessed by the kernel argument migration and kernel
+// execution events for in-order queue hazard tracking.  Read only
+// buffers are read by the kernel, all other buffers are conservatively
+// written.  Only the execution event is ordered after prior kernel
+// executions.  Kernels with svm arguments can access any memory, their
+// events are left without an access set, which orders them after
+// everything.
+static void
+recordKernelAccess(xocl::event* event, cl_kernel kernel)
+{
+  if (!xrt::config::get_hazard_tracking())
+    return;
+
+  auto args = xocl::xocl(kernel)->get_argument_range();
+  for (auto& arg : args)
+    if (arg->get_svm_object())
+      return;
+
+  for (auto& arg : args) {
+    auto mem = arg->get_memory_object();
+    if (!mem)
+      continue;
+    if (mem->get_flags() & CL_MEM_READ_ONLY)
+      event->add_memory_read(mem);
+    else
+      event->add_memory_write(mem);
+  }
+  if (event->get_command_type()==CL_COMMAND_NDRANGE_KERNEL)
+    event->add_kernel_access();
+  else
+    event->add_memory_access();
+}
+
 }
 
 namespace xocl {
@@ -417,6 +454,7 @@ clEnqueueNDRangeKernel(cl_command_queue command_queue,
   xocl::appdebug::set_event_action(umEvent.get(),xocl::appdebug::action_ndrange_migrate,mEvent,kernel);
 
   // Schedule migration
+  recordKernelAccess(umEvent.get(),kernel);
   umEvent->queue();
 
   // Event for kernel execution, must wait on migration
@@ -434,6 +472,7 @@ clEnqueueNDRangeKernel(cl_command_queue command_queue,
   xocl::appdebug::set_event_action(ueEvent.get(),xocl::appdebug::action_ndrange,eEvent,kernel);
 
   // Schedule execution
+  recordKernelAccess(ueEvent.get(),kernel);
   ueEvent->queue();
 
   // Schdule the printf buffer retrieval to happen AFTER the kernel
@@ -475,10 +514,13 @@ clEnqueueNDRangeKernel(cl_command_queue command_queue,
 
 namespace {
 
+using init_pattern_type = std::shared_ptr<const std::vector<uint8_t>>;
+
 struct CallbackArgs {
   xocl::ptr<xocl::kernel> kernel;
   xocl::ptr<xocl::memory> mem;
   std::vector<uint8_t> buf;
+  init_pattern_type init;
 };
 
 void CL_CALLBACK cb_BufferInitialized(cl_event event, cl_int status, void *data)
@@ -493,11 +535,10 @@ void CL_CALLBACK cb_BufferInitialized(cl_event event, cl_int status, void *data)
 
 void CL_CALLBACK cb_BufferReturned(cl_event event, cl_int status, void *data)
 {
-  CallbackArgs *args = reinterpret_cast<CallbackArgs*>(data);
+  std::unique_ptr<CallbackArgs> args(reinterpret_cast<CallbackArgs*>(data));
   cl_kernel kernel = args->kernel.get();
   XCL::Printf::PrintfManager printfManager;
-  printfManager.enqueueBuffer(kernel, args->buf);
-  delete args;
+  printfManager.enqueueBuffer(kernel, std::move(args->buf));
   if ( XCL::Printf::isPrintfDebugMode() ) {
     std::cout << "clEnqueueNDRangeKernel - printf buffer returned callback\n";
     printfManager.dbgDump();
@@ -505,55 +546,131 @@ void CL_CALLBACK cb_BufferReturned(cl_event event, cl_int status, void *data)
   printfManager.print();
   printfManager.clear();
 
+  // Output has been read back, the device buffer can be reused
+  releasePrintfBuffer(kernel,std::move(args->mem));
+
   xocl::api::clReleaseEvent(event);
 }
 
+// Host copy of printf buffer init pattern.  Shared by all launches
+// with same size printf buffer, the pattern is kept alive by the
+// callback args of the write that uses it.
+static init_pattern_type
+getPrintfInitPattern(size_t size)
+{
+  static std::mutex mutex;
+  static init_pattern_type pattern;
+  std::lock_guard<std::mutex> lk(mutex);
+  if (!pattern || pattern->size()!=size)
+    pattern = std::make_shared<const std::vector<uint8_t>>(size,0xFF);
+  return pattern;
+}
+
 // Creates a device printf buffer but does not initialize
 // Allocate device printf buffer if printf is needed for this workgroup.
+// Buffers are recycled from previous launches of the kernel when possible.
 xocl::ptr<xocl::memory>
 createPrintfBuffer(cl_context context, cl_kernel kernel
                    ,const std::vector<size_t>& gsz, const std::vector<size_t>& lsz)
 {
-  auto mem = XCL::Printf::kernelHasPrintf(kernel)
-    ? clCreateBuffer(context, CL_MEM_READ_WRITE,XCL::Printf::getPrintfBufferSize(gsz,lsz),nullptr,nullptr)
-    : nullptr;
+  if (!XCL::Printf::kernelHasPrintf(kernel))
+    return nullptr;
 
+  auto size = XCL::Printf::getPrintfBufferSize(gsz,lsz);
+  auto retval = xocl::xocl(kernel)->acquire_printf_buffer(size);
+  if (retval.get())
+    return retval;
+
+  auto mem = clCreateBuffer(context, CL_MEM_READ_WRITE,size,nullptr,nullptr);
   if (!mem)
     return nullptr;
 
-  xocl::ptr<xocl::memory> retval(xocl::xocl(mem));
+  retval = xocl::xocl(mem);
   assert(retval->count()==2);
   retval->release();
   return retval;
 }
 
+// Return a device printf buffer to the kernel for use by later launches
+void
+releasePrintfBuffer(cl_kernel kernel, xocl::ptr<xocl::memory>&& mem)
+{
+  xocl::xocl(kernel)->release_printf_buffer(std::move(mem));
+}
+
+// Write the init pattern to a printf buffer
+static cl_event
+enqueueWritePrintfInitPattern(cl_kernel kernel, cl_command_queue queue, cl_mem mem)
+{
+  cl_event event = nullptr;
+  std::unique_ptr<CallbackArgs> args = std::make_unique<CallbackArgs>();
+  auto bufSize = xocl::xocl(mem)->get_size();
+  args->kernel = xocl::xocl(kernel);
+  args->mem = xocl::xocl(mem);
+  args->init = getPrintfInitPattern(bufSize);
+  cl_int err = xocl::api::clEnqueueWriteBuffer
+    (queue, mem, /*blocking_read*/CL_FALSE,
+     /*offset*/0, bufSize, args->init->data(),
+     /*num_events_in_wait_list*/0,
+     /*event_wait_list*/nullptr,
+     /*return event*/&event);
+  if ( err != CL_SUCCESS )
+    throw xocl::error(err,"enqueueInitializePrintfBuffer");
+  err = xocl::api::clSetEventCallback(event, CL_COMPLETE, cb_BufferInitialized, args.get());
+  if (err == CL_SUCCESS)
+    args.release();
+  return event;
+}
+
+// Reset a printf buffer on the device by copying from an initialized
+// buffer of the kernel.  The initialized buffer is created and written
+// once per kernel and buffer size.  Every copy waits for the write,
+// launches on other queues may reset their buffers before it completes.
+static cl_event
+enqueueResetPrintfBuffer(cl_kernel kernel, cl_command_queue queue, cl_mem mem)
+{
+  auto bufSize = xocl::xocl(mem)->get_size();
+  xocl::ptr<xocl::event> init_event;
+  auto reset = xocl::xocl(kernel)->get_printf_reset_buffer(bufSize,init_event);
+  if (!reset.get()) {
+    cl_int err = CL_SUCCESS;
+    auto context = xocl::xocl(queue)->get_context();
+    auto rmem = clCreateBuffer(context, CL_MEM_READ_ONLY, bufSize, nullptr, &err);
+    if (err != CL_SUCCESS)
+      throw xocl::error(err,"enqueueResetPrintfBuffer");
+    reset = xocl::xocl(rmem);
+    reset->release();
+    auto ev = enqueueWritePrintfInitPattern(kernel, queue, rmem);
+    init_event = xocl::xocl(ev);
+    xocl::api::clReleaseEvent(ev);
+    xocl::xocl(kernel)->set_printf_reset_buffer
+      (xocl::ptr<xocl::memory>(reset),xocl::ptr<xocl::event>(init_event));
+  }
+
+  cl_event event = nullptr;
+  cl_mem rmem = reset.get();
+  cl_event wait_event = init_event.get();
+  cl_int err = xocl::api::clEnqueueCopyBuffer
+    (queue, rmem, mem, /*src_offset*/0, /*dst_offset*/0, bufSize,
+     /*num_events_in_wait_list*/wait_event ? 1 : 0,
+     /*event_wait_list*/wait_event ? &wait_event : nullptr,
+     /*return event*/&event);
+  if ( err != CL_SUCCESS )
+    throw xocl::error(err,"enqueueResetPrintfBuffer");
+  return event;
+}
+
 // Initialize the device printf buffer to known values. This must execute
 // BEFORE the clEnqueueNDRangeKernel starts so the event is returned so it
 // can be appended to the list of events the enqueue must wait for.
 cl_event enqueueInitializePrintfBuffer(cl_kernel kernel, cl_command_queue queue,cl_mem mem)
 {
-  cl_event event = nullptr;
-  if ( XCL::Printf::kernelHasPrintf(kernel) ) {
-    std::unique_ptr<CallbackArgs> args = std::make_unique<CallbackArgs>();
-    auto bufSize = xocl::xocl(mem)->get_size();
-    args->kernel = xocl::xocl(kernel);
-    args->mem = xocl::xocl(mem);
-    args->buf.resize(bufSize);
-    uint8_t *hostBuf = &args->buf[0];
-    memset(hostBuf, 0xFF, bufSize);
-    cl_int err = xocl::api::clEnqueueWriteBuffer
-      (queue, mem, /*blocking_read*/CL_FALSE,
-       /*offset*/0, bufSize, hostBuf,
-       /*num_events_in_wait_list*/0,
-       /*event_wait_list*/nullptr,
-       /*return event*/&event);
-    if ( err != CL_SUCCESS )
-      throw xocl::error(err,"enqueueInitializePrintfBuffer");
-    err = xocl::api::clSetEventCallback(event, CL_COMPLETE, cb_BufferInitialized, args.get());
-    if (err == CL_SUCCESS)
-      args.release();
-  }
-  return event;
+  if ( !XCL::Printf::kernelHasPrintf(kernel) )
+    return nullptr;
+
+  return xrt::config::get_printf_device_reset()
+    ? enqueueResetPrintfBuffer(kernel, queue, mem)
+    : enqueueWritePrintfInitPattern(kernel, queue, mem);
 }
 
 // Read device printf buffer back from the device. This must execute AFTER the
@@ -83,7 +83,7 @@ clEnqueueSVMMap(cl_command_queue command_queue,
 
   uevent->queue();
   if (blocking_map)
-    uevent->wait();
+    xocl(command_queue)->wait(uevent.get());
 
   xocl::assign(event,uevent.get());
 
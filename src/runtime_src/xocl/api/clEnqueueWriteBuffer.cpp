@@ -104,10 +104,14 @@ clEnqueueWriteBuffer(cl_command_queue   command_queue,
   xocl::enqueue::set_event_action(uevent.get(),xocl::enqueue::action_write_buffer,buffer,offset,size,ptr);
   xocl::profile::set_event_action(uevent.get(),xocl::profile::action_write,buffer,offset,size,false);
   xocl::appdebug::set_event_action(uevent.get(),xocl::appdebug::action_readwrite,buffer,offset,size,ptr);
+  if (xrt::config::get_hazard_tracking()) {
+    uevent->add_memory_write(xocl::xocl(buffer));
+    uevent->add_host_access(ptr,size,false);
+  }
  
   uevent->queue();
   if (blocking)
-    uevent->wait();
+    xocl(command_queue)->wait(uevent.get());
 
   xocl::assign(event_parameter,uevent.get());
   return CL_SUCCESS;
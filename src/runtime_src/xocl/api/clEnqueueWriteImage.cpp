@@ -20,6 +20,7 @@
 #include "xocl/config.h"
 #include "xocl/core/memory.h"
 #include "xocl/core/event.h"
+#include "xocl/core/command_queue.h"
 
 #include "detail/memory.h"
 #include "detail/event.h"
@@ -145,7 +146,7 @@ clEnqueueWriteImage(cl_command_queue     command_queue,
 
   uevent->queue();
   if (blocking_write)
-    uevent->wait();
+    xocl(command_queue)->wait(uevent.get());
 
   xocl::assign(event,uevent.get());
   return CL_SUCCESS;
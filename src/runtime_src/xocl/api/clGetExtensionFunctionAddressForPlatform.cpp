@@ -34,6 +34,7 @@ static const std::map<const std::string, void *> extensionFunctionTable = {
   std::pair<const std::string, void *>("xclGetXrtDevice", (void *)xclGetXrtDevice),
   std::pair<const std::string, void *>("xclGetMemObjDeviceAddress", (void *)xclGetMemObjDeviceAddress),
   std::pair<const std::string, void *>("xclGetComputeUnitInfo", (void *)xclGetComputeUnitInfo),
+  std::pair<const std::string, void *>("xclEnqueueKernelBatch", (void *)xclEnqueueKernelBatch),
   std::pair<const std::string, void *>("clIcdGetPlatformIDsKHR", (void *)clIcdGetPlatformIDsKHR),
 };
 
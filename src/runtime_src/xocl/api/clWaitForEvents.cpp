@@ -18,6 +18,8 @@
 
 #include "xocl/core/object.h"
 #include "xocl/core/range.h"
+#include "xocl/core/event.h"
+#include "xocl/core/command_queue.h"
 #include "detail/event.h"
 
 #include <iostream>
@@ -40,8 +42,13 @@ static cl_int
 clWaitForEvents(cl_uint num_events, const cl_event* event_list)
 {
   validOrError(num_events, event_list);
-  for (auto event : get_range(event_list,event_list+num_events))
-    xocl(event)->wait();  
+  for (auto event : get_range(event_list,event_list+num_events)) {
+    auto ev = xocl(event);
+    if (auto queue = ev->get_command_queue())
+      queue->wait(ev);
+    else
+      ev->wait();
+  }
   return CL_SUCCESS;
 }
 
@@ -138,7 +138,7 @@ copy_buffer(xocl::event* event,xocl::device* device
             ,cl_mem src_buffer,cl_mem dst_buffer,size_t src_offset,size_t dst_offset,size_t size)
 {
   try {
-    auto cmd = std::make_shared<enqueue_command>(device,event,ERT_START_CU);
+    auto cmd = xrt::make_command<enqueue_command>(device,event,ERT_START_CU);
     device->copy_buffer(xocl::xocl(src_buffer),xocl::xocl(dst_buffer),src_offset,dst_offset,size,cmd);
   }
   catch (const std::exception& ex) {
@@ -336,14 +336,9 @@ action_copy_p2p_buffer(cl_mem src_buffer,cl_mem dst_buffer,size_t src_offset,siz
 }
 
 
-xocl::event::action_enqueue_type
-action_ndrange_migrate(cl_event event,cl_kernel kernel)
+std::vector<xocl::memory*>
+allocate_kernel_args(xocl::device* device, cl_kernel kernel)
 {
-  throw_if_error();
-  //Allocate all global/constant args onto target device
-  auto command_queue = xocl::xocl(event)->get_command_queue();
-  auto device = command_queue->get_device();
-
   // Create buffer objects for all arguments
   std::vector<xocl::memory*> kernel_args;
   for (auto& arg : xocl::xocl(kernel)->get_argument_range()) {
@@ -358,7 +353,23 @@ action_ndrange_migrate(cl_event event,cl_kernel kernel)
       }
     }
   }
+  return kernel_args;
+}
+
+xocl::event::action_enqueue_type
+action_ndrange_migrate(cl_event event,cl_kernel kernel)
+{
+  throw_if_error();
+  //Allocate all global/constant args onto target device
+  auto command_queue = xocl::xocl(event)->get_command_queue();
+  auto device = command_queue->get_device();
+  return action_ndrange_migrate_batch(allocate_kernel_args(device,kernel));
+}
 
+xocl::event::action_enqueue_type
+action_ndrange_migrate_batch(std::vector<xocl::memory*> kernel_args)
+{
+  throw_if_error();
   return [kernel_args](xocl::event* ev) {
     XOCL_DEBUG(std::cout,"launching ndrange migrate DMA event(",ev->get_uid(),")\n");
     auto command_queue = ev->get_command_queue();
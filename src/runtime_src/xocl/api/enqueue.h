@@ -28,6 +28,7 @@
 #include "xocl/core/object.h"
 #include "xocl/core/event.h"
 #include <utility>
+#include <vector>
 
 namespace xocl { namespace enqueue {
 
@@ -44,6 +45,23 @@ action_copy_p2p_buffer(cl_mem src_buffer,cl_mem dst_buffer,size_t src_offset,siz
 xocl::event::action_enqueue_type
 action_ndrange_migrate(cl_event event,cl_kernel kernel);
 
+/**
+ * Migrate buffers of a batch of kernel launches, the buffers
+ * must have been allocated with allocate_kernel_args
+ */
+xocl::event::action_enqueue_type
+action_ndrange_migrate_batch(std::vector<xocl::memory*> kernel_args);
+
+/**
+ * Allocate buffer objects for all arguments of a kernel on device
+ *
+ * @return
+ *   The buffers that are migrated to device with the kernel,
+ *   program scope globals are allocated but not migrated
+ */
+std::vector<xocl::memory*>
+allocate_kernel_args(xocl::device* device, cl_kernel kernel);
+
 xocl::event::action_enqueue_type
 action_read_buffer(cl_mem buffer,size_t offset, size_t size, const void* ptr);
 
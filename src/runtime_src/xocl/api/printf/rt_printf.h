@@ -47,6 +47,7 @@ public:
   ~PrintfManager();
 
   void enqueueBuffer(cl_kernel kernel, const std::vector<uint8_t>& buf);
+  void enqueueBuffer(cl_kernel kernel, std::vector<uint8_t>&& buf);
   void clear();
   void print(std::ostream& os = std::cout);
   void dbgDump(std::ostream& os = std::cout);
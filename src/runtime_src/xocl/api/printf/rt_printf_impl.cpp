@@ -25,6 +25,8 @@
 #include <stdexcept>
 #include <iomanip>
 #include <algorithm>
+#include <memory>
+#include <mutex>
 
 #ifdef _WINDOWS
 #define snprintf _snprintf
@@ -670,8 +672,34 @@ void FormatString::dbgDump(std::ostream& str) const
 
 /////////////////////////////////////////////////////////////////////////
 
+ParsedFormat::ParsedFormat(const std::string& format)
+  : m_format(format)
+  , m_valid(false)
+  , m_argByteCount(0)
+{
+  FormatString formatString(format);
+  m_valid = formatString.isValid();
+  if ( !m_valid ) {
+    return;
+  }
+  formatString.getSpecifiers(m_specVec);
+  formatString.getSplitFormatString(m_splitFormatString);
+  for ( auto& conversion : m_specVec ) {
+    m_argByteCount += BufferPrintf::getElementByteCount(conversion) * conversion.m_vectorSize;
+    // HACK: Special handling for vec3 packed strangely from compiler
+    //    float3 += 32 bits
+    //    others += 64 bits
+    if ( conversion.isVector() && conversion.m_vectorSize == 3) {
+      m_argByteCount += conversion.isFloatClass() ? 4 : 8;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////
+
 BufferPrintf::BufferPrintf()
   : m_currentOffset(0)
+  , m_stringTable(nullptr)
 {
 }
 
@@ -682,11 +710,18 @@ BufferPrintf::BufferPrintf(const MemBuffer& buf, const StringTable& table)
   setStringTable(table);
 }
 
+BufferPrintf::BufferPrintf(MemBuffer&& buf, const StringTable& table)
+  : m_currentOffset(0)
+{
+  setBuffer(std::move(buf));
+  setStringTable(table);
+}
+
 BufferPrintf::~BufferPrintf()
 {
   m_currentOffset = 0;
   m_buf.clear();
-  m_stringTable.clear();
+  m_stringTable = nullptr;
 }
 
 BufferPrintf::BufferPrintf(const uint8_t* buf, size_t bufLen, const StringTable& table)
@@ -713,23 +748,31 @@ void BufferPrintf::setBuffer(const MemBuffer& buf)
   std::copy(buf.begin(), buf.end(), m_buf.begin());
 }
 
+void BufferPrintf::setBuffer(MemBuffer&& buf)
+{
+  // Currently bufLen must be 64-bit aligned
+  if ( (buf.size() % 8) != 0 ) {
+    throwError("setBuffer - bufLen is not a multiple of 8 bytes");
+  }
+  m_buf = std::move(buf);
+}
+
 void BufferPrintf::setStringTable(const StringTable& table)
 {
-  m_stringTable = table;
+  m_stringTable = &table;
+  m_formatCache.clear();
 }
 
 void BufferPrintf::print(std::ostream& os)
 {
   moveToFirstRecord();
   while ( hasNextRecord() ) {
-    std::string formatStr = getFormat();
-    FormatString format(formatStr);
-    if ( format.isValid() ) {
-      std::vector<XCL::Printf::ConversionSpec> conversionVec;
-      format.getSpecifiers(conversionVec);
+    const ParsedFormat& format = getParsedFormat();
+    if ( format.m_valid ) {
       std::vector<PrintfArg> argVec;
+      argVec.reserve(format.m_specVec.size());
       int argOffset = getFormatByteCount();
-      for ( auto conversion : conversionVec ) {
+      for ( auto& conversion : format.m_specVec ) {
         PrintfArg arg = buildArg(m_currentOffset + argOffset, conversion);
         argVec.push_back(arg);
         argOffset += getElementByteCount(conversion) * conversion.m_vectorSize;
@@ -745,8 +788,7 @@ void BufferPrintf::print(std::ostream& os)
           }
         }
       }
-      std::string result = string_printf(formatStr, argVec);
-      os << result;
+      os << string_printf(format, argVec);
     }
     nextRecord();
   }
@@ -758,8 +800,10 @@ void BufferPrintf::dbgDump(std::ostream& os) const
   IOS_FlagRestore ios_flagRestore(os);
   os << "------- BUFFER DEBUG DUMP --------\n";
   os << "String table:" << "\n";
-  for ( auto iter : m_stringTable ) {
-    os << iter.first << "=" << escape(iter.second) << "\n";
+  if ( m_stringTable ) {
+    for ( auto& iter : *m_stringTable ) {
+      os << iter.first << "=" << escape(iter.second) << "\n";
+    }
   }
   os << "\nBuffer Contents:" << "\n";
   os << "ADDR    [0]                         [7]" << "\n";
@@ -877,32 +921,14 @@ void BufferPrintf::nextRecord()
     throwError("nextRecord - No next record");
   }
 
-  std::string formatStr = getFormat();
-  FormatString format(formatStr);
-  if ( !format.isValid() ) {
+  const ParsedFormat& format = getParsedFormat();
+  if ( !format.m_valid ) {
     std::string msg = "nextRecord - Invalid format: ";
-    msg += formatStr;
+    msg += format.m_format;
     throwError(msg);
   }
-  std::vector<ConversionSpec> conversionVec;
-  format.getSpecifiers(conversionVec);
-  // skip format ID
-  m_currentOffset += getFormatByteCount();
-  // Skip all arguments
-  for (auto conversion : conversionVec) {
-    m_currentOffset += getElementByteCount(conversion) * conversion.m_vectorSize;
-    // HACK: Special handling for vec3 packed strangely from compiler
-    //    float3 += 32 bits
-    //    others += 64 bits
-    if ( conversion.isVector() && conversion.m_vectorSize == 3) {
-      if ( conversion.isFloatClass() ) {
-        m_currentOffset += 4;
-      }
-      else {
-        m_currentOffset += 8;
-      }
-    }
-  }
+  // skip format ID and all arguments
+  m_currentOffset += getFormatByteCount() + format.m_argByteCount;
   m_currentOffset = nextRecordOffset(m_currentOffset);
 }
 
@@ -914,6 +940,21 @@ std::string BufferPrintf::getFormat() const
   return retval;
 }
 
+const ParsedFormat& BufferPrintf::getParsedFormat() const
+{
+  // Format strings are looked up and parsed once per Format_ID
+  uint32_t id = getFormatID();
+  auto found = m_formatCache.find(id);
+  if ( found != m_formatCache.end() ) {
+    return *found->second;
+  }
+  std::string formatStr;
+  lookup(id, formatStr);
+  const ParsedFormat& format = Printf::getParsedFormat(formatStr);
+  m_formatCache.emplace(id, &format);
+  return format;
+}
+
 uint32_t BufferPrintf::getFormatID() const
 {
   uint32_t id = (uint32_t)extractField(m_currentOffset, getFormatByteCount());
@@ -922,8 +963,11 @@ uint32_t BufferPrintf::getFormatID() const
 
 void BufferPrintf::lookup(int id, std::string& retval) const
 {
-  auto found = m_stringTable.find(id);
-  if ( found != m_stringTable.end() ) {
+  if ( !m_stringTable ) {
+    throwError("BufferPrintf lookup() - no string table");
+  }
+  auto found = m_stringTable->find(id);
+  if ( found != m_stringTable->end() ) {
     retval = found->second;
   }
   else {
@@ -943,7 +987,7 @@ uint64_t BufferPrintf::extractField(int idx, int byteCount) const
   return val;
 }
 
-PrintfArg BufferPrintf::buildArg(int bufIdx, ConversionSpec& conversion) const
+PrintfArg BufferPrintf::buildArg(int bufIdx, const ConversionSpec& conversion) const
 {
   int elementBytes = getElementByteCount(conversion);
   if ( conversion.isIntClass() ) {
@@ -1003,7 +1047,7 @@ PrintfArg BufferPrintf::buildArg(int bufIdx, ConversionSpec& conversion) const
 
 /////////////////////////////////////////////////////////////////////////
 
-std::string convertArg(PrintfArg& arg, ConversionSpec& conversion)
+std::string convertArg(PrintfArg& arg, const ConversionSpec& conversion)
 {
   std::string retval = "";
   char formatStr[32];
@@ -1122,17 +1166,19 @@ std::string convertArg(PrintfArg& arg, ConversionSpec& conversion)
 
 std::string string_printf(const std::string& formatStr, std::vector<PrintfArg> args)
 {
-  std::vector<ConversionSpec> specVec;
-  std::vector<std::string> splitVec;
-  FormatString formatString(formatStr);
-  if ( formatString.isValid() == false ) {
+  return string_printf(getParsedFormat(formatStr), args);
+}
+
+std::string string_printf(const ParsedFormat& format, std::vector<PrintfArg>& args)
+{
+  const std::vector<ConversionSpec>& specVec = format.m_specVec;
+  const std::vector<std::string>& splitVec = format.m_splitFormatString;
+  if ( format.m_valid == false ) {
     std::ostringstream oss;
-    oss << "Error - invalid format string '" << formatStr;
+    oss << "Error - invalid format string '" << format.m_format;
     throwError(oss.str());
     return "";
   }
-  formatString.getSplitFormatString(splitVec);
-  formatString.getSpecifiers(specVec);
 
   if ( args.size() != specVec.size() ) {
     std::ostringstream oss;
@@ -1147,7 +1193,7 @@ std::string string_printf(const std::string& formatStr, std::vector<PrintfArg> a
   }
   for ( size_t idx = 1; idx < splitVec.size(); ++idx ) {
     PrintfArg& arg = args[idx-1];
-    ConversionSpec& conversion = specVec[idx-1];
+    const ConversionSpec& conversion = specVec[idx-1];
     oss << convertArg(arg, conversion);
     oss << splitVec[idx];
   }
@@ -1155,6 +1201,18 @@ std::string string_printf(const std::string& formatStr, std::vector<PrintfArg> a
   return retval;
 }
 
+const ParsedFormat& getParsedFormat(const std::string& formatStr)
+{
+  static std::mutex mutex;
+  static std::map<std::string,std::unique_ptr<ParsedFormat>> cache;
+  std::lock_guard<std::mutex> lk(mutex);
+  auto& format = cache[formatStr];
+  if ( !format ) {
+    format = std::make_unique<ParsedFormat>(formatStr);
+  }
+  return *format;
+}
+
 void throwError(const std::string& errorMsg)
 {
   throw std::runtime_error(errorMsg);
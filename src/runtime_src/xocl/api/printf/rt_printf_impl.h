@@ -160,6 +160,24 @@ private:
 
 };
 
+/////////////////////////////////////////////////////////////////////////
+// ParsedFormat -
+//
+// A format string parsed once into its conversion specifiers and split
+// strings along with the number of buffer bytes taken by the arguments
+// of one record.  Parsed formats are cached by format string and shared
+// by all printf buffers, see getParsedFormat().
+struct ParsedFormat
+{
+    std::string m_format;
+    bool m_valid;
+    std::vector<ConversionSpec> m_specVec;
+    std::vector<std::string> m_splitFormatString;
+    int m_argByteCount;
+
+    explicit ParsedFormat(const std::string& format);
+};
+
 /////////////////////////////////////////////////////////////////////////
 // A decoded printf argument. This is just a convenient way to quickly 
 // store anything that a printf argument is allowed to be. Arguments are 
@@ -242,14 +260,18 @@ public:
     typedef std::map<uint32_t,std::string> StringTable;
 
 public:
+    // The string table is referenced, not copied, and must outlive
+    // the BufferPrintf
     BufferPrintf();
     BufferPrintf(const MemBuffer& buf, const StringTable& table);
+    BufferPrintf(MemBuffer&& buf, const StringTable& table);
     BufferPrintf(const uint8_t* buf, size_t bufSize, const StringTable& table);
 
     ~BufferPrintf();
 
     void setBuffer(const uint8_t* buf, size_t bufLen);
     void setBuffer(const MemBuffer& buf);
+    void setBuffer(MemBuffer&& buf);
 
     void setStringTable(const StringTable& table);
     
@@ -286,6 +308,9 @@ private:
     // Extracts the Format for the current record
     std::string getFormat() const;
 
+    // Parsed Format for the current record, cached by Format_ID
+    const ParsedFormat& getParsedFormat() const;
+
     // Extracts the Format_ID for the current record
     uint32_t getFormatID() const;
 
@@ -297,7 +322,7 @@ private:
 
     // Build up a printf argument given the conversion specifier
     // and memory buffer and string table
-    PrintfArg buildArg(int bufIdx, ConversionSpec& conversion) const;
+    PrintfArg buildArg(int bufIdx, const ConversionSpec& conversion) const;
     
     // Convert escape sequences \n, \r, \t, \ to text representation
     // Newline replaced by string: "\n"
@@ -309,7 +334,8 @@ private:
     // currentOffset always points at the current format string
     int m_currentOffset;
     MemBuffer m_buf;
-    StringTable m_stringTable;
+    const StringTable* m_stringTable;
+    mutable std::map<uint32_t,const ParsedFormat*> m_formatCache;
 };
 
 
@@ -319,12 +345,18 @@ private:
 // Perform a conversion given a single printf argument and return the string 
 // representation of the result. This is called repeatedly for each arg
 // during string_printf to build the complete output string.
-std::string convertArg(PrintfArg& arg, ConversionSpec& conversion);
+std::string convertArg(PrintfArg& arg, const ConversionSpec& conversion);
 
 // Given format string and args, create and return a string (similar to sprintf). 
 // This exercises the round trip internal printf and is used to test breaking down
 // a format and printing arguments.
 std::string string_printf(const std::string& formatStr, std::vector<PrintfArg> args);
+std::string string_printf(const ParsedFormat& format, std::vector<PrintfArg>& args);
+
+// Return the parsed format for a format string.  Each distinct format
+// string is parsed once per process, the returned reference remains
+// valid for the life of the process.
+const ParsedFormat& getParsedFormat(const std::string& formatStr);
 
 // Throws an exception with the given error message. Put as a utility function 
 // because I am not sure on the exception throwing and error reporting standards
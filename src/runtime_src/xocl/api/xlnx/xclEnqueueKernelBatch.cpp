@@ -0,0 +1,224 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CL/cl_ext_xilinx.h>
+#include "xocl/config.h"
+#include "xocl/core/error.h"
+#include "xocl/core/kernel.h"
+#include "xocl/core/device.h"
+#include "xocl/core/command_queue.h"
+#include "xocl/core/event.h"
+#include "xocl/core/execution_context.h"
+
+#include "detail/command_queue.h"
+#include "detail/kernel.h"
+#include "detail/event.h"
+
+#include "enqueue.h"
+#include "api.h"
+
+#include "plugin/xdp/appdebug.h"
+#include "plugin/xdp/profile.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace xocl {
+
+static void
+validOrError(cl_command_queue         command_queue,
+             cl_kernel                kernel,
+             cl_uint                  num_launches,
+             const xcl_kernel_launch* launches,
+             cl_uint                  num_events_in_wait_list,
+             const cl_event*          event_wait_list,
+             cl_event*                event)
+{
+  if (!config::api_checks())
+    return;
+
+  // CL_INVALID_COMMAND_QUEUE if command_queue is not a valid host
+  // command-queue.
+  detail::command_queue::validOrError(command_queue);
+
+  // CL_INVALID_PROGRAM_EXECUTABLE if there is no successfully built
+  // program executable available for device associated with
+  // command_queue
+  if (!xocl(command_queue)->get_device()->is_active())
+    throw error(CL_INVALID_PROGRAM_EXECUTABLE,"No program executable for device");
+
+  // CL_INVALID_KERNEL if kernel is not a valid kernel object
+  detail::kernel::validOrError(kernel);
+
+  // CL_INVALID_KERNEL if kernel uses printf, the printf buffer is
+  // per launch and not supported in a batch
+  if (xocl(kernel)->has_printf())
+    throw error(CL_INVALID_KERNEL,"printf is not supported for batched kernel launches");
+
+  // CL_INVALID_CONTEXT if context associated with command_queue and
+  // kernel are not the same or if the context associated with
+  // command_queue and events in event_wait_list are not the same.
+  detail::event::validOrError(command_queue,num_events_in_wait_list,event_wait_list);
+
+  // CL_INVALID_VALUE if num_launches is 0 or launches is nullptr
+  if (!num_launches || !launches)
+    throw error(CL_INVALID_VALUE,"no kernel launches");
+
+  // CL_INVALID_VALUE if a launch has arguments but args is nullptr
+  if (std::any_of(launches,launches+num_launches,
+                  [](const xcl_kernel_launch& l) { return l.num_args && !l.args; }))
+    throw error(CL_INVALID_VALUE,"kernel launch args is nullptr");
+
+  // Argument values are validated by validArgsOrError, and
+  // kernel launch validation is per clEnqueueTask
+}
+
+// Validate the argument values of all launches before any is set, so
+// that an invalid value leaves the kernel arguments unchanged.  Errors
+// raised while the launches are set up, connectivity or allocation,
+// leave the arguments of the launches set so far.
+static void
+validArgsOrError(cl_kernel                kernel,
+                 cl_uint                  num_launches,
+                 const xcl_kernel_launch* launches)
+{
+  auto xkernel = xocl(kernel);
+  for (auto l=launches, le=launches+num_launches; l!=le; ++l) {
+    for (auto arg=l->args, ae=l->args+l->num_args; arg!=ae; ++arg) {
+      auto where = "argument '" + std::to_string(arg->arg_index)
+        + "' of kernel launch '" + std::to_string(l-launches) + "'";
+      try {
+        xkernel->validate_argument(arg->arg_index,arg->arg_size,arg->arg_value);
+      }
+      catch (const std::out_of_range&) {
+        throw error(CL_INVALID_ARG_INDEX,"bad kernel " + where);
+      }
+      catch (const error& ex) {
+        throw error(ex.get_code(),"invalid " + where + ": " + ex.what());
+      }
+    }
+  }
+
+  if (!config::api_checks())
+    return;
+
+  // CL_INVALID_KERNEL_ARGS if an argument is set neither before the
+  // call nor by the first launch.  Arguments carry over, so later
+  // launches then have all arguments set as well.
+  unsigned long idx = 0;
+  for (auto& arg : xkernel->get_indexed_argument_range()) {
+    auto first = launches[0].args;
+    auto last = first + launches[0].num_args;
+    if (!arg->is_set()
+        && std::none_of(first,last,[idx](const xcl_kernel_arg& a) { return a.arg_index==idx; }))
+      throw error(CL_INVALID_KERNEL_ARGS,"Kernel arg '" + arg->get_name() + "' is not set");
+    ++idx;
+  }
+}
+
+static cl_int
+xclEnqueueKernelBatch(cl_command_queue         command_queue,
+                      cl_kernel                kernel,
+                      cl_uint                  num_launches,
+                      const xcl_kernel_launch* launches,
+                      cl_uint                  num_events_in_wait_list,
+                      const cl_event*          event_wait_list,
+                      cl_event*                event_parameter)
+{
+  validOrError(command_queue,kernel,num_launches,launches
+               ,num_events_in_wait_list,event_wait_list,event_parameter);
+
+  validArgsOrError(kernel,num_launches,launches);
+
+  auto device = xocl(command_queue)->get_device();
+
+  // Set the arguments of each launch in turn, allocate the launch's
+  // buffers on the device, and capture the launch register map.
+  // Only arguments that changed from previous launch are recomputed.
+  std::vector<execution_context::launch> batch;
+  std::vector<xocl::memory*> kernel_args;
+  batch.reserve(num_launches);
+  for (auto l=launches, le=launches+num_launches; l!=le; ++l) {
+    for (auto arg=l->args, ae=l->args+l->num_args; arg!=ae; ++arg) {
+      auto err = api::clSetKernelArg(kernel,arg->arg_index,arg->arg_size,arg->arg_value);
+      if (err != CL_SUCCESS)
+        throw error(err,"failed to set argument '" + std::to_string(arg->arg_index)
+                    + "' of kernel launch '" + std::to_string(l-launches) + "'");
+    }
+
+    auto args = enqueue::allocate_kernel_args(device,kernel);
+    kernel_args.insert(kernel_args.end(),args.begin(),args.end());
+    batch.push_back(execution_context::capture_launch(device,xocl(kernel)));
+  }
+
+  // Each buffer is migrated once for the entire batch
+  std::sort(kernel_args.begin(),kernel_args.end());
+  kernel_args.erase(std::unique(kernel_args.begin(),kernel_args.end()),kernel_args.end());
+
+  // Event for kernel arg migration.  The batch events carry no memory
+  // access set, so with hazard tracking they are ordered conservatively.
+  auto umEvent = xocl::create_hard_event(command_queue,CL_COMMAND_MIGRATE_MEM_OBJECTS,num_events_in_wait_list,event_wait_list);
+  cl_event mEvent = umEvent.get();
+  enqueue::set_event_action(umEvent.get(),enqueue::action_ndrange_migrate_batch,std::move(kernel_args));
+  profile::set_event_action(umEvent.get(),profile::action_ndrange_migrate,mEvent,kernel);
+  appdebug::set_event_action(umEvent.get(),appdebug::action_ndrange_migrate,mEvent,kernel);
+  umEvent->queue();
+
+  // Event for kernel execution of all launches, must wait on migration
+  const size_t global_work_offset[3] = {0,0,0};
+  const size_t global_work_size[3] = {1,1,1};
+  const size_t local_work_size[3] = {1,1,1};
+  auto ueEvent = xocl::create_hard_event(command_queue,CL_COMMAND_NDRANGE_KERNEL,1,&mEvent);
+  cl_event eEvent = ueEvent.get();
+  ueEvent->set_execution_context
+    (std::make_unique<execution_context>
+     (device,xocl(kernel),xocl(eEvent),std::move(batch)
+      ,1,global_work_offset,global_work_size,local_work_size));
+  enqueue::set_event_action(ueEvent.get(),enqueue::action_ndrange_execute);
+  profile::set_event_action(ueEvent.get(),profile::action_ndrange,eEvent,kernel);
+  appdebug::set_event_action(ueEvent.get(),appdebug::action_ndrange,eEvent,kernel);
+  ueEvent->queue();
+
+  xocl::assign(event_parameter,ueEvent.get());
+  return CL_SUCCESS;
+}
+
+} // xocl
+
+extern CL_API_ENTRY cl_int CL_API_CALL
+xclEnqueueKernelBatch(cl_command_queue         command_queue,
+                      cl_kernel                kernel,
+                      cl_uint                  num_launches,
+                      const xcl_kernel_launch* launches,
+                      cl_uint                  num_events_in_wait_list,
+                      const cl_event*          event_wait_list,
+                      cl_event*                event)
+{
+  try {
+    PROFILE_LOG_FUNCTION_CALL_WITH_QUEUE(command_queue);
+    return xocl::xclEnqueueKernelBatch
+      (command_queue,kernel,num_launches,launches
+       ,num_events_in_wait_list,event_wait_list,event);
+  }
+  catch (const xocl::error& ex) {
+    xocl::send_exception_message(ex.what());
+    return ex.get_code();
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+    return CL_OUT_OF_HOST_MEMORY;
+  }
+}
@@ -18,6 +18,7 @@
 #include "context.h"
 #include "device.h"
 #include "event.h"
+#include "memory.h"
 
 #include "xocl/api/plugin/xdp/profile.h"
 
@@ -31,6 +32,21 @@ namespace {
 static xocl::command_queue::commandqueue_callback_list sg_constructor_callbacks;
 static xocl::command_queue::commandqueue_callback_list sg_destructor_callbacks;
 
+// Sub-buffers alias their parent, track hazards on the root buffer
+static const xocl::memory*
+hazard_key(const xocl::memory* mem)
+{
+  while (auto parent = mem->get_sub_buffer_parent())
+    mem = parent;
+  return mem;
+}
+
+static bool
+overlaps(const char* p1, size_t sz1, const char* p2, size_t sz2)
+{
+  return p1 < p2+sz2 && p2 < p1+sz1;
+}
+
 }
 
 namespace xocl {
@@ -45,6 +61,8 @@ command_queue(context* ctx, device* device, cl_command_queue_properties props)
   if (xrt::config::get_profile())
     m_props |= CL_QUEUE_PROFILING_ENABLE;
 
+  m_hazard_tracking = !m_props.test(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) && xrt::config::get_hazard_tracking();
+
   XOCL_DEBUG(std::cout,"xocl::command_queue::command_queue(",m_uid,")\n");
   //appdebug::add_command_queue(this);
 
@@ -77,7 +95,10 @@ queue(event* ev)
   XOCL_DEBUG(std::cout,"queue(",m_uid,") queues event(",ev->get_uid(),")\n");
 
   std::lock_guard<std::mutex> lk(m_events_mutex);
-  if (!ooo && m_last_queued_event.get()) {
+  if (m_hazard_tracking) {
+    queue_hazards(ev);
+  }
+  else if (!ooo && m_last_queued_event.get()) {
     m_last_queued_event->chain(ev);
 
     auto tmp_lval = static_cast<cl_event>(m_last_queued_event.get());
@@ -88,12 +109,14 @@ queue(event* ev)
     for (auto b: m_barriers)
       b->chain(ev);
 
-    xocl::profile::log_dependencies(ev, m_barriers.size(), reinterpret_cast<cl_event*>(m_barriers.data()) );
+    std::vector<cl_event> deps(m_barriers.begin(),m_barriers.end());
+    xocl::profile::log_dependencies(ev, deps.size(), deps.data());
 
     if (ev->get_command_type()==CL_COMMAND_BARRIER)
       m_barriers.push_back(ev);
   }
 
+  ev->m_queue_order = ++m_queue_order;
   m_events.insert(ev);
   m_last_queued_event = ev;
   ev->retain();
@@ -101,6 +124,117 @@ queue(event* ev)
   return true;
 }
 
+void
+command_queue::
+queue_hazards(event* ev)
+{
+  std::vector<event*> deps;
+  auto depend = [&deps,ev](event* dep) {
+    if (dep && dep!=ev && std::find(deps.begin(),deps.end(),dep)==deps.end())
+      deps.push_back(dep);
+  };
+
+  auto access = ev->m_memory_access.get();
+  if (!access) {
+    // Unknown side effects, order after everything queued so far.
+    // Subsequent events need only order after this event, so prior
+    // hazard state can be dropped.
+    for (auto e : m_events)
+      depend(e);
+    m_memory_hazards.clear();
+    m_host_hazards.clear();
+    m_last_kernel_event = nullptr;
+    m_ordering_event = ev;
+  }
+  else {
+    // Memory objects are keyed once here while they are known to be
+    // alive, removal of the event uses the recorded keys as is.
+    for (auto& mem : access->reads)
+      mem = hazard_key(mem);
+    for (auto& mem : access->writes)
+      mem = hazard_key(mem);
+
+    depend(m_ordering_event);
+
+    if (access->kernel) {
+      depend(m_last_kernel_event);
+      m_last_kernel_event = ev;
+    }
+
+    // RAW
+    for (auto mem : access->reads) {
+      auto& hazard = m_memory_hazards[mem];
+      depend(hazard.writer);
+      hazard.readers.push_back(ev);
+    }
+
+    // WAW and WAR.  Later events that order after this writer are
+    // transitively ordered after the readers it waits on.
+    for (auto mem : access->writes) {
+      auto& hazard = m_memory_hazards[mem];
+      depend(hazard.writer);
+      for (auto reader : hazard.readers)
+        depend(reader);
+      hazard.writer = ev;
+      hazard.readers.clear();
+    }
+
+    for (auto& range : access->host) {
+      for (auto& hazard : m_host_hazards)
+        if ((range.write || hazard.write) && overlaps(range.ptr,range.size,hazard.ptr,hazard.size))
+          depend(hazard.ev);
+    }
+    for (auto& range : access->host)
+      m_host_hazards.push_back({ev,range.ptr,range.size,range.write});
+  }
+
+  for (auto dep : deps)
+    dep->chain(ev);
+
+  if (!deps.empty()) {
+    std::vector<cl_event> cldeps(deps.begin(),deps.end());
+    xocl::profile::log_dependencies(ev, cldeps.size(), cldeps.data());
+  }
+
+  XOCL_DEBUG(std::cout,"queue(",m_uid,") event(",ev->get_uid(),") has ",deps.size()," hazards\n");
+}
+
+void
+command_queue::
+remove_hazards(event* ev)
+{
+  if (m_ordering_event==ev)
+    m_ordering_event = nullptr;
+  if (m_last_kernel_event==ev)
+    m_last_kernel_event = nullptr;
+
+  auto access = ev->get_memory_access();
+  if (!access)
+    return;
+
+  auto erase = [this,ev](const memory* mem) {
+    auto itr = m_memory_hazards.find(mem);
+    if (itr==m_memory_hazards.end())
+      return;
+    auto& hazard = itr->second;
+    if (hazard.writer==ev)
+      hazard.writer = nullptr;
+    hazard.readers.erase(std::remove(hazard.readers.begin(),hazard.readers.end(),ev),hazard.readers.end());
+    if (!hazard.writer && hazard.readers.empty())
+      m_memory_hazards.erase(itr);
+  };
+
+  for (auto mem : access->reads)
+    erase(mem);
+  for (auto mem : access->writes)
+    erase(mem);
+
+  if (!access->host.empty())
+    m_host_hazards.erase
+      (std::remove_if(m_host_hazards.begin(),m_host_hazards.end(),[ev](const host_hazard& h) { return h.ev==ev; })
+       ,m_host_hazards.end());
+}
+
 bool
 command_queue::
 submit(event* ev)
@@ -142,6 +276,9 @@ remove(event* ev)
   if (m_last_queued_event==ev)
     m_last_queued_event = nullptr;
 
+  if (m_hazard_tracking)
+    remove_hazards(ev);
+
   if ((ev->get_command_type()==CL_COMMAND_BARRIER) && (m_props.test(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)))  {
     auto bit = std::find(m_barriers.begin(),m_barriers.end(),ev);
     assert(bit!=m_barriers.end());
@@ -149,7 +286,8 @@ remove(event* ev)
   }
 
   ev->release();
-  if (m_events.empty())
+  // Ordering point waits are for events queued before a given event
+  if (m_events.empty() || m_hazard_tracking)
     m_has_events.notify_all();
 
 #if 0
@@ -181,6 +319,22 @@ wait() const
     m_has_events.wait(lk);
 }
 
+void
+command_queue::
+wait(event* ev) const
+{
+  ev->wait();
+  if (!m_hazard_tracking)
+    return;
+
+  XOCL_DEBUG(std::cout,"xocl::command_queue::wait(",m_uid,",",ev->get_uid(),")\n");
+  auto order = ev->m_queue_order;
+  std::unique_lock<std::mutex> lk(m_events_mutex);
+  auto prior = [order](const event* e) { return e->m_queue_order < order; };
+  while (std::any_of(m_events.begin(),m_events.end(),prior))
+    m_has_events.wait(lk);
+}
+
 void
 command_queue::
 flush() const
@@ -24,6 +24,7 @@
 #include <vector>
 #include <set>
 #include <unordered_set>
+#include <unordered_map>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
@@ -160,6 +161,17 @@ public:
   void
   wait() const;
 
+  /**
+   * Wait for an event of this queue to complete as an ordering point
+   *
+   * In an in-order queue with hazard tracking an event is ordered only
+   * after events it has a data hazard with.  Blocking enqueues and
+   * clWaitForEvents must still observe in-order semantics, so this
+   * also waits for all events queued before the argument event.
+   */
+  void
+  wait(event* ev) const;
+
   /**
    * Wait for all enqueued events to be submitted
    */
@@ -194,6 +206,40 @@ public:
   register_destructor_callbacks(commandqueue_callback_type&& aCallback);
 
 private:
+  /**
+   * Chain argument event to the queued events it has a data hazard
+   * with per its recorded memory access set.
+   *
+   * Pre-condition: m_events_mutex is locked
+   */
+  void
+  queue_hazards(event* ev);
+
+  /**
+   * Remove argument event from hazard tracking
+   *
+   * Pre-condition: m_events_mutex is locked
+   */
+  void
+  remove_hazards(event* ev);
+
+private:
+  // Outstanding accesses of one memory object
+  struct memory_hazard
+  {
+    event* writer = nullptr;
+    std::vector<event*> readers;
+  };
+
+  // Outstanding access of a host memory range
+  struct host_hazard
+  {
+    event* ev;
+    const char* ptr;
+    size_t size;
+    bool write;
+  };
+
   unsigned int m_uid = 0;
   ptr<context> m_context;
   ptr<device> m_device;
@@ -204,6 +250,16 @@ private:
   std::vector<event*> m_barriers;
   ptr<event> m_last_queued_event;
   property_type m_props;
+
+  // In-order hazard tracking, guarded by m_events_mutex.  Events
+  // without a recorded memory access set become the ordering event
+  // that all subsequent events chain to.
+  bool m_hazard_tracking = false;
+  std::unordered_map<const memory*,memory_hazard> m_memory_hazards;
+  std::vector<host_hazard> m_host_hazards;
+  event* m_last_kernel_event = nullptr;
+  event* m_ordering_event = nullptr;
+  uint64_t m_queue_order = 0;
 };
 
 } // xocl
@@ -27,6 +27,7 @@
 
 #include "core/common/xclbin_parser.h"
 
+#include <atomic>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -34,7 +35,7 @@
 
 namespace {
 
-static unsigned int uid_count = 0;
+static std::atomic<unsigned int> uid_count(0);
 
 static
 std::string
@@ -516,8 +517,9 @@ set_xrt_device(xrt::device* xd,bool final)
     throw std::runtime_error("temp device already set");
   m_xdevice = xd;
 
-  // start the DMA threads if necessary
-  if (final)
+  // start the DMA threads if the device is already in use by a
+  // context, otherwise they are started on first lock()
+  if (final && m_locks)
     m_xdevice->setup();
 }
 
@@ -556,12 +558,14 @@ lock()
   if (m_locks)
     return ++m_locks;
 
-  // First time, but only hw devices need locking
+  // First time, but only hw devices need locking.  The DMA worker
+  // threads are started when the device is first used in a context.
 #ifndef PMD_OCL
   if (m_hw_device) {
     auto rv = m_hw_device->lockDevice();
     if (rv.valid() && rv.get())
       throw  xocl::error(CL_DEVICE_NOT_AVAILABLE,"could not lock device");
+    m_hw_device->setup();
   }
 #endif
 
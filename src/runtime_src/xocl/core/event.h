@@ -236,6 +236,98 @@ public:
     m_command_type = ct;
   }
 
+  /**
+   * Memory objects and host memory accessed by this event
+   *
+   * Recorded by the enqueue APIs prior to queuing the event, and
+   * used by in-order command queues with hazard tracking enabled to
+   * order the event only after events it has a data hazard with.
+   * An event without a recorded access set is ordered after all
+   * events queued before it.
+   */
+  struct memory_access
+  {
+    struct host_range
+    {
+      const char* ptr;
+      size_t size;
+      bool write;
+    };
+
+    std::vector<const memory*> reads;
+    std::vector<const memory*> writes;
+    std::vector<host_range> host;
+
+    // Kernel executions remain ordered with respect to each other
+    bool kernel = false;
+  };
+
+  /**
+   * Record that this event reads argument memory object
+   *
+   * Pre-condition (unchecked): Event is not yet queued
+   */
+  void
+  add_memory_read(const memory* mem)
+  {
+    get_or_create_memory_access()->reads.push_back(mem);
+  }
+
+  /**
+   * Record that this event writes argument memory object
+   *
+   * Pre-condition (unchecked): Event is not yet queued
+   */
+  void
+  add_memory_write(const memory* mem)
+  {
+    get_or_create_memory_access()->writes.push_back(mem);
+  }
+
+  /**
+   * Record that this event accesses the host memory range [ptr,ptr+sz)
+   *
+   * Pre-condition (unchecked): Event is not yet queued
+   */
+  void
+  add_host_access(const void* ptr, size_t sz, bool write)
+  {
+    get_or_create_memory_access()->host.push_back({static_cast<const char*>(ptr),sz,write});
+  }
+
+  /**
+   * Record that this event has a known access set, which may be
+   * empty, so that it is not ordered after all prior events
+   *
+   * Pre-condition (unchecked): Event is not yet queued
+   */
+  void
+  add_memory_access()
+  {
+    get_or_create_memory_access();
+  }
+
+  /**
+   * Record that this event executes a kernel
+   *
+   * Pre-condition (unchecked): Event is not yet queued
+   */
+  void
+  add_kernel_access()
+  {
+    get_or_create_memory_access()->kernel = true;
+  }
+
+  /**
+   * @return
+   *   Recorded memory access set or nullptr if none was recorded
+   */
+  const memory_access*
+  get_memory_access() const
+  {
+    return m_memory_access.get();
+  }
+
   /**
    * Hook for overriding the autmatic time setting of
    * a profiling event.
@@ -402,6 +494,14 @@ protected:
   chain(event* ev);
 
 private:
+  memory_access*
+  get_or_create_memory_access()
+  {
+    if (!m_memory_access)
+      m_memory_access = std::make_unique<memory_access>();
+    return m_memory_access.get();
+  }
+
   /**
    * Submit this event for execution if possible
    *
@@ -516,6 +616,13 @@ private:
   // allocation unless needed.
   std::unique_ptr<callback_list> m_callbacks;
 
+  // Memory access set if recorded.  On heap to avoid allocation
+  // unless needed.
+  std::unique_ptr<memory_access> m_memory_access;
+
+  // Position of event in its command queue, set when queued
+  uint64_t m_queue_order = 0;
+
   // List of chained events (events to submit upon completion)
   event_vector_type m_chain;
 
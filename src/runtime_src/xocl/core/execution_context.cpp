@@ -180,41 +180,31 @@ struct execution_context::start_kernel_conformance : start_kernel
   }
 };
 
-static int
-fill_regmap(execution_context::regmap_type& regmap, size_t offset,
-            const void* data, const size_t size,
-            const xocl::kernel::argument::arginfo_range_type& arginforange)
+static std::vector<execution_context::launch>
+capture_single_launch(device* device, kernel* kd)
 {
-  // scale raw data input to specified size so that the
-  // value when cast to uint32_t* doesn't carry junk in case
-  // size is less than sizeof(uint32_t). Fill host_data
-  // conservative with an additional sizeof(uint32_t) bytes.
-  const char* cdata = reinterpret_cast<const char*>(data);
-  std::vector<char> host_data(cdata,cdata+size);
-  host_data.resize(size+sizeof(uint32_t));
-
-  // For each component of the argument
-  for (auto arginfo : arginforange) {
-    const char* component = host_data.data() + arginfo->hostoffset;
-    const uint32_t* word = reinterpret_cast<const uint32_t*>(component);
-    // For each 32-bit word of the component
-    for (size_t wi=0, we=arginfo->size/sizeof(uint32_t); wi!=we; ++wi) {
-      size_t device_offset = arginfo->offset + wi*sizeof(uint32_t);
-      uint32_t device_value = *word;
-      size_t register_offset = device_offset / sizeof(uint32_t);
-      regmap[offset+register_offset] = device_value;
-      //      std::cout << "regmap[" << register_offset << "]=" << device_value << "\n";
-      ++word;
-    }
-  }
-  return 0;
+  std::vector<execution_context::launch> launches;
+  launches.push_back(execution_context::capture_launch(device,kd));
+  return launches;
 }
 
+execution_context::
+execution_context(device* device
+                  ,kernel* kd
+                  ,event* event
+                  ,size_t work_dim
+                  ,const size_t* global_work_offset
+                  ,const size_t* global_work_size
+                  ,const size_t* local_work_size)
+  : execution_context(device,kd,event,capture_single_launch(device,kd)
+                      ,work_dim,global_work_offset,global_work_size,local_work_size)
+{}
 
 execution_context::
 execution_context(device* device
                   ,kernel* kd
                   ,event* event
+                  ,std::vector<launch>&& launches
                   ,size_t work_dim
                   ,const size_t* global_work_offset
                   ,const size_t* global_work_size
@@ -223,25 +213,43 @@ execution_context(device* device
   , m_event(event)
   , m_kernel(kd)
   , m_device(device)
+  , m_launches(std::move(launches))
 {
   static unsigned int count = 0;
   m_uid = count++;
 
-  XOCL_DEBUGF("execution_context::execution_context(%d) for kernel(%s)\n",m_uid,m_kernel->get_name().c_str());
+  XOCL_DEBUGF("execution_context::execution_context(%d) for kernel(%s) launches(%zu)\n"
+              ,m_uid,m_kernel->get_name().c_str(),m_launches.size());
+  assert(!m_launches.empty());
   std::copy(global_work_offset,global_work_offset+work_dim,m_goffset.begin());
   std::copy(global_work_size,global_work_size+work_dim,m_gsize.begin());
   std::copy(local_work_size,local_work_size+work_dim,m_lsize.begin());
 
-  // Bind the kernel arguments to this context so that the same kernel
-  // object can be reused while this context is executing
-  for (auto& arg : m_kernel->get_argument_range())
-    m_kernel_args.push_back(arg->clone());
-
   // Compute units to use
   add_compute_units(device);
 
   m_dataflow = xrt_core::xclbin::get_dataflow(device->get_axlf());
   XOCL_DEBUGF("execution_context(%d) has dataflow(%d)\n",m_uid,m_dataflow);
+
+  init_regmap();
+}
+
+execution_context::launch
+execution_context::
+capture_launch(device* device, kernel* kd)
+{
+  launch l;
+
+  // Bind the kernel arguments to the launch so that the same kernel
+  // object can be reused while the launch is executing
+  for (auto& arg : kd->get_argument_range())
+    l.args.push_back(arg->clone());
+
+  // The argument values are taken from the kernel's register map
+  // template, which recomputes only the arguments that changed since
+  // the kernel was last launched.
+  l.regmap = kd->get_regmap_template().get_regmap(device);
+  return l;
 }
 
 void
@@ -275,9 +283,9 @@ add_compute_units(device* device)
                      + std::to_string(m_uid) + "'\n");
 }
 
-bool
+void
 execution_context::
-write(const command_type& cmd)
+finalize_packet(const command_type& cmd)
 {
   auto& packet = cmd->get_packet();
   auto data_size = packet.size() - 1; // subtract header
@@ -306,9 +314,6 @@ write(const command_type& cmd)
     for (size_t i=0; i<packet.size(); ++i)
       ostr << "0x" << std::uppercase << std::setfill('0') << std::setw(8) << std::hex << packet[i] << std::dec << "\n";
   }
-
-  xrt::scheduler::schedule(cmd);
-  return true;
 }
 
 void
@@ -365,26 +370,67 @@ update_work()
 
   }
 
+  // Next launch starts over with the first workgroup
+  if (++m_launch < m_launches.size())
+    return;
+
   m_done = true;
 }
 
 void
 execution_context::
+init_regmap()
+{
+  m_regmap_template = &m_kernel->get_regmap_template();
+
+  // Runtime info that is the same for all workgroups
+  using rtinfo = regmap_template::rtinfo;
+  size3 num_workgroups {{0,0,0}};
+  for (auto d : {0,1,2}) {
+    if (m_lsize[d]) // actually always true
+      num_workgroups[d] = m_gsize[d]/m_lsize[d];
+  }
+  size3 local_id {{0,0,0}};
+  auto& rtmpl = *m_regmap_template;
+  for (auto& l : m_launches) {
+    auto regmap = l.regmap.data();
+    regmap_template::patch(regmap,rtmpl.get_rtinfo_layout(rtinfo::work_dim),&m_dim,sizeof(cl_uint));
+    regmap_template::patch(regmap,rtmpl.get_rtinfo_layout(rtinfo::global_offset),m_goffset.data(),3*sizeof(size_t));
+    regmap_template::patch(regmap,rtmpl.get_rtinfo_layout(rtinfo::global_size),m_gsize.data(),3*sizeof(size_t));
+    regmap_template::patch(regmap,rtmpl.get_rtinfo_layout(rtinfo::local_size),m_lsize.data(),3*sizeof(size_t));
+    regmap_template::patch(regmap,rtmpl.get_rtinfo_layout(rtinfo::num_groups),num_workgroups.data(),3*sizeof(size_t));
+    regmap_template::patch(regmap,rtmpl.get_rtinfo_layout(rtinfo::local_id),local_id.data(),3*sizeof(size_t));
+  }
+
+  // Base address of printf buffer, each workgroup gets its own
+  // segment.  Batched launches do not support printf.
+  for (auto& arg : m_launches.front().args) {
+    if (arg->is_printf()) {
+      auto printf_buffer = arg->get_memory_object();
+      assert(printf_buffer);
+      auto boh = printf_buffer->get_buffer_object_or_error(m_device);
+      m_printf_buffer_addr = m_device->get_xrt_device()->getDeviceAddr(boh);
+    }
+  }
+}
+
+execution_context::command_type
+execution_context::
 start()
 {
   XOCL_DEBUGF("execution_context(%d) starting workgroup(%d,%d,%d)\n"
               ,get_uid(),m_cu_group_id[0],m_cu_group_id[1],m_cu_group_id[2]);
 
   // On first work load, transition event to CL_RUNNING
-  if ( (m_cu_group_id[0]==0) && (m_cu_group_id[1]==0) && (m_cu_group_id[2]==0))
+  if (m_launch==0 && (m_cu_group_id[0]==0) && (m_cu_group_id[1]==0) && (m_cu_group_id[2]==0))
     m_event->set_status(CL_RUNNING);
 
   auto xdevice = m_device->get_xrt_device();
 
   // Construct command packet and send to hardware
   auto cmd = conformance::on()
-    ? std::make_shared<start_kernel_conformance>(xdevice,this)
-    : std::make_shared<start_kernel>(xdevice,this);
+    ? xrt::make_command<start_kernel_conformance>(xdevice,this)
+    : xrt::make_command<start_kernel>(xdevice,this);
   ++m_active;
   auto& packet = cmd->get_packet();
 
@@ -392,70 +438,18 @@ start()
   // CUs that can be used
   encode_compute_units(packet);
 
-  // Create the cu register map
+  // Copy the precomputed cu register map
   auto offset = packet.size();  // start of regmap
-  auto& regmap = packet;
+  auto& launch_regmap = m_launches[m_launch].regmap;
+  packet.append(launch_regmap.data(),launch_regmap.size());
+  auto regmap = packet.data() + offset;
 
-  // Ensure that S_AXI_CONTROL is created even when kernel
-  // has no arguments.
-  packet[offset]   = 0;  // control signals
-  packet[offset+1] = 0;  // gier
-  packet[offset+2] = 0;  // ier
-  packet[offset+3] = 0;  // isr
+  // Set workgroup specific runtime arguments
+  using rtinfo = regmap_template::rtinfo;
+  regmap_template::patch(regmap,m_regmap_template->get_rtinfo_layout(rtinfo::global_id),m_cu_global_id.data(),3*sizeof(size_t));
+  regmap_template::patch(regmap,m_regmap_template->get_rtinfo_layout(rtinfo::group_id),m_cu_group_id.data(),3*sizeof(size_t));
 
-  size3 num_workgroups {0,0,0};
-  for (auto d : {0,1,2}) {
-    if (m_lsize[d]) // actually always true
-      num_workgroups[d] = m_gsize[d]/m_lsize[d];
-  }
-
-  // Push kernel args
-  xocl::memory* printf_buffer = nullptr;
-  for (auto& arg : m_kernel_args) {
-    if (arg->is_printf()) {
-      printf_buffer = arg->get_memory_object();
-      assert(printf_buffer);
-      continue;
-    }
-
-    auto address_space = arg->get_address_space();
-    if (address_space == kernel::argument::addr_space_type::SPIR_ADDRSPACE_PRIVATE)
-    {
-      auto arginforange = arg->get_arginfo_range();
-      fill_regmap(regmap,offset,arg->get_value(),arg->get_size(),arginforange);
-    } else if(address_space == kernel::argument::addr_space_type::SPIR_ADDRSPACE_PIPES) {
-	//do nothing
-    } else if (address_space == kernel::argument::addr_space_type::SPIR_ADDRSPACE_GLOBAL
-            || address_space == kernel::argument::addr_space_type::SPIR_ADDRSPACE_CONSTANT)
-    {
-      uint64_t physaddr = 0;
-      if (auto mem = arg->get_memory_object()) {
-        auto boh = xocl::xocl(mem)->get_buffer_object_or_error(m_device);
-        physaddr = xdevice->getDeviceAddr(boh);
-      }
-      else if (auto svm = arg->get_svm_object()) {
-        physaddr = reinterpret_cast<uint64_t>(svm);
-      }
-      auto arginforange = arg->get_arginfo_range();
-      assert(arginforange.size()==1);
-      fill_regmap(regmap,offset,&physaddr, arg->get_size(), arginforange);
-    }
-  }
-
-  for (auto& arg : m_kernel->get_progvar_argument_range()) {
-    uint64_t physaddr = 0;
-    if (auto mem = arg->get_memory_object()) {
-      auto boh = xocl::xocl(mem)->get_buffer_object_or_error(m_device);
-      physaddr = xdevice->getDeviceAddr(boh);
-    }
-    assert(arg->get_arginfo_range().size()==1);
-    fill_regmap(regmap,offset,&physaddr,arg->get_size(),arg->get_arginfo_range());
-  }
-
-  // Set runtime arguments as required
-  size3 local_id {0,0,0};
-  uint64_t printf_buffer_addr = 0;
-  if ( printf_buffer ) {
+  if (m_kernel->has_printf()) {
     // This computes the offset that gets added to a physical printf buffer
     // address for a given workgroup. Necessary so we have a different
     // segment to hold each workgroup in the overall buffer.
@@ -471,37 +465,12 @@ start()
                       group_x_size * m_cu_group_id[1] +
                       group_y_size * group_x_size * m_cu_group_id[2];
     auto printf_buffer_offset = group_id * local_buffer_size;
-    auto boh = printf_buffer->get_buffer_object_or_error(m_device);
-    auto printf_buffer_base_addr = static_cast<uint64_t>(xdevice->getDeviceAddr(boh));
-    printf_buffer_addr = printf_buffer_base_addr + printf_buffer_offset;
-  }
-
-  // Push runtime args
-  for (auto& arg : m_kernel->get_rtinfo_argument_range()) {
-    auto nm = arg->get_name();
-    XOCL_DEBUGF("execution_context(%d) sets rtinfo(%s)\n",get_uid(),nm.c_str());
-    if (nm=="work_dim")
-      fill_regmap(regmap,offset,&m_dim,sizeof(cl_uint),arg->get_arginfo_range());
-    else if (nm=="global_offset")
-      fill_regmap(regmap,offset,m_goffset.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="global_size")
-      fill_regmap(regmap,offset,m_gsize.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="local_size")
-      fill_regmap(regmap,offset,m_lsize.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="num_groups")
-      fill_regmap(regmap,offset,num_workgroups.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="global_id")
-      fill_regmap(regmap,offset,m_cu_global_id.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="local_id")
-      fill_regmap(regmap,offset,local_id.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="group_id")
-      fill_regmap(regmap,offset,m_cu_group_id.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="printf_buffer")
-      fill_regmap(regmap,offset,&printf_buffer_addr,sizeof(printf_buffer_addr),arg->get_arginfo_range());
+    uint64_t printf_buffer_addr = m_printf_buffer_addr + printf_buffer_offset;
+    regmap_template::patch(regmap,m_regmap_template->get_rtinfo_layout(rtinfo::printf_buffer),&printf_buffer_addr,sizeof(printf_buffer_addr));
   }
 
-  // send command to mbs
-  write(cmd);
+  finalize_packet(cmd);
+  return cmd;
 }
 
 bool
@@ -553,13 +522,20 @@ execute()
   // In order to keep scheduler busy, we need more than just one
   // workgroup at a time, so here we try to ensure that the scheduled
   // commands at any given time is twice the number of available CUs.
-  auto limit = m_dataflow ? 20*m_cus.size() : 2*m_cus.size();
+  //
+  // Dataflow kernels and batched launches keep a deeper pipeline of
+  // commands so that CUs are not idle while completions are processed.
+  auto limit = (m_dataflow || m_launches.size()>1) ? 20*m_cus.size() : 2*m_cus.size();
+  std::vector<command_type> cmds;
   for (size_t i=m_active; !m_done && i<limit; ++i) {
-    start();
+    cmds.push_back(start());
     update_work();
     XOCL_DEBUG(std::cout,"active=",m_active,"\n");
   }
 
+  // Send all new commands to the scheduler in one go
+  xrt::scheduler::schedule(cmds);
+
   return m_done;
 }
 
@@ -623,10 +599,12 @@ conformance_execute()
   // Run
   conformance::active(this);
   // Schedule all workgroups
+  std::vector<command_type> cmds;
   for (size_t i=0; !m_done; ++i) {
-    start();
+    cmds.push_back(start());
     update_work();
   }
+  xrt::scheduler::schedule(cmds);
 
   return true;
 }
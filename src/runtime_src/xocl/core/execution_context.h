@@ -20,6 +20,7 @@
 #include "xocl/config.h"
 #include "xocl/core/kernel.h"
 #include "xocl/core/compute_unit.h"
+#include "xocl/core/regmap_template.h"
 
 #include "xrt/scheduler/command.h"
 #include <mutex>
@@ -63,6 +64,20 @@ public:
   using size = std::size_t;
   using size3 = std::array<size,3>;
 
+  using argument_vector_type = std::vector<std::unique_ptr<xocl::kernel::argument>>;
+  using argument_iterator_type = argument_vector_type::const_iterator;
+
+  /**
+   * A launch of the kernel.  The kernel arguments are bound to the
+   * launch so that the same kernel object can be reused while the
+   * launch is executing.  The register map holds the argument values.
+   */
+  struct launch
+  {
+    argument_vector_type args;
+    regmap_template::regmap_type regmap;
+  };
+
 private:
   unsigned int m_uid {0};
 
@@ -88,13 +103,21 @@ private:
   // The device associated with this context
   device* m_device;
 
-  // Kernel state
-  using argument_vector_type = std::vector<std::unique_ptr<xocl::kernel::argument>>;
-  using argument_iterator_type = argument_vector_type::const_iterator;
-  argument_vector_type m_kernel_args;
+  // Kernel launches executed by this context and the launch
+  // currently being scheduled.  Each launch runs all workgroups.
+  std::vector<launch> m_launches;
+  size_t m_launch = 0;
 
   bool m_dataflow = false;
 
+  // Layout of the runtime info that is set per workgroup.  The
+  // launch register maps hold the kernel arguments and the runtime
+  // info that is constant across workgroups.
+  const regmap_template* m_regmap_template = nullptr;
+
+  // Device address of printf buffer if any
+  uint64_t m_printf_buffer_addr = 0;
+
   // The context maintains a list of kernel compute units represented
   // by xcl::cu.  These cus (their base addresses) are used in the command
   // that starts the mbs.
@@ -115,19 +138,31 @@ private:
   void
   add_compute_units(xocl::device* device);
 
-  bool
-  write(const command_type& cmd);
+  /**
+   * Complete the packet header of a command before it is scheduled
+   */
+  void
+  finalize_packet(const command_type& cmd);
 
   void
   encode_compute_units(packet_type& pkt);
 
+  /**
+   * Initialize the launch register maps shared by all workgroups
+   */
+  void
+  init_regmap();
+
   /**
    * Update workgroup accounting.
    */
   void
   update_work();
 
-  void
+  /**
+   * Create the command that starts the current workgroup
+   */
+  command_type
   start();
 
   /**
@@ -158,6 +193,44 @@ public:
                     ,const size_t* global_work_size
                     ,const size_t* local_work_size);
 
+  /**
+   * Construct an execution context for a batch of kernel launches
+   *
+   * Each launch executes the full NDRange with its own arguments.
+   * Launches are not ordered with respect to each other, the event
+   * completes when all launches have completed.
+   *
+   * @param launches
+   *   The launches to execute, created with capture_launch()
+   */
+  execution_context(device* device
+                    ,kernel* kd
+                    ,event* event
+                    ,std::vector<launch>&& launches
+                    ,size_t work_dim
+                    ,const size_t* global_work_offset
+                    ,const size_t* global_work_size
+                    ,const size_t* local_work_size);
+
+  /**
+   * Capture a launch of a kernel with its current arguments
+   *
+   * All buffer arguments of the kernel must have been allocated on
+   * the device.
+   */
+  static launch
+  capture_launch(device* device, kernel* kd);
+
+  /**
+   * @return
+   *   Number of kernel launches in this context
+   */
+  size_t
+  get_num_launches() const
+  {
+    return m_launches.size();
+  }
+
   unsigned long
   get_uid() const
   {
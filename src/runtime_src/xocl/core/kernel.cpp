@@ -19,6 +19,8 @@
 #include "context.h"
 #include "device.h"
 #include "compute_unit.h"
+#include "event.h"
+#include "regmap_template.h"
 #include "core/common/xclbin_parser.h"
 
 #include <sstream>
@@ -122,11 +124,18 @@ add(arginfo_type arg)
 
 void
 kernel::scalar_argument::
-set(size_t size, const void* cvalue)
+validate(size_t size, const void* cvalue) const
 {
   if (size != m_sz)
     throw error(CL_INVALID_ARG_SIZE,"Invalid scalar argument size, expected "
                 + std::to_string(m_sz) + " got " + std::to_string(size));
+}
+
+void
+kernel::scalar_argument::
+set(size_t size, const void* cvalue)
+{
+  validate(size,cvalue);
   // construct vector from iterator range.
   // the value can be gathered with m_value.data()
   // the value bytes can be manipulated with std:: algorithms
@@ -163,6 +172,24 @@ clone()
   return std::make_unique<global_argument>(*this);
 }
 
+// A memory object argument must be from the context of the kernel
+static void
+validate_memory_argument(const kernel* kern, const void* cvalue)
+{
+  auto mem = cvalue ? *static_cast<const cl_mem*>(cvalue) : nullptr;
+  if (mem && xocl(mem)->get_context()!=kern->get_context())
+    throw error(CL_INVALID_MEM_OBJECT,"Kernel arg memory object is from another context");
+}
+
+void
+kernel::global_argument::
+validate(size_t size, const void* cvalue) const
+{
+  if (size != sizeof(cl_mem))
+    throw error(CL_INVALID_ARG_SIZE,"Invalid global_argument size for kernel arg");
+  validate_memory_argument(m_kernel,cvalue);
+}
+
 void
 kernel::global_argument::
 set(size_t size, const void* cvalue)
@@ -201,7 +228,7 @@ clone()
 
 void
 kernel::local_argument::
-set(size_t size, const void* value)
+validate(size_t size, const void* value) const
 {
   if (value!=nullptr)
     throw xocl::error(CL_INVALID_ARG_VALUE,"CL_KERNEL_ARG_ADDRESS_LOCAL value!=nullptr");
@@ -209,7 +236,13 @@ set(size_t size, const void* value)
   // todo: curently fixed at 16K, but should come from kernel.xml
   if (size == 0 || size > 1024*16)
     throw xocl::error(CL_INVALID_ARG_SIZE,"CL_KERNEL_ARG_ADDRESS_LOCAL wrong size:" + std::to_string(size));
+}
 
+void
+kernel::local_argument::
+set(size_t size, const void* value)
+{
+  validate(size,value);
   m_set = true;
 }
 
@@ -220,6 +253,15 @@ clone()
   return std::make_unique<constant_argument>(*this);
 }
 
+void
+kernel::constant_argument::
+validate(size_t size, const void* cvalue) const
+{
+  if (size != sizeof(cl_mem))
+    throw error(CL_INVALID_ARG_SIZE,"Invalid constant_argument size for kernel arg");
+  validate_memory_argument(m_kernel,cvalue);
+}
+
 void
 kernel::constant_argument::
 set(size_t size, const void* cvalue)
@@ -270,13 +312,20 @@ clone()
 
 void
 kernel::stream_argument::
-set(size_t size, const void* cvalue)
+validate(size_t size, const void* cvalue) const
 {
   //PTR_SIZE
   if (size != sizeof(cl_mem))
     throw error(CL_INVALID_ARG_SIZE,"Invalid stream_argument size for kernel arg");
   if(cvalue != nullptr)
     throw error(CL_INVALID_VALUE,"Invalid stream_argument value for kernel arg, it should be null");
+}
+
+void
+kernel::stream_argument::
+set(size_t size, const void* cvalue)
+{
+  validate(size,cvalue);
   m_set = true;
 }
 
@@ -348,6 +397,9 @@ kernel(program* prog, const std::string& name, const xclbin::symbol& symbol)
     } // switch (arg.atype)
   }
 
+  // Created eagerly, concurrent launches of this kernel share the template
+  m_regmap = std::make_unique<regmap_template>(this);
+
   auto cus = kernel_utils::get_cu_names(name);
   auto context = prog->get_context();
   for (auto device : context->get_device_range())
@@ -402,6 +454,73 @@ kernel::
   XOCL_DEBUG(std::cout,"xocl::kernel::~kernel(",m_uid,")\n");
 }
 
+regmap_template&
+kernel::
+get_regmap_template()
+{
+  return *m_regmap;
+}
+
+void
+kernel::
+set_regmap_dirty(unsigned long argidx)
+{
+  // Progvar arguments are set before the template is created, the
+  // template computes all arguments when it is created
+  if (m_regmap)
+    m_regmap->set_dirty(argidx);
+}
+
+ptr<memory>
+kernel::
+acquire_printf_buffer(size_t size)
+{
+  std::lock_guard<std::mutex> lk(m_printf_mutex);
+  auto itr = std::find_if(m_printf_buffers.begin(),m_printf_buffers.end(),
+                          [size](const ptr<memory>& mem) { return mem->get_size()==size; });
+  if (itr == m_printf_buffers.end())
+    return nullptr;
+  auto mem = std::move(*itr);
+  m_printf_buffers.erase(itr);
+  return mem;
+}
+
+void
+kernel::
+release_printf_buffer(ptr<memory>&& mem)
+{
+  // Bound the pool to the number of buffers typically in flight,
+  // excess buffers are released to the context
+  static const size_t max_printf_buffers = 16;
+  std::lock_guard<std::mutex> lk(m_printf_mutex);
+  if (m_printf_buffers.size() < max_printf_buffers)
+    m_printf_buffers.push_back(std::move(mem));
+}
+
+ptr<memory>
+kernel::
+get_printf_reset_buffer(size_t size, ptr<event>& init_event) const
+{
+  std::lock_guard<std::mutex> lk(m_printf_mutex);
+  if (!m_printf_reset_buffer.get() || m_printf_reset_buffer->get_size()!=size)
+    return nullptr;
+
+  // Keep the init event only until it completes, it retains its queue
+  if (m_printf_reset_event.get() && m_printf_reset_event->get_status()==CL_COMPLETE)
+    m_printf_reset_event = nullptr;
+  init_event = m_printf_reset_event;
+  return m_printf_reset_buffer;
+}
+
+void
+kernel::
+set_printf_reset_buffer(ptr<memory>&& mem, ptr<event>&& init_event)
+{
+  std::lock_guard<std::mutex> lk(m_printf_mutex);
+  m_printf_reset_buffer = std::move(mem);
+  m_printf_reset_event = std::move(init_event);
+}
+
 kernel::memidx_bitmask_type
 kernel::
 get_memidx(const device* device, unsigned int argidx) const
@@ -24,12 +24,15 @@
 
 #include "xrt/util/td.h"
 #include <limits>
+#include <mutex>
 
 #include <iostream>
 
 namespace xocl {
 
 class compute_unit;
+class event;
+class regmap_template;
 
 class kernel : public refcount, public _cl_kernel
 {
@@ -139,6 +142,16 @@ public:
     virtual void
     set(size_t sz, const void* arg) = 0;
 
+    /**
+     * Check that set() would accept the value.
+     *
+     * Throws on an invalid value same as set(), but neither this
+     * argument nor the kernel and its buffers are changed.
+     */
+    virtual void
+    validate(size_t sz, const void* arg) const
+    { throw std::runtime_error("not implemented"); }
+
     /**
      * Set an svm argument (clSetKernelArgSVMPointer) to some value.
      */
@@ -253,6 +266,7 @@ public:
     virtual addr_space_type get_address_space() const { return addr_space_type::SPIR_ADDRSPACE_PRIVATE; }
     virtual std::unique_ptr<argument> clone();
     virtual size_t add(arginfo_type arg);
+    virtual void validate(size_t sz, const void* arg) const;
     virtual void set(size_t sz, const void* arg);
     virtual size_t get_size() const { return m_sz; }
     virtual const void* get_value() const { return m_value.data(); }
@@ -276,6 +290,7 @@ public:
     virtual std::string get_name() const { return m_arg_info->name; }
     virtual addr_space_type get_address_space() const { return addr_space_type::SPIR_ADDRSPACE_GLOBAL; }
     virtual std::unique_ptr<argument> clone();
+    virtual void validate(size_t sz, const void* arg) const;
     void set(size_t sz, const void* arg) ;
     void set_svm(size_t sz, const void* arg) ;
     virtual memory* get_memory_object() const { return m_buf.get(); }
@@ -311,6 +326,7 @@ public:
     virtual std::string get_name() const { return m_arg_info->name; }
     virtual addr_space_type get_address_space() const { return addr_space_type::SPIR_ADDRSPACE_LOCAL; }
     virtual std::unique_ptr<argument> clone();
+    virtual void validate(size_t sz, const void* arg) const;
     virtual void set(size_t sz, const void* arg);
     virtual arginfo_range_type get_arginfo_range() const
     { return arginfo_range_type(&m_arg_info,&m_arg_info+1); }
@@ -327,6 +343,7 @@ public:
     virtual argtype get_argtype() const { return m_arg_info->atype; }
     virtual addr_space_type get_address_space() const { return addr_space_type::SPIR_ADDRSPACE_CONSTANT; }
     virtual std::unique_ptr<argument> clone();
+    virtual void validate(size_t sz, const void* arg) const;
     virtual void set(size_t sz, const void* arg);
     virtual memory* get_memory_object() const { return m_buf.get(); }
     virtual size_t get_size() const { return sizeof(memory*); }
@@ -362,6 +379,7 @@ public:
     stream_argument(arginfo_type arg, kernel* kernel)
       : argument(kernel), m_arg_info(arg) { m_set = true; }
     virtual std::unique_ptr<argument> clone();
+    virtual void validate(size_t sz, const void* arg) const;
     virtual void set(size_t sz, const void* arg);
     virtual argtype get_argtype() const { return m_arg_info->atype; }
     virtual addr_space_type get_address_space() const { return addr_space_type::SPIR_ADDRSPACE_PIPES; }
@@ -481,7 +499,7 @@ public:
   }
 
   auto
-  get_stringtable() const -> decltype(xclbin::symbol::stringtable)
+  get_stringtable() const -> const decltype(xclbin::symbol::stringtable)&
   {
     return m_symbol.stringtable;
   }
@@ -502,12 +520,27 @@ public:
   set_argument(unsigned long idx, size_t sz, const void* arg)
   {
     m_indexed_args.at(idx)->set(idx,sz,arg);
+    set_regmap_dirty(idx);
+  }
+
+  /**
+   * Validate an argument value per set_argument without changing the
+   * argument.  The argument, the kernel, and its buffers are not
+   * changed.
+   *
+   * Throws on invalid index or value, same as set_argument
+   */
+  void
+  validate_argument(unsigned long idx, size_t sz, const void* arg) const
+  {
+    m_indexed_args.at(idx)->validate(sz,arg);
   }
 
   void
   set_svm_argument(unsigned long idx, size_t sz, const void* arg)
   {
     m_indexed_args.at(idx)->set_svm(sz,arg);
+    set_regmap_dirty(idx);
   }
 
   void
@@ -554,6 +587,44 @@ public:
     return range<argument_iterator_type>(m_printf_args.begin(),m_printf_args.end());
   }
 
+  /**
+   * Get a recycled printf buffer of this kernel
+   *
+   * Printf buffers are returned to the kernel when the printf
+   * output of a launch has been read back, and are reused by
+   * later launches that need a buffer of the same size.
+   *
+   * @param size
+   *   Required size of buffer in bytes
+   * @return
+   *   A buffer of @size bytes, or nullptr if none is available
+   */
+  ptr<memory>
+  acquire_printf_buffer(size_t size);
+
+  /**
+   * Return a printf buffer for use by a later launch
+   */
+  void
+  release_printf_buffer(ptr<memory>&& mem);
+
+  /**
+   * Initialized buffer used to reset printf buffers on the device
+   *
+   * @param size
+   *   Required size of buffer in bytes
+   * @param init_event
+   *   Set to the event initializing the buffer, which every copy
+   *   from the buffer must wait for, or nullptr if it has completed
+   * @return
+   *   The reset buffer of @size bytes, or nullptr if not created
+   */
+  ptr<memory>
+  get_printf_reset_buffer(size_t size, ptr<event>& init_event) const;
+
+  void
+  set_printf_reset_buffer(ptr<memory>&& mem, ptr<event>&& init_event);
+
   /**
    * Get rtinfo args.
    *
@@ -569,6 +640,16 @@ public:
     return boost::join(m_printf_args,m_rtinfo_args);
   }
 
+  /**
+   * Get the precompiled register map of this kernel
+   *
+   * The template is created with the kernel and tracks changes to
+   * the kernel arguments so that register values are recomputed
+   * only for arguments that changed since the previous launch.
+   */
+  regmap_template&
+  get_regmap_template();
+
   /**
    * @return
    *  List of CUs that can be used by this kernel object
@@ -655,6 +736,10 @@ private:
   void
   assign_buffer_to_argidx(memory* mem, unsigned long argidx);
 
+  // Mark indexed argument as changed in regmap template
+  void
+  set_regmap_dirty(unsigned long argidx);
+
 private:
   unsigned int m_uid = 0;
   ptr<program> m_program;     // retain reference
@@ -664,6 +749,13 @@ private:
   argument_vector_type m_printf_args;
   argument_vector_type m_progvar_args;
   argument_vector_type m_rtinfo_args;
+  std::unique_ptr<regmap_template> m_regmap;
+
+  // Printf buffers available for reuse
+  mutable std::mutex m_printf_mutex;
+  std::vector<ptr<memory>> m_printf_buffers;
+  ptr<memory> m_printf_reset_buffer;
+  mutable ptr<event> m_printf_reset_event;
 };
 
 namespace kernel_utils {
@@ -20,10 +20,12 @@
 
 #include "xocl/xclbin/xclbin.h"
 #include "xrt/scheduler/scheduler.h"
+#include "xrt/util/time.h"
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <cassert>
 
@@ -77,6 +79,15 @@ read_file(const std::string& filename)
   return buffer;
 }
 
+// Startup time breakdown, printed in debug mode
+static void
+debug_elapsed(const char* what, unsigned long& last)
+{
+  auto now = xrt::time_ns();
+  XOCL_DEBUG(std::cout,"xocl::platform startup: ",what," ",(now-last)/1000," us\n");
+  last = now;
+}
+
 static void
 init_conformance()
 {
@@ -209,7 +220,6 @@ public:
 
 platform::
 platform()
-  : m_device_mgr(std::make_unique<xrt_device_manager>())
 {
   static unsigned int uid_count = 0;
   m_uid = uid_count++;
@@ -219,6 +229,11 @@ platform()
 
   XOCL_DEBUG(std::cout,"xocl::platform::platform(",m_uid,")\n");
 
+  auto start = xrt::time_ns();
+  auto last = start;
+  m_device_mgr = std::make_unique<xrt_device_manager>();
+  debug_elapsed("load and probe devices",last);
+
   if (is_emulation_mode()) {
     while (auto hwem_device = m_device_mgr->get_hwem_device()) {
       auto swem_device = m_device_mgr->get_swem_device();
@@ -233,13 +248,21 @@ platform()
 
   //User can target either emulation or board. Not both at the same time.
   if (!is_emulation_mode() && m_device_mgr->has_hw_devices()) {
+    // Opening a board is independent of other boards, so open all
+    // boards concurrently but add them to the platform in probe order.
+    std::vector<std::future<std::unique_ptr<xocl::device>>> udevs;
     while (xrt::device* hw_device = m_device_mgr->get_hw_device()) {
-      auto udev = std::make_unique<xocl::device>(this,hw_device,nullptr,nullptr);
-      auto dev = udev.release();
+      udevs.emplace_back(std::async(std::launch::async,[this,hw_device] {
+        return std::make_unique<xocl::device>(this,hw_device,nullptr,nullptr);
+      }));
+    }
+    for (auto& udev : udevs) {
+      auto dev = udev.get().release();
       add_device(dev);
       dev->release();
     }
   }
+  debug_elapsed("open devices",last);
 
   try {
     xrt::scheduler::start();
@@ -247,8 +270,11 @@ platform()
   catch(const std::exception&) {
     throw error(CL_OUT_OF_HOST_MEMORY,"failed to allocate platform event_scheduler");
   }
+  debug_elapsed("start scheduler",last);
 
   init_conformance();
+  debug_elapsed("init conformance",last);
+  debug_elapsed("total",start);
 }
 
 platform::
@@ -0,0 +1,203 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "regmap_template.h"
+#include "device.h"
+#include "memory.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+using addr_space_type = xocl::kernel::argument::addr_space_type;
+using rtinfo = xocl::regmap_template::rtinfo;
+
+// Arguments whose value is cached in the template
+bool
+is_template_argument(const xocl::kernel::argument* arg)
+{
+  if (arg->is_printf() || arg->is_rtinfo())
+    return false;
+  auto address_space = arg->get_address_space();
+  return address_space == addr_space_type::SPIR_ADDRSPACE_PRIVATE
+    || address_space == addr_space_type::SPIR_ADDRSPACE_GLOBAL
+    || address_space == addr_space_type::SPIR_ADDRSPACE_CONSTANT;
+}
+
+bool
+is_buffer_argument(const xocl::kernel::argument* arg)
+{
+  return arg->get_address_space() != addr_space_type::SPIR_ADDRSPACE_PRIVATE;
+}
+
+rtinfo
+to_rtinfo(const std::string& nm)
+{
+  if (nm=="work_dim")
+    return rtinfo::work_dim;
+  else if (nm=="global_offset")
+    return rtinfo::global_offset;
+  else if (nm=="global_size")
+    return rtinfo::global_size;
+  else if (nm=="local_size")
+    return rtinfo::local_size;
+  else if (nm=="num_groups")
+    return rtinfo::num_groups;
+  else if (nm=="global_id")
+    return rtinfo::global_id;
+  else if (nm=="local_id")
+    return rtinfo::local_id;
+  else if (nm=="group_id")
+    return rtinfo::group_id;
+  else if (nm=="printf_buffer")
+    return rtinfo::printf_buffer;
+  return rtinfo::count;
+}
+
+size_t
+regmap_size(const xocl::regmap_template::arg_layout& layout)
+{
+  size_t size = 0;
+  for (auto& word : layout)
+    size = std::max<size_t>(size,word.regidx+1);
+  return size;
+}
+
+} // namespace
+
+namespace xocl {
+
+regmap_template::arg_layout
+regmap_template::
+compile(const kernel::argument::arginfo_range_type& arginforange)
+{
+  arg_layout layout;
+  // For each component of the argument
+  for (auto arginfo : arginforange) {
+    // For each 32-bit word of the component
+    for (size_t wi=0, we=arginfo->size/sizeof(word_type); wi!=we; ++wi) {
+      auto hostoffset = arginfo->hostoffset + wi*sizeof(word_type);
+      auto regidx = (arginfo->offset + wi*sizeof(word_type)) / sizeof(word_type);
+      layout.push_back({static_cast<uint32_t>(hostoffset),static_cast<uint32_t>(regidx)});
+    }
+  }
+  return layout;
+}
+
+void
+regmap_template::
+patch(word_type* regmap, const arg_layout& layout, const void* data, size_t size)
+{
+  // Host data may be smaller than the register words that hold it,
+  // e.g. a char argument, so copy only what is there and zero fill
+  // the remainder of the word
+  auto cdata = static_cast<const char*>(data);
+  for (auto& word : layout) {
+    word_type value = 0;
+    if (word.hostoffset < size)
+      std::memcpy(&value,cdata+word.hostoffset,std::min(sizeof(word_type),size-word.hostoffset));
+    regmap[word.regidx] = value;
+  }
+}
+
+regmap_template::
+regmap_template(const kernel* kernel)
+  : m_kernel(kernel)
+{
+  // Ensure that S_AXI_CONTROL is created even when kernel has no
+  // arguments (control, gier, ier, isr)
+  size_t size = 4;
+
+  for (auto& arg : m_kernel->get_argument_range()) {
+    m_args.emplace_back(is_template_argument(arg.get())
+                        ? compile(arg->get_arginfo_range())
+                        : arg_layout());
+    size = std::max(size,regmap_size(m_args.back()));
+  }
+
+  for (auto& arg : m_kernel->get_rtinfo_argument_range()) {
+    auto info = to_rtinfo(arg->get_name());
+    if (info == rtinfo::count)
+      continue;
+    auto& layout = m_rtinfo[static_cast<size_t>(info)];
+    layout = compile(arg->get_arginfo_range());
+    size = std::max(size,regmap_size(layout));
+  }
+
+  m_regmap.resize(size,0);
+  m_dirty.resize(m_args.size(),true);
+}
+
+void
+regmap_template::
+set_dirty(unsigned long argidx)
+{
+  // Indexed arguments are first in kernel::get_argument_range()
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (argidx < m_dirty.size())
+    m_dirty[argidx] = true;
+}
+
+void
+regmap_template::
+update(size_t argpos, const kernel::argument* arg, const device* device)
+{
+  auto& layout = m_args[argpos];
+  if (layout.empty())
+    return;
+
+  if (!is_buffer_argument(arg)) {
+    patch(m_regmap.data(),layout,arg->get_value(),arg->get_size());
+    return;
+  }
+
+  uint64_t physaddr = 0;
+  if (auto mem = arg->get_memory_object()) {
+    auto boh = mem->get_buffer_object_or_error(device);
+    physaddr = device->get_xrt_device()->getDeviceAddr(boh);
+  }
+  else if (arg->is_indexed()) {
+    physaddr = reinterpret_cast<uint64_t>(arg->get_svm_object());
+  }
+  patch(m_regmap.data(),layout,&physaddr,sizeof(physaddr));
+}
+
+regmap_template::regmap_type
+regmap_template::
+get_regmap(const device* device)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+
+  // Buffer addresses are device specific, refresh all arguments
+  if (device != m_device) {
+    std::fill(m_dirty.begin(),m_dirty.end(),true);
+    m_device = device;
+  }
+
+  size_t argpos = 0;
+  for (auto& arg : m_kernel->get_argument_range()) {
+    if (m_dirty[argpos]) {
+      update(argpos,arg.get(),device);
+      m_dirty[argpos] = false;
+    }
+    ++argpos;
+  }
+
+  return m_regmap;
+}
+
+} // xocl
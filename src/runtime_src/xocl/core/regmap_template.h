@@ -0,0 +1,157 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef xocl_core_regmap_template_h_
+#define xocl_core_regmap_template_h_
+
+#include "xocl/core/kernel.h"
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+namespace xocl {
+
+class device;
+
+/**
+ * Precompiled register map of a kernel
+ *
+ * The template is owned by an xocl::kernel and outlives the
+ * execution contexts that launch the kernel.  The register offsets
+ * of every argument word are computed once from the xclbin arginfo
+ * meta data.  The register values of the kernel arguments are cached
+ * in the template and updated only for arguments that have been
+ * marked dirty by clSetKernelArg since the template was last used.
+ *
+ * The template covers the indexed and progvar arguments.  Runtime
+ * info arguments are laid out by the template but their values are
+ * filled in by the execution context since they vary per launch
+ * and per workgroup.
+ */
+class regmap_template
+{
+public:
+  using word_type = uint32_t;
+  using regmap_type = std::vector<word_type>;
+
+  /**
+   * Location of one 32-bit word of an argument
+   */
+  struct word_layout
+  {
+    uint32_t hostoffset;  // byte offset in host argument data
+    uint32_t regidx;      // word index in register map
+  };
+  using arg_layout = std::vector<word_layout>;
+
+  /**
+   * Runtime info arguments recognized by the execution context
+   */
+  enum class rtinfo : unsigned short {
+    work_dim,
+    global_offset,
+    global_size,
+    local_size,
+    num_groups,
+    global_id,
+    local_id,
+    group_id,
+    printf_buffer,
+    count
+  };
+
+  /**
+   * Compute the word layout of an argument from its arginfo
+   */
+  static arg_layout
+  compile(const kernel::argument::arginfo_range_type& arginforange);
+
+  /**
+   * Write host argument data into register map per argument layout
+   *
+   * @param regmap
+   *   The register map to update, must be large enough to hold
+   *   all words of the layout
+   * @param layout
+   *   Compiled layout of the argument
+   * @param data
+   *   Host argument data
+   * @param size
+   *   Size of host data in bytes, words past @size are zero filled
+   */
+  static void
+  patch(word_type* regmap, const arg_layout& layout, const void* data, size_t size);
+
+  explicit
+  regmap_template(const kernel* kernel);
+
+  /**
+   * Mark an indexed argument as changed
+   *
+   * Called when the argument is set through clSetKernelArg
+   */
+  void
+  set_dirty(unsigned long argidx);
+
+  /**
+   * Get a copy of the register map with current argument values
+   *
+   * Dirty arguments are patched in the template before the
+   * copy is made.  All buffer arguments are refreshed if the
+   * template was last used for a different device.
+   *
+   * @param device
+   *   Device on which the kernel will execute.  Buffer arguments
+   *   must have been allocated on this device.
+   */
+  regmap_type
+  get_regmap(const device* device);
+
+  /**
+   * Layout of a runtime info argument
+   *
+   * @return
+   *   Compiled layout, empty if kernel has no such argument
+   */
+  const arg_layout&
+  get_rtinfo_layout(rtinfo info) const
+  {
+    return m_rtinfo[static_cast<size_t>(info)];
+  }
+
+private:
+  void
+  update(size_t argpos, const kernel::argument* arg, const device* device);
+
+  const kernel* m_kernel;
+
+  // Layout of arguments in kernel::get_argument_range() order,
+  // empty for arguments not written to the register map
+  std::vector<arg_layout> m_args;
+  std::array<arg_layout,static_cast<size_t>(rtinfo::count)> m_rtinfo;
+
+  // Cached register values and arguments needing an update
+  std::mutex m_mutex;
+  regmap_type m_regmap;
+  std::vector<bool> m_dirty;
+  const device* m_device = nullptr;
+};
+
+} // xocl
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "../xcl_test_helpers.h"
+
+#include "xocl/xclbin/xclbin.h"
+#include "xocl/xclbin/cache.h"
+#include "xclbin.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Kernel with indexed and rtinfo args, two instances, and a string table
+static const std::string xml =
+  "<project name=\"vadd\">"
+  " <platform>"
+  "  <version major=\"2\" minor=\"1\"/>"
+  "  <device name=\"fpga0\">"
+  "   <systemClocks>"
+  "    <clock port=\"clk_main\" frequency=\"250\"/>"
+  "   </systemClocks>"
+  "   <core name=\"OCL_REGION_0\" target=\"bitstream\" type=\"clc_region\" clockFreq=\"300\">"
+  "    <kernelClocks>"
+  "     <clock port=\"KERNEL_CLK\" frequency=\"300\"/>"
+  "     <clock port=\"DATA_CLK\" frequency=\"300\"/>"
+  "    </kernelClocks>"
+  "    <profilers>"
+  "     <instance name=\"monitor_0\">"
+  "      <slot index=\"0\" name=\"vadd_1\" type=\"kernel\"/>"
+  "     </instance>"
+  "    </profilers>"
+  "    <kernel name=\"vadd\" workGroupSize=\"1\" hash=\"abc123\" attributes=\"reqd_work_group_size(1,1,1)\">"
+  "     <port name=\"M_AXI_GMEM\" dataWidth=\"32\"/>"
+  "     <port name=\"S_AXI_CONTROL\" dataWidth=\"32\"/>"
+  "     <arg name=\"a\" id=\"0\" port=\"M_AXI_GMEM\" addressQualifier=\"1\" size=\"0x8\" offset=\"0x10\" hostOffset=\"0x0\" hostSize=\"0x8\" type=\"int*\"/>"
+  "     <arg name=\"n\" id=\"1\" port=\"S_AXI_CONTROL\" addressQualifier=\"0\" size=\"0x4\" offset=\"0x1C\" hostOffset=\"0x0\" hostSize=\"0x4\" type=\"uint\"/>"
+  "     <arg name=\"work_dim\" id=\"\" port=\"S_AXI_CONTROL\" addressQualifier=\"0\" size=\"0x4\" offset=\"0x40\" hostOffset=\"0x4\" hostSize=\"0x4\" type=\"uint\"/>"
+  "     <compileWorkGroupSize x=\"1\" y=\"1\" z=\"1\"/>"
+  "     <maxWorkGroupSize x=\"16\" y=\"1\" z=\"1\"/>"
+  "     <instance name=\"vadd_1\">"
+  "      <addrRemap base=\"0x1800000\" port=\"S_AXI_CONTROL\"/>"
+  "     </instance>"
+  "     <instance name=\"vadd_2\">"
+  "      <addrRemap base=\"0x1810000\" port=\"S_AXI_CONTROL\"/>"
+  "     </instance>"
+  "     <string_table>"
+  "      <format_string id=\"1\" value=\"%d\\n\"/>"
+  "      <format_string id=\"2\" value=\"sum=%u\"/>"
+  "     </string_table>"
+  "    </kernel>"
+  "   </core>"
+  "  </device>"
+  " </platform>"
+  "</project>";
+
+// Minimal axlf with the xml as its only section
+static std::vector<char>
+make_xclbin(const uuid_t uuid)
+{
+  std::vector<char> xb(sizeof(axlf) + xml.size());
+  auto top = reinterpret_cast<axlf*>(xb.data());
+  std::strcpy(top->m_magic,"xclbin2");
+  top->m_header.m_length = xb.size();
+  top->m_header.m_numSections = 1;
+  std::memcpy(top->m_header.uuid,uuid,sizeof(uuid_t));
+  top->m_sections[0].m_sectionKind = EMBEDDED_METADATA;
+  top->m_sections[0].m_sectionOffset = sizeof(axlf);
+  top->m_sections[0].m_sectionSize = xml.size();
+  std::memcpy(xb.data() + sizeof(axlf),xml.data(),xml.size());
+  return xb;
+}
+
+static void
+check_clocks(const xocl::xclbin::kernel_clocks_type& c1, const xocl::xclbin::kernel_clocks_type& c2)
+{
+  BOOST_REQUIRE_EQUAL(c1.size(),c2.size());
+  for (size_t i=0; i<c1.size(); ++i) {
+    BOOST_CHECK_EQUAL(c1[i].region_name,c2[i].region_name);
+    BOOST_CHECK_EQUAL(c1[i].clock_name,c2[i].clock_name);
+    BOOST_CHECK_EQUAL(c1[i].frequency,c2[i].frequency);
+  }
+}
+
+static void
+check_symbol(const xocl::xclbin::symbol& s1, const xocl::xclbin::symbol& s2)
+{
+  BOOST_CHECK_EQUAL(s1.name,s2.name);
+  BOOST_CHECK_EQUAL(s1.attributes,s2.attributes);
+  BOOST_CHECK_EQUAL(s1.hash,s2.hash);
+  BOOST_CHECK(s1.target==s2.target);
+  BOOST_CHECK_EQUAL(s1.workgroupsize,s2.workgroupsize);
+  for (int i=0; i<3; ++i) {
+    BOOST_CHECK_EQUAL(s1.compileworkgroupsize[i],s2.compileworkgroupsize[i]);
+    BOOST_CHECK_EQUAL(s1.maxworkgroupsize[i],s2.maxworkgroupsize[i]);
+  }
+
+  BOOST_REQUIRE_EQUAL(s1.arguments.size(),s2.arguments.size());
+  for (size_t i=0; i<s1.arguments.size(); ++i) {
+    auto& a1 = s1.arguments[i];
+    auto& a2 = s2.arguments[i];
+    BOOST_CHECK_EQUAL(a1.name,a2.name);
+    BOOST_CHECK_EQUAL(a1.address_qualifier,a2.address_qualifier);
+    BOOST_CHECK_EQUAL(a1.id,a2.id);
+    BOOST_CHECK_EQUAL(a1.port,a2.port);
+    BOOST_CHECK_EQUAL(a1.port_width,a2.port_width);
+    BOOST_CHECK_EQUAL(a1.size,a2.size);
+    BOOST_CHECK_EQUAL(a1.offset,a2.offset);
+    BOOST_CHECK_EQUAL(a1.hostoffset,a2.hostoffset);
+    BOOST_CHECK_EQUAL(a1.hostsize,a2.hostsize);
+    BOOST_CHECK_EQUAL(a1.type,a2.type);
+    BOOST_CHECK_EQUAL(a1.memsize,a2.memsize);
+    BOOST_CHECK_EQUAL(a1.baseaddr,a2.baseaddr);
+    BOOST_CHECK_EQUAL(a1.linkage,a2.linkage);
+    BOOST_CHECK(a1.atype==a2.atype);
+  }
+
+  BOOST_REQUIRE_EQUAL(s1.instances.size(),s2.instances.size());
+  for (size_t i=0; i<s1.instances.size(); ++i) {
+    BOOST_CHECK_EQUAL(s1.instances[i].name,s2.instances[i].name);
+    BOOST_CHECK_EQUAL(s1.instances[i].base,s2.instances[i].base);
+  }
+
+  BOOST_CHECK(s1.stringtable==s2.stringtable);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_xclbin_cache )
+
+BOOST_AUTO_TEST_CASE( test_xclbin_cache_roundtrip )
+{
+  uuid_t uuid;
+  uuid_generate(uuid);
+  xocl::xclbin xclbin(make_xclbin(uuid));
+
+  // Freshly parsed meta data as exposed by xocl::xclbin
+  xocl::xclbin_cache::entry parsed;
+  parsed.project_name = xclbin.project_name();
+  parsed.target = xclbin.target();
+  parsed.system_clocks = xclbin.system_clocks();
+  parsed.kernel_clocks = xclbin.kernel_clocks();
+  parsed.profilers = xclbin.profilers();
+  for (auto symbol : xclbin.kernel_symbols())
+    parsed.symbols.push_back(*symbol);
+
+  BOOST_REQUIRE_EQUAL(parsed.symbols.size(),1);
+  BOOST_CHECK_EQUAL(parsed.symbols[0].arguments.size(),3);
+  BOOST_CHECK_EQUAL(parsed.symbols[0].instances.size(),2);
+  BOOST_CHECK_EQUAL(parsed.symbols[0].stringtable.size(),2);
+
+  auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  xocl::xclbin_cache::store(dir.string(),xclbin.uuid(),xml.size(),parsed);
+
+  xocl::xclbin_cache::entry decoded;
+  BOOST_REQUIRE(xocl::xclbin_cache::load(dir.string(),xclbin.uuid(),xml.size(),decoded));
+
+  BOOST_CHECK_EQUAL(decoded.project_name,parsed.project_name);
+  BOOST_CHECK(decoded.target==parsed.target);
+  check_clocks(decoded.system_clocks,parsed.system_clocks);
+  check_clocks(decoded.kernel_clocks,parsed.kernel_clocks);
+
+  BOOST_REQUIRE_EQUAL(decoded.profilers.size(),parsed.profilers.size());
+  for (size_t i=0; i<parsed.profilers.size(); ++i) {
+    BOOST_CHECK_EQUAL(decoded.profilers[i].name,parsed.profilers[i].name);
+    BOOST_CHECK(decoded.profilers[i].slots==parsed.profilers[i].slots);
+  }
+
+  BOOST_REQUIRE_EQUAL(decoded.symbols.size(),parsed.symbols.size());
+  for (size_t i=0; i<parsed.symbols.size(); ++i)
+    check_symbol(decoded.symbols[i],parsed.symbols[i]);
+
+  // A different xml size is a stale entry
+  xocl::xclbin_cache::entry stale;
+  BOOST_CHECK(!xocl::xclbin_cache::load(dir.string(),xclbin.uuid(),xml.size()+1,stale));
+
+  boost::system::error_code ec;
+  boost::filesystem::remove_all(dir,ec);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,497 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cache.h"
+
+#include "xocl/core/debug.h"
+#include "xrt/util/config_reader.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Cache file layout, all integers are 64 bit host endian:
+//
+//   magic[8] version sizeof(size_t) uuid[16] xml_size payload_size
+//   payload
+//
+// Strings are encoded as length followed by characters.  The cache
+// is a host local optimization, it is not portable across hosts.
+
+namespace {
+
+using xclbin = xocl::xclbin;
+using entry = xocl::xclbin_cache::entry;
+
+static const char magic[8] = {'X','O','C','L','X','M','D','\0'};
+static const uint64_t version = 1;
+
+static std::string
+cache_file(const std::string& dir, const xclbin::uuid_type& uuid)
+{
+  return dir + "/" + uuid.to_string() + ".xmd";
+}
+
+class writer
+{
+  std::string m_buf;
+public:
+  void
+  u64(uint64_t value)
+  { m_buf.append(reinterpret_cast<const char*>(&value),sizeof(value)); }
+
+  void
+  str(const std::string& value)
+  {
+    u64(value.size());
+    m_buf.append(value);
+  }
+
+  void
+  raw(const void* data, size_t size)
+  { m_buf.append(static_cast<const char*>(data),size); }
+
+  const std::string&
+  data() const
+  { return m_buf; }
+};
+
+class reader
+{
+  const char* m_cur;
+  const char* m_end;
+
+  void
+  need(uint64_t size) const
+  {
+    if (size > static_cast<uint64_t>(m_end-m_cur))
+      throw std::runtime_error("truncated cache file");
+  }
+
+public:
+  reader(const char* begin, const char* end)
+    : m_cur(begin), m_end(end)
+  {}
+
+  uint64_t
+  u64()
+  {
+    uint64_t value = 0;
+    need(sizeof(value));
+    std::memcpy(&value,m_cur,sizeof(value));
+    m_cur += sizeof(value);
+    return value;
+  }
+
+  std::string
+  str()
+  {
+    auto size = u64();
+    need(size);
+    std::string value(m_cur,size);
+    m_cur += size;
+    return value;
+  }
+
+  void
+  raw(void* data, size_t size)
+  {
+    need(size);
+    std::memcpy(data,m_cur,size);
+    m_cur += size;
+  }
+
+  // Number of elements in a container, each element takes at
+  // least 8 bytes so a count larger than what is left is corrupt
+  uint64_t
+  count()
+  {
+    auto value = u64();
+    if (value > remaining()/sizeof(uint64_t))
+      throw std::runtime_error("bad element count in cache file");
+    return value;
+  }
+
+  uint64_t
+  remaining() const
+  { return m_end-m_cur; }
+};
+
+static void
+encode(writer& w, const xclbin::symbol& symbol)
+{
+  w.str(symbol.name);
+  w.str(symbol.attributes);
+  w.str(symbol.hash);
+  w.u64(static_cast<uint64_t>(symbol.target));
+  w.u64(symbol.workgroupsize);
+  for (int i=0; i<3; ++i)
+    w.u64(symbol.compileworkgroupsize[i]);
+  for (int i=0; i<3; ++i)
+    w.u64(symbol.maxworkgroupsize[i]);
+
+  w.u64(symbol.arguments.size());
+  for (auto& arg : symbol.arguments) {
+    w.str(arg.name);
+    w.u64(arg.address_qualifier);
+    w.str(arg.id);
+    w.str(arg.port);
+    w.u64(arg.port_width);
+    w.u64(arg.size);
+    w.u64(arg.offset);
+    w.u64(arg.hostoffset);
+    w.u64(arg.hostsize);
+    w.str(arg.type);
+    w.u64(arg.memsize);
+    w.u64(arg.baseaddr);
+    w.str(arg.linkage);
+    w.u64(static_cast<uint64_t>(arg.atype));
+  }
+
+  w.u64(symbol.instances.size());
+  for (auto& instance : symbol.instances) {
+    w.str(instance.name);
+    w.u64(instance.base);
+  }
+
+  w.u64(symbol.stringtable.size());
+  for (auto& format : symbol.stringtable) {
+    w.u64(format.first);
+    w.str(format.second);
+  }
+}
+
+static void
+decode(reader& r, xclbin::symbol& symbol)
+{
+  using argtype = xclbin::symbol::arg::argtype;
+
+  symbol.name = r.str();
+  symbol.attributes = r.str();
+  symbol.hash = r.str();
+  symbol.target = static_cast<xclbin::target_type>(r.u64());
+  symbol.workgroupsize = r.u64();
+  for (int i=0; i<3; ++i)
+    symbol.compileworkgroupsize[i] = r.u64();
+  for (int i=0; i<3; ++i)
+    symbol.maxworkgroupsize[i] = r.u64();
+
+  for (auto n=r.count(); n; --n) {
+    xclbin::symbol::arg arg;
+    arg.name = r.str();
+    arg.address_qualifier = r.u64();
+    arg.id = r.str();
+    arg.port = r.str();
+    arg.port_width = r.u64();
+    arg.size = r.u64();
+    arg.offset = r.u64();
+    arg.hostoffset = r.u64();
+    arg.hostsize = r.u64();
+    arg.type = r.str();
+    arg.memsize = r.u64();
+    arg.baseaddr = r.u64();
+    arg.linkage = r.str();
+    auto atype = r.u64();
+    if (atype > static_cast<uint64_t>(argtype::rtinfo))
+      throw std::runtime_error("bad argument type");
+    arg.atype = static_cast<argtype>(atype);
+    arg.host = nullptr; // fixed up by owner of symbol
+    symbol.arguments.emplace_back(std::move(arg));
+  }
+
+  for (auto n=r.count(); n; --n) {
+    xclbin::symbol::instance instance;
+    instance.name = r.str();
+    instance.base = r.u64();
+    symbol.instances.emplace_back(std::move(instance));
+  }
+
+  for (auto n=r.count(); n; --n) {
+    auto id = static_cast<uint32_t>(r.u64());
+    symbol.stringtable.emplace(id,r.str());
+  }
+}
+
+static void
+encode(writer& w, const xclbin::clocks& clock)
+{
+  w.str(clock.region_name);
+  w.str(clock.clock_name);
+  w.u64(clock.frequency);
+}
+
+static void
+decode(reader& r, std::vector<xclbin::clocks>& clocks)
+{
+  for (auto n=r.count(); n; --n) {
+    auto region = r.str();
+    auto clock = r.str();
+    auto freq = static_cast<unsigned int>(r.u64());
+    clocks.emplace_back(std::move(region),std::move(clock),freq);
+  }
+}
+
+static void
+encode(writer& w, const entry& e)
+{
+  w.str(e.project_name);
+  w.u64(static_cast<uint64_t>(e.target));
+
+  w.u64(e.system_clocks.size());
+  for (auto& clock : e.system_clocks)
+    encode(w,clock);
+
+  w.u64(e.kernel_clocks.size());
+  for (auto& clock : e.kernel_clocks)
+    encode(w,clock);
+
+  w.u64(e.profilers.size());
+  for (auto& profiler : e.profilers) {
+    w.str(profiler.name);
+    w.u64(profiler.slots.size());
+    for (auto& slot : profiler.slots) {
+      w.u64(std::get<0>(slot));
+      w.str(std::get<1>(slot));
+      w.str(std::get<2>(slot));
+    }
+  }
+
+  w.u64(e.symbols.size());
+  for (auto& symbol : e.symbols)
+    encode(w,symbol);
+}
+
+static void
+decode(reader& r, entry& e)
+{
+  e.project_name = r.str();
+  e.target = static_cast<xclbin::target_type>(r.u64());
+  decode(r,e.system_clocks);
+  decode(r,e.kernel_clocks);
+
+  for (auto n=r.count(); n; --n) {
+    xclbin::profiler profiler;
+    profiler.name = r.str();
+    for (auto s=r.count(); s; --s) {
+      auto index = static_cast<int>(static_cast<int64_t>(r.u64()));
+      auto cuname = r.str();
+      auto type = r.str();
+      profiler.slots.emplace_back(index,std::move(cuname),std::move(type));
+    }
+    e.profilers.emplace_back(std::move(profiler));
+  }
+
+  auto symbols = r.count();
+  e.symbols.resize(symbols);
+  for (auto& symbol : e.symbols)
+    decode(r,symbol);
+}
+
+static void
+encode_header(writer& w, const xclbin::uuid_type& uuid, size_t xml_size, size_t payload_size)
+{
+  w.raw(magic,sizeof(magic));
+  w.u64(version);
+  w.u64(sizeof(size_t));
+  w.raw(uuid.get(),sizeof(uuid_t));
+  w.u64(xml_size);
+  w.u64(payload_size);
+}
+
+static bool
+valid_header(reader& r, const xclbin::uuid_type& uuid, size_t xml_size)
+{
+  char m[sizeof(magic)];
+  r.raw(m,sizeof(m));
+  if (std::memcmp(m,magic,sizeof(magic)))
+    return false;
+  if (r.u64()!=version || r.u64()!=sizeof(size_t))
+    return false;
+  uuid_t u;
+  r.raw(u,sizeof(u));
+  if (uuid_compare(u,uuid.get()))
+    return false;
+  if (r.u64()!=xml_size)
+    return false;
+  return true;
+}
+
+static bool
+write_all(int fd, const std::string& data)
+{
+  const char* buf = data.data();
+  size_t size = data.size();
+  while (size) {
+    auto n = ::write(fd,buf,size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    buf += n;
+    size -= n;
+  }
+  return true;
+}
+
+// Memory map of a read only file
+class mapped_file
+{
+  int m_fd = -1;
+  void* m_addr = MAP_FAILED;
+  size_t m_size = 0;
+
+public:
+  explicit
+  mapped_file(const std::string& path)
+  {
+    m_fd = ::open(path.c_str(),O_RDONLY);
+    if (m_fd == -1)
+      return;
+    struct stat st;
+    if (fstat(m_fd,&st) || st.st_size <= 0)
+      return;
+    m_size = st.st_size;
+    m_addr = mmap(nullptr,m_size,PROT_READ,MAP_PRIVATE,m_fd,0);
+  }
+
+  ~mapped_file()
+  {
+    if (m_addr != MAP_FAILED)
+      munmap(m_addr,m_size);
+    if (m_fd != -1)
+      ::close(m_fd);
+  }
+
+  bool
+  valid() const
+  { return m_addr != MAP_FAILED; }
+
+  const char*
+  begin() const
+  { return static_cast<const char*>(m_addr); }
+
+  const char*
+  end() const
+  { return begin() + m_size; }
+};
+
+} // namespace
+
+namespace xocl { namespace xclbin_cache {
+
+std::string
+directory()
+{
+  static std::string dir = xrt::config::get_xclbin_cache_dir();
+  return dir=="null" ? std::string() : dir;
+}
+
+bool
+load(const std::string& dir, const xclbin::uuid_type& uuid, size_t xml_size, entry& e)
+{
+  if (dir.empty() || uuid_is_null(uuid.get()))
+    return false;
+
+  auto path = cache_file(dir,uuid);
+  mapped_file file(path);
+  if (!file.valid())
+    return false;
+
+  try {
+    reader r(file.begin(),file.end());
+    if (!valid_header(r,uuid,xml_size))
+      return false;
+    auto payload_size = r.u64();
+    if (payload_size!=r.remaining())
+      return false;
+    decode(r,e);
+    if (r.remaining())
+      throw std::runtime_error("trailing data in cache file");
+  }
+  catch (const std::exception& ex) {
+    XOCL_DEBUG(std::cout,"xclbin cache: ignoring '",path,"': ",ex.what(),"\n");
+    e = entry();
+    return false;
+  }
+
+  XOCL_DEBUG(std::cout,"xclbin cache: loaded '",path,"'\n");
+  return true;
+}
+
+bool
+load(const xclbin::uuid_type& uuid, size_t xml_size, entry& e)
+{
+  return load(directory(),uuid,xml_size,e);
+}
+
+void
+store(const std::string& dir, const xclbin::uuid_type& uuid, size_t xml_size, const entry& e)
+{
+  if (dir.empty() || uuid_is_null(uuid.get()))
+    return;
+
+  boost::system::error_code ec;
+  boost::filesystem::create_directories(dir,ec);
+  if (ec)
+    return;
+
+  writer payload;
+  encode(payload,e);
+  writer header;
+  encode_header(header,uuid,xml_size,payload.data().size());
+
+  auto path = cache_file(dir,uuid);
+  // Unique per writer, threads of one process may store concurrently
+  std::string tmp = path + ".tmp.XXXXXX";
+  int fd = mkstemp(&tmp[0]);
+  if (fd == -1)
+    return;
+
+  bool ok = fchmod(fd,0644)==0
+    && write_all(fd,header.data())
+    && write_all(fd,payload.data());
+  if (::close(fd))
+    ok = false;
+  if (!ok) {
+    std::remove(tmp.c_str());
+    return;
+  }
+
+  if (std::rename(tmp.c_str(),path.c_str())) {
+    std::remove(tmp.c_str());
+    return;
+  }
+
+  XOCL_DEBUG(std::cout,"xclbin cache: stored '",path,"'\n");
+}
+
+void
+store(const xclbin::uuid_type& uuid, size_t xml_size, const entry& e)
+{
+  store(directory(),uuid,xml_size,e);
+}
+
+}} // xclbin_cache,xocl
@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef runtime_src_xocl_xclbin_cache_h_
+#define runtime_src_xocl_xclbin_cache_h_
+
+#include "xocl/xclbin/xclbin.h"
+
+#include <string>
+#include <vector>
+
+namespace xocl { namespace xclbin_cache {
+
+/**
+ * Parsed xml meta data of an xclbin.
+ *
+ * This is everything xocl::xclbin extracts from the xml meta data
+ * section.  The binary sections (mem_topology, connectivity, etc.)
+ * are accessed in place and are not part of the entry.
+ */
+struct entry
+{
+  std::string project_name;
+  xclbin::target_type target = xclbin::target_type::invalid;
+  xclbin::system_clocks_type system_clocks;
+  xclbin::kernel_clocks_type kernel_clocks;
+  xclbin::profilers_type profilers;
+  std::vector<xclbin::symbol> symbols;
+};
+
+/**
+ * Directory of the on-disk cache per Runtime.xclbin_cache_dir
+ *
+ * @return
+ *   Cache directory or empty string if caching is disabled
+ */
+std::string
+directory();
+
+/**
+ * Load cached meta data for an xclbin
+ *
+ * The cache file is memory mapped and decoded into @entry.  A
+ * missing, stale, or corrupt cache file is a cache miss.
+ *
+ * @param uuid
+ *   The uuid of the xclbin
+ * @param xml_size
+ *   Size of xml meta data section, used to validate the cache file
+ * @param entry
+ *   Entry to populate on cache hit
+ * @return
+ *   true on cache hit, false otherwise
+ */
+bool
+load(const xclbin::uuid_type& uuid, size_t xml_size, entry& entry);
+
+/**
+ * Load cached meta data from specified cache directory
+ */
+bool
+load(const std::string& dir, const xclbin::uuid_type& uuid, size_t xml_size, entry& entry);
+
+/**
+ * Store meta data for an xclbin in the cache
+ *
+ * The file is written to a temporary and renamed into place so that
+ * concurrent processes never see a partial file.  Errors are ignored,
+ * the cache is an optimization only.
+ */
+void
+store(const xclbin::uuid_type& uuid, size_t xml_size, const entry& entry);
+
+/**
+ * Store meta data in specified cache directory
+ */
+void
+store(const std::string& dir, const xclbin::uuid_type& uuid, size_t xml_size, const entry& entry);
+
+}} // xclbin_cache,xocl
+
+#endif
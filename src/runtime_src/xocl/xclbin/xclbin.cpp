@@ -15,6 +15,7 @@
  */
 
 #include "xclbin.h"
+#include "cache.h"
 
 #include "xocl/config.h"
 #include "xocl/core/debug.h"
@@ -59,7 +60,9 @@ convert(const std::string& str)
 // Representation of meta data section of an xclbin
 // This class supports extraction of specific sections
 // of the meta data.  All xml/lmx parsing is isolated
-// to this class.
+// to this class.  The parsed data is kept in a cache
+// entry that is stored on disk per xclbin uuid, later
+// loads of the same xclbin skip the xml parsing.
 class metadata
 {
 private:
@@ -550,9 +553,6 @@ private:
     void
     init_symbol()
     {
-      static unsigned int count = 0;
-      m_symbol.uid = count++;
-
       init_args();
       fix_rtinfo();
       fix_progvar();
@@ -578,45 +578,21 @@ private:
     {
       return m_symbol;
     }
-
-    void
-    cu_base_address_map(std::vector<uint64_t>& amap) const
-    {
-      for (auto& instance : m_symbol.instances)
-        amap.push_back(instance.base);
-    }
-
-    std::string
-    conformance_rename()
-    {
-      std::string name = m_name;
-      m_name = name.substr(0,name.find_last_of("_"));
-      m_symbol.name = m_name;
-      return name;
-    }
-
-    size_t
-    regmap_size() const
-    {
-      size_t sz = 0;
-      for (auto& arg : m_symbol.arguments)
-        sz = std::max(arg.offset+arg.size,sz);
-      return sz;
-    }
   }; // class kernel_wrapper
 
 private:
-  std::vector<std::unique_ptr<kernel_wrapper>> m_kernels;
-  std::vector<std::unique_ptr<platform_wrapper>> m_platforms;
-  std::vector<std::unique_ptr<device_wrapper>> m_devices;
-  std::vector<std::unique_ptr<core_wrapper>> m_cores;
+  xocl::xclbin_cache::entry m_data;
 
-  pt::ptree xml_project;
-
-public:
-  explicit
-  metadata(const data_range& xml)
+  // Parse the xml meta data into m_data
+  void
+  parse(const data_range& xml)
   {
+    std::vector<std::unique_ptr<kernel_wrapper>> kernels;
+    std::vector<std::unique_ptr<platform_wrapper>> platforms;
+    std::vector<std::unique_ptr<device_wrapper>> devices;
+    std::vector<std::unique_ptr<core_wrapper>> cores;
+    pt::ptree xml_project;
+
     try {
       std::stringstream xml_stream;
       xml_stream.write(xml.first,xml.second-xml.first);
@@ -633,9 +609,9 @@ public:
         continue;
       if (++count>1)
         throw xocl::error(CL_INVALID_BINARY,"Only one platform supported");
-      m_platforms.emplace_back(std::make_unique<platform_wrapper>(xml_platform.second));
+      platforms.emplace_back(std::make_unique<platform_wrapper>(xml_platform.second));
     }
-    auto platform = m_platforms.back().get();
+    auto platform = platforms.back().get();
 
     // iterate devices
     count = 0;
@@ -644,9 +620,9 @@ public:
         continue;
       if (++count>1)
         throw xocl::error(CL_INVALID_BINARY,"Only one device supported");
-      m_devices.emplace_back(std::make_unique<device_wrapper>(platform,xml_device.second));
+      devices.emplace_back(std::make_unique<device_wrapper>(platform,xml_device.second));
     }
-    auto device = m_devices.back().get();
+    auto device = devices.back().get();
 
     auto nm = device->name();
     auto c = device->system_clocks();
@@ -658,53 +634,77 @@ public:
         continue;
       if (++count>1)
         throw xocl::error(CL_INVALID_BINARY,"Only one core supported");
-      m_cores.emplace_back(std::make_unique<core_wrapper>(platform,device,xml_core.second));
+      cores.emplace_back(std::make_unique<core_wrapper>(platform,device,xml_core.second));
     }
-    auto core = m_cores.back().get();
+    auto core = cores.back().get();
 
     // iterate kernels
     for (auto& xml_kernel : xml_project.get_child("project.platform.device.core")) {
       if (xml_kernel.first != "kernel")
         continue;
       XOCL_DEBUG(std::cout,"xclbin found kernel '" + xml_kernel.second.get<std::string>("<xmlattr>.name") + "'\n");
-      m_kernels.emplace_back(std::make_unique<kernel_wrapper>(platform,device,core,xml_kernel.second));
+      kernels.emplace_back(std::make_unique<kernel_wrapper>(platform,device,core,xml_kernel.second));
     }
+
+    // extract everything needed by xocl::xclbin, the xml is not
+    // referenced after this point
+    m_data.project_name = xml_project.get<std::string>("project.<xmlattr>.name","");
+    m_data.target = core->target();
+    m_data.profilers = core->profilers();
+    m_data.system_clocks = device->system_clocks();
+    m_data.kernel_clocks = core->kernel_clocks();
+    for (auto& kernel : kernels)
+      m_data.symbols.push_back(kernel->symbol());
+  }
+
+  // Symbols are owned by m_data, assign unique ids and point
+  // arguments back at their symbol
+  void
+  init_symbols()
+  {
+    static unsigned int count = 0;
+    for (auto& symbol : m_data.symbols) {
+      symbol.uid = count++;
+      for (auto& arg : symbol.arguments)
+        arg.host = &symbol;
+    }
+  }
+
+public:
+  metadata(const data_range& xml, const xocl::xclbin::uuid_type& uuid)
+  {
+    size_t xml_size = xml.second-xml.first;
+    if (!xocl::xclbin_cache::load(uuid,xml_size,m_data)) {
+      parse(xml);
+      xocl::xclbin_cache::store(uuid,xml_size,m_data);
+    }
+    init_symbols();
   }
 
   xocl::xclbin::system_clocks_type
   system_clocks() const
   {
-    xocl::xclbin::system_clocks_type clocks;
-    for (auto& device : m_devices) {
-      auto cclocks = device->system_clocks();
-      std::move(cclocks.begin(),cclocks.end(),std::back_inserter(clocks));
-    }
-    return clocks;
+    return m_data.system_clocks;
   }
 
   xocl::xclbin::kernel_clocks_type
   kernel_clocks() const
   {
-    xocl::xclbin::kernel_clocks_type clocks;
-    for (auto& core : m_cores) {
-      auto cclocks = core->kernel_clocks();
-      std::move(cclocks.begin(),cclocks.end(),std::back_inserter(clocks));
-    }
-    return clocks;
+    return m_data.kernel_clocks;
   }
 
   unsigned int
   num_kernels() const
   {
-    return m_kernels.size();
+    return m_data.symbols.size();
   }
 
   std::vector<std::string>
   kernel_names() const
   {
     std::vector<std::string> names;
-    for (auto& kernel : m_kernels)
-      names.emplace_back(kernel->name());
+    for (auto& symbol : m_data.symbols)
+      names.emplace_back(symbol.name);
     return names;
   }
 
@@ -712,17 +712,17 @@ public:
   kernel_symbols() const
   {
     std::vector<const xocl::xclbin::symbol*> symbols;
-    for (auto& kernel : m_kernels)
-      symbols.push_back(&kernel->symbol());
+    for (auto& symbol : m_data.symbols)
+      symbols.push_back(&symbol);
     return symbols;
   }
 
   const xocl::xclbin::symbol&
   lookup_kernel(const std::string& kernel_name) const
   {
-    for (auto& kernel : m_kernels) {
-      if (kernel->name()==kernel_name)
-        return kernel->symbol();
+    for (auto& symbol : m_data.symbols) {
+      if (symbol.name==kernel_name)
+        return symbol;
     }
     throw xocl::error(CL_INVALID_KERNEL_NAME,"No kernel with name '" + kernel_name + "' found in program");
   }
@@ -730,27 +730,28 @@ public:
   std::string
   project_name() const
   {
-    return xml_project.get<std::string>("project.<xmlattr>.name","");
+    return m_data.project_name;
   }
 
   target_type
   target() const
   {
-    return m_cores[0]->target();
+    return m_data.target;
   }
 
   xocl::xclbin::profilers_type
   profilers() const
   {
-    return m_cores[0]->profilers();
+    return m_data.profilers;
   }
 
   std::vector<uint64_t>
   cu_base_address_map() const
   {
     std::vector<uint64_t> amap;
-    for (auto& kernel : m_kernels)
-      kernel->cu_base_address_map(amap);
+    for (auto& symbol : m_data.symbols)
+      for (auto& instance : symbol.instances)
+        amap.push_back(instance.base);
 
     std::sort(amap.begin(),amap.end());
     return amap;
@@ -760,9 +761,9 @@ public:
   conformance_rename_kernel(const std::string& hash)
   {
     unsigned int retval = 0;
-    for (auto& kernel : m_kernels) {
-      if (kernel->hash()==hash)  {
-        kernel->conformance_rename();
+    for (auto& symbol : m_data.symbols) {
+      if (symbol.hash==hash)  {
+        symbol.name = symbol.name.substr(0,symbol.name.find_last_of("_"));
         ++retval;
       }
     }
@@ -773,8 +774,8 @@ public:
   conformance_kernel_hashes() const
   {
     std::vector<std::string> retval;
-    for (auto& kernel : m_kernels)
-      retval.push_back(kernel->hash());
+    for (auto& symbol : m_data.symbols)
+      retval.push_back(symbol.hash);
     return retval;
   }
 }; // metadata
@@ -1010,13 +1011,13 @@ namespace xocl {
 struct xclbin::impl
 {
   binary_type m_binary;
-  metadata m_xml;
   xclbin_data_sections m_sections;
+  metadata m_xml;
 
   impl(std::vector<char>&& xb)
     : m_binary(std::move(xb))
-    , m_xml(m_binary.meta_data())
     , m_sections(m_binary)
+    , m_xml(m_binary.meta_data(),m_sections.uuid())
   {}
 
   std::string
@@ -22,6 +22,7 @@
 #include "xclbin.h"
 #include "ert.h"
 
+#include <atomic>
 #include <set>
 #include <vector>
 #include <thread>
@@ -67,7 +68,7 @@ public:
   }
 
   device(device&& rhs)
-    : m_hal(std::move(rhs.m_hal)), m_setup_done(rhs.m_setup_done)
+    : m_hal(std::move(rhs.m_hal)), m_setup_done(rhs.m_setup_done.load())
   {}
 
   ~device()
@@ -79,7 +80,8 @@ public:
   /**
    * Prepare a device for actual use.
    * For devices that support DMA threads, this function
-   * should start the threads.
+   * should start the threads.  Safe to call more than once
+   * and from multiple threads.
    */
   void
   setup()
@@ -891,7 +893,7 @@ private:
   std::vector<BufferObjectHandle> m_buffers;
   mutable std::mutex m_buffers_mutex;
   xrt::uuid m_uuid;
-  bool m_setup_done;
+  std::atomic<bool> m_setup_done;
 };
 
 /**
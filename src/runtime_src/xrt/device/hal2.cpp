@@ -18,11 +18,30 @@
 #include "xrt/util/thread.h"
 #include "ert.h"
 
+#include <algorithm>
 #include <cstring> // for std::memcpy
 #include <iostream>
 #include <cerrno>
 #include <sys/mman.h> // for POSIX munmap
 
+namespace {
+
+// Event wrapping the shared completion of a coalesced sync
+class sync_event
+{
+  std::shared_future<int> m_future;
+public:
+  typedef int value_type;
+
+  explicit
+  sync_event(std::shared_future<int> f) : m_future(std::move(f)) {}
+
+  int wait() const { return m_future.get(); }
+  bool ready() const { return m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+};
+
+}
+
 namespace xrt { namespace hal2 {
 
 device::
@@ -39,6 +58,8 @@ device::
     q.stop();
   for (auto& t : m_workers)
     t.join();
+  if (m_sync_requested)
+    XRT_DEBUG(std::cout,"async syncs requested: ",m_sync_requested," issued: ",m_sync_issued,"\n");
 }
 
 std::ostream&
@@ -75,6 +96,7 @@ device::
 setup()
 {
 #ifndef PMD_OCL
+  std::lock_guard<std::mutex> lk(m_setup_mutex);
   if (!m_workers.empty())
     return;
 
@@ -367,13 +389,65 @@ device::sync(const BufferObjectHandle& boh, size_t sz, size_t offset, direction
 
   BufferObject* bo = getBufferObject(boh);
 
-  if (async) {
-    auto qt = (dir==XCL_BO_SYNC_BO_FROM_DEVICE) ? hal::queue_type::read : hal::queue_type::write;
-    return event(addTaskF(m_ops->mSyncBO,qt,m_handle,bo->handle,dir,sz,offset));
-  }
+  if (async)
+    return event(sync_event(addSync(bo->handle,dir,sz,offset+bo->offset)));
   return event(typed_event<int>(m_ops->mSyncBO(m_handle, bo->handle, dir, sz, offset+bo->offset)));
 }
 
+std::shared_future<int>
+device::
+addSync(unsigned int handle, xclBOSyncDirection dir, size_t sz, size_t offset)
+{
+  std::lock_guard<std::mutex> lk(m_sync_mutex);
+  ++m_sync_requested;
+
+  // Extend a batch that is still waiting in the queue if the ranges
+  // overlap or are adjacent
+  if (config::get_dma_coalesce()) {
+    for (auto& batch : m_sync_pending) {
+      if (batch->handle!=handle || batch->dir!=dir)
+        continue;
+      if (offset > batch->end || offset+sz < batch->begin)
+        continue;
+      batch->begin = std::min(batch->begin,offset);
+      batch->end = std::max(batch->end,offset+sz);
+      return batch->future;
+    }
+  }
+
+  auto batch = std::make_shared<SyncBatch>();
+  batch->handle = handle;
+  batch->dir = dir;
+  batch->begin = offset;
+  batch->end = offset+sz;
+  batch->future = batch->promise.get_future().share();
+  m_sync_pending.push_back(batch);
+
+  auto qt = (dir==XCL_BO_SYNC_BO_FROM_DEVICE) ? hal::queue_type::read : hal::queue_type::write;
+  addTaskM(&device::issueSync,qt,batch);
+  return batch->future;
+}
+
+int
+device::
+issueSync(const std::shared_ptr<SyncBatch>& batch)
+{
+  {
+    // No more merging once the transfer is under way
+    std::lock_guard<std::mutex> lk(m_sync_mutex);
+    m_sync_pending.erase(std::find(m_sync_pending.begin(),m_sync_pending.end(),batch));
+    ++m_sync_issued;
+  }
+
+  try {
+    batch->promise.set_value(m_ops->mSyncBO(m_handle,batch->handle,batch->dir,batch->end-batch->begin,batch->begin));
+  }
+  catch (...) {
+    batch->promise.set_exception(std::current_exception());
+  }
+  return 0;
+}
+
 event
 device::
 copy(const BufferObjectHandle& dst_boh, const BufferObjectHandle& src_boh, size_t sz, size_t dst_offset, size_t src_offset)
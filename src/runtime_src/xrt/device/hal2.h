@@ -23,6 +23,7 @@
 
 #include "ert.h"
 
+#include <array>
 #include <cassert>
 
 #include <functional>
@@ -30,6 +31,9 @@
 #include <cstring>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <future>
+#include <vector>
 
 namespace xrt { namespace hal2 {
 
@@ -61,6 +65,7 @@ class device : public xrt::hal::device
   using qtype = std::underlying_type<hal::queue_type>::type;
   std::array<task::queue,static_cast<qtype>(hal::queue_type::max)> m_queue;
   std::vector<std::thread> m_workers;
+  std::mutex m_setup_mutex; // guards lazy creation of m_workers
   svmbomap_type m_svmbomap;
 
   std::shared_ptr<hal2::operations> m_ops;
@@ -90,6 +95,32 @@ class device : public xrt::hal::device
     hal2::device_handle owner = nullptr;
   };
 
+  // Pending asynchronous sync of a byte range [begin,end) of one
+  // buffer object in one direction.  Async syncs that overlap or
+  // abut the range of a batch still waiting in the DMA queue are
+  // merged into the batch, and every merged request waits on the
+  // same shared future.
+  struct SyncBatch
+  {
+    unsigned int handle;
+    xclBOSyncDirection dir;
+    size_t begin;
+    size_t end;
+    std::promise<int> promise;
+    std::shared_future<int> future;
+  };
+
+  std::mutex m_sync_mutex;
+  std::vector<std::shared_ptr<SyncBatch>> m_sync_pending;
+  size_t m_sync_requested = 0;
+  size_t m_sync_issued = 0;
+
+  std::shared_future<int>
+  addSync(unsigned int handle, xclBOSyncDirection dir, size_t sz, size_t offset);
+
+  int
+  issueSync(const std::shared_ptr<SyncBatch>& batch);
+
   BufferObject*
   getBufferObject(const BufferObjectHandle& boh) const;
 
@@ -177,7 +208,7 @@ public:
    * Prepare the hal2 device for actual use
    *
    * If the device supports DMA threads then they are started by
-   * this function.
+   * this function.  The workers are created once, on first call.
    */
   void
   setup();
@@ -220,6 +251,25 @@ public:
     return &m_queue[static_cast<qtype>(qt)];
   }
 
+  /**
+   * Statistics of asynchronous syncs
+   *
+   * @requested: number of async sync requests
+   * @issued: number of DMA transfers issued for the requests
+   */
+  struct sync_stats
+  {
+    size_t requested;
+    size_t issued;
+  };
+
+  sync_stats
+  get_sync_stats()
+  {
+    std::lock_guard<std::mutex> lk(m_sync_mutex);
+    return {m_sync_requested,m_sync_issued};
+  }
+
   virtual std::string
   getDriverLibraryName() const
   {
@@ -16,14 +16,242 @@
 
 #include "command.h"
 #include "scheduler.h"
+#include "xrt/util/mpsc_ring.h"
 
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace {
 
+////////////////////////////////////////////////////////////////
+// Per thread cache of recyclable entries
+//
+// Entries are acquired by the owning thread only.  Entries released
+// by the owning thread go straight to its free list, entries released
+// by other threads are pushed lock-free to a return ring that the
+// owner drains when its free list is empty.  Entries that do not fit
+// in the cache are destroyed.
+//
+// The id of an exited thread can be reused by a new thread, so the
+// cache is orphaned when its owner exits and entries released to an
+// orphaned cache are destroyed.
+////////////////////////////////////////////////////////////////
+template <typename Entry>
+class thread_cache
+{
+  static constexpr size_t max_free = 256;
+
+  std::thread::id m_owner = std::this_thread::get_id();
+  std::atomic<bool> m_orphaned {false};
+  std::vector<Entry> m_free;
+  xrt::mpsc_ring<Entry,max_free> m_returned;
+
+  static void
+  dispose(Entry&& entry)
+  {
+    Entry discard(std::move(entry));
+  }
+
+public:
+  // Owner thread only
+  bool
+  acquire(Entry& entry)
+  {
+    if (m_free.empty())
+      m_returned.pop_batch([this](Entry&& e) { m_free.push_back(std::move(e)); });
+
+    if (m_free.empty())
+      return false;
+
+    entry = std::move(m_free.back());
+    m_free.pop_back();
+    return true;
+  }
+
+  // Any thread
+  void
+  release(Entry&& entry)
+  {
+    if (m_orphaned.load(std::memory_order_acquire)) {
+      dispose(std::move(entry));
+      return;
+    }
+
+    if (std::this_thread::get_id()==m_owner) {
+      if (m_free.size() < max_free)
+        m_free.push_back(std::move(entry));
+      else
+        dispose(std::move(entry));
+      return;
+    }
+
+    if (!m_returned.try_push(std::move(entry)))
+      dispose(std::move(entry));
+  }
+
+  // Owner thread only, when the owner exits
+  void
+  orphan()
+  {
+    m_orphaned.store(true,std::memory_order_release);
+    clear();
+  }
+
+  // Static destruction only, no other thread may use the cache
+  void
+  clear()
+  {
+    m_free.clear();
+    Entry entry;
+    while (m_returned.try_pop(entry))
+      ;
+  }
+};
+
+////////////////////////////////////////////////////////////////
+// Command object memory blocks.
+//
+// Blocks are rounded to size classes of 64 bytes.  Each block is
+// prefixed with a header that identifies the cache of the allocating
+// thread, the header holds the cache alive while the block is in use.
+////////////////////////////////////////////////////////////////
+struct block
+{
+  char* mem = nullptr;
+
+  block() {}
+  explicit block(char* m) : mem(m) {}
+  block(block&& rhs) : mem(rhs.mem) { rhs.mem = nullptr; }
+  ~block() { ::operator delete(mem); }
+
+  block&
+  operator=(block&& rhs)
+  {
+    std::swap(mem,rhs.mem);
+    return *this;
+  }
+};
+
+using block_cache = thread_cache<block>;
+
+// Thread local caches of a thread, orphaned when the thread exits
+template <typename Cache>
+struct thread_caches : std::vector<std::shared_ptr<Cache>>
+{
+  ~thread_caches()
+  {
+    for (auto& cache : *this)
+      if (cache)
+        cache->orphan();
+  }
+};
+
+struct block_header
+{
+  std::shared_ptr<block_cache> owner;
+  size_t size_class;
+};
+
+const size_t block_granularity = 64;
+const size_t block_classes = 16;
+const size_t header_size = (sizeof(block_header) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+static std::shared_ptr<block_cache>&
+get_block_cache(size_t size_class)
+{
+  static thread_local thread_caches<block_cache> caches;
+  if (caches.empty())
+    caches.resize(block_classes);
+  auto& cache = caches[size_class];
+  if (!cache)
+    cache = std::make_shared<block_cache>();
+  return cache;
+}
+
+////////////////////////////////////////////////////////////////
+// Exec buffer cache entry, a mapped exec buffer object with the
+// number of packet words that may be non-zero
+////////////////////////////////////////////////////////////////
 using buffer_type = xrt::device::ExecBufferObjectHandle;
-static std::mutex s_mutex;
+
+// Exec buffer allocation is not thread safe.  The mutex is never
+// destroyed since exec buffers are freed during static destruction.
+static std::mutex&
+get_alloc_mutex()
+{
+  static auto mutex = new std::mutex;
+  return *mutex;
+}
+
+struct exec_buffer
+{
+  xrt::device* device = nullptr;
+  buffer_type bo;
+  void* data = nullptr;
+  size_t used = 0;
+
+  exec_buffer() {}
+
+  exec_buffer(xrt::device* dev, buffer_type b, void* d, size_t u)
+    : device(dev), bo(std::move(b)), data(d), used(u)
+  {}
+
+  exec_buffer(exec_buffer&& rhs)
+    : device(rhs.device), bo(std::move(rhs.bo)), data(rhs.data), used(rhs.used)
+  {
+    rhs.data = nullptr;
+  }
+
+  ~exec_buffer()
+  {
+    if (!bo)
+      return;
+    std::lock_guard<std::mutex> lk(get_alloc_mutex());
+    if (data)
+      device->unmap(bo);
+    bo.reset();
+  }
+
+  exec_buffer&
+  operator=(exec_buffer&& rhs)
+  {
+    std::swap(device,rhs.device);
+    std::swap(bo,rhs.bo);
+    std::swap(data,rhs.data);
+    std::swap(used,rhs.used);
+    return *this;
+  }
+};
+
+} // namespace
+
+namespace xrt {
+
+////////////////////////////////////////////////////////////////
+// Per device, per thread cache of mapped exec buffers
+////////////////////////////////////////////////////////////////
+class exec_buffer_cache : public thread_cache<exec_buffer>
+{
+  xrt::device* m_device;
+public:
+  explicit
+  exec_buffer_cache(xrt::device* device)
+    : m_device(device)
+  {}
+
+  xrt::device*
+  get_device() const
+  {
+    return m_device;
+  }
+};
+
+} // xrt
+
+namespace {
 
 // Static destruction logic to prevent double purging.
 
@@ -33,44 +261,107 @@ static std::mutex s_mutex;
 // object in this file first.
 static bool s_purged = false;
 
+// All exec buffer caches created, weak references so that caches
+// are deleted along with their thread and outstanding commands.
+// Used only when caches are created and when purged.
 struct X {
-  std::map<xrt::device*,std::vector<buffer_type>> freelist;
+  std::mutex mutex;
+  std::vector<std::weak_ptr<xrt::exec_buffer_cache>> caches;
   X() {}
   ~X() { s_purged = true; }
 };
 
 static X sx;
 
-static buffer_type
-get_buffer(xrt::device* device,size_t sz)
+// Get the exec buffer cache for device of calling thread
+static const std::shared_ptr<xrt::exec_buffer_cache>&
+get_cache(xrt::device* device)
 {
-  std::lock_guard<std::mutex> lk(s_mutex);
+  static thread_local thread_caches<xrt::exec_buffer_cache> caches;
+  static thread_local size_t last = 0;
 
-  auto itr = sx.freelist.find(device);
-  if (itr != sx.freelist.end()) {
-    auto& freelist = (*itr).second;
-    if (!freelist.empty()) {
-      auto buffer = freelist.back();
-      freelist.pop_back();
-      return buffer;
-    }
-  }
+  // Fast path, same device as last call
+  if (last < caches.size() && caches[last]->get_device()==device)
+    return caches[last];
+
+  for (last=0; last<caches.size(); ++last)
+    if (caches[last]->get_device()==device)
+      return caches[last];
 
-  return device->allocExecBuffer(sz); // not thread safe
+  auto cache = std::make_shared<xrt::exec_buffer_cache>(device);
+  {
+    std::lock_guard<std::mutex> lk(sx.mutex);
+    s_purged = false;
+    sx.caches.erase(std::remove_if(sx.caches.begin(),sx.caches.end(),
+                                   [](const std::weak_ptr<xrt::exec_buffer_cache>& wp) { return wp.expired(); })
+                    ,sx.caches.end());
+    sx.caches.push_back(cache);
+  }
+  caches.push_back(std::move(cache));
+  return caches[last];
 }
 
-static void
-free_buffer(xrt::device* device,buffer_type bo)
+static exec_buffer
+get_buffer(const std::shared_ptr<xrt::exec_buffer_cache>& cache, size_t sz)
 {
-  std::lock_guard<std::mutex> lk(s_mutex);
-  s_purged=false;
-  sx.freelist[device].emplace_back(std::move(bo));
+  exec_buffer buffer;
+  if (cache->acquire(buffer))
+    return buffer;
+
+  auto device = cache->get_device();
+  std::lock_guard<std::mutex> lk(get_alloc_mutex());
+  auto bo = device->allocExecBuffer(sz); // not thread safe
+  auto data = device->map(bo);
+  return exec_buffer(device,std::move(bo),data,sz/sizeof(uint32_t));
 }
 
 } // namespace
 
 namespace xrt {
 
+namespace detail {
+
+void*
+allocate_command(size_t bytes)
+{
+  size_t size_class = (bytes + block_granularity - 1) / block_granularity;
+  if (size_class >= block_classes) {
+    auto mem = static_cast<char*>(::operator new(header_size + bytes));
+    new (mem) block_header{nullptr,block_classes};
+    return mem + header_size;
+  }
+
+  auto& cache = get_block_cache(size_class);
+  block blk;
+  if (!cache->acquire(blk))
+    blk.mem = static_cast<char*>(::operator new(header_size + size_class*block_granularity));
+
+  auto mem = blk.mem;
+  blk.mem = nullptr;
+  new (mem) block_header{cache,size_class};
+  return mem + header_size;
+}
+
+void
+deallocate_command(void* ptr)
+{
+  auto mem = static_cast<char*>(ptr) - header_size;
+  auto header = reinterpret_cast<block_header*>(mem);
+
+  // Keep owning cache alive through release
+  auto owner = std::move(header->owner);
+  header->~block_header();
+
+  if (!owner) {
+    ::operator delete(mem);
+    return;
+  }
+
+  owner->release(block(mem));
+}
+
+} // detail
+
 // Purge exec buffer freelist during static destruction.
 // Not safe to call outside of static descruction, can't lock
 // static mutex since it could have been destructed
@@ -80,8 +371,9 @@ purge_command_freelist()
   if (s_purged)
     return;
 
-  for (auto& elem : sx.freelist)
-    elem.second.clear();
+  for (auto& wp : sx.caches)
+    if (auto cache = wp.lock())
+      cache->clear();
 
   s_purged = true;
 }
@@ -89,14 +381,19 @@ purge_command_freelist()
 command::
 command(xrt::device* device, ert_cmd_opcode opcode)
   : m_device(device)
-  , m_exec_bo(get_buffer(m_device,regmap_size*sizeof(value_type)))
-  , m_packet(m_device->map(m_exec_bo))
+  , m_cache(get_cache(device))
+  , m_packet(static_cast<value_type*>(nullptr))
 {
   static unsigned int uid_count = 0;
   m_uid = uid_count++;
 
-  // Clear in case packet was recycled
-  m_packet.clear();
+  auto buffer = get_buffer(m_cache,regmap_size*sizeof(value_type));
+  m_exec_bo = std::move(buffer.bo);
+  m_packet = packet_type(buffer.data);
+
+  // Clear words used if packet was recycled
+  m_packet.clear(buffer.used);
+  buffer.data = nullptr;
 
   auto epacket = get_ert_cmd<ert_packet*>();
   epacket->state = ERT_CMD_STATE_NEW; // new command
@@ -110,8 +407,10 @@ command(xrt::device* device, ert_cmd_opcode opcode)
 command::
 command(command&& rhs)
   : m_uid(rhs.m_uid), m_device(rhs.m_device)
+  , m_cache(std::move(rhs.m_cache))
   , m_exec_bo(std::move(rhs.m_exec_bo))
   , m_packet(std::move(rhs.m_packet))
+  , m_payload_size(rhs.m_payload_size)
 {
   rhs.m_exec_bo = 0;
 }
@@ -121,10 +420,24 @@ command::
 {
   if (m_exec_bo) {
     XRT_DEBUG(std::cout,"xrt::command::~command(",m_uid,")\n");
-    m_device->unmap(m_exec_bo);
-    free_buffer(m_device,m_exec_bo);
+
+    // Words that may be non-zero.  A command that was never
+    // scheduled still has the header count written by the client.
+    if (!m_payload_size)
+      record_payload_size();
+    size_t used = std::max<size_t>(m_packet.size(),m_payload_size);
+    auto data = m_packet.data();
+    m_cache->release(exec_buffer(m_device,std::move(m_exec_bo),data,used));
   }
 }
+void
+command::
+record_payload_size()
+{
+  // The header count covers words written directly through the ert packet
+  auto epacket = get_ert_cmd<ert_packet*>();
+  m_payload_size = std::min<size_t>(std::max<size_t>(m_packet.size(),1 + epacket->count),regmap_size);
+}
 
 void
 command::
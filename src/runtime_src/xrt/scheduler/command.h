@@ -24,14 +24,24 @@
 #include <cstddef>
 #include <array>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
 
 namespace xrt {
 
+class exec_buffer_cache;
+
 /**
  * Command class for command format used by scheduler.
  *
  * A command consist of a 4K packet.  Each word (u32) of the packet
  * can be accessed through the command API.
+ *
+ * The exec buffer backing the packet is taken from a per device, per
+ * thread cache of pre-mapped exec buffers.  When the command is
+ * destroyed, the exec buffer is returned to the cache of the thread
+ * that constructed the command, and only the packet words used by
+ * the command are cleared when the buffer is recycled.
  */
 class command : public std::enable_shared_from_this<command>
 {
@@ -139,6 +149,17 @@ public:
     return m_device;
   }
 
+  /**
+   * Record the number of packet words written by the client
+   *
+   * Called when the command is handed to the scheduler.  The
+   * scheduler and ERT may rewrite the packet header after this
+   * point, so the recorded size is what is cleared when the exec
+   * buffer is recycled.
+   */
+  void
+  record_payload_size();
+
   /**
    * Accessor for underlying command buffer object
    *
@@ -245,8 +266,10 @@ public:
 private:
   unsigned int m_uid;
   xrt::device* m_device;
+  std::shared_ptr<exec_buffer_cache> m_cache;
   buffer_type m_exec_bo;
   mutable packet_type m_packet;
+  size_t m_payload_size = 0; // words, 0 if not yet recorded
 
   // synchronization
   bool m_done = false;
@@ -254,6 +277,77 @@ private:
   std::condition_variable m_cmd_done;
 };
 
+namespace detail {
+
+void*
+allocate_command(size_t bytes);
+
+void
+deallocate_command(void* ptr);
+
+} // detail
+
+/**
+ * Allocator for command objects
+ *
+ * Memory is recycled through per thread caches.  Memory released
+ * by a thread other than the allocating thread is returned to the
+ * cache of the allocating thread.  Use with std::allocate_shared,
+ * see make_command().
+ */
+template <typename T>
+struct command_allocator
+{
+  using value_type = T;
+
+  command_allocator() {}
+
+  template <typename U>
+  command_allocator(const command_allocator<U>&) {}
+
+  T*
+  allocate(size_t n)
+  {
+    return static_cast<T*>(detail::allocate_command(n*sizeof(T)));
+  }
+
+  void
+  deallocate(T* ptr, size_t)
+  {
+    detail::deallocate_command(ptr);
+  }
+
+  template <typename U>
+  bool
+  operator==(const command_allocator<U>&) const
+  {
+    return true;
+  }
+
+  template <typename U>
+  bool
+  operator!=(const command_allocator<U>&) const
+  {
+    return false;
+  }
+};
+
+/**
+ * Construct a command object of specified type
+ *
+ * Object and shared_ptr control block are allocated together
+ * through the recycling command allocator.
+ *
+ * @args: arguments forwarded to CommandType constructor
+ * Return: shared pointer to new command
+ */
+template <typename CommandType, typename ...Args>
+std::shared_ptr<CommandType>
+make_command(Args&&... args)
+{
+  return std::allocate_shared<CommandType>(command_allocator<CommandType>(),std::forward<Args>(args)...);
+}
+
 template <typename ERT_COMMAND_TYPE>
 ERT_COMMAND_TYPE
 command_cast(command* cmd)
@@ -38,13 +38,13 @@
 #include <cerrno>
 #include <algorithm>
 #include <thread>
-#include <list>
+#include <atomic>
+#include <vector>
 #include <map>
 
 namespace {
 
 using command_type = std::shared_ptr<xrt::command>;
-using command_queue_type = std::list<command_type>;
 
 ////////////////////////////////////////////////////////////////
 // Command notification is threaded through task queue
@@ -55,16 +55,67 @@ static xrt::task::queue notify_queue;
 static std::thread notifier;
 static bool threaded_notification = true;
 
+////////////////////////////////////////////////////////////////
+// Outstanding commands of one device.
+//
+// Commands occupy slots that are tracked by a bitmap, the monitor
+// checks only occupied slots for completion.  Freed slots are reused
+// most recent first to keep the occupied slots compact.  Each device
+// has its own lock and wakeup so that devices do not contend.
+////////////////////////////////////////////////////////////////
+struct device_monitor
+{
+  using bitmap_word = uint64_t;
+  static constexpr size_t bits_per_word = sizeof(bitmap_word)*8;
+
+  std::mutex mutex;
+  std::condition_variable work;
+  std::vector<command_type> slots;
+  std::vector<size_t> free_slots;
+  std::vector<bitmap_word> busy;
+  size_t outstanding = 0;
+  std::thread thread;
+
+  // Add a command, caller must hold mutex
+  size_t
+  add(const command_type& cmd)
+  {
+    size_t slot = 0;
+    if (free_slots.empty()) {
+      slot = slots.size();
+      slots.push_back(cmd);
+      if (slot % bits_per_word == 0)
+        busy.push_back(0);
+    }
+    else {
+      slot = free_slots.back();
+      free_slots.pop_back();
+      slots[slot] = cmd;
+    }
+    busy[slot / bits_per_word] |= bitmap_word(1) << (slot % bits_per_word);
+    ++outstanding;
+    return slot;
+  }
+
+  // Remove the command in a slot, caller must hold mutex
+  command_type
+  remove(size_t slot)
+  {
+    busy[slot / bits_per_word] &= ~(bitmap_word(1) << (slot % bits_per_word));
+    free_slots.push_back(slot);
+    --outstanding;
+    return std::move(slots[slot]);
+  }
+};
+
 ////////////////////////////////////////////////////////////////
 // Main command monitor interfacing to embedded MB scheduler
 ////////////////////////////////////////////////////////////////
 static std::mutex s_mutex;
-static std::condition_variable s_work;
 static bool s_running = false;
-static bool s_stop = false;
+static std::atomic<bool> s_stop {false};
 static std::exception_ptr s_exception;
-static std::map<const xrt::device*, command_queue_type> s_device_cmds;
-static std::map<const xrt::device*, std::thread> s_device_monitor_threads;
+static std::map<const xrt::device*, std::unique_ptr<device_monitor>> s_device_monitors;
 
 inline bool
 is_51_dsa(const xrt::device* device)
@@ -86,24 +137,46 @@ is_command_done(const command_type& cmd)
   return get_command_state(cmd) >= ERT_CMD_STATE_COMPLETED;
 }
 
-static bool
-check(const command_type& cmd)
+// Monitors are never erased, so a monitor once looked up under the
+// lock is cached per thread and later lookups on the submission path
+// take no global lock
+static device_monitor&
+get_device_monitor(const xrt::device* device)
 {
-  if (!is_command_done(cmd))
-    return false;
+  static thread_local std::map<const xrt::device*, device_monitor*> cache;
+  auto citr = cache.find(device);
+  if (citr != cache.end())
+    return *(citr->second);
+
+  std::lock_guard<std::mutex> lk(s_mutex);
+  auto itr = s_device_monitors.find(device);
+  if (itr == s_device_monitors.end())
+    throw std::runtime_error("kds command monitor not initialized for device '" + device->getName() + "'");
+  cache.emplace(device,itr->second.get());
+  return *(itr->second);
+}
+
+// Notify completion of all commands found done in one wakeup
+static void
+notify(std::vector<command_type>& cmds)
+{
+#ifdef XRT_VERBOSE
+  for (auto& cmd : cmds)
+    XRT_DEBUG(std::cout,"xrt::kds::command(",cmd->get_uid(),") [running->done]\n");
+#endif
 
-  XRT_DEBUG(std::cout,"xrt::kds::command(",cmd->get_uid(),") [running->done]\n");
   if (!threaded_notification) {
-    cmd->notify(ERT_CMD_STATE_COMPLETED);
-    return true;
+    for (auto& cmd : cmds)
+      cmd->notify(ERT_CMD_STATE_COMPLETED);
+    return;
   }
 
-  auto notify = [](command_type c) {
-    c->notify(ERT_CMD_STATE_COMPLETED);
+  auto notify = [](const std::vector<command_type>& c) {
+    for (auto& cmd : c)
+      cmd->notify(ERT_CMD_STATE_COMPLETED);
   };
 
-  xrt::task::createF(notify_queue,notify,cmd);
-  return true;
+  xrt::task::createF(notify_queue,notify,std::move(cmds));
 }
 
 static void
@@ -112,17 +185,16 @@ launch(command_type cmd)
   XRT_DEBUG(std::cout,"xrt::kds::command(",cmd->get_uid(),") [new->submitted->running]\n");
 
   auto device = cmd->get_device();
-  auto& submitted_cmds = s_device_cmds[device]; // safe since inserted in init
-
-  command_queue_type::const_iterator pos;
+  auto& dm = get_device_monitor(device);
 
   // Store command so completion can be tracked.  Make sure this is
   // done prior to exec_buf as exec_wait can otherwise be missed.
+  size_t slot = 0;
   {
-    std::lock_guard<std::mutex> lk(s_mutex);
-    pos = submitted_cmds.insert(submitted_cmds.end(),cmd);
-    s_work.notify_all();
+    std::lock_guard<std::mutex> lk(dm.mutex);
+    slot = dm.add(cmd);
   }
+  dm.work.notify_one();
 
   // Submit the command
   auto exec_bo = cmd->get_exec_bo();
@@ -131,64 +203,65 @@ launch(command_type cmd)
   }
   catch (...) {
     // Remove the pending command
-    std::lock_guard<std::mutex> lk(s_mutex);
+    std::lock_guard<std::mutex> lk(dm.mutex);
     assert(get_command_state(cmd)==ERT_CMD_STATE_NEW);
-    submitted_cmds.erase(pos);
+    dm.remove(slot);
     throw;
   }
 }
 
 static void
-monitor_loop(const xrt::device* device)
+monitor_loop(const xrt::device* device, device_monitor& dm)
 {
   unsigned long loops = 0;           // number of outer loops
   unsigned long sleeps = 0;          // number of sleeps
 
-  // thread safe access, since guaranteed to be inserted in init
-  auto& submitted_cmds = s_device_cmds[device];
+  std::vector<command_type> done;
 
   while (1) {
     ++loops;
 
     {
-      {
-        std::unique_lock<std::mutex> lk(s_mutex);
+      std::unique_lock<std::mutex> lk(dm.mutex);
 
-        // Larger wait
-        while (!s_stop && submitted_cmds.empty()) {
-          ++sleeps;
-          s_work.wait(lk);
-        }
+      // Larger wait
+      while (!s_stop && !dm.outstanding) {
+        ++sleeps;
+        dm.work.wait(lk);
       }
+    }
 
-      if (s_stop)
-        return;
+    if (s_stop)
+      return;
 
-      // Finer wait
-      while (device->exec_wait(1000)==0) ;
+    // Finer wait
+    while (device->exec_wait(1000)==0) {}
 
-      std::lock_guard<std::mutex> lk(s_mutex);
-      auto end = submitted_cmds.end();
-      for (auto itr=submitted_cmds.begin(); itr!=end; ) {
-        auto& cmd = (*itr);
-        if (check(cmd)) {
-          itr = submitted_cmds.erase(itr);
-          end = submitted_cmds.end();
-        }
-        else {
-          ++itr;
+    // Check occupied slots only
+    {
+      std::lock_guard<std::mutex> lk(dm.mutex);
+      for (size_t widx=0, wend=dm.busy.size(); widx!=wend; ++widx) {
+        for (auto bits=dm.busy[widx]; bits; bits &= bits-1) {
+          auto slot = widx*device_monitor::bits_per_word + __builtin_ctzll(bits);
+          if (is_command_done(dm.slots[slot]))
+            done.push_back(dm.remove(slot));
         }
       }
     }
+
+    if (!done.empty()) {
+      notify(done);
+      done.clear();
+    }
   }
 }
 
 
 static void
-monitor(const xrt::device* device)
+monitor(const xrt::device* device, device_monitor* dm)
 {
   try {
-    monitor_loop(device);
+    monitor_loop(device,*dm);
   }
   catch (const std::exception& ex) {
     std::string msg = std::string("kds command monitor died unexpectedly: ") + ex.what();
@@ -212,6 +285,48 @@ schedule(const command_type& cmd)
   return launch(cmd);
 }
 
+void
+schedule(const std::vector<command_type>& cmds)
+{
+  if (cmds.empty())
+    return;
+
+  // All commands in a batch target the same device
+  auto device = cmds.front()->get_device();
+  auto& dm = get_device_monitor(device);
+
+  // Store all commands under one lock so completion can be tracked
+  std::vector<size_t> slots;
+  slots.reserve(cmds.size());
+  {
+    std::lock_guard<std::mutex> lk(dm.mutex);
+    for (auto& cmd : cmds) {
+      assert(cmd->get_device()==device);
+      XRT_DEBUG(std::cout,"xrt::kds::command(",cmd->get_uid(),") [new->submitted->running]\n");
+      slots.push_back(dm.add(cmd));
+    }
+  }
+  dm.work.notify_one();
+
+  // Submit the commands back to back
+  size_t submitted = 0;
+  try {
+    for (auto& cmd : cmds) {
+      device->exec_buf(cmd->get_exec_bo());
+      ++submitted;
+    }
+  }
+  catch (...) {
+    // Remove the pending commands
+    std::lock_guard<std::mutex> lk(dm.mutex);
+    for (size_t idx=submitted; idx<cmds.size(); ++idx) {
+      assert(get_command_state(cmds[idx])==ERT_CMD_STATE_NEW);
+      dm.remove(slots[idx]);
+    }
+    throw;
+  }
+}
+
 void
 start()
 {
@@ -230,14 +345,23 @@ stop()
   if (!s_running)
     return;
 
+  std::vector<device_monitor*> monitors;
   {
     std::lock_guard<std::mutex> lk(s_mutex);
-    s_stop = true;
+    for (auto& e : s_device_monitors)
+      monitors.push_back(e.second.get());
   }
 
-  s_work.notify_all();
-  for (auto& e : s_device_monitor_threads)
-    e.second.join();
+  // Set stop under each device lock so no monitor misses the wakeup
+  s_stop = true;
+  for (auto dm : monitors) {
+    {
+      std::lock_guard<std::mutex> lk(dm->mutex);
+    }
+    dm->work.notify_all();
+  }
+  for (auto dm : monitors)
+    dm->thread.join();
 
   notify_queue.stop();
   if (threaded_notification)
@@ -252,11 +376,12 @@ init(xrt::device* device, const axlf*)
   // create a submitted command queue for this device if necessary,
   // create a command monitor thread for this device if necessary
   std::lock_guard<std::mutex> lk(s_mutex);
-  auto itr = s_device_monitor_threads.find(device);
-  if (itr==s_device_monitor_threads.end()) {
+  auto itr = s_device_monitors.find(device);
+  if (itr==s_device_monitors.end()) {
     XRT_DEBUG(std::cout,"creating monitor thread and queue for device '",device->getName(),"'\n");
-    s_device_cmds.emplace(device,command_queue_type());
-    s_device_monitor_threads.emplace(device,xrt::thread(::monitor,device));
+    auto& dm = s_device_monitors[device];
+    dm = std::make_unique<device_monitor>();
+    dm->thread = xrt::thread(::monitor,device,dm.get());
   }
 }
 
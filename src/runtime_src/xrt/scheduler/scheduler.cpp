@@ -104,12 +104,30 @@ stop()
 void
 schedule(const command_type& cmd)
 {
+  cmd->record_payload_size();
   if (kds_enabled())
     kds::schedule(cmd);
   else
     sws::schedule(cmd);
 }
 
+/**
+ * Schedule a batch of commands for the same device
+ *
+ * The commands are handed to the scheduler with one pass over
+ * its locks rather than one pass per command
+ */
+void
+schedule(const std::vector<command_type>& cmds)
+{
+  for (auto& cmd : cmds)
+    cmd->record_payload_size();
+  if (kds_enabled())
+    kds::schedule(cmds);
+  else
+    sws::schedule(cmds);
+}
+
 void
 init(xrt::device* device, const axlf* top)
 {
@@ -29,9 +29,48 @@ using command_type = std::shared_ptr<command>;
  */
 namespace sws {
 
+/**
+ * CU polling statistics accumulated over all devices
+ *
+ * @polls: number of CU status register reads issued
+ * @completions: number of command completions found by polls
+ */
+struct poll_counters
+{
+  uint64_t polls;
+  uint64_t completions;
+};
+
+poll_counters
+get_poll_counters();
+
+/**
+ * Per CU utilization statistics
+ *
+ * @started: number of commands started on the CU
+ * @busy_ns: accumulated time the CU had at least one running command
+ */
+struct cu_stats
+{
+  uint64_t started;
+  uint64_t busy_ns;
+};
+
+/**
+ * Get utilization statistics for CUs of a device
+ *
+ * Return: statistics indexed by CU index, empty if device has no
+ *  execution core
+ */
+std::vector<cu_stats>
+get_cu_stats(const xrt::device* device);
+
 void
 schedule(const command_type& cmd);
 
+void
+schedule(const std::vector<command_type>& cmds);
+
 void
 start();
 
@@ -54,6 +93,9 @@ namespace kds {
 void
 schedule(const command_type& cmd);
 
+void
+schedule(const std::vector<command_type>& cmds);
+
 void
 start();
 
@@ -72,6 +114,9 @@ namespace scheduler {
 void
 schedule(const command_type& cmd);
 
+void
+schedule(const std::vector<command_type>& cmds);
+
 void
 start();
 
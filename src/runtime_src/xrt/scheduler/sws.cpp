@@ -25,17 +25,22 @@
 #include "xrt/util/debug.h"
 #include "xrt/util/thread.h"
 #include "xrt/util/task.h"
+#include "xrt/util/mpsc_ring.h"
 #include "ert.h"
 #include "xclbin.h"
 #include "core/common/xclbin_parser.h"
 #include "command.h"
+#include "scheduler.h"
 #include <limits>
+#include <atomic>
 #include <bitset>
 #include <vector>
 #include <list>
 #include <map>
+#include <algorithm>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
 
 namespace {
 
@@ -73,6 +78,20 @@ const size_type no_index = std::numeric_limits<size_type>::max();
 
 const size_type MAX_SLOTS = 128;
 
+// Number of slots in per exec_core submission ring
+const size_t SUBMIT_RING_SIZE = 1024;
+
+// CU polling backoff
+using clock_type = std::chrono::steady_clock;
+const clock_type::duration min_poll_interval = std::chrono::microseconds(1);
+
+static clock_type::duration
+max_poll_interval()
+{
+  static clock_type::duration value = std::chrono::microseconds(xrt::config::get_sws_max_poll_interval());
+  return value;
+}
+
 // FFA  handling
 const value_type AP_START    = 0x1;
 const value_type AP_DONE     = 0x2;
@@ -88,7 +107,14 @@ const value_type AP_CONTINUE = 0x10;
 static xrt::task::queue notify_queue;
 static std::thread notifier;
 static bool threaded_notification = true;
-static bool cu_trace_enabled = false;
+static std::atomic<bool> cu_trace_enabled {false};
+
+////////////////////////////////////////////////////////////////
+// Polling statistics, number of CU polls issued and number of
+// completions found by those polls
+////////////////////////////////////////////////////////////////
+static std::atomic<uint64_t> s_polls {0};
+static std::atomic<uint64_t> s_completions {0};
 
 ////////////////////////////////////////////////////////////////
 // Forward declarations
@@ -136,7 +162,7 @@ public:
   xocl_cmd(exec_core* ec, cmd_ptr cmd)
     : m_cmd(cmd), m_ecmd(m_cmd->get_ert_cmd<ert_packet*>()), m_exec(ec), m_state(ERT_CMD_STATE_NEW)
   {
-    static size_type count = 0;
+    static std::atomic<size_type> count {0};
     m_uid = count++;
     if (m_ecmd->opcode==ERT_START_KERNEL) {
       m_cus |= m_kcmd->cu_mask;
@@ -295,18 +321,6 @@ public:
 
 using xcmd_ptr = std::shared_ptr<xocl_cmd>;
 
-////////////////////////////////////////////////////////////////
-// List of new pending xocl_cmd objects
-//
-// @s_pending_cmds: populated from user space with new commands for buffer objects
-// @s_num_pending: number of pending commands
-//
-// Scheduler copies pending commands to its private queue when necessary
-////////////////////////////////////////////////////////////////
-static std::vector<xcmd_ptr> s_pending_cmds;
-static std::mutex s_pending_mutex;
-static std::atomic<unsigned int> s_num_pending {0};
-
 ////////////////////////////////////////////////////////////////
 // class xocl_cu represents a compute unit on a device
 //
@@ -316,6 +330,8 @@ static std::atomic<unsigned int> s_num_pending {0};
 // @addr: base address of this CU
 // @ctrlreg: state of the CU (value of AXI-lite control register)
 // @done_counter: number of command that have completed (<=running_queue.size())
+// @next_poll: earliest time at which the CU should be polled again
+// @poll_interval: current backoff between polls of this CU
 //
 // The CU supports HLS data flow model where running_queue represents
 // all the commands that have been started on this CU. The CU is polled
@@ -323,13 +339,18 @@ static std::atomic<unsigned int> s_num_pending {0};
 // is incremented to reflect the number of commands in the fifo that have
 // completed execution.
 //
+// A CU is polled only when it has outstanding work and its poll
+// deadline has expired.  Each poll that finds no completion doubles
+// the interval to the next poll up to a configurable maximum, a
+// completion or a new start resets the interval.
+//
 // New commands can be pushed to the running_queue when the CU has
 // asserted AP_READY (=> AP_START is low)
 ////////////////////////////////////////////////////////////////
 class xocl_cu
 {
 private:
-  std::queue<xocl_cmd*> running_queue;
+  std::queue<xcmd_ptr> running_queue;
   xrt::device* xdev = nullptr;
   size_type idx = 0;
   value_type addr = 0;
@@ -338,6 +359,14 @@ private:
   mutable size_type done_cnt = 0;
   mutable size_type run_cnt = 0;
 
+  mutable clock_type::time_point next_poll;
+  mutable clock_type::duration poll_interval {0};
+
+  // Utilization, read by other threads
+  mutable clock_type::time_point busy_since;
+  mutable std::atomic<uint64_t> busy_ns {0};
+  std::atomic<uint64_t> started {0};
+
   void
   poll() const
   {
@@ -345,15 +374,24 @@ private:
     ctrlreg = 0;
 
     xdev->read_register(addr,&ctrlreg,4);
+    ++s_polls;
     XRT_DEBUGF("sws cu(%d) poll(0x%x) done(%d) run(%d)\n",idx,ctrlreg,done_cnt,run_cnt);
     if (ctrlreg & (AP_DONE | AP_IDLE))  { // AP_IDLE check in sw emulation
       ++done_cnt;
       --run_cnt;
+      ++s_completions;
+      if (!run_cnt)
+        busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now()-busy_since).count();
       XRT_ASSERT(done_cnt <= running_queue.size(),"too many dones");
       // acknowledge done
       value_type cont = AP_CONTINUE;
       xdev->write_register(addr,&cont,4);
+      poll_interval = clock_type::duration::zero();
     }
+    else {
+      poll_interval = std::min(std::max(poll_interval*2,min_poll_interval),max_poll_interval());
+    }
+    next_poll = clock_type::now() + poll_interval;
   }
 
 public:
@@ -361,6 +399,49 @@ public:
     : xdev(dev), idx(index), addr(baseaddr)
   {}
 
+  // Poll the CU if it has running commands and its deadline has expired
+  void
+  poll_if_due() const
+  {
+    if (run_cnt && clock_type::now() >= next_poll)
+      poll();
+  }
+
+  // Check if CU has commands that have not yet been popped
+  bool
+  has_work() const
+  {
+    return !running_queue.empty();
+  }
+
+  // Number of commands started and not yet known to be done
+  size_type
+  get_run_cnt() const
+  {
+    return run_cnt;
+  }
+
+  // Total number of commands started on this CU
+  uint64_t
+  get_started() const
+  {
+    return started;
+  }
+
+  // Total time this CU has had at least one command running
+  uint64_t
+  get_busy_ns() const
+  {
+    return busy_ns;
+  }
+
+  // Earliest time at which CU must be polled, max if idle
+  clock_type::time_point
+  get_next_poll() const
+  {
+    return run_cnt ? next_poll : clock_type::time_point::max();
+  }
+
   // Check if CU is ready to start another command
   //
   // The CU is ready when AP_START is low
@@ -372,7 +453,7 @@ public:
   {
     if ( (ctrlreg & AP_START) || (is_sw_emulation() && run_cnt) ) {
       XRT_DEBUGF("sws ready() is polling cu(%d)\n",idx);
-      poll();
+      poll_if_due();
     }
 
     return is_sw_emulation()
@@ -380,40 +461,31 @@ public:
       : !(ctrlreg & AP_START);
   }
 
-  // Get the first completed command from the running queue
+  // Pop the first completed command off of the running queue
+  //
+  // The CU is not polled, completion must have been observed
+  // by a prior poll.
   //
   // @return
   //   The first command that has completed or nullptr if none
-  xocl_cmd*
-  get_done() const
-  {
-    if (!done_cnt) {
-      XRT_DEBUGF("sws get_done() is polling cu(%d)\n",idx);
-      poll();
-    }
-
-    return done_cnt
-      ? running_queue.front()
-      : nullptr;
-  }
-
-  // Pop the first completed command off of the running queue
-  void
+  xcmd_ptr
   pop_done()
   {
     if (!done_cnt)
-      return;
+      return nullptr;
 
+    auto xcmd = std::move(running_queue.front());
     running_queue.pop();
     --done_cnt;
     XRT_DEBUGF("sws pop_done() popped cu(%d) done(%d) run(%d)\n",idx,done_cnt,run_cnt);
+    return xcmd;
   }
 
   // Start the CU with a new command.
   //
   // The command is pushed onto the running queue
   void
-  start(xocl_cmd* xcmd)
+  start(const xcmd_ptr& xcmd)
   {
     XRT_ASSERT(!(ctrlreg & AP_START),"cu not ready");
 
@@ -437,23 +509,127 @@ public:
       xdev->write_register(addr,regmap,4);
 
     running_queue.push(xcmd);
-    ++run_cnt;
+    auto now = clock_type::now();
+    if (!run_cnt++)
+      busy_since = now;
+    ++started;
+    poll_interval = clock_type::duration::zero();
+    next_poll = now;
     XRT_DEBUGF("started cu(%d) xcmd(%d) done(%d) run(%d)\n",idx,xcmd->get_uid(),done_cnt,run_cnt);
   }
 };
 
 
+////////////////////////////////////////////////////////////////
+// class cu_policy selects the CU on which to start a command
+//
+// The policy is given the CUs of an execution core and returns the
+// index of a ready CU that can execute the command, or no_index if
+// none is available.  Policies are selected per sdaccel.ini:
+//  [Runtime]
+//   sws_cu_policy = first_fit | round_robin | least_loaded
+//
+// first_fit:    lowest index ready CU (default)
+// round_robin:  first ready CU after the most recently selected CU
+// least_loaded: ready CU with fewest running commands, ties broken
+//               by fewest total started commands
+////////////////////////////////////////////////////////////////
+class cu_policy
+{
+public:
+  using cu_vector = std::vector<std::unique_ptr<xocl_cu>>;
+
+  virtual
+  ~cu_policy()
+  {}
+
+  virtual size_type
+  select(const xocl_cmd* xcmd, const cu_vector& cus) = 0;
+
+  static std::unique_ptr<cu_policy>
+  create(const std::string& name);
+};
+
+class first_fit_policy : public cu_policy
+{
+public:
+  virtual size_type
+  select(const xocl_cmd* xcmd, const cu_vector& cus)
+  {
+    for (size_type cuidx=0; cuidx<cus.size(); ++cuidx)
+      if (xcmd->has_cu(cuidx) && cus[cuidx]->ready())
+        return cuidx;
+    return no_index;
+  }
+};
+
+class round_robin_policy : public cu_policy
+{
+  size_type m_last = no_index;
+public:
+  virtual size_type
+  select(const xocl_cmd* xcmd, const cu_vector& cus)
+  {
+    size_type num_cus = cus.size();
+    for (size_type i=1; i<=num_cus; ++i) {
+      auto cuidx = (m_last + i) % num_cus;
+      if (xcmd->has_cu(cuidx) && cus[cuidx]->ready())
+        return (m_last = cuidx);
+    }
+    return no_index;
+  }
+};
+
+class least_loaded_policy : public cu_policy
+{
+public:
+  virtual size_type
+  select(const xocl_cmd* xcmd, const cu_vector& cus)
+  {
+    auto best = no_index;
+    for (size_type cuidx=0; cuidx<cus.size(); ++cuidx) {
+      auto& cu = cus[cuidx];
+      if (!xcmd->has_cu(cuidx) || !cu->ready())
+        continue;
+      if (best==no_index
+          || cu->get_run_cnt() < cus[best]->get_run_cnt()
+          || (cu->get_run_cnt()==cus[best]->get_run_cnt() && cu->get_started() < cus[best]->get_started()))
+        best = cuidx;
+    }
+    return best;
+  }
+};
+
+std::unique_ptr<cu_policy>
+cu_policy::
+create(const std::string& name)
+{
+  if (name=="round_robin")
+    return std::make_unique<round_robin_policy>();
+  if (name=="least_loaded")
+    return std::make_unique<least_loaded_policy>();
+  if (name!="first_fit")
+    throw std::runtime_error("unknown sws cu policy '" + name + "'");
+  return std::make_unique<first_fit_policy>();
+}
+
 ////////////////////////////////////////////////////////////////
 // class exec_core: core data struct for command execution on a device
 //
 // @xdev: the xrt device on which to execute
 // @scheduler: scheduler that manages this execution core
+// @pending_ring: lock-free ring of new commands submitted by user threads
 // @submit_queue: queue holding command that have been submitted by scheduler
 // @slot_status: bitset representing free/busy slots in submit_queue
 // @cu_usage: list of CUs managed by this execution core (device)
+// @policy: policy selecting which ready CU starts a command
 // @num_slots: number of slots in submit queue
 // @num_cus: number of CUs on device
 //
+// New commands are pushed to the pending ring by any number of user
+// threads without locking, and drained in batches by the scheduler
+// thread, which is the only consumer of the ring.
+//
 // The submit queue reflects the hardware command queue such that
 // number of slots is limitted.  Once submit queue is full, the
 // scheduler backs off submitting commands to this execution core. The
@@ -462,9 +638,9 @@ public:
 // affect performance.
 //
 // Once a command is started on a CU it is removed from the submit
-// queue.  The command is annotated with the CU on which is has been
-// started, so scheduler will revisit the command and check for its
-// completion.
+// queue and owned by the running queue of the CU on which it has been
+// started.  The scheduler harvests completed commands from CUs with
+// outstanding work rather than revisiting each running command.
 ////////////////////////////////////////////////////////////////
 class exec_core
 {
@@ -474,6 +650,9 @@ class exec_core
   // scheduler for this device
   xocl_scheduler* m_scheduler = nullptr;
 
+  // New commands from user threads, consumed by scheduler thread
+  xrt::mpsc_ring<xcmd_ptr,SUBMIT_RING_SIZE> pending_ring;
+
   // Commands submitted to this device, the queue is slot based
   // and a slot becomes free when its command is started on a CU
   xocl_cmd* submit_queue[MAX_SLOTS] = {nullptr}; // reflects ERT CQ # slots
@@ -482,6 +661,9 @@ class exec_core
   // Compute units on this device
   std::vector<std::unique_ptr<xocl_cu>> cu_usage;
 
+  // CU selection policy
+  std::unique_ptr<cu_policy> policy;
+
   size_type num_slots = 0;
   size_type num_cus = 0;
 
@@ -492,6 +674,14 @@ public:
     cu_usage.reserve(cu_amap.size());
     for (size_type idx=0; idx<cu_amap.size(); ++idx)
       cu_usage.push_back(std::make_unique<xocl_cu>(xdev,idx,cu_amap[idx]));
+    policy = cu_policy::create(xrt::config::get_sws_cu_policy());
+  }
+
+  // CUs managed by this execution core
+  const std::vector<std::unique_ptr<xocl_cu>>&
+  get_cus() const
+  {
+    return cu_usage;
   }
 
   // Scheduler mananging this execution core
@@ -501,6 +691,32 @@ public:
     return m_scheduler;
   }
 
+  // Push a new command onto the pending ring
+  //
+  // Called from any user thread, never blocks.
+  //
+  // @return
+  //  True if command was pushed, false if ring is full
+  bool
+  push_pending(xcmd_ptr& xcmd)
+  {
+    return pending_ring.try_push(std::move(xcmd));
+  }
+
+  // Drain up to @max pending commands
+  //
+  // Called from scheduler thread only.  Each drained command is
+  // passed to the argument callable.
+  //
+  // @return
+  //  Number of commands drained
+  template <typename Callable>
+  size_t
+  drain_pending(Callable&& fn, size_t max)
+  {
+    return pending_ring.pop_batch(std::forward<Callable>(fn),max);
+  }
+
   // Get a free slot index into submit queue
   //
   // @return
@@ -548,31 +764,28 @@ public:
     return true;
   }
 
-  // Start a command on first available ready CU
+  // Start a command on a ready CU selected by CU policy
   //
   // @return
   //  True if started successfully, false otherwise
   bool
-  penguin_start(xocl_cmd* xcmd)
-  {
-    // Find a ready CU
-    for (size_type cuidx=0; cuidx<num_cus; ++cuidx) {
-      auto& cu = cu_usage[cuidx];
-      if (xcmd->has_cu(cuidx) && cu->ready()) {
-        xcmd->cuidx = cuidx;
-        cu->start(xcmd);
-        return true;
-      }
-    }
-    return false;
+  penguin_start(const xcmd_ptr& xcmd)
+  {
+    auto cuidx = policy->select(xcmd.get(),cu_usage);
+    if (cuidx==no_index)
+      return false;
+
+    xcmd->cuidx = cuidx;
+    cu_usage[cuidx]->start(xcmd);
+    return true;
   }
 
-  // Start a command on first available ready CU
+  // Start a command on a ready CU
   //
   // @return
   //  True if started successfully, false otherwise
   bool
-  start(xocl_cmd* xcmd)
+  start(const xcmd_ptr& xcmd)
   {
     if (penguin_start(xcmd)) {
       submit_queue[xcmd->slotidx]=nullptr;
@@ -582,52 +795,69 @@ public:
     return false;
   }
 
-  // Check if a command has completed execution
+  // Harvest completed commands from CUs with outstanding work
   //
-  // It is precond that command has been started, so the CU that executes
-  // the command is indicated by the cuidx in the command.  Simply check
-  // if the first completed command in the CU is the argument command
-  // and if so pop it off the CU.
+  // Each CU with running commands is polled at most once if its
+  // poll deadline has expired, and all its completed commands are
+  // passed to the argument callable in order of completion.
   //
   // @return
-  //   True if completed, false otherwise
-  bool
-  penguin_query(xocl_cmd* xcmd)
+  //   Number of completed commands
+  template <typename Callable>
+  size_t
+  harvest(Callable&& fn)
   {
-    // no point to query a command
-    auto& cu = cu_usage[xcmd->cuidx];
-    if (cu->get_done()==xcmd) {
-      cu->pop_done();
-      return true;
+    size_t count = 0;
+    for (auto& cu : cu_usage) {
+      if (!cu->has_work())
+        continue;
+      cu->poll_if_due();
+      while (auto xcmd = cu->pop_done()) {
+        fn(xcmd);
+        ++count;
+      }
     }
-    return false;
+    return count;
   }
 
-  // Check if a command has completed execution
-  bool
-  query(xocl_cmd* xcmd)
+  // Earliest poll deadline of any CU with running commands
+  clock_type::time_point
+  next_poll() const
   {
-    return penguin_query(xcmd);
+    auto deadline = clock_type::time_point::max();
+    for (auto& cu : cu_usage)
+      deadline = std::min(deadline,cu->get_next_poll());
+    return deadline;
   }
 };
 
 ////////////////////////////////////////////////////////////////
 // class xocl_scheduler: The scheduler data structure
 //
-// @m_command_queue: all the commands managed by scheduler
+// @m_command_queue: commands managed by scheduler that are not yet running
+// @m_num_running: number of commands running on CUs of managed exec cores
 //
 // The scheduler babysits all commands launched by user. It
 // transitions the commands from state to state until the command
-// completes.
+// completes.  Running commands are owned by the CUs they execute on
+// and completions are harvested from CUs with outstanding work.
+//
+// When a loop iteration makes no progress the scheduler backs off,
+// first spinning, then yielding, and finally blocking until the
+// earliest CU poll deadline or until a new command is submitted.
 //
 // The scheduler runs on its own thread and manages command execution
-// on execution cores.  An execution core is 1-1 with a scheduler, but
-// a scheduler can manage any number of cores.  Because the scheduler
+// on execution cores.  Each device has its own scheduler, which
+// manages the execution core of that device.  Because the scheduler
 // is the only client of an exec_core, and exec_core is the only
 // client of xocl_cu, no locking is necessary is any of the data
-// structures.  Exception is the pending command list which is copied
-// to the scheduler command queue, the pending list is populated by
-// user thread, and harvested by scheduler thread.
+// structures.  Exception is the per exec_core pending ring, which is
+// populated lock-free by user threads and drained in batches by the
+// scheduler thread.
+//
+// The scheduler mutex protects the list of managed execution cores
+// and is otherwise only taken by a submitter when the scheduler is
+// sleeping and must be woken up.
 ////////////////////////////////////////////////////////////////
 class xocl_scheduler
 {
@@ -636,26 +866,38 @@ class xocl_scheduler
 
   bool                       m_stop = false;
   std::list<xcmd_ptr>        m_command_queue;
+  std::vector<exec_core*>    m_exec_cores;
+  size_t                     m_num_running = 0;
+
+  // Number of consecutive loop iterations without progress
+  unsigned int               m_idle = 0;
+
+  // Number of commands pushed to exec_core rings but not yet drained
+  std::atomic<size_t>        m_num_pending {0};
+
+  // Set while scheduler thread is (about to be) blocked in wait()
+  std::atomic<bool>          m_sleeping {false};
 
   // Copy pending commands into command queue.
+  //
+  // Each execution core ring is drained in one batch
   void
   queue_cmds()
   {
-    std::lock_guard<std::mutex> lk(s_pending_mutex);
-    for (auto itr=s_pending_cmds.begin(); itr!=s_pending_cmds.end(); ) {
-      auto xcmd = (*itr);
-      auto exec = xcmd->get_exec();
-      if (exec->get_scheduler()==this) {
-        XRT_DEBUGF("xcmd(%d) [new->queued]\n",xcmd->get_uid());
-        itr = s_pending_cmds.erase(itr);
-        xcmd->set_int_state(ERT_CMD_STATE_QUEUED);
-        m_command_queue.push_back(std::move(xcmd));
-      }
-      else {
-        ++itr;
-      }
-    }
-    s_num_pending = s_pending_cmds.size();
+    if (!m_num_pending)
+      return;
+
+    auto queue = [this](xcmd_ptr&& xcmd) {
+      XRT_DEBUGF("xcmd(%d) [new->queued]\n",xcmd->get_uid());
+      xcmd->set_int_state(ERT_CMD_STATE_QUEUED);
+      m_command_queue.push_back(std::move(xcmd));
+    };
+
+    std::lock_guard<std::mutex> lk(m_mutex);
+    size_t drained = 0;
+    for (auto exec : m_exec_cores)
+      drained += exec->drain_pending(queue,SUBMIT_RING_SIZE);
+    m_num_pending -= drained;
   }
 
   // Transition command to submitted state if possible
@@ -678,27 +920,23 @@ class xocl_scheduler
   {
     bool retval = false;
     auto exec = xcmd->get_exec();
-    if (exec->start(xcmd.get())) {
+    if (exec->start(xcmd)) {
       XRT_DEBUGF("xcmd(%d) [submitted->running]\n",xcmd->get_uid());
       xcmd->set_int_state(ERT_CMD_STATE_RUNNING);
+      ++m_num_running;
       retval = true;
     }
     return retval;
   }
 
-  // Transition command to complete state if command has completed
-  bool
+  // Transition command to complete state, command has been
+  // harvested from the CU on which it completed
+  void
   running_to_complete(const xcmd_ptr& xcmd)
   {
-    bool retval = false;
-    auto exec = xcmd->get_exec();
-    if (exec->query(xcmd.get())) {
-      XRT_DEBUGF("xcmd(%d) [running->complete]\n",xcmd->get_uid());
-      xcmd->set_state(ERT_CMD_STATE_COMPLETED);
-      xcmd->notify_host();
-      retval = true;
-    }
-    return retval;
+    XRT_DEBUGF("xcmd(%d) [running->complete]\n",xcmd->get_uid());
+    xcmd->set_state(ERT_CMD_STATE_COMPLETED);
+    xcmd->notify_host();
   }
 
   // Free a command
@@ -709,22 +947,25 @@ class xocl_scheduler
     return true;
   }
 
-  // Iterate command queue and baby sit all commands
-  void
+  // Iterate command queue and baby sit commands not yet running
+  //
+  // Commands that are started are removed from the command queue,
+  // they are now owned by the CU on which they run.
+  //
+  // @return
+  //  True if any command changed state, false otherwise
+  bool
   iterate_cmds()
   {
+    bool progress = false;
     auto end = m_command_queue.end();
     auto nitr = m_command_queue.begin();
     for (auto itr=nitr; itr!=end; itr=nitr) {
       auto& xcmd = (*itr);
       if (xcmd->get_state() == ERT_CMD_STATE_QUEUED)
-        queued_to_submitted(xcmd);
-      if (xcmd->get_state() == ERT_CMD_STATE_SUBMITTED)
-        submitted_to_running(xcmd);
-      if (xcmd->get_state() == ERT_CMD_STATE_RUNNING)
-        running_to_complete(xcmd);
-      if (xcmd->get_state() == ERT_CMD_STATE_COMPLETED) {
-        complete_to_free(xcmd);
+        progress |= queued_to_submitted(xcmd);
+      if (xcmd->get_state() == ERT_CMD_STATE_SUBMITTED && submitted_to_running(xcmd)) {
+        progress = true;
         nitr = m_command_queue.erase(itr);
         end = m_command_queue.end();
         continue;
@@ -732,18 +973,89 @@ class xocl_scheduler
 
       nitr = ++itr;
     }
+    return progress;
+  }
+
+  // Harvest completed commands from all managed exec cores
+  //
+  // @return
+  //  True if any command completed, false otherwise
+  bool
+  harvest_cmds()
+  {
+    if (!m_num_running)
+      return false;
+
+    auto complete = [this](const xcmd_ptr& xcmd) {
+      running_to_complete(xcmd);
+      complete_to_free(xcmd);
+    };
+
+    std::lock_guard<std::mutex> lk(m_mutex);
+    size_t completed = 0;
+    for (auto exec : m_exec_cores)
+      completed += exec->harvest(complete);
+    m_num_running -= completed;
+    return completed > 0;
+  }
+
+  // Back off when an iteration made no progress
+  //
+  // Spin for configured number of iterations, then yield for
+  // configured number of iterations, then block until the earliest
+  // CU poll deadline or until a new command is submitted.
+  void
+  backoff(bool progress)
+  {
+    if (progress) {
+      m_idle = 0;
+      return;
+    }
+
+    static auto spin = xrt::config::get_sws_spin_count();
+    static auto yield = spin + xrt::config::get_sws_yield_count();
+
+    if (++m_idle <= spin)
+      return;
+
+    if (m_idle <= yield) {
+      std::this_thread::yield();
+      return;
+    }
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    auto deadline = clock_type::time_point::max();
+    for (auto exec : m_exec_cores)
+      deadline = std::min(deadline,exec->next_poll());
+    if (deadline == clock_type::time_point::max())
+      deadline = clock_type::now() + max_poll_interval();
+
+    m_sleeping = true;
+    while (!m_stop && !m_num_pending)
+      if (m_work.wait_until(lk,deadline) == std::cv_status::timeout)
+        break;
+    m_sleeping = false;
   }
 
   // Wait until something interesting happens
+  //
+  // The sleeping flag is raised before pending commands are checked,
+  // and submitters bump the pending count before checking the flag,
+  // so either the scheduler sees the new command or the submitter
+  // sees the scheduler sleeping and notifies under the mutex.
   void
   wait()
   {
     std::unique_lock<std::mutex> lk(m_mutex);
-    while (!m_stop && !s_num_pending && m_command_queue.empty())
-      m_work.wait(lk);
+    if (m_command_queue.empty() && !m_num_running) {
+      m_sleeping = true;
+      while (!m_stop && !m_num_pending)
+        m_work.wait(lk);
+      m_sleeping = false;
+    }
 
     if (m_stop) {
-      if (!m_command_queue.empty() || s_num_pending)
+      if (!m_command_queue.empty() || m_num_running || m_num_pending)
         throw std::runtime_error("software scheduler stopping while there are active commands");
     }
   }
@@ -755,15 +1067,71 @@ class xocl_scheduler
   {
     wait();
     queue_cmds();
-    iterate_cmds();
+    auto progress = iterate_cmds();
+    progress |= harvest_cmds();
+    backoff(progress);
   }
 
 public:
 
+  // Add an execution core to be managed by this scheduler
+  void
+  add_exec_core(exec_core* exec)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_exec_cores.push_back(exec);
+  }
+
+  // Remove an execution core from this scheduler
+  void
+  remove_exec_core(exec_core* exec)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_exec_cores.erase(std::remove(m_exec_cores.begin(),m_exec_cores.end(),exec),m_exec_cores.end());
+  }
+
+  // Submit a new command to its execution core
+  //
+  // Called from user threads.  The command is pushed lock-free to
+  // the execution core's pending ring.  If the ring is full, the
+  // submitter yields until the scheduler has drained the ring.
+  void
+  submit(xcmd_ptr xcmd)
+  {
+    auto exec = xcmd->get_exec();
+    ++m_num_pending;
+    while (!exec->push_pending(xcmd)) {
+      notify();
+      std::this_thread::yield();
+    }
+    notify();
+  }
+
+  // Submit a batch of new commands
+  //
+  // Same as submit() for each command, but the scheduler is woken
+  // up once after the last command has been pushed.
+  void
+  submit(std::vector<xcmd_ptr>& xcmds)
+  {
+    m_num_pending += xcmds.size();
+    for (auto& xcmd : xcmds) {
+      auto exec = xcmd->get_exec();
+      while (!exec->push_pending(xcmd)) {
+        notify();
+        std::this_thread::yield();
+      }
+    }
+    notify();
+  }
+
   // Wake up the scheduler if it is waiting
   void
   notify()
   {
+    if (!m_sleeping)
+      return;
+    std::lock_guard<std::mutex> lk(m_mutex);
     m_work.notify_one();
   }
 
@@ -775,6 +1143,14 @@ public:
       loop();
   }
 
+  // Prepare a stopped scheduler to be run again
+  void
+  restart()
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stop = false;
+  }
+
   // Stop the scheduler
   void
   stop()
@@ -787,19 +1163,95 @@ public:
 };
 
 ////////////////////////////////////////////////////////////////
-// One static scheduler currently on a single thread
-static xocl_scheduler s_global_scheduler;
-static std::thread s_scheduler_thread;
+// Each device has its own scheduler running on its own thread
+//
+// @scheduler: the scheduler managing the device's execution core
+// @thread: thread running the scheduler loop
+// @idx: creation index of the scheduler, used for cpu pinning
+////////////////////////////////////////////////////////////////
+struct device_scheduler
+{
+  xocl_scheduler scheduler;
+  std::thread thread;
+  unsigned int idx = 0;
+
+  explicit
+  device_scheduler(unsigned int i)
+    : idx(i)
+  {}
+
+  // Start scheduler thread, optionally pinned to one of the cpus
+  // in Runtime.cpu_affinity selected by scheduler index
+  void
+  start()
+  {
+    scheduler.restart();
+    thread = xrt::thread([this]() { scheduler.run(); });
+    if (xrt::config::get_sws_pin_scheduler())
+      xrt::detail::set_cpu_affinity(thread,idx);
+  }
+
+  void
+  stop()
+  {
+    if (!thread.joinable())
+      return;
+    scheduler.stop();
+    thread.join();
+  }
+};
+
+// Devices are opened and initialized concurrently, s_device_mutex
+// guards s_device_scheduler, s_device_exec_core, and s_running
+static std::mutex s_device_mutex;
+static std::map<const xrt::device*, std::unique_ptr<device_scheduler>> s_device_scheduler;
 static bool s_running=false;
 
 // Each device has a execution core
 static std::map<const xrt::device*, std::unique_ptr<exec_core>> s_device_exec_core;
 
-// Thread routine for scheduler loop
+// Get the scheduler of a device, create and start it if necessary.
+// Caller must hold s_device_mutex.
+static xocl_scheduler*
+get_scheduler(const xrt::device* xdev)
+{
+  auto itr = s_device_scheduler.find(xdev);
+  if (itr != s_device_scheduler.end())
+    return &(*itr).second->scheduler;
+
+  auto ds = std::make_unique<device_scheduler>(s_device_scheduler.size());
+  if (s_running)
+    ds->start();
+  auto scheduler = &ds->scheduler;
+  s_device_scheduler.insert(std::make_pair(xdev,std::move(ds)));
+  return scheduler;
+}
+
+// Replace the execution core of a device.
+// Caller must hold s_device_mutex.
 static void
-scheduler_loop()
+set_exec_core(xrt::device* xdev, std::unique_ptr<exec_core> exec)
+{
+  auto itr = s_device_exec_core.find(xdev);
+  if (itr != s_device_exec_core.end()) {
+    (*itr).second->get_scheduler()->remove_exec_core((*itr).second.get());
+    s_device_exec_core.erase(itr);
+  }
+  exec->get_scheduler()->add_exec_core(exec.get());
+  s_device_exec_core.insert(std::make_pair(xdev,std::move(exec)));
+}
+
+// Execution core of a device.  The core is replaced only when a new
+// xclbin is loaded, which cannot happen while commands are submitted
+// to the device, so the pointer can be used after the lock is released.
+static exec_core*
+get_exec_core(const xrt::device* xdev)
 {
-  s_global_scheduler.run();
+  std::lock_guard<std::mutex> lk(s_device_mutex);
+  auto itr = s_device_exec_core.find(xdev);
+  if (itr == s_device_exec_core.end())
+    throw std::runtime_error("no execution core for device");
+  return (*itr).second.get();
 }
 
 } // namespace
@@ -811,23 +1263,39 @@ schedule(const cmd_ptr& cmd)
 {
   auto device = cmd->get_device();
 
-  auto& exec = s_device_exec_core[device];
-  auto xcmd = xocl_cmd::create(exec.get(),cmd);
-  auto scheduler = exec->get_scheduler();
+  auto exec = get_exec_core(device);
+  auto xcmd = xocl_cmd::create(exec,cmd);
+  exec->get_scheduler()->submit(std::move(xcmd));
+}
 
-  std::lock_guard<std::mutex> lk(s_pending_mutex);
-  s_pending_cmds.push_back(xcmd);
-  ++s_num_pending;
-  scheduler->notify();
+void
+schedule(const std::vector<cmd_ptr>& cmds)
+{
+  if (cmds.empty())
+    return;
+
+  // All commands in a batch target the same device
+  auto device = cmds.front()->get_device();
+
+  auto exec = get_exec_core(device);
+  std::vector<xcmd_ptr> xcmds;
+  xcmds.reserve(cmds.size());
+  for (auto& cmd : cmds) {
+    assert(cmd->get_device()==device);
+    xcmds.push_back(xocl_cmd::create(exec,cmd));
+  }
+  exec->get_scheduler()->submit(xcmds);
 }
 
 void
 start()
 {
+  std::lock_guard<std::mutex> lk(s_device_mutex);
   if (s_running)
     throw std::runtime_error("software command scheduler is already started");
 
-  s_scheduler_thread = std::move(xrt::thread(scheduler_loop));
+  for (auto& elem : s_device_scheduler)
+    elem.second->start();
   if (threaded_notification)
     notifier = std::move(xrt::thread(xrt::task::worker,std::ref(notify_queue)));
   s_running = true;
@@ -836,11 +1304,22 @@ start()
 void
 stop()
 {
-  if (!s_running)
-    return;
+  // Schedulers are stopped without holding the lock, command
+  // completion callbacks may schedule new commands
+  std::vector<device_scheduler*> schedulers;
+  {
+    std::lock_guard<std::mutex> lk(s_device_mutex);
+    if (!s_running)
+      return;
+    s_running = false;
+    for (auto& elem : s_device_scheduler)
+      schedulers.push_back(elem.second.get());
+  }
+
+  for (auto ds : schedulers)
+    ds->stop();
 
-  s_global_scheduler.stop();
-  s_scheduler_thread.join();
+  XRT_DEBUGF("sws polls(%lu) completions(%lu)\n",s_polls.load(),s_completions.load());
 
   if (threaded_notification) {
     // wait for notifier to drain
@@ -851,8 +1330,26 @@ stop()
     notify_queue.stop();
     notifier.join();
   }
+}
 
-  s_running = false;
+poll_counters
+get_poll_counters()
+{
+  return {s_polls.load(),s_completions.load()};
+}
+
+std::vector<cu_stats>
+get_cu_stats(const xrt::device* xdev)
+{
+  std::vector<cu_stats> stats;
+  std::lock_guard<std::mutex> lk(s_device_mutex);
+  auto itr = s_device_exec_core.find(xdev);
+  if (itr == s_device_exec_core.end())
+    return stats;
+
+  for (auto& cu : (*itr).second->get_cus())
+    stats.push_back({cu->get_started(),cu->get_busy_ns()});
+  return stats;
 }
 
 void
@@ -865,10 +1362,8 @@ init(xrt::device* xdev, const std::vector<uint64_t>& cu_addr_map)
   std::copy(cu_addr_map.begin(),cu_addr_map.end(),std::back_inserter(amap));
   auto slots = ERT_CQ_SIZE / xrt::config::get_ert_slotsize();
   cu_trace_enabled = xrt::config::get_profile();
-  s_device_exec_core.erase(xdev);
-  s_device_exec_core.insert
-    (std::make_pair
-     (xdev,std::make_unique<exec_core>(xdev,&s_global_scheduler,slots,amap)));
+  std::lock_guard<std::mutex> lk(s_device_mutex);
+  set_exec_core(xdev,std::make_unique<exec_core>(xdev,get_scheduler(xdev),slots,amap));
 }
 
 void
@@ -877,10 +1372,8 @@ init(xrt::device* xdev, const axlf* top)
   // create execution core for this device
   auto slots = ERT_CQ_SIZE / xrt::config::get_ert_slotsize();
   cu_trace_enabled = xrt::config::get_profile();
-  s_device_exec_core.erase(xdev);
-  s_device_exec_core.insert
-    (std::make_pair
-     (xdev,std::make_unique<exec_core>(xdev,&s_global_scheduler,slots,xrt_core::xclbin::get_cus(top))));
+  std::lock_guard<std::mutex> lk(s_device_mutex);
+  set_exec_core(xdev,std::make_unique<exec_core>(xdev,get_scheduler(xdev),slots,xrt_core::xclbin::get_cus(top)));
 }
 
 }} // sws,xrt
@@ -0,0 +1,202 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+////////////////////////////////////////////////////////////////
+// Software scheduler submission benchmark
+//
+// Measures commands/sec through xrt::sws with 1..32 submitting
+// threads, and per CU utilization when all sw_emu devices run
+// concurrently each on their own scheduler.  Run in sw_emu with an
+// xclbin containing at least one kernel that tolerates all zero
+// arguments:
+//
+//  % XCL_EMULATION_MODE=sw_emu XRT_TEST_XCLBIN=kernel.xclbin a.out
+////////////////////////////////////////////////////////////////
+#include <boost/test/unit_test.hpp>
+#include "../test_helpers.h"
+
+#include "xrt/device/device.h"
+#include "xrt/scheduler/command.h"
+#include "xrt/scheduler/scheduler.h"
+#include "core/common/xclbin_parser.h"
+
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace xrt::test;
+
+namespace {
+
+static std::vector<char>
+read_xclbin(const char* fnm)
+{
+  std::ifstream stream(fnm,std::ios::binary);
+  if (!stream)
+    throw std::runtime_error(std::string("could not open ") + fnm);
+  return std::vector<char>((std::istreambuf_iterator<char>(stream)),std::istreambuf_iterator<char>());
+}
+
+// Each thread submits @count commands, keeping at most @depth
+// outstanding before waiting for the oldest
+static void
+submit(xrt::device* device, size_t num_cus, size_t count, size_t depth)
+{
+  std::vector<std::shared_ptr<xrt::command>> cmds(depth);
+
+  for (size_t i=0; i<count; ++i) {
+    auto& cmd = cmds[i % depth];
+    if (cmd)
+      cmd->wait();
+
+    cmd = std::make_shared<xrt::command>(device,ERT_START_CU);
+    auto kcmd = cmd->get_ert_cmd<ert_start_kernel_cmd*>();
+    kcmd->cu_mask = (num_cus >= 32) ? 0xFFFFFFFF : ((1u << num_cus) - 1);
+    kcmd->extra_cu_masks = 0;
+    kcmd->count = 1 + 4; // cumask + ctrl + 3 reserved
+    cmd->execute();
+  }
+
+  for (auto& cmd : cmds)
+    if (cmd)
+      cmd->wait();
+}
+
+static void
+run(xrt::device* device, const axlf* top)
+{
+  auto num_cus = xrt_core::xclbin::get_cus(top).size();
+  if (!num_cus)
+    throw std::runtime_error("xclbin has no compute units");
+
+  const size_t count = 20000;
+  const size_t depth = 16;
+
+  for (size_t threads : {1,2,4,8,16,32}) {
+    std::vector<std::thread> workers;
+    auto per_thread = count / threads;
+
+    Timer timer;
+    for (size_t t=0; t<threads; ++t)
+      workers.emplace_back(submit,device,num_cus,per_thread,depth);
+    for (auto& t : workers)
+      t.join();
+    auto elapsed = timer.stop();
+
+    std::cout << "sws threads(" << threads << ") cus(" << num_cus << ") "
+              << (per_thread*threads)/elapsed << " commands/sec\n";
+  }
+
+  auto counters = xrt::sws::get_poll_counters();
+  std::cout << "sws polls(" << counters.polls << ") completions(" << counters.completions << ")\n";
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(test_sws_bw)
+
+BOOST_AUTO_TEST_CASE(sws_bw)
+{
+  auto xclbin = std::getenv("XRT_TEST_XCLBIN");
+  if (!xclbin) {
+    std::cout << "XRT_TEST_XCLBIN not set, skipping sws benchmark\n";
+    return;
+  }
+
+  auto data = read_xclbin(xclbin);
+  auto top = reinterpret_cast<const axlf*>(data.data());
+
+  auto pred = [](const xrt::hal::device& hal) {
+    return (hal.getDriverLibraryName().find("xrt_swemu")!=std::string::npos);
+  };
+  auto devices = xrt::test::loadDevices(pred);
+
+  for (auto& device : devices) {
+    device.open();
+    device.setup();
+    device.loadXclBin(top);
+    xrt::scheduler::init(&device,top);
+    xrt::scheduler::start();
+
+    try {
+      run(&device,top);
+    }
+    catch (const std::exception& ex) {
+      std::cout << ex.what() << "\n";
+      BOOST_CHECK_EQUAL(true,false);
+    }
+
+    xrt::scheduler::stop();
+    xrt::purge_command_freelist();
+    device.close();
+  }
+}
+
+BOOST_AUTO_TEST_CASE(sws_multi_device)
+{
+  auto xclbin = std::getenv("XRT_TEST_XCLBIN");
+  if (!xclbin) {
+    std::cout << "XRT_TEST_XCLBIN not set, skipping sws benchmark\n";
+    return;
+  }
+
+  auto data = read_xclbin(xclbin);
+  auto top = reinterpret_cast<const axlf*>(data.data());
+  auto num_cus = xrt_core::xclbin::get_cus(top).size();
+
+  auto pred = [](const xrt::hal::device& hal) {
+    return (hal.getDriverLibraryName().find("xrt_swemu")!=std::string::npos);
+  };
+  auto devices = xrt::test::loadDevices(pred);
+
+  for (auto& device : devices) {
+    device.open();
+    device.setup();
+    device.loadXclBin(top);
+    xrt::scheduler::init(&device,top);
+  }
+  xrt::scheduler::start();
+
+  // 4 submitting threads per device
+  const size_t count = 5000;
+  const size_t depth = 16;
+  std::vector<std::thread> workers;
+  Timer timer;
+  for (auto& device : devices)
+    for (int t=0; t<4; ++t)
+      workers.emplace_back(submit,&device,num_cus,count,depth);
+  for (auto& t : workers)
+    t.join();
+  auto elapsed = timer.stop();
+
+  std::cout << "sws devices(" << devices.size() << ") "
+            << (devices.size()*4*count)/elapsed << " commands/sec\n";
+
+  for (size_t didx=0; didx<devices.size(); ++didx) {
+    auto stats = xrt::sws::get_cu_stats(&devices[didx]);
+    for (size_t cuidx=0; cuidx<stats.size(); ++cuidx)
+      std::cout << "device(" << didx << ") cu(" << cuidx << ") started(" << stats[cuidx].started
+                << ") utilization(" << (100.0*stats[cuidx].busy_ns)/(elapsed*1e9) << "%)\n";
+  }
+
+  xrt::scheduler::stop();
+  xrt::purge_command_freelist();
+  for (auto& device : devices)
+    device.close();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
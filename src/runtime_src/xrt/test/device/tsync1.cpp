@@ -0,0 +1,75 @@
+/**
+ * Copyright (C) 2016-2017 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "../test_helpers.h"
+
+#include "xrt/device/hal.h"
+#include "xrt/device/hal2.h"
+#include "xrt/util/config_reader.h"
+#include <vector>
+#include <iostream>
+
+// Async syncs of one buffer object are queued before the DMA workers
+// are started, so that all of them are still pending when the next
+// one is added.  Overlapping and adjacent ranges must be merged into
+// one transfer, disjoint ranges and other directions must not.
+
+BOOST_AUTO_TEST_SUITE ( test_sync )
+
+BOOST_AUTO_TEST_CASE( test_sync1 )
+{
+  std::string ini(__FILE__);
+  ini += ".ini";
+  xrt::config::detail::debug(std::cout,ini);
+  BOOST_CHECK_EQUAL(xrt::config::get_dma_coalesce(),true);
+
+  using direction = xrt::hal::device::direction;
+  auto devices = xrt::hal::loadDevices();
+  for (auto& device : devices) {
+    device->open("device.log",xrt::hal::verbosity_level::quiet);
+
+    auto hal2 = dynamic_cast<xrt::hal2::device*>(device.get());
+    if (!hal2)
+      continue;
+
+    auto bo = hal2->alloc(16*1024);
+    auto before = hal2->get_sync_stats();
+
+    std::vector<xrt::event> events;
+    events.push_back(hal2->sync(bo,1024,0,direction::HOST2DEVICE,true));
+    events.push_back(hal2->sync(bo,1024,1024,direction::HOST2DEVICE,true));  // abuts
+    events.push_back(hal2->sync(bo,1024,512,direction::HOST2DEVICE,true));   // overlaps
+    events.push_back(hal2->sync(bo,1024,8192,direction::HOST2DEVICE,true));  // disjoint
+    events.push_back(hal2->sync(bo,1024,0,direction::DEVICE2HOST,true));     // other direction
+
+    // Start the DMA workers and drain the queued syncs
+    hal2->setup();
+    for (auto& e : events)
+      e.wait();
+
+    auto after = hal2->get_sync_stats();
+    BOOST_CHECK_EQUAL(after.requested-before.requested,5u);
+    BOOST_CHECK_EQUAL(after.issued-before.issued,3u);
+
+    // Workers are running, so a new sync cannot join a drained batch
+    hal2->sync(bo,1024,2048,direction::HOST2DEVICE,true).wait();
+    auto last = hal2->get_sync_stats();
+    BOOST_CHECK_EQUAL(last.issued-after.issued,1u);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
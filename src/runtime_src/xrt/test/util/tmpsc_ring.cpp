@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+////////////////////////////////////////////////////////////////
+// Unit testing of xrt/util/mpsc_ring.h
+////////////////////////////////////////////////////////////////
+#include <boost/test/unit_test.hpp>
+
+#include "xrt/util/mpsc_ring.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE ( test_mpsc_ring )
+
+BOOST_AUTO_TEST_CASE( test_mpsc_ring1 )
+{
+  // single thread fill and drain
+  xrt::mpsc_ring<std::shared_ptr<int>,4> ring;
+
+  for (int i=0; i<4; ++i) {
+    auto v = std::make_shared<int>(i);
+    BOOST_CHECK_EQUAL(ring.try_push(std::move(v)),true);
+    BOOST_CHECK(v==nullptr);
+  }
+
+  // full, value must be left untouched
+  auto v = std::make_shared<int>(4);
+  BOOST_CHECK_EQUAL(ring.try_push(std::move(v)),false);
+  BOOST_CHECK(v!=nullptr);
+
+  std::shared_ptr<int> p;
+  for (int i=0; i<4; ++i) {
+    BOOST_CHECK_EQUAL(ring.try_pop(p),true);
+    BOOST_CHECK_EQUAL(*p,i);
+  }
+  BOOST_CHECK_EQUAL(ring.try_pop(p),false);
+
+  // wrap around
+  BOOST_CHECK_EQUAL(ring.try_push(std::move(v)),true);
+  auto count = ring.pop_batch([](std::shared_ptr<int>&& p) { BOOST_CHECK_EQUAL(*p,4); });
+  BOOST_CHECK_EQUAL(count,1);
+}
+
+BOOST_AUTO_TEST_CASE( test_mpsc_ring2 )
+{
+  // many producers, one consumer, every value seen exactly once
+  const int producers = 8;
+  const int per_producer = 100000;
+  xrt::mpsc_ring<int,256> ring;
+
+  std::vector<std::thread> workers;
+  for (int t=0; t<producers; ++t) {
+    workers.emplace_back([&ring,t,per_producer]() {
+        for (int i=0; i<per_producer; ++i) {
+          int value = t*per_producer + i;
+          while (!ring.try_push(std::move(value)))
+            std::this_thread::yield();
+        }
+      });
+  }
+
+  std::vector<char> seen(producers*per_producer,0);
+  std::vector<int> last(producers,-1);
+  int total = 0;
+  while (total < producers*per_producer) {
+    total += ring.pop_batch([&](int&& value) {
+        ++seen[value];
+        // values from one producer arrive in order
+        auto t = value / per_producer;
+        BOOST_CHECK(last[t] < value);
+        last[t] = value;
+      });
+  }
+
+  for (auto& t : workers)
+    t.join();
+
+  for (auto s : seen)
+    BOOST_CHECK_EQUAL(s,1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
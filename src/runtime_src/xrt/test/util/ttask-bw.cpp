@@ -0,0 +1,114 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+////////////////////////////////////////////////////////////////
+// Task queue benchmark
+//
+// Compares tasks/sec and task start latency (p50/p99) of the mutex
+// based mpmcqueue against the work stealing wsqueue, with several
+// producers submitting small tasks to a pool of workers.
+////////////////////////////////////////////////////////////////
+#include <boost/test/unit_test.hpp>
+
+#include "xrt/util/task.h"
+#include "xrt/util/time.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <typename Queue>
+static void
+worker(Queue& q)
+{
+  while (true) {
+    auto t = q.getWork();
+    if (!t.valid())
+      break;
+    t();
+  }
+}
+
+template <typename Queue>
+static void
+run(const char* name, size_t producers, size_t workers, size_t per_producer)
+{
+  Queue queue;
+  std::vector<std::thread> pool;
+  for (size_t w=0; w<workers; ++w)
+    pool.emplace_back(worker<Queue>,std::ref(queue));
+
+  // latency from submission to start of execution, per producer
+  std::vector<std::vector<unsigned long>> latency(producers);
+  std::atomic<size_t> done {0};
+
+  auto start = xrt::time_ns();
+  std::vector<std::thread> submitters;
+  for (size_t p=0; p<producers; ++p) {
+    latency[p].resize(per_producer);
+    submitters.emplace_back([&,p]() {
+        auto lat = latency[p].data();
+        for (size_t i=0; i<per_producer; ++i) {
+          auto submitted = xrt::time_ns();
+          queue.addWork(xrt::task::task([lat,i,submitted,&done]() {
+                lat[i] = xrt::time_ns() - submitted;
+                ++done;
+              }));
+        }
+      });
+  }
+
+  for (auto& t : submitters)
+    t.join();
+  while (done < producers*per_producer)
+    std::this_thread::yield();
+  auto elapsed = xrt::time_ns() - start;
+
+  queue.stop();
+  for (auto& t : pool)
+    t.join();
+
+  std::vector<unsigned long> all;
+  for (auto& lat : latency)
+    all.insert(all.end(),lat.begin(),lat.end());
+  std::sort(all.begin(),all.end());
+
+  std::cout << name << " producers(" << producers << ") workers(" << workers << ") "
+            << (all.size()*1e9)/elapsed << " tasks/sec"
+            << " p50(" << all[all.size()/2]/1000.0 << "us)"
+            << " p99(" << all[(all.size()*99)/100]/1000.0 << "us)\n";
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(test_task_bw)
+
+BOOST_AUTO_TEST_CASE(task_bw)
+{
+  const size_t per_producer = 100000;
+  for (size_t producers : {1,4}) {
+    for (size_t workers : {1,2,4,8}) {
+      run<xrt::task::mpmcqueue<xrt::task::task>>("mpmcqueue",producers,workers,per_producer);
+      run<xrt::task::wsqueue<xrt::task::task>>("wsqueue",producers,workers,per_producer);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
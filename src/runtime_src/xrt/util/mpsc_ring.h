@@ -0,0 +1,164 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef xrt_util_mpsc_ring_h_
+#define xrt_util_mpsc_ring_h_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace xrt {
+
+/**
+ * Bounded lock-free multi-producer single-consumer ring.
+ *
+ * Any number of threads can push to the ring concurrently, exactly
+ * one thread may pop from it.  Each slot carries a sequence number
+ * that tells producers and the consumer whether the slot is free or
+ * holds a published value, so neither side ever takes a lock.
+ *
+ * The producer tail and the consumer head are kept on separate cache
+ * lines to avoid false sharing between submitters and the consumer.
+ *
+ * @T: value type, must be default constructible and move assignable
+ * @Capacity: number of slots, must be a power of 2
+ */
+template <typename T, size_t Capacity>
+class mpsc_ring
+{
+  static_assert(Capacity && !(Capacity & (Capacity-1)),"mpsc_ring capacity must be power of 2");
+
+  static constexpr size_t cacheline = 64;
+  static constexpr size_t mask = Capacity - 1;
+
+  struct slot
+  {
+    std::atomic<size_t> seq;
+    T value;
+  };
+
+  // Written by producers
+  std::atomic<size_t> m_tail {0};
+  char m_pad0[cacheline - sizeof(std::atomic<size_t>)];
+
+  // Written by consumer only
+  size_t m_head = 0;
+  char m_pad1[cacheline - sizeof(size_t)];
+
+  std::array<slot,Capacity> m_slots;
+
+public:
+  mpsc_ring()
+  {
+    for (size_t idx=0; idx<Capacity; ++idx)
+      m_slots[idx].seq.store(idx,std::memory_order_relaxed);
+  }
+
+  mpsc_ring(const mpsc_ring&) = delete;
+  mpsc_ring& operator=(const mpsc_ring&) = delete;
+
+  /**
+   * Push a value onto the ring.  Safe to call from any thread.
+   *
+   * @value: value to move into the ring, left untouched on failure
+   * Return: true on success, false if the ring is full
+   */
+  bool
+  try_push(T&& value)
+  {
+    auto pos = m_tail.load(std::memory_order_relaxed);
+    while (true) {
+      auto& s = m_slots[pos & mask];
+      auto seq = s.seq.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff==0) {
+        if (m_tail.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed)) {
+          s.value = std::move(value);
+          s.seq.store(pos+1,std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff<0) {
+        return false;
+      }
+      else {
+        pos = m_tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Pop a value off the ring.  Must be called from the consumer only.
+   *
+   * @value: receives the popped value
+   * Return: true on success, false if the ring is empty or the
+   *  next value has not yet been published by its producer
+   */
+  bool
+  try_pop(T& value)
+  {
+    auto& s = m_slots[m_head & mask];
+    auto seq = s.seq.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(m_head+1) < 0)
+      return false;
+
+    value = std::move(s.value);
+    s.value = T();
+    s.seq.store(m_head+Capacity,std::memory_order_release);
+    ++m_head;
+    return true;
+  }
+
+  /**
+   * Pop up to @max values off the ring.  Consumer only.
+   *
+   * @fn: callable invoked with each popped value (T&&)
+   * Return: number of values popped
+   */
+  template <typename Callable>
+  size_t
+  pop_batch(Callable&& fn, size_t max=Capacity)
+  {
+    size_t count = 0;
+    T value;
+    while (count<max && try_pop(value)) {
+      fn(std::move(value));
+      ++count;
+    }
+    return count;
+  }
+
+  /**
+   * Approximate number of values in the ring.  Consumer only.
+   */
+  size_t
+  size() const
+  {
+    return m_tail.load(std::memory_order_relaxed) - m_head;
+  }
+
+  static constexpr size_t
+  capacity()
+  {
+    return Capacity;
+  }
+};
+
+} // xrt
+
+#endif
@@ -191,6 +191,18 @@ public:
       push_back(rhs[i]);
   }
 
+  /**
+   * Append @count words from @words with a single copy
+   */
+  void
+  append(const word_type* words, size_type count)
+  {
+    if (m_size+count>MaxSize)
+      throw std::runtime_error(std::to_string(m_size+count) + ">" + std::to_string(MaxSize));
+    std::memcpy(m_regmap+m_size,words,count*sizeof(WordType));
+    m_size+=count;
+  }
+
   void
   resize(size_type size)
   {
@@ -212,6 +224,17 @@ public:
     std::memset(m_regmap,0,MaxSize*sizeof(WordType));
   }
 
+  /**
+   * Clear only the first @words words, caller guarantees
+   * that remaining words are already zero
+   */
+  void
+  clear(size_type words)
+  {
+    m_size = 0;
+    std::memset(m_regmap,0,std::min(words,MaxSize)*sizeof(WordType));
+  }
+
   std::size_t
   bytes() const
   {
@@ -21,6 +21,10 @@
 #include "xrt/util/debug.h"
 #include "xrt/config.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
 #include <future>
 #include <functional>
 #include <chrono>
@@ -28,6 +32,8 @@
 #include <mutex>
 #include <condition_variable>
 #include <iostream>
+#include <thread>
+#include <type_traits>
 
 namespace xrt { namespace task {
 
@@ -46,6 +52,7 @@ class task
   {
     virtual ~task_iholder() {};
     virtual void execute() = 0;
+    virtual task_iholder* move_to(void* buffer) = 0;
   };
 
   template <typename Callable>
@@ -54,28 +61,101 @@ class task
     Callable held;
     task_holder(Callable&& t) : held(std::move(t)) {}
     void execute() { held(); }
+    task_iholder* move_to(void* buffer) { return new (buffer) task_holder(std::move(held)); }
   };
 
-  std::unique_ptr<task_iholder> content;
+  // Small buffer for the holder.  A std::packaged_task is a single
+  // pointer to its shared state, so every task created through
+  // createF/createM is stored inline without a heap allocation.
+  // Larger callables or callables that can throw on move fall back
+  // to the heap.
+  static constexpr size_t buffer_size = 4 * sizeof(void*);
+  using buffer_type = typename std::aligned_storage<buffer_size>::type;
+
+  template <typename Callable>
+  struct fits_inline
+    : std::integral_constant<bool,
+                             sizeof(task_holder<Callable>) <= buffer_size
+                             && alignof(task_holder<Callable>) <= alignof(buffer_type)
+                             && std::is_nothrow_move_constructible<Callable>::value>
+  {};
+
+  buffer_type m_buffer;
+  task_iholder* content = nullptr;
+
+  bool
+  is_inline() const
+  {
+    return content == reinterpret_cast<const task_iholder*>(&m_buffer);
+  }
+
+  void
+  reset()
+  {
+    if (is_inline())
+      content->~task_iholder();
+    else
+      delete content;
+    content = nullptr;
+  }
+
+  void
+  take(task&& rhs)
+  {
+    if (rhs.is_inline()) {
+      content = rhs.content->move_to(&m_buffer);
+      rhs.reset();
+    }
+    else {
+      content = rhs.content;
+      rhs.content = nullptr;
+    }
+  }
+
+  template <typename Callable>
+  void
+  emplace(Callable&& c, std::true_type)
+  {
+    content = new (&m_buffer) task_holder<Callable>(std::move(c));
+  }
+
+  template <typename Callable>
+  void
+  emplace(Callable&& c, std::false_type)
+  {
+    content = new task_holder<Callable>(std::move(c));
+  }
 
 public:
   task()
-    : content(nullptr)
   {}
 
   task(task&& rhs)
-    : content(std::move(rhs.content))
-  {}
+  {
+    take(std::move(rhs));
+  }
 
-  template <typename Callable>
+  template <typename Callable,
+            typename Held = typename std::decay<Callable>::type,
+            typename = typename std::enable_if<!std::is_same<Held,task>::value>::type>
   task(Callable&& c)
-    : content(new task_holder<Callable>(std::forward<Callable>(c)))
-  {}
+  {
+    Held held(std::forward<Callable>(c));
+    emplace(std::move(held),fits_inline<Held>());
+  }
+
+  ~task()
+  {
+    reset();
+  }
 
   task&
   operator=(task&& rhs)
   {
-    content = std::move(rhs.content);
+    if (this != &rhs) {
+      reset();
+      take(std::move(rhs));
+    }
     return *this;
   }
 
@@ -228,7 +308,200 @@ public:
   }
 };
 
-using queue = mpmcqueue<task>;
+/**
+ * Work stealing queue of task objects
+ *
+ * Drop-in replacement for mpmcqueue with the same addWork / getWork /
+ * size / stop interface, but without a single lock that every
+ * producer and consumer contend on.
+ *
+ * Each thread that calls getWork() is registered as a worker and
+ * gets its own deque.  Producers that are themselves workers of the
+ * queue push to their own deque, other producers spread work round
+ * robin over the worker deques.  A worker takes tasks from its own
+ * deque first and steals from the other workers when it runs dry.
+ * Each deque is guarded by its own small lock, so contention is
+ * limited to a producer and at most one consumer at the time.
+ *
+ * Tasks are taken oldest first from both ends, which keeps the
+ * ordering of a single producer intact for a single worker queue
+ * and bounds the latency of work sitting in a busy worker's deque.
+ *
+ * Idle workers sleep on a condition variable, producers only take
+ * the sleep lock when some worker is actually sleeping.
+ */
+template <typename Task>
+class wsqueue
+{
+  static constexpr size_t max_workers = 64;
+  static constexpr size_t cacheline = 64;
+  static constexpr unsigned int spin_count = 64;
+
+  struct worker_deque
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    char pad[cacheline];
+  };
+
+  // Thread local registration of the calling thread as a worker of
+  // the queue with unique id @queue_id
+  struct registration
+  {
+    unsigned long queue_id = 0;
+    size_t idx = 0;
+  };
+
+  static std::atomic<unsigned long> s_queue_id;
+  static thread_local registration t_worker;
+
+  const unsigned long m_id = ++s_queue_id;
+  std::array<worker_deque,max_workers> m_deques;
+  std::atomic<size_t> m_workers {0};
+  std::atomic<size_t> m_next {0};
+
+  // Number of queued tasks, transiently negative when a consumer
+  // pops a task before its producer accounted for it
+  std::atomic<long> m_size {0};
+
+  std::mutex m_mutex;
+  std::condition_variable m_work;
+  std::atomic<unsigned int> m_sleeping {0};
+  std::atomic<bool> m_stop {false};
+
+  // Deque index of calling thread if it is a worker of this queue,
+  // or max_workers if not
+  size_t
+  worker_index() const
+  {
+    return (t_worker.queue_id == m_id) ? t_worker.idx : max_workers;
+  }
+
+  size_t
+  register_worker()
+  {
+    auto idx = worker_index();
+    if (idx != max_workers)
+      return idx;
+    // Threads beyond max_workers share deques, which is still correct
+    idx = m_workers.fetch_add(1) % max_workers;
+    t_worker.queue_id = m_id;
+    t_worker.idx = idx;
+    return idx;
+  }
+
+  size_t
+  num_deques() const
+  {
+    auto workers = m_workers.load(std::memory_order_acquire);
+    return workers ? std::min(workers,max_workers) : 1;
+  }
+
+  bool
+  try_pop(size_t idx, Task& task)
+  {
+    auto& dq = m_deques[idx];
+    std::lock_guard<std::mutex> lk(dq.mutex);
+    if (dq.tasks.empty())
+      return false;
+    task = std::move(dq.tasks.front());
+    dq.tasks.pop_front();
+    return true;
+  }
+
+  // Own deque first, then steal from the others
+  bool
+  try_get(size_t idx, Task& task)
+  {
+    if (try_pop(idx,task))
+      return true;
+    auto deques = num_deques();
+    for (size_t i=1; i<deques; ++i)
+      if (try_pop((idx + i) % deques,task))
+        return true;
+    return false;
+  }
+
+public:
+  wsqueue()
+  {}
+
+  wsqueue(const wsqueue&) = delete;
+  wsqueue& operator=(const wsqueue&) = delete;
+
+  void
+  addWork(Task&& t)
+  {
+    auto idx = worker_index();
+    if (idx == max_workers)
+      idx = m_next.fetch_add(1,std::memory_order_relaxed) % num_deques();
+
+    {
+      auto& dq = m_deques[idx];
+      std::lock_guard<std::mutex> lk(dq.mutex);
+      dq.tasks.push_back(std::move(t));
+    }
+
+    // Pairs with the sleeping worker's increment of m_sleeping
+    // followed by its check of m_size; one of the two sides is
+    // guaranteed to see the other.
+    m_size.fetch_add(1);
+    if (m_sleeping.load()) {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_work.notify_one();
+    }
+  }
+
+  Task
+  getWork()
+  {
+    auto idx = register_worker();
+    Task task;
+    unsigned int spins = 0;
+    while (!m_stop.load(std::memory_order_relaxed)) {
+      if (try_get(idx,task)) {
+        m_size.fetch_sub(1);
+        return task;
+      }
+
+      if (++spins < spin_count) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lk(m_mutex);
+      ++m_sleeping;
+      while (!m_stop && m_size.load() <= 0)
+        m_work.wait(lk);
+      --m_sleeping;
+      spins = 0;
+    }
+    return task;
+  }
+
+  size_t
+  size() const
+  {
+    auto sz = m_size.load();
+    return sz > 0 ? sz : 0;
+  }
+
+  void
+  stop()
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stop=true;
+    m_work.notify_all();
+  }
+};
+
+template <typename Task>
+std::atomic<unsigned long> wsqueue<Task>::s_queue_id {0};
+
+template <typename Task>
+thread_local typename wsqueue<Task>::registration wsqueue<Task>::t_worker;
+
+using queue = wsqueue<task>;
 
 /**
  * event class wraps std::future<RT>
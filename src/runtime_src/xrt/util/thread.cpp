@@ -21,6 +21,7 @@
 
 #include <thread>
 #include <iostream>
+#include <vector>
 
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/tokenizer.hpp>
@@ -55,22 +56,23 @@ debug_thread_policy(const std::string& str, int policy, int priority)
   }
 }
 
-static void
-set_thread_policy(std::thread& thread)
+// Scheduling policy and priority for runtime threads per sdaccel.ini.
+// Function local statics are initialized once even when threads are
+// created concurrently, e.g. per device schedulers.
+struct thread_policy
 {
-  static int policy = 0;
-  static int priority = 0;
-  static bool initialized = false;
-  if (!initialized) {
-    initialized=true;
+  int policy = 0;
+  int priority = 0;
 
+  thread_policy()
+  {
     sched_param sch;
     pthread_getschedparam(pthread_self(),&policy,&sch);
     priority = sch.sched_priority;
 
     debug_thread_policy("default",policy,priority);
 
-    static std::string config_policy = xrt::config::detail::get_string_value("Runtime.thread_policy","default");
+    std::string config_policy = xrt::config::detail::get_string_value("Runtime.thread_policy","default");
     if (config_policy=="rr") {
       policy = SCHED_RR;
       priority = 1;
@@ -86,47 +88,85 @@ set_thread_policy(std::thread& thread)
 
     debug_thread_policy("config",policy,priority);
   }
+};
+
+static void
+set_thread_policy(std::thread& thread)
+{
+  static const thread_policy tp;
 
   struct sched_param sch;
-  sch.sched_priority = priority;
-  pthread_setschedparam(thread.native_handle(), policy, &sch);
+  sch.sched_priority = tp.priority;
+  pthread_setschedparam(thread.native_handle(), tp.policy, &sch);
 }
 
-static void
-set_cpu_affinity(std::thread& thread)
+static std::vector<unsigned long>
+init_affinity_cpus()
 {
-  static bool initialized = false;
-  static cpu_set_t cpuset;
-  static bool all=false;
-  if (!initialized) {
-    initialized = true;
-
-    std::string cpus = xrt::config::detail::get_string_value("Runtime.cpu_affinity","default");
-    if (cpus=="default")
-      all=true;
+  std::vector<unsigned long> cpulist;
+  std::string cpus = xrt::config::detail::get_string_value("Runtime.cpu_affinity","default");
+  if (cpus=="default")
+    return cpulist;
+
+  boost::trim_if(cpus,boost::is_any_of("{}"));
+  using tokenizer=boost::tokenizer<boost::char_separator<char> >;
+  boost::char_separator<char> sep(", ");
+  auto max_cpus = std::thread::hardware_concurrency();
+  for (auto& tok : tokenizer(cpus,sep)) {
+    auto cpu = std::stoul(tok);
+    if (cpu < max_cpus) {
+      XRT_DEBUG(std::cout,"adding cpu #",cpu," to affinity mask\n");
+      cpulist.push_back(cpu);
+    }
     else {
-      boost::trim_if(cpus,boost::is_any_of("{}"));
-      using tokenizer=boost::tokenizer<boost::char_separator<char> >;
-      boost::char_separator<char> sep(", ");
-      auto max_cpus = std::thread::hardware_concurrency();
-      CPU_ZERO(&cpuset);
-      for (auto& tok : tokenizer(cpus,sep)) {
-        auto cpu = std::stoul(tok);
-        if (cpu < max_cpus) {
-          XRT_DEBUG(std::cout,"adding cpu #",cpu," to affinity mask\n");
-          CPU_SET(cpu,&cpuset);
-        }
-        else {
-          xrt::message::send(xrt::message::severity_level::XRT_WARNING,"Ignoring cpu affinity since cpu #" + tok + " is out of range\n");
-          all=true;
-        }
-      }
+      xrt::message::send(xrt::message::severity_level::XRT_WARNING,"Ignoring cpu affinity since cpu #" + tok + " is out of range\n");
+      cpulist.clear();
+      break;
     }
   }
+  return cpulist;
+}
 
-  if (all)
+// Cpus specified in sdaccel.ini, empty if all cpus are allowed
+static const std::vector<unsigned long>&
+get_affinity_cpus()
+{
+  static const std::vector<unsigned long> cpulist = init_affinity_cpus();
+  return cpulist;
+}
+
+static cpu_set_t
+init_affinity_cpuset()
+{
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (auto cpu : get_affinity_cpus())
+    CPU_SET(cpu,&cpuset);
+  return cpuset;
+}
+
+static void
+set_cpu_affinity(std::thread& thread)
+{
+  if (get_affinity_cpus().empty())
     return;
 
+  static const cpu_set_t cpuset = init_affinity_cpuset();
+  if (pthread_setaffinity_np(thread.native_handle(),sizeof(cpu_set_t),&cpuset)) {
+    throw std::runtime_error("error calling pthread_setaffinity_np");
+  }
+}
+
+static void
+set_cpu_affinity(std::thread& thread, unsigned int idx)
+{
+  auto& cpus = get_affinity_cpus();
+  if (cpus.empty())
+    return;
+
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpus[idx % cpus.size()],&cpuset);
   if (pthread_setaffinity_np(thread.native_handle(),sizeof(cpu_set_t),&cpuset)) {
     throw std::runtime_error("error calling pthread_setaffinity_np");
   }
@@ -144,6 +184,11 @@ set_cpu_affinity(std::thread& thread)
 {
 }
 
+static void
+set_cpu_affinity(std::thread& thread, unsigned int idx)
+{
+}
+
 #endif
 
 } // platform_specific
@@ -164,6 +209,11 @@ void set_cpu_affinity(std::thread& thread)
   ::platform_specific::set_cpu_affinity(thread);
 }
 
+void set_cpu_affinity(std::thread& thread, unsigned int idx)
+{
+  ::platform_specific::set_cpu_affinity(thread,idx);
+}
+
 } // detail
 
 } // xrt
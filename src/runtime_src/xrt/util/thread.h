@@ -38,6 +38,14 @@ set_thread_policy(std::thread& thread);
 void
 set_cpu_affinity(std::thread& thread);
 
+/**
+ * Pin a thread to a single cpu selected by @idx (modulo number of
+ * cpus) from the cpus specified in sdaccel.ini.  No-op if no cpus
+ * are specified.
+ */
+void
+set_cpu_affinity(std::thread& thread, unsigned int idx);
+
 }
 
 /**
@@ -49,7 +49,7 @@ struct command::impl : xrt::command
 
 command::
 command(xrt_device* device, ert_cmd_opcode opcode)
-  : m_impl(std::make_shared<impl>(static_cast<xrt::device*>(device),opcode))
+  : m_impl(xrt::make_command<impl>(static_cast<xrt::device*>(device),opcode))
 {}
 
 void
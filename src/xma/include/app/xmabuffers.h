@@ -210,6 +210,74 @@ xma_data_from_buffer_clone(uint8_t *data, size_t size);
 void
 xma_data_buffer_free(XmaDataBuffer *data);
 
+/**
+ * @XMA_FRAME_POOL_HUGEPAGE - Back the host planes of pooled frames with huge
+ * pages.  Falls back to transparent huge pages or regular pages when huge
+ * pages are not available.
+*/
+#define XMA_FRAME_POOL_HUGEPAGE (1 << 0)
+
+/**
+ * struct XmaFramePool - Opaque pool of frames sharing the same XmaFrameProperties
+*/
+typedef struct XmaFramePool XmaFramePool;
+
+/**
+ * xma_frame_pool_create() - Create a pool recycling host frames of given properties
+ *
+ * Frames handed out by a pool keep their plane buffers when returned with
+ * xma_frame_pool_put() so that steady state processing does not allocate.
+ * Plane sizes are computed from format, width, height and bits_per_pixel.
+ * Plugins can create pools of frames backed by device buffers with
+ * xma_plg_frame_pool_create().
+ *
+ * @frame_props: Properties of every frame in the pool
+ * @flags: 0 or XMA_FRAME_POOL_HUGEPAGE
+ *
+ * RETURN: XmaFramePool pointer, NULL on failure
+*/
+XmaFramePool*
+xma_frame_pool_create(XmaFrameProperties *frame_props, int32_t flags);
+
+/**
+ * xma_frame_pool_get() - Get a frame from the pool, allocating one if the pool is empty
+ *
+ * The frame has the properties of the pool, one reference on each plane
+ * and all other fields cleared.  It is thread safe to get and put frames
+ * of the same pool concurrently.
+ *
+ * @pool: Pool to get frame from
+ *
+ * RETURN: XmaFrame pointer, NULL on failure
+*/
+XmaFrame*
+xma_frame_pool_get(XmaFramePool *pool);
+
+/**
+ * xma_frame_pool_put() - Return a frame to its pool
+ *
+ * Drops one reference from each plane like xma_frame_free() and recycles
+ * the frame once no references remain.  The frame must have been obtained
+ * from the same pool with xma_frame_pool_get() and must not be passed to
+ * xma_frame_free().
+ *
+ * @pool: Pool the frame was obtained from
+ * @frame: Frame to return
+*/
+void
+xma_frame_pool_put(XmaFramePool *pool, XmaFrame *frame);
+
+/**
+ * xma_frame_pool_destroy() - Destroy pool and free its frames
+ *
+ * Frames still in use are freed when they are returned with
+ * xma_frame_pool_put().
+ *
+ * @pool: Pool to destroy
+*/
+void
+xma_frame_pool_destroy(XmaFramePool *pool);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2019, Xilinx Inc - All rights reserved
+ * Xilinx SDAccel Media Accelerator API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _XMAAPP_RESOURCE_H_
+#define _XMAAPP_RESOURCE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * DOC:
+ *  XMA tracks the load of every compute unit (CU) of every device and
+ *  can place sessions automatically.  A session requests automatic
+ *  placement by setting dev_index and/or cu_index of its properties
+ *  to XMA_ANY_INDEX.
+ *
+ *  When cu_index is XMA_ANY_INDEX, the session properties must carry an
+ *  XmaParameter named XMA_KERNEL_NAME_PARAM of type XMA_STRING holding
+ *  the kernel name, e.g. "encoder" or the instance name "encoder:encoder_1".
+ *  XMA picks the compatible CU with the least declared load, restricted
+ *  to dev_index if that is not XMA_ANY_INDEX.  The load of a session is
+ *  its pixel rate (width x height x framerate) for video sessions and
+ *  zero for kernel sessions, in which case the number of sessions on
+ *  the CU decides.  The chosen indices are written back to dev_index
+ *  and cu_index of the session properties.
+ *
+ *  ::
+ *
+ *       XmaParameter param;
+ *       param.name = XMA_KERNEL_NAME_PARAM;
+ *       param.type = XMA_STRING;
+ *       param.value = "encoder";
+ *       param.length = strlen("encoder");
+ *       enc_props.params = &param;
+ *       enc_props.param_cnt = 1;
+ *       enc_props.dev_index = XMA_ANY_INDEX;
+ *       enc_props.cu_index = XMA_ANY_INDEX;
+ *       session = xma_enc_session_create(&enc_props);
+ */
+
+/**
+ * @XMA_ANY_INDEX - Let XMA choose the device or compute unit
+*/
+#define XMA_ANY_INDEX         (-1)
+
+/**
+ * @XMA_KERNEL_NAME_PARAM - Name of XmaParameter selecting the kernel
+ * when XMA chooses the compute unit
+*/
+#define XMA_KERNEL_NAME_PARAM "kernel_name"
+
+/**
+ * struct XmaCUUtilization - Current load of one compute unit
+*/
+typedef struct XmaCUUtilization
+{
+    int32_t     dev_index; /**< index of device */
+    int32_t     cu_index; /**< index of compute unit on device */
+    const char  *kernel_name; /**< name of compute unit */
+    int32_t     num_sessions; /**< number of sessions placed on compute unit */
+    uint64_t    load; /**< sum of declared pixel rate of sessions */
+    int32_t     reserved[4];
+} XmaCUUtilization;
+
+/**
+ * xma_res_cu_utilization() - Query the current load of all compute units
+ *
+ * @util: Array receiving one entry per compute unit, may be NULL
+ * @num_entries: Number of entries in util
+ *
+ * Entries are ordered by device and compute unit index.
+ *
+ * RETURN: Total number of compute units, which may exceed num_entries
+*/
+int32_t
+xma_res_cu_utilization(XmaCUUtilization *util, int32_t num_entries);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
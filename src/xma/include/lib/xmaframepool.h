@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2019, Xilinx Inc - All rights reserved
+ * Xilinx SDAccel Media Accelerator API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _XMA_FRAME_POOL_LIB_H_
+#define _XMA_FRAME_POOL_LIB_H_
+
+#include "app/xmabuffers.h"
+
+/**
+ *  @brief Plane allocator of a frame pool
+ *
+ *  alloc returns the host address of a new plane of size bytes and may
+ *  store allocator private data in priv.  free releases a plane given
+ *  the values returned by alloc.  release is called once when the pool
+ *  is gone, with arg.
+ */
+typedef struct XmaFramePoolAllocator
+{
+    void*         (*alloc)(void *arg, size_t size, void **priv);
+    void          (*free)(void *arg, void *buffer, size_t size, void *priv);
+    void          (*release)(void *arg);
+    void          *arg;
+    XmaBufferType buffer_type;
+} XmaFramePoolAllocator;
+
+/**
+ *  @brief Create a frame pool with a custom plane allocator
+ *
+ *  @return Pool, NULL on failure in which case allocator->release
+ *          has not been called
+ */
+XmaFramePool *xma_frame_pool_create_with(XmaFrameProperties          *frame_props,
+                                         const XmaFramePoolAllocator *allocator);
+
+/**
+ *  @brief Allocator private data of a plane of a pooled frame
+ *
+ *  @return priv as returned by the allocator, NULL if plane is out
+ *          of range or frame was not obtained from xma_frame_pool_get()
+ */
+void *xma_frame_pool_plane_priv(XmaFrame *frame, int32_t plane);
+
+#endif
@@ -25,10 +25,14 @@
 #include "app/xmahw.h"
 #include "plg/xmasess.h"
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <vector>
 
 #define MAX_EXECBO_POOL_SIZE      16
 #define MAX_EXECBO_BUFF_SIZE      4096// 4KB
+#define MAX_COMPLETED_PER_SESSION 64//Finished work items per session whose id and status are kept
 #define MAX_KERNEL_REGMAP_SIZE    4032//Some space used by ert pkt
 #define MAX_REGMAP_ENTRIES        1024//Int32 entries; So 4B x 1024 = 4K Bytes
 
@@ -45,6 +49,27 @@
  * @{
  */
 
+typedef struct XmaHwKernelCompletion
+{
+    int32_t        work_item_id;
+    int32_t        session_id;    //-1 once the session is destroyed
+    XmaSessionType session_type;
+    int32_t        status;        //XMA_SUCCESS, or XMA_ERROR if failed or aborted
+} XmaHwKernelCompletion;
+
+typedef struct XmaHwSessionCompletions
+{
+    int32_t        session_id;
+    XmaSessionType session_type;
+    //Finished work items not yet waited for, counted without limit
+    uint64_t       count;
+    //Id and status of the most recent of them, at most
+    //MAX_COMPLETED_PER_SESSION.  Older ones keep only their count and
+    //the number of them that failed
+    std::deque<XmaHwKernelCompletion> items;
+    uint64_t       failed_without_item;
+} XmaHwSessionCompletions;
+
 typedef struct XmaHwKernel
 {
     uint8_t     name[MAX_KERNEL_NAME];
@@ -53,28 +78,60 @@ typedef struct XmaHwKernel
     uint64_t    base_address;
     uint32_t    ddr_bank;
     //For execbo:
-    int32_t     kernel_complete_count;
-    std::atomic<bool> kernel_complete_locked;
     uint32_t    kernel_execbo_handle[MAX_EXECBO_POOL_SIZE];
     char*       kernel_execbo_data[MAX_EXECBO_POOL_SIZE];//execBO size is 4096 in xmahw_hal.cpp
     bool        kernel_execbo_inuse[MAX_EXECBO_POOL_SIZE];
 
+    //execBO bookkeeping, all guarded by execbo_mutex:
+    //Free execBO indices as a stack, top at execbo_free_count - 1
+    int32_t     execbo_free[MAX_EXECBO_POOL_SIZE];
+    int32_t     execbo_free_count;
+    //Submitted execBO indices in submission order, and the work item
+    //and session each one belongs to
+    int32_t     execbo_submitted[MAX_EXECBO_POOL_SIZE];
+    int32_t     execbo_submitted_count;
+    XmaHwKernelCompletion execbo_work_item[MAX_EXECBO_POOL_SIZE];
+    int32_t     next_work_item_id;
+    //Finished work items not yet picked up, per session.  An entry is
+    //removed when its session is destroyed
+    std::vector<XmaHwSessionCompletions> completed;
+    //One thread at a time blocks in xclExecWait, the others wait on
+    //execbo_done until it has harvested new completions
+    bool        exec_waiting;
+    std::mutex  execbo_mutex;
+    std::condition_variable execbo_done;
+
     uint32_t    reg_map[MAX_REGMAP_ENTRIES];//4KB = 4B x 1024; Supported Max regmap of 4032 Bytes only in xmaplugin.cpp; execBO size is 4096 = 4KB in xmahw_hal.cpp
     //pthread_mutex_t *lock;
+    //reg_map_locked is only set and cleared with reg_map_mutex held
+    std::mutex  reg_map_mutex;
     std::atomic<bool> reg_map_locked;
     int32_t         locked_by_session_id;
     XmaSessionType locked_by_session_type;
 
+    //Resource manager bookkeeping, guarded by xmaresource.cpp mutex:
+    //Sessions placed on this CU and the sum of their declared load
+    int32_t     num_sessions;
+    uint64_t    load;
+
     //bool             have_lock;
     uint32_t    reserved[16];
 
   XmaHwKernel() {
     in_use = false;
     instance = -1;
-    kernel_complete_count = 0;
-    kernel_complete_locked = false;
+    for (int32_t i = 0; i < MAX_EXECBO_POOL_SIZE; i++) {
+      kernel_execbo_inuse[i] = false;
+      execbo_free[i] = MAX_EXECBO_POOL_SIZE - 1 - i;
+    }
+    execbo_free_count = MAX_EXECBO_POOL_SIZE;
+    execbo_submitted_count = 0;
+    next_work_item_id = 0;
+    exec_waiting = false;
     reg_map_locked = false;
     locked_by_session_id = -100;
+    num_sessions = 0;
+    load = 0;
   }
 } XmaHwKernel;
 
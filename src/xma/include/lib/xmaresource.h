@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2019, Xilinx Inc - All rights reserved
+ * Xilinx SDAccel Media Accelerator API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _XMA_RESOURCE_LIB_H_
+#define _XMA_RESOURCE_LIB_H_
+
+#include "app/xmabuffers.h"
+#include "app/xmaparam.h"
+#include "app/xmaresource.h"
+#include "plg/xmasess.h"
+
+/**
+ *  @brief Place a session on a compute unit
+ *
+ *  Both indices are used as is when neither is XMA_ANY_INDEX.
+ *  Otherwise the least loaded compute unit matching the
+ *  XMA_KERNEL_NAME_PARAM parameter is chosen.  The load of the
+ *  session is added to the chosen compute unit until
+ *  @ref xma_res_free_cu() is called.
+ *
+ *  @param session   Session being created
+ *  @param params    Session custom parameters
+ *  @param param_cnt Number of custom parameters
+ *  @param load      Declared load of session, see @ref xma_res_load()
+ *  @param dev_index In: requested device or XMA_ANY_INDEX.
+ *                   Out: chosen device
+ *  @param cu_index  In: requested compute unit or XMA_ANY_INDEX.
+ *                   Out: chosen compute unit
+ *
+ *  @return          XMA_SUCCESS on success
+ *                   XMA_ERROR_INVALID if requested indices are out of range
+ *                   XMA_ERROR_NO_KERNEL if no compatible compute unit exists
+ */
+int32_t xma_res_alloc_cu(XmaSession   *session,
+                         XmaParameter *params,
+                         uint32_t      param_cnt,
+                         uint64_t      load,
+                         int32_t      *dev_index,
+                         int32_t      *cu_index);
+
+/**
+ *  @brief Remove a session's load from its compute unit
+ *
+ *  No-op if the session was never placed.  Completed work items of
+ *  the session that were never waited for are discarded.
+ */
+void xma_res_free_cu(XmaSession *session);
+
+/**
+ *  @brief Compute the declared load of a video session
+ *
+ *  @return  Pixels per second, 0 if framerate is not set
+ */
+uint64_t xma_res_load(int32_t width, int32_t height, XmaFraction framerate);
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2019, Xilinx Inc - All rights reserved
+ * Xilinx SDAccel Media Accelerator API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _XMA_STATS_LIB_H_
+#define _XMA_STATS_LIB_H_
+
+#include <stdint.h>
+
+/**
+ *  @file
+ *
+ *  Session statistics are kept in a file per session under
+ *  XMA_STATS_PATH which is mapped shared into the process owning the
+ *  session.  The file holds one XmaStatsRegion in native byte order.
+ *  Counters are updated with relaxed atomic operations so the hot path
+ *  does no formatting and no system calls; readers such as xmastat map
+ *  the same file and format it on demand.  A reader may observe
+ *  counters of one frame partially updated.
+ *
+ *  Files are named per process and session, so the library removes
+ *  them rather than leaving one per session ever created: the file is
+ *  unlinked when the session is destroyed, and files of sessions still
+ *  open are unlinked by xma_exit() at process exit and on the fatal
+ *  signals XMA handles.  Only a process killed with SIGKILL leaves its
+ *  files behind.
+ */
+
+#define XMA_STATS_PATH    "/var/tmp/xilinx"
+#define XMA_STATS_MAGIC   0x53414d58 /* "XMAS" */
+#define XMA_STATS_VERSION 1
+
+typedef struct XmaStatsRegion
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    size;                    // sizeof(XmaStatsRegion)
+    int32_t     session_type;            // XmaSessionType
+    int32_t     dev_index;
+    int32_t     cu_index;
+    int32_t     channel_id;
+    int32_t     reserved0;
+    uint64_t    last_pid_in_use;
+    uint64_t    last_received_input_ts;  // CLOCK_MONOTONIC ns
+    uint64_t    last_received_output_ts; // CLOCK_MONOTONIC ns
+    uint64_t    received_frame_count;    // frames, data buffers or writes
+    uint64_t    received_pixel_count;
+    uint64_t    received_bit_count;
+    uint64_t    output_frame_count;      // frames, data buffers or reads
+    uint64_t    output_pixel_count;
+    uint64_t    output_bit_count;
+    uint64_t    reserved[7];
+} XmaStatsRegion;
+
+/**
+ *  @brief Create and map the statistics file of a session
+ *
+ *  The file XMA_STATS_PATH/<prefix>-<vendor>-<dev>-<cu>-<channel>-<pid>-<session>
+ *  is created in a temporary file and renamed into place, so sessions
+ *  sharing a CU and channel never share or truncate a mapped file.
+ *
+ *  @return Mapped region, NULL on failure in which case
+ *          statistics of the session are not recorded
+ */
+XmaStatsRegion *xma_stats_open(const char *prefix,
+                               const char *vendor,
+                               int32_t     session_type,
+                               int32_t     dev_index,
+                               int32_t     cu_index,
+                               int32_t     channel_id,
+                               int32_t     session_id);
+
+/**
+ *  @brief Account for input received by a session
+ *
+ *  No-op if stats is NULL
+ */
+void xma_stats_input(XmaStatsRegion *stats,
+                     uint64_t        pixels,
+                     uint64_t        bits);
+
+/**
+ *  @brief Account for output produced by a session
+ *
+ *  No-op if stats is NULL
+ */
+void xma_stats_output(XmaStatsRegion *stats,
+                      uint64_t        pixels,
+                      uint64_t        bits);
+
+/**
+ *  @brief Unmap and remove the statistics file of a session
+ */
+void xma_stats_close(XmaStatsRegion *stats);
+
+/**
+ *  @brief Remove the statistics files of all sessions still open
+ *
+ *  Called by xma_exit() at process exit and from the XMA signal
+ *  handler, so it only unlinks paths kept in preallocated slots.  The
+ *  mappings and slots are released by xma_stats_close().  At most 256
+ *  sessions have a statistics file at a time.
+ */
+void xma_stats_cleanup(void);
+
+#endif
@@ -101,6 +101,38 @@ XmaBufferObj xma_plg_buffer_alloc(XmaSession s_handle, size_t size, bool device_
  */
 void xma_plg_buffer_free(XmaSession s_handle, XmaBufferObj b_obj);
 
+/**
+ *  xma_plg_frame_pool_create() - Create a pool of frames backed by device buffers
+ *
+ *  Each plane of a pooled frame is a host mapped device buffer allocated
+ *  with @ref xma_plg_buffer_alloc() on the DDR bank of the session's
+ *  kernel.  The plane's XmaBufferRef::buffer is the mapped host pointer
+ *  and its buffer_type is XMA_DEVICE_BUFFER_TYPE, so applications can
+ *  fill frames directly and plugins sync them to or from the device with
+ *  @ref xma_plg_buffer_write() and @ref xma_plg_buffer_read() without a
+ *  copy.  Frames are obtained and returned with xma_frame_pool_get() and
+ *  xma_frame_pool_put(), and the pool is destroyed with
+ *  xma_frame_pool_destroy() which must happen before the session is
+ *  destroyed.
+ *
+ *  @s_handle:    The session handle associated with this plugin instance
+ *  @frame_props: Properties of every frame in the pool
+ *
+ *  RETURN:       Frame pool, NULL on failure
+ */
+XmaFramePool* xma_plg_frame_pool_create(XmaSession s_handle, XmaFrameProperties *frame_props);
+
+/**
+ *  xma_plg_frame_buffer_obj() - Get the device buffer of a plane of a pooled frame
+ *
+ *  @frame: Frame obtained from a pool created with
+ *          @ref xma_plg_frame_pool_create()
+ *  @plane: Plane index
+ *
+ *  RETURN: Buffer object of the plane, NULL if plane is out of range
+ */
+XmaBufferObj* xma_plg_frame_buffer_obj(XmaFrame *frame, int32_t plane);
+
 /**
  *  xma_plg_buffer_free() - Get a physical address for a buffer handle
  *  This function returns the physical address of DDR memory on the FPGA
@@ -178,18 +210,58 @@ int32_t xma_plg_schedule_work_item(XmaSession s_handle);
  * xma_plg_is_work_item_done() - This function checks if at least one work item
  * previously submitted via xma_plg_schedule_work_item() has completed.  If the
  * supplied timeout expires before a work item has completed, this function
- * returns an error.
+ * returns an error.  Only work items scheduled by the calling session are
+ * counted; completions of other sessions sharing the kernel are left for
+ * those sessions.
  *
  * @s_handle:      The session handle associated with this plugin instance
  * @timeout_in_ms: A timeout value in milliseconds
  *
  * RETURN:         XMA_SUCCESS on success
  *
- * XMA_ERROR on timeout
+ * XMA_ERROR on timeout, or if the work item failed or was aborted
  *
  */
 int32_t xma_plg_is_work_item_done(XmaSession s_handle, int32_t timeout_in_ms);
 
+/**
+ * xma_plg_schedule_work_item_id() - Same as xma_plg_schedule_work_item() but
+ * also returns an id identifying the scheduled work item.
+ *
+ * @s_handle:     The session handle associated with this plugin instance
+ * @work_item_id: Returns the id of the scheduled work item
+ *
+ * RETURN:     XMA_SUCCESS on success
+ *
+ * XMA_ERROR on failure
+ *
+ */
+int32_t xma_plg_schedule_work_item_id(XmaSession s_handle, int32_t* work_item_id);
+
+/**
+ * xma_plg_is_work_item_done_id() - Wait for the oldest finished work item
+ * scheduled by this session and return its id.  Work items scheduled by
+ * other sessions sharing the kernel are left for those sessions.  The
+ * calling thread sleeps while waiting.
+ *
+ * @s_handle:      The session handle associated with this plugin instance
+ * @timeout_in_ms: A timeout value in milliseconds
+ * @work_item_id:  Returns the id of the finished work item as returned by
+ *                 xma_plg_schedule_work_item_id()
+ *
+ * RETURN:         XMA_SUCCESS on success
+ *
+ * XMA_ERROR on timeout, or if the work item failed or was aborted.  In the
+ * latter case @work_item_id is set.
+ *
+ * Every completion is counted until it is waited for, but only the id and
+ * status of the most recent 64 completions of a session are kept.  An older
+ * completion is returned with @work_item_id set to -1, and failures among
+ * them are reported before successes.
+ *
+ */
+int32_t xma_plg_is_work_item_done_id(XmaSession s_handle, int32_t timeout_in_ms, int32_t* work_item_id);
+
 int32_t xma_plg_kernel_lock_regmap(XmaSession s_handle);
 int32_t xma_plg_kernel_unlock_regmap(XmaSession s_handle);
 
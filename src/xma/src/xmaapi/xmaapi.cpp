@@ -29,6 +29,7 @@
 #include "lib/xmaapi.h"
 #include "lib/xmahw_hal.h"
 #include "lib/xmasignal.h"
+#include "lib/xmastats.h"
 
 #define XMAAPI_MOD "xmaapi"
 
@@ -152,6 +153,7 @@ error:
 
 void xma_exit(void)
 {
+    xma_stats_cleanup();
 /*
     extern XmaSingleton *g_xma_singleton;
     if (!g_xma_singleton->shm_freed)
@@ -16,9 +16,14 @@
  */
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
 
 #include "app/xmabuffers.h"
 #include "app/xmalogger.h"
+#include "lib/xmaframepool.h"
 
 #define XMA_BUFFER_MOD "xmabuffer"
 
@@ -171,3 +176,294 @@ xma_data_buffer_free(XmaDataBuffer *data)
     free(data);
 }
 
+
+// Frame pools
+//
+// Pooled frames are allocated as XmaPooledFrame with the XmaFrame
+// handed to the application as first member.  Plane buffers stay
+// attached to the frame while it sits in the pool.  Frames of all
+// pools are registered so a frame can be recognized as pooled without
+// reading past the end of a frame from xma_frame_alloc().
+
+typedef struct XmaPooledFrame
+{
+    XmaFrame      frame;
+    void         *plane_priv[XMA_MAX_PLANES];
+} XmaPooledFrame;
+
+static std::mutex g_pooled_frames_mutex;
+static std::unordered_set<const XmaFrame*> g_pooled_frames;
+
+struct XmaFramePool
+{
+    XmaFrameProperties    frame_props;
+    int32_t               num_planes;
+    size_t                plane_size[XMA_MAX_PLANES];
+    XmaFramePoolAllocator allocator;
+    // Guards all members below
+    std::mutex            mutex;
+    std::vector<XmaPooledFrame*> free_frames;
+    int32_t               outstanding;
+    bool                  destroyed;
+};
+
+static size_t
+xma_frame_plane_size(XmaFrameProperties *frame_props, int32_t plane)
+{
+    size_t width = frame_props->width;
+    size_t height = frame_props->height;
+    size_t sample = (frame_props->bits_per_pixel > 8) ? 2 : 1;
+
+    switch (frame_props->format)
+    {
+        case XMA_YUV420_FMT_TYPE:
+            if (plane)
+                return ((width + 1) / 2) * ((height + 1) / 2) * sample;
+            return width * height * sample;
+        case XMA_YUV422_FMT_TYPE:
+            if (plane)
+                return ((width + 1) / 2) * height * sample;
+            return width * height * sample;
+        case XMA_RGB888_FMT_TYPE:
+            if (frame_props->bits_per_pixel > 24)
+                return width * height * ((frame_props->bits_per_pixel + 7) / 8);
+            return width * height * 3;
+        default:
+            return width * height * sample;
+    }
+}
+
+static void*
+xma_frame_pool_host_alloc(void *arg, size_t size, void **priv)
+{
+    void *buffer = NULL;
+    if (posix_memalign(&buffer, 4096, size))
+        return NULL;
+    return buffer;
+}
+
+static void
+xma_frame_pool_host_free(void *arg, void *buffer, size_t size, void *priv)
+{
+    free(buffer);
+}
+
+#define XMA_HUGEPAGE_SIZE (2UL * 1024 * 1024)
+
+static size_t
+xma_hugepage_round(size_t size)
+{
+    return (size + XMA_HUGEPAGE_SIZE - 1) & ~(XMA_HUGEPAGE_SIZE - 1);
+}
+
+static void*
+xma_frame_pool_hugepage_alloc(void *arg, size_t size, void **priv)
+{
+    size_t len = xma_hugepage_round(size);
+    void *buffer = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (buffer != MAP_FAILED)
+        return buffer;
+
+    // No reserved huge pages, ask for transparent huge pages instead
+    buffer = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED)
+        return NULL;
+    madvise(buffer, len, MADV_HUGEPAGE);
+    return buffer;
+}
+
+static void
+xma_frame_pool_hugepage_free(void *arg, void *buffer, size_t size, void *priv)
+{
+    munmap(buffer, xma_hugepage_round(size));
+}
+
+static void
+xma_frame_pool_release(XmaFramePool *pool)
+{
+    if (pool->allocator.release)
+        pool->allocator.release(pool->allocator.arg);
+    delete pool;
+}
+
+static void
+xma_frame_pool_delete_frame(XmaFramePool *pool, XmaPooledFrame *pframe)
+{
+    {
+        std::lock_guard<std::mutex> lk(g_pooled_frames_mutex);
+        g_pooled_frames.erase(&pframe->frame);
+    }
+    for (int32_t i = 0; i < pool->num_planes; i++)
+    {
+        if (pframe->frame.data[i].buffer)
+            pool->allocator.free(pool->allocator.arg,
+                                 pframe->frame.data[i].buffer,
+                                 pool->plane_size[i],
+                                 pframe->plane_priv[i]);
+    }
+    free(pframe);
+}
+
+static XmaPooledFrame*
+xma_frame_pool_new_frame(XmaFramePool *pool)
+{
+    XmaPooledFrame *pframe = (XmaPooledFrame*) calloc(1, sizeof(XmaPooledFrame));
+    if (pframe == NULL)
+        return NULL;
+
+    for (int32_t i = 0; i < pool->num_planes; i++)
+    {
+        pframe->frame.data[i].buffer_type = pool->allocator.buffer_type;
+        pframe->frame.data[i].is_clone = false;
+        pframe->frame.data[i].buffer =
+            pool->allocator.alloc(pool->allocator.arg, pool->plane_size[i],
+                                  &pframe->plane_priv[i]);
+        if (pframe->frame.data[i].buffer == NULL)
+        {
+            xma_logmsg(XMA_ERROR_LOG, XMA_BUFFER_MOD,
+                       "%s() Failed to allocate plane %d of %lu bytes\n",
+                       __func__, i, pool->plane_size[i]);
+            xma_frame_pool_delete_frame(pool, pframe);
+            return NULL;
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(g_pooled_frames_mutex);
+    g_pooled_frames.insert(&pframe->frame);
+    return pframe;
+}
+
+XmaFramePool*
+xma_frame_pool_create_with(XmaFrameProperties          *frame_props,
+                           const XmaFramePoolAllocator *allocator)
+{
+    xma_logmsg(XMA_DEBUG_LOG, XMA_BUFFER_MOD, "%s()\n", __func__);
+    XmaFramePool *pool = new XmaFramePool;
+    pool->frame_props = *frame_props;
+    pool->num_planes = xma_frame_planes_get(frame_props);
+    for (int32_t i = 0; i < XMA_MAX_PLANES; i++)
+        pool->plane_size[i] = (i < pool->num_planes)
+                            ? xma_frame_plane_size(frame_props, i) : 0;
+    pool->allocator = *allocator;
+    pool->outstanding = 0;
+    pool->destroyed = false;
+    return pool;
+}
+
+XmaFramePool*
+xma_frame_pool_create(XmaFrameProperties *frame_props, int32_t flags)
+{
+    XmaFramePoolAllocator allocator;
+    memset(&allocator, 0, sizeof(allocator));
+    allocator.buffer_type = XMA_HOST_BUFFER_TYPE;
+    if (flags & XMA_FRAME_POOL_HUGEPAGE)
+    {
+        allocator.alloc = xma_frame_pool_hugepage_alloc;
+        allocator.free = xma_frame_pool_hugepage_free;
+    }
+    else
+    {
+        allocator.alloc = xma_frame_pool_host_alloc;
+        allocator.free = xma_frame_pool_host_free;
+    }
+    return xma_frame_pool_create_with(frame_props, &allocator);
+}
+
+XmaFrame*
+xma_frame_pool_get(XmaFramePool *pool)
+{
+    XmaPooledFrame *pframe = NULL;
+    {
+        std::lock_guard<std::mutex> lk(pool->mutex);
+        if (!pool->free_frames.empty())
+        {
+            pframe = pool->free_frames.back();
+            pool->free_frames.pop_back();
+        }
+        pool->outstanding++;
+    }
+
+    if (pframe == NULL)
+        pframe = xma_frame_pool_new_frame(pool);
+
+    if (pframe == NULL)
+    {
+        std::lock_guard<std::mutex> lk(pool->mutex);
+        pool->outstanding--;
+        return NULL;
+    }
+
+    // Reset everything but the plane buffers
+    XmaFrame *frame = &pframe->frame;
+    XmaBufferRef data[XMA_MAX_PLANES];
+    memcpy(data, frame->data, sizeof(data));
+    memset(frame, 0, sizeof(XmaFrame));
+    memcpy(frame->data, data, sizeof(data));
+    frame->frame_props = pool->frame_props;
+    for (int32_t i = 0; i < pool->num_planes; i++)
+        frame->data[i].refcount = 1;
+
+    return frame;
+}
+
+void
+xma_frame_pool_put(XmaFramePool *pool, XmaFrame *frame)
+{
+    XmaPooledFrame *pframe = (XmaPooledFrame*) frame;
+
+    for (int32_t i = 0; i < pool->num_planes; i++)
+        frame->data[i].refcount--;
+
+    if (frame->data[0].refcount > 0)
+        return;
+
+    bool release = false;
+    {
+        std::lock_guard<std::mutex> lk(pool->mutex);
+        pool->outstanding--;
+        if (!pool->destroyed)
+        {
+            pool->free_frames.push_back(pframe);
+            return;
+        }
+        release = (pool->outstanding == 0);
+    }
+
+    xma_frame_pool_delete_frame(pool, pframe);
+    if (release)
+        xma_frame_pool_release(pool);
+}
+
+void
+xma_frame_pool_destroy(XmaFramePool *pool)
+{
+    xma_logmsg(XMA_DEBUG_LOG, XMA_BUFFER_MOD, "%s()\n", __func__);
+    std::vector<XmaPooledFrame*> free_frames;
+    bool release = false;
+    {
+        std::lock_guard<std::mutex> lk(pool->mutex);
+        pool->destroyed = true;
+        free_frames.swap(pool->free_frames);
+        release = (pool->outstanding == 0);
+    }
+
+    for (auto pframe : free_frames)
+        xma_frame_pool_delete_frame(pool, pframe);
+    if (release)
+        xma_frame_pool_release(pool);
+}
+
+void*
+xma_frame_pool_plane_priv(XmaFrame *frame, int32_t plane)
+{
+    if (plane < 0 || plane >= XMA_MAX_PLANES)
+        return NULL;
+    {
+        std::lock_guard<std::mutex> lk(g_pooled_frames_mutex);
+        if (g_pooled_frames.find(frame) == g_pooled_frames.end())
+            return NULL;
+    }
+    return ((XmaPooledFrame*) frame)->plane_priv[plane];
+}
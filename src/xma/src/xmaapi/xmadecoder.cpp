@@ -20,6 +20,8 @@
 #include <dlfcn.h>
 #include "lib/xmaapi.h"
 #include "lib/xmahw_hal.h"
+#include "lib/xmaresource.h"
+#include "lib/xmastats.h"
 //#include "lib/xmares.h"
 #include "app/xmalogger.h"
 #include "xmaplugin.h"
@@ -128,6 +130,25 @@ xma_dec_session_create(XmaDecoderProperties *dec_props)
     }
     */
 
+    // Place the session on the requested CU or on the least loaded
+    // compatible CU if the application leaves the choice to XMA
+    int rc, dev_index, cu_index;
+    dev_index = dec_props->dev_index;
+    cu_index = dec_props->cu_index;
+    rc = xma_res_alloc_cu(&dec_session->base, dec_props->params,
+                          dec_props->param_cnt,
+                          xma_res_load(dec_props->width, dec_props->height,
+                                       dec_props->framerate),
+                          &dev_index, &cu_index);
+    if (rc) {
+        xma_logmsg(XMA_ERROR_LOG, XMA_DECODER_MOD,
+                   "Failed to allocate decoder cu. Return code %d\n", rc);
+        free(dec_session);
+        return NULL;
+    }
+    dec_props->dev_index = dec_session->decoder_props.dev_index = dev_index;
+    dec_props->cu_index = dec_session->decoder_props.cu_index = cu_index;
+
     bool expected = false;
     bool desired = true;
     while (!(g_xma_singleton->locked).compare_exchange_weak(expected, desired)) {
@@ -135,11 +156,7 @@ xma_dec_session_create(XmaDecoderProperties *dec_props)
     }
     //Singleton lock acquired
 
-   //Sarab: TODO Fix device index, CU index & session->xx_plugin assigned above
     //int rc, dev_handle, kern_handle, dec_handle;
-    int rc, dev_index, cu_index;
-    dev_index = dec_props->dev_index;
-    cu_index = dec_props->cu_index;
     //dec_handle = dec_props->cu_index;
     
     g_xma_singleton->num_decoders++;
@@ -170,6 +187,7 @@ xma_dec_session_create(XmaDecoderProperties *dec_props)
     int32_t xma_main_ver = -1;
     int32_t xma_sub_ver = -1;
     rc = dec_session->decoder_plugin->xma_version(&xma_main_ver, & xma_sub_ver);
+    xma_res_free_cu(&dec_session->base);
     if (rc < 0) {
         return NULL;
     }
@@ -179,10 +197,17 @@ xma_dec_session_create(XmaDecoderProperties *dec_props)
 
     if (dec_session->decoder_plugin->init(dec_session)) {
         free(dec_session->base.plugin_data);
+        xma_res_free_cu(&dec_session->base);
         free(dec_session);
         return NULL;
     }
 
+    // Map the stats file of the session
+    dec_session->base.stats =
+        xma_stats_open("DEC", dec_props->hwvendor_string, XMA_DECODER,
+                       dev_index, cu_index, dec_session->base.channel_id,
+                       dec_session->base.session_id);
+
     return dec_session;
 }
 
@@ -208,6 +233,9 @@ xma_dec_session_destroy(XmaDecoderSession *session)
                    "Error freeing kernel session. Return code %d\n", rc);
 
     */
+    xma_res_free_cu(&session->base);
+    xma_stats_close((XmaStatsRegion*)session->base.stats);
+
     // Free the session
     // TODO: (should also free the Hw sessions)
     free(session);
@@ -221,7 +249,11 @@ xma_dec_session_send_data(XmaDecoderSession *session,
 						  int32_t           *data_used)
 {
     xma_logmsg(XMA_DEBUG_LOG, XMA_DECODER_MOD, "%s()\n", __func__);
-    return session->decoder_plugin->send_data(session, data, data_used);
+    int32_t rc = session->decoder_plugin->send_data(session, data, data_used);
+    if (rc >= 0 && *data_used)
+        xma_stats_input((XmaStatsRegion*)session->base.stats,
+                        0, (uint64_t)*data_used * 8);
+    return rc;
 }
 
 int32_t
@@ -237,5 +269,9 @@ xma_dec_session_recv_frame(XmaDecoderSession *session,
                            XmaFrame           *frame)
 {
     xma_logmsg(XMA_DEBUG_LOG, XMA_DECODER_MOD, "%s()\n", __func__);
-    return session->decoder_plugin->recv_frame(session, frame);
+    int32_t rc = session->decoder_plugin->recv_frame(session, frame);
+    if (rc == XMA_SUCCESS)
+        xma_stats_output((XmaStatsRegion*)session->base.stats,
+                         (uint64_t)frame->frame_props.width * frame->frame_props.height, 0);
+    return rc;
 }
@@ -25,44 +25,14 @@
 #include <unistd.h>
 #include "lib/xmaapi.h"
 #include "lib/xmahw_hal.h"
+#include "lib/xmaresource.h"
+#include "lib/xmastats.h"
 //#include "lib/xmares.h"
 #include "xmaplugin.h"
 
-char    g_stat_fmt[] = "last_pid_in_use          :%d\n"
-                       "last_received_input_ts   :%lu\n"
-                       "last_received_output_ts  :%lu\n"
-                       "received_frame_count     :%lu\n"
-                       "received_pixel_count     :%lu\n"
-                       "received_bit_count       :%lu\n"
-                       "encoded_frame_count      :%lu\n"
-                       "encoded_bit_count        :%lu\n";
-
-typedef struct XmaEncoderStats
-{
-    int32_t     fd;
-    uint64_t    last_pid_in_use;
-    uint64_t    last_received_input_ts;
-    uint64_t    last_received_output_ts;
-    uint64_t    received_frame_count;
-    uint64_t    received_pixel_count;
-    uint64_t    received_bit_count;
-    uint64_t    encoded_frame_count;
-    uint64_t    encoded_bit_count;
-} XmaEncoderStats;
-
 // Private functions for managing statistics
 void xma_enc_session_statsfile_init(XmaEncoderSession *session);
 
-void xma_enc_session_statsfile_send_frame(XmaEncoderSession *session, 
-                                          uint64_t           timestamp,
-                                          uint32_t           frame_size);
-
-void xma_enc_session_statsfile_recv_data(XmaEncoderSession *session, 
-                                         uint64_t           timestamp,
-                                         uint32_t           data_size);
-
-void xma_enc_session_statsfile_write(XmaEncoderStats *stats);
-
 void xma_enc_session_statsfile_close(XmaEncoderSession *session);
 
 #define XMA_ENCODER_MOD "xmaencoder"
@@ -167,6 +137,25 @@ xma_enc_session_create(XmaEncoderProperties *enc_props)
     }
     */
 
+    // Place the session on the requested CU or on the least loaded
+    // compatible CU if the application leaves the choice to XMA
+    int rc, dev_index, cu_index;
+    dev_index = enc_props->dev_index;
+    cu_index = enc_props->cu_index;
+    rc = xma_res_alloc_cu(&enc_session->base, enc_props->params,
+                          enc_props->param_cnt,
+                          xma_res_load(enc_props->width, enc_props->height,
+                                       enc_props->framerate),
+                          &dev_index, &cu_index);
+    if (rc) {
+        xma_logmsg(XMA_ERROR_LOG, XMA_ENCODER_MOD,
+                   "Failed to allocate encoder cu. Return code %d\n", rc);
+        free(enc_session);
+        return NULL;
+    }
+    enc_props->dev_index = enc_session->encoder_props.dev_index = dev_index;
+    enc_props->cu_index = enc_session->encoder_props.cu_index = cu_index;
+
     bool expected = false;
     bool desired = true;
     while (!(g_xma_singleton->locked).compare_exchange_weak(expected, desired)) {
@@ -174,12 +163,6 @@ xma_enc_session_create(XmaEncoderProperties *enc_props)
     }
     //Singleton lock acquired
 
-   //Sarab: TODO Fix device index, CU index & session->xx_plugin assigned above
-    int rc, dev_index, cu_index;
-    dev_index = enc_props->dev_index;
-    cu_index = enc_props->cu_index;
-    //enc_handle = enc_props->cu_index;
-
     g_xma_singleton->num_encoders++;
 
     XmaHwCfg *hwcfg = &g_xma_singleton->hwcfg;
@@ -226,6 +209,7 @@ xma_enc_session_create(XmaEncoderProperties *enc_props)
     rc = enc_session->encoder_plugin->xma_version(&xma_main_ver, & xma_sub_ver);
     //Sarab: TODO. Check version match. Stop here for now
     //Sarab: Remove it later on
+    xma_res_free_cu(&enc_session->base);
     return NULL;
 
     rc = enc_session->encoder_plugin->init(enc_session);
@@ -235,6 +219,7 @@ xma_enc_session_create(XmaEncoderProperties *enc_props)
                    rc);
         free(enc_session->base.plugin_data);
         //xma_connect_free(enc_session->conn_recv_handle, XMA_CONNECT_RECEIVER);
+        xma_res_free_cu(&enc_session->base);
         free(enc_session);
         return NULL;
     }
@@ -276,6 +261,8 @@ xma_enc_session_destroy(XmaEncoderSession *session)
         xma_logmsg(XMA_ERROR_LOG, XMA_ENCODER_MOD,
                    "Error freeing kernel session. Return code %d\n", rc);
     */
+    xma_res_free_cu(&session->base);
+
     // Free the session
     // TODO: (should also free the Hw sessions)
     free(session);
@@ -288,20 +275,15 @@ xma_enc_session_send_frame(XmaEncoderSession *session,
                            XmaFrame          *frame)
 {
     int32_t  rc;
-    struct   timespec ts;
-    uint64_t timestamp;
-    uint32_t frame_size;
+    uint64_t frame_size;
 
     xma_logmsg(XMA_DEBUG_LOG, XMA_ENCODER_MOD, "%s()\n", __func__);
-    clock_gettime(CLOCK_MONOTONIC, &ts);  
-    timestamp = (ts.tv_sec * 1000000000) + ts.tv_nsec;
     rc = session->encoder_plugin->send_frame(session, frame);
     if (frame->do_not_encode == false)
     {
         frame_size = frame->frame_props.width * frame->frame_props.height; 
-        xma_enc_session_statsfile_send_frame(session, 
-                                             timestamp,
-                                             frame_size);
+        xma_stats_input((XmaStatsRegion*)session->base.stats,
+                        frame_size, frame_size * 12);
     }
     return rc;
 
@@ -313,19 +295,12 @@ xma_enc_session_recv_data(XmaEncoderSession *session,
                           int32_t           *data_size)
 {
     int32_t  rc;
-    struct   timespec ts;
-    uint64_t timestamp;
 
     xma_logmsg(XMA_DEBUG_LOG, XMA_ENCODER_MOD, "%s()\n", __func__);
     rc = session->encoder_plugin->recv_data(session, data, data_size);
     if (*data_size)
-    {
-        clock_gettime(CLOCK_MONOTONIC, &ts);  
-        timestamp = (ts.tv_sec * 1000000000) + ts.tv_nsec;
-        xma_enc_session_statsfile_recv_data(session, 
-                                            timestamp,
-                                            *data_size);
-    }
+        xma_stats_output((XmaStatsRegion*)session->base.stats,
+                         0, (uint64_t)*data_size * 8);
 
     return rc;
 }
@@ -333,21 +308,8 @@ xma_enc_session_recv_data(XmaEncoderSession *session,
 void 
 xma_enc_session_statsfile_init(XmaEncoderSession *session)
 {
-    char            *path = (char*) "/var/tmp/xilinx";
     char            *enc_type_str;
-    char            *vendor;
-    int32_t          dev_id = 0;
-    int32_t          kern_inst = 0;
-    int32_t          chan_id = 0;
-    char             fname[512];
-    XmaEncoderStats *stats;
-
-    stats = (XmaEncoderStats*) malloc(sizeof(XmaEncoderStats));
-	if (stats == NULL) {
-        xma_logmsg(XMA_ERROR_LOG, XMA_ENCODER_MOD,
-                   "Unable to initialize encoder stats file\n");
-		return;
-    }
+    char             prefix[32];
 
     // Convert encoder type to string
     switch(session->encoder_props.hwencoder_type)
@@ -372,104 +334,17 @@ xma_enc_session_statsfile_init(XmaEncoderSession *session)
         break;
     }
 
-    // Build up file name based on session parameters
-    vendor = session->encoder_props.hwvendor_string;
-    /*Sarab: TODO. Fix dev id, cu id, etc
-    dev_id = xma_res_dev_handle_get(session->base.kern_res);
-    kern_inst = xma_res_kern_handle_get(session->base.kern_res);
-    */
-    chan_id = session->base.channel_id;
-    sprintf(fname, "%s/ENC-%s-%s-%d-%d-%d",
-            path, enc_type_str, vendor, dev_id, kern_inst, chan_id);     
-    
-    // Open the file - create if it doesn't exixt, truncate if it does
-    umask(0);
-    stats->fd = open(fname, O_RDWR | O_CREAT | O_TRUNC, 0666);    
-
-    // Initialize our in-memory copy of the stats
-    stats->last_pid_in_use = getpid();
-    stats->last_received_input_ts = 0ULL;
-    stats->last_received_output_ts = 0ULL;
-    stats->received_frame_count = 0ULL;
-    stats->received_pixel_count = 0ULL;
-    stats->received_bit_count = 0ULL;
-    stats->encoded_frame_count = 0ULL;
-    stats->encoded_bit_count = 0ULL;
-
-    xma_enc_session_statsfile_write(stats);
-
-    session->base.stats = stats;
-}
-
-void xma_enc_session_statsfile_send_frame(XmaEncoderSession *session, 
-                                          uint64_t           timestamp,
-                                          uint32_t           frame_size)
-{
-    XmaEncoderStats *stats;
-
-    stats = (XmaEncoderStats*)session->base.stats;
-     
-    // Update send_frame stats
-    stats->last_received_input_ts = timestamp;
-    stats->received_frame_count++;
-    stats->received_pixel_count += frame_size;
-    stats->received_bit_count += (frame_size * 12);
-
-    xma_enc_session_statsfile_write(stats);
-}
-
-void xma_enc_session_statsfile_recv_data(XmaEncoderSession *session, 
-                                         uint64_t           timestamp,
-                                         uint32_t           data_size)
-{
-    XmaEncoderStats *stats;
-
-    stats = (XmaEncoderStats*)session->base.stats;
-     
-    // Update recv_data stats
-    stats->last_received_output_ts = timestamp;
-    stats->encoded_frame_count++;
-    stats->encoded_bit_count += data_size * 8;
-
-    xma_enc_session_statsfile_write(stats);
-}
-
-void xma_enc_session_statsfile_write(XmaEncoderStats *stats)
-{
-    int32_t          rc;
-    char             stat_buf[1024];
-
-    sprintf(stat_buf, g_stat_fmt, 
-            stats->last_pid_in_use,
-            stats->last_received_input_ts,
-            stats->last_received_output_ts,
-            stats->received_frame_count,
-            stats->received_pixel_count,
-            stats->received_bit_count,
-            stats->encoded_frame_count,
-            stats->encoded_bit_count);
-
-    if (stats->fd <= 0) {
-        xma_logmsg(XMA_INFO_LOG, XMA_ENCODER_MOD, 
-                   "statsfile failed to open\n");
-    } else {
-        // Always re-write the entire file
-        lseek(stats->fd, 0, SEEK_SET);
-        rc = write(stats->fd, stat_buf, strlen(stat_buf)); 
-        if (rc < 0)
-            xma_logmsg(XMA_INFO_LOG, XMA_ENCODER_MOD, 
-                    "Write to statsfile failed\n");
-    }
+    snprintf(prefix, sizeof(prefix), "ENC-%s", enc_type_str);
+    session->base.stats =
+        xma_stats_open(prefix, session->encoder_props.hwvendor_string,
+                       XMA_ENCODER, session->encoder_props.dev_index,
+                       session->encoder_props.cu_index, session->base.channel_id,
+                       session->base.session_id);
 }
 
 void 
 xma_enc_session_statsfile_close(XmaEncoderSession *session)
 {
-    XmaEncoderStats *stats;
-
-    stats = (XmaEncoderStats*)session->base.stats;
-     
-    // Close and free the stats memory
-    close(stats->fd);
-    free(stats);
+    xma_stats_close((XmaStatsRegion*)session->base.stats);
+    session->base.stats = NULL;
 }
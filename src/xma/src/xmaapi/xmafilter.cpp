@@ -20,6 +20,8 @@
 #include <dlfcn.h>
 #include "lib/xmaapi.h"
 #include "lib/xmahw_hal.h"
+#include "lib/xmaresource.h"
+#include "lib/xmastats.h"
 //#include "lib/xmares.h"
 #include "xmaplugin.h"
 
@@ -130,6 +132,25 @@ xma_filter_session_create(XmaFilterProperties *filter_props)
     }
     */
 
+    // Place the session on the requested CU or on the least loaded
+    // compatible CU if the application leaves the choice to XMA
+    int rc, dev_index, cu_index;
+    dev_index = filter_props->dev_index;
+    cu_index = filter_props->cu_index;
+    rc = xma_res_alloc_cu(&filter_session->base, filter_props->params,
+                          filter_props->param_cnt,
+                          xma_res_load(filter_props->input.width, filter_props->input.height,
+                                       filter_props->input.framerate),
+                          &dev_index, &cu_index);
+    if (rc) {
+        xma_logmsg(XMA_ERROR_LOG, XMA_FILTER_MOD,
+                   "Failed to allocate filter cu. Return code %d\n", rc);
+        free(filter_session);
+        return NULL;
+    }
+    filter_props->dev_index = filter_session->props.dev_index = dev_index;
+    filter_props->cu_index = filter_session->props.cu_index = cu_index;
+
     bool expected = false;
     bool desired = true;
     while (!(g_xma_singleton->locked).compare_exchange_weak(expected, desired)) {
@@ -137,10 +158,6 @@ xma_filter_session_create(XmaFilterProperties *filter_props)
     }
     //Singleton lock acquired
 
-   //Sarab: TODO Fix device index, CU index & session->xx_plugin assigned above
-    int rc, dev_index, cu_index;
-    dev_index = filter_props->dev_index;
-    cu_index = filter_props->cu_index;
     //filter_handle = filter_props->cu_index;
 
     g_xma_singleton->num_filters++;
@@ -190,6 +207,7 @@ xma_filter_session_create(XmaFilterProperties *filter_props)
     rc = filter_session->filter_plugin->xma_version(&xma_main_ver, & xma_sub_ver);
     //Sarab: TODO. Check version match. Stop here for now
     //Sarab: Remove it later on
+    xma_res_free_cu(&filter_session->base);
     return NULL;
 
     rc = filter_session->filter_plugin->init(filter_session);
@@ -199,10 +217,17 @@ xma_filter_session_create(XmaFilterProperties *filter_props)
                    rc);
         free(filter_session->base.plugin_data);
         //xma_connect_free(filter_session->conn_send_handle, XMA_CONNECT_SENDER);
+        xma_res_free_cu(&filter_session->base);
         free(filter_session);
         return NULL;
     }
 
+    // Map the stats file of the session
+    filter_session->base.stats =
+        xma_stats_open("FILT", filter_props->hwvendor_string, XMA_FILTER,
+                       dev_index, cu_index, filter_session->base.channel_id,
+                       filter_session->base.session_id);
+
     return filter_session;
 }
 
@@ -235,6 +260,9 @@ xma_filter_session_destroy(XmaFilterSession *session)
         xma_logmsg(XMA_ERROR_LOG, XMA_FILTER_MOD,
                    "Error freeing filter session. Return code %d\n", rc);
     */
+    xma_res_free_cu(&session->base);
+    xma_stats_close((XmaStatsRegion*)session->base.stats);
+
     // Free the session
     // TODO: (should also free the Hw sessions)
     free(session);
@@ -271,7 +299,11 @@ xma_filter_session_send_frame(XmaFilterSession  *session,
     }
 send:
     */
-    return session->filter_plugin->send_frame(session, frame);
+    int32_t rc = session->filter_plugin->send_frame(session, frame);
+    if (rc >= 0)
+        xma_stats_input((XmaStatsRegion*)session->base.stats,
+                        (uint64_t)frame->frame_props.width * frame->frame_props.height, 0);
+    return rc;
 }
 
 int32_t
@@ -279,5 +311,9 @@ xma_filter_session_recv_frame(XmaFilterSession  *session,
                               XmaFrame          *frame)
 {
     xma_logmsg(XMA_DEBUG_LOG, XMA_FILTER_MOD, "%s()\n", __func__);
-    return session->filter_plugin->recv_frame(session, frame);
+    int32_t rc = session->filter_plugin->recv_frame(session, frame);
+    if (rc == XMA_SUCCESS)
+        xma_stats_output((XmaStatsRegion*)session->base.stats,
+                         (uint64_t)frame->frame_props.width * frame->frame_props.height, 0);
+    return rc;
 }
@@ -20,6 +20,8 @@
 #include <dlfcn.h>
 #include "lib/xmaapi.h"
 #include "lib/xmahw_hal.h"
+#include "lib/xmaresource.h"
+#include "lib/xmastats.h"
 //#include "lib/xmares.h"
 #include "xmaplugin.h"
 
@@ -119,6 +121,23 @@ xma_kernel_session_create(XmaKernelProperties *props)
     }
     */
 
+    // Place the session on the requested CU or on the least loaded
+    // compatible CU if the application leaves the choice to XMA
+    int rc, dev_index, cu_index;
+    dev_index = props->dev_index;
+    cu_index = props->cu_index;
+    rc = xma_res_alloc_cu(&session->base, props->params,
+                          props->param_cnt, 0,
+                          &dev_index, &cu_index);
+    if (rc) {
+        xma_logmsg(XMA_ERROR_LOG, XMA_KERNEL_MOD,
+                   "Failed to allocate kernel cu. Return code %d\n", rc);
+        free(session);
+        return NULL;
+    }
+    props->dev_index = session->kernel_props.dev_index = dev_index;
+    props->cu_index = session->kernel_props.cu_index = cu_index;
+
     bool expected = false;
     bool desired = true;
     while (!(g_xma_singleton->locked).compare_exchange_weak(expected, desired)) {
@@ -126,11 +145,6 @@ xma_kernel_session_create(XmaKernelProperties *props)
     }
     //Singleton lock acquired
 
-   //Sarab: TODO Fix device index, CU index & session->xx_plugin assigned above
-    int rc, dev_index, cu_index;
-    dev_index = props->dev_index;
-    cu_index = props->cu_index;
-
     g_xma_singleton->num_kernels++;
     
     XmaHwCfg *hwcfg = &g_xma_singleton->hwcfg;
@@ -161,6 +175,7 @@ xma_kernel_session_create(XmaKernelProperties *props)
     int32_t xma_main_ver = -1;
     int32_t xma_sub_ver = -1;
     rc = session->kernel_plugin->xma_version(&xma_main_ver, & xma_sub_ver);
+    xma_res_free_cu(&session->base);
     //Sarab: TODO. Check version match. Stop here for now
     //Sarab: Remove it later on
     if (rc < 0) {
@@ -174,10 +189,17 @@ xma_kernel_session_create(XmaKernelProperties *props)
                    "Initalization of kernel plugin failed. Return code %d\n",
                    rc);
         free(session->base.plugin_data);
+        xma_res_free_cu(&session->base);
         free(session);
         return NULL;
     }
 
+    // Map the stats file of the session
+    session->base.stats =
+        xma_stats_open("KERN", props->hwvendor_string, XMA_KERNEL,
+                       dev_index, cu_index, session->base.channel_id,
+                       session->base.session_id);
+
     return session;
 }
 
@@ -202,6 +224,9 @@ xma_kernel_session_destroy(XmaKernelSession *session)
         xma_logmsg(XMA_ERROR_LOG, XMA_KERNEL_MOD,
                    "Error freeing kernel session. Return code %d\n", rc);
     */
+    xma_res_free_cu(&session->base);
+    xma_stats_close((XmaStatsRegion*)session->base.stats);
+
     // Free the session
     // TODO: (should also free the Hw sessions)
     free(session);
@@ -215,7 +240,10 @@ xma_kernel_session_write(XmaKernelSession *session,
                          int32_t           param_cnt)
 {
     xma_logmsg(XMA_DEBUG_LOG, XMA_KERNEL_MOD, "%s()\n", __func__);
-    return session->kernel_plugin->write(session, param, param_cnt);
+    int32_t rc = session->kernel_plugin->write(session, param, param_cnt);
+    if (rc >= 0)
+        xma_stats_input((XmaStatsRegion*)session->base.stats, 0, 0);
+    return rc;
 }
 
 int32_t
@@ -224,5 +252,8 @@ xma_kernel_session_read(XmaKernelSession *session,
                         int32_t           *param_cnt)
 {
     xma_logmsg(XMA_DEBUG_LOG, XMA_KERNEL_MOD, "%s()\n", __func__);
-    return session->kernel_plugin->read(session, param, param_cnt);
+    int32_t rc = session->kernel_plugin->read(session, param, param_cnt);
+    if (rc == XMA_SUCCESS)
+        xma_stats_output((XmaStatsRegion*)session->base.stats, 0, 0);
+    return rc;
 }
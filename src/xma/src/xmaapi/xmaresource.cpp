@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2019, Xilinx Inc - All rights reserved
+ * Xilinx SDAccel Media Accelerator API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include "app/xmaerror.h"
+#include "lib/xmaapi.h"
+#include "lib/xmaresource.h"
+
+#define XMA_RES_MOD "xmaresource"
+
+extern XmaSingleton *g_xma_singleton;
+
+namespace {
+
+//Placement of a session, recorded so that the load can be
+//removed from the CU when the session is destroyed
+struct XmaResPlacement
+{
+    int32_t  dev_index;
+    int32_t  cu_index;
+    uint64_t load;
+};
+
+//Guards XmaHwKernel::num_sessions, XmaHwKernel::load and placements.
+//Independent of g_xma_singleton->locked so that sessions are placed
+//without spinning.
+std::mutex res_mutex;
+std::map<XmaSession*, XmaResPlacement> placements;
+
+const char*
+get_kernel_name_param(XmaParameter *params, uint32_t param_cnt)
+{
+    for (uint32_t i = 0; params && i < param_cnt; i++)
+    {
+        if (params[i].name && params[i].type == XMA_STRING && params[i].value &&
+            strcmp(params[i].name, XMA_KERNEL_NAME_PARAM) == 0)
+            return (const char*)params[i].value;
+    }
+    return NULL;
+}
+
+//CU names from ip_layout are "kernel:instance".  A request matches
+//either the full instance name or the kernel name.
+bool
+is_compatible(const XmaHwKernel& kernel, const char *kernel_name)
+{
+    const char *name = (const char*)kernel.name;
+    if (strcmp(name, kernel_name) == 0)
+        return true;
+    size_t len = strlen(kernel_name);
+    return strncmp(name, kernel_name, len) == 0 && name[len] == ':';
+}
+
+bool
+is_less_loaded(const XmaHwKernel& lhs, const XmaHwKernel& rhs)
+{
+    if (lhs.load != rhs.load)
+        return lhs.load < rhs.load;
+    return lhs.num_sessions < rhs.num_sessions;
+}
+
+} // namespace
+
+int32_t
+xma_res_alloc_cu(XmaSession   *session,
+                 XmaParameter *params,
+                 uint32_t      param_cnt,
+                 uint64_t      load,
+                 int32_t      *dev_index,
+                 int32_t      *cu_index)
+{
+    XmaHwCfg *hwcfg = &g_xma_singleton->hwcfg;
+    int32_t num_devices = (int32_t)hwcfg->devices.size();
+    int32_t req_dev = *dev_index;
+    int32_t req_cu = *cu_index;
+
+    std::lock_guard<std::mutex> lk(res_mutex);
+
+    if (req_dev >= num_devices || req_dev < XMA_ANY_INDEX || req_cu < XMA_ANY_INDEX)
+    {
+        xma_logmsg(XMA_ERROR_LOG, XMA_RES_MOD,
+                   "Invalid device index %d or cu index %d\n", req_dev, req_cu);
+        return XMA_ERROR_INVALID;
+    }
+
+    int32_t dev = XMA_ANY_INDEX, cu = XMA_ANY_INDEX;
+    if (req_dev != XMA_ANY_INDEX && req_cu != XMA_ANY_INDEX)
+    {
+        //Fixed placement by application
+        if (req_cu >= (int32_t)hwcfg->devices[req_dev].kernels.size())
+        {
+            xma_logmsg(XMA_ERROR_LOG, XMA_RES_MOD,
+                       "Invalid cu index %d on device %d\n", req_cu, req_dev);
+            return XMA_ERROR_INVALID;
+        }
+        dev = req_dev;
+        cu = req_cu;
+    }
+    else
+    {
+        const char *kernel_name = get_kernel_name_param(params, param_cnt);
+        if (!kernel_name)
+        {
+            xma_logmsg(XMA_ERROR_LOG, XMA_RES_MOD,
+                       "Automatic cu selection requires %s parameter\n",
+                       XMA_KERNEL_NAME_PARAM);
+            return XMA_ERROR_INVALID;
+        }
+
+        int32_t dev_begin = (req_dev == XMA_ANY_INDEX) ? 0 : req_dev;
+        int32_t dev_end = (req_dev == XMA_ANY_INDEX) ? num_devices : req_dev + 1;
+        for (int32_t d = dev_begin; d < dev_end; d++)
+        {
+            std::vector<XmaHwKernel>& kernels = hwcfg->devices[d].kernels;
+            for (int32_t c = 0; c < (int32_t)kernels.size(); c++)
+            {
+                if (!is_compatible(kernels[c], kernel_name))
+                    continue;
+                if (dev == XMA_ANY_INDEX ||
+                    is_less_loaded(kernels[c], hwcfg->devices[dev].kernels[cu]))
+                {
+                    dev = d;
+                    cu = c;
+                }
+            }
+        }
+
+        if (dev == XMA_ANY_INDEX)
+        {
+            xma_logmsg(XMA_ERROR_LOG, XMA_RES_MOD,
+                       "No cu found for kernel %s\n", kernel_name);
+            return XMA_ERROR_NO_KERNEL;
+        }
+    }
+
+    XmaHwKernel& kernel = hwcfg->devices[dev].kernels[cu];
+    kernel.num_sessions++;
+    kernel.load += load;
+    placements[session] = {dev, cu, load};
+
+    xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD,
+               "Session placed on device %d cu %d (%s), sessions %d load %lu\n",
+               dev, cu, (const char*)kernel.name, kernel.num_sessions, kernel.load);
+
+    *dev_index = dev;
+    *cu_index = cu;
+    return XMA_SUCCESS;
+}
+
+void
+xma_res_free_cu(XmaSession *session)
+{
+    std::lock_guard<std::mutex> lk(res_mutex);
+    auto itr = placements.find(session);
+    if (itr == placements.end())
+        return;
+
+    XmaResPlacement& p = itr->second;
+    XmaHwKernel& kernel = g_xma_singleton->hwcfg.devices[p.dev_index].kernels[p.cu_index];
+    kernel.num_sessions--;
+    kernel.load -= p.load;
+    placements.erase(itr);
+
+    // Drop work items of the session that were never waited for
+    std::lock_guard<std::mutex> exec_lk(kernel.execbo_mutex);
+    auto owned = [session](const auto& item) {
+        return item.session_id == session->session_id
+            && item.session_type == session->session_type;
+    };
+    kernel.completed.erase(std::remove_if(kernel.completed.begin(),
+                                          kernel.completed.end(), owned),
+                           kernel.completed.end());
+    for (int32_t i = 0; i < kernel.execbo_submitted_count; i++)
+    {
+        XmaHwKernelCompletion& item = kernel.execbo_work_item[kernel.execbo_submitted[i]];
+        if (owned(item))
+            item.session_id = -1;
+    }
+}
+
+uint64_t
+xma_res_load(int32_t width, int32_t height, XmaFraction framerate)
+{
+    if (width <= 0 || height <= 0 ||
+        framerate.numerator <= 0 || framerate.denominator <= 0)
+        return 0;
+
+    return ((uint64_t)width * height * framerate.numerator) / framerate.denominator;
+}
+
+int32_t
+xma_res_cu_utilization(XmaCUUtilization *util, int32_t num_entries)
+{
+    XmaHwCfg *hwcfg = &g_xma_singleton->hwcfg;
+    int32_t count = 0;
+
+    std::lock_guard<std::mutex> lk(res_mutex);
+    for (int32_t d = 0; d < (int32_t)hwcfg->devices.size(); d++)
+    {
+        std::vector<XmaHwKernel>& kernels = hwcfg->devices[d].kernels;
+        for (int32_t c = 0; c < (int32_t)kernels.size(); c++, count++)
+        {
+            if (!util || count >= num_entries)
+                continue;
+            XmaCUUtilization& entry = util[count];
+            memset(&entry, 0, sizeof(XmaCUUtilization));
+            entry.dev_index = d;
+            entry.cu_index = c;
+            entry.kernel_name = (const char*)kernels[c].name;
+            entry.num_sessions = kernels[c].num_sessions;
+            entry.load = kernels[c].load;
+        }
+    }
+    return count;
+}
@@ -20,6 +20,8 @@
 #include <dlfcn.h>
 #include "lib/xmaapi.h"
 #include "lib/xmahw_hal.h"
+#include "lib/xmaresource.h"
+#include "lib/xmastats.h"
 //#include "lib/xmares.h"
 #include "xmaplugin.h"
 
@@ -211,6 +213,25 @@ xma_scaler_session_create(XmaScalerProperties *sc_props)
         return NULL;
     */
 
+    // Place the session on the requested CU or on the least loaded
+    // compatible CU if the application leaves the choice to XMA
+    int rc, dev_index, cu_index;
+    dev_index = sc_props->dev_index;
+    cu_index = sc_props->cu_index;
+    rc = xma_res_alloc_cu(&sc_session->base, sc_props->params,
+                          sc_props->param_cnt,
+                          xma_res_load(sc_props->input.width, sc_props->input.height,
+                                       sc_props->input.framerate),
+                          &dev_index, &cu_index);
+    if (rc) {
+        xma_logmsg(XMA_ERROR_LOG, XMA_SCALER_MOD,
+                   "Failed to allocate scaler cu. Return code %d\n", rc);
+        free(sc_session);
+        return NULL;
+    }
+    sc_props->dev_index = sc_session->props.dev_index = dev_index;
+    sc_props->cu_index = sc_session->props.cu_index = cu_index;
+
     bool expected = false;
     bool desired = true;
     while (!(g_xma_singleton->locked).compare_exchange_weak(expected, desired)) {
@@ -218,10 +239,6 @@ xma_scaler_session_create(XmaScalerProperties *sc_props)
     }
     //Singleton lock acquired
 
-   //Sarab: TODO Fix device index, CU index & session->xx_plugin assigned above
-    int rc, dev_index, cu_index;
-    dev_index = sc_props->dev_index;
-    cu_index = sc_props->cu_index;
     //enc_handle = enc_props->cu_index;
 
     g_xma_singleton->num_scalers++;
@@ -275,6 +292,7 @@ xma_scaler_session_create(XmaScalerProperties *sc_props)
     rc = sc_session->scaler_plugin->xma_version(&xma_main_ver, & xma_sub_ver);
     //Sarab: TODO. Check version match. Stop here for now
     //Sarab: Remove it later on
+    xma_res_free_cu(&sc_session->base);
     return NULL;
 
     rc = sc_session->scaler_plugin->init(sc_session);
@@ -282,9 +300,16 @@ xma_scaler_session_create(XmaScalerProperties *sc_props)
         xma_logmsg(XMA_ERROR_LOG, XMA_SCALER_MOD,
                    "Initalization of scaler plugin failed. Return code %d\n",
                    rc);
+        xma_res_free_cu(&sc_session->base);
         return NULL;
     }
 
+    // Map the stats file of the session
+    sc_session->base.stats =
+        xma_stats_open("SCAL", sc_props->hwvendor_string, XMA_SCALER,
+                       dev_index, cu_index, sc_session->base.channel_id,
+                       sc_session->base.session_id);
+
     return sc_session;
 }
 
@@ -315,6 +340,9 @@ xma_scaler_session_destroy(XmaScalerSession *session)
         xma_logmsg(XMA_ERROR_LOG, XMA_SCALER_MOD,
                    "Error freeing kernel session. Return code %d\n", rc);
     */
+    xma_res_free_cu(&session->base);
+    xma_stats_close((XmaStatsRegion*)session->base.stats);
+
     // Free the session
     // TODO: (should also free the Hw sessions)
     free(session);
@@ -358,7 +386,11 @@ xma_scaler_session_send_frame(XmaScalerSession  *session,
     }
     */
 
-    return session->scaler_plugin->send_frame(session, frame);
+    int32_t rc = session->scaler_plugin->send_frame(session, frame);
+    if (rc >= 0)
+        xma_stats_input((XmaStatsRegion*)session->base.stats,
+                        (uint64_t)frame->frame_props.width * frame->frame_props.height, 0);
+    return rc;
 }
 
 int32_t
@@ -366,6 +398,15 @@ xma_scaler_session_recv_frame_list(XmaScalerSession  *session,
                                    XmaFrame          **frame_list)
 {
     xma_logmsg(XMA_DEBUG_LOG, XMA_SCALER_MOD, "%s()\n", __func__);
-    return session->scaler_plugin->recv_frame_list(session,
-                                                   frame_list);
+    int32_t rc = session->scaler_plugin->recv_frame_list(session,
+                                                         frame_list);
+    if (rc == XMA_SUCCESS)
+    {
+        uint64_t pixels = 0;
+        for (int32_t i = 0; i < session->props.num_outputs; i++)
+            pixels += (uint64_t)frame_list[i]->frame_props.width *
+                      frame_list[i]->frame_props.height;
+        xma_stats_output((XmaStatsRegion*)session->base.stats, pixels, 0);
+    }
+    return rc;
 }
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2019, Xilinx Inc - All rights reserved
+ * Xilinx SDAccel Media Accelerator API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <mutex>
+#include "app/xmalogger.h"
+#include "lib/xmastats.h"
+
+#define XMA_STATS_MOD "xmastats"
+#define XMA_STATS_MAX_FILES 256
+
+// Files of open sessions, removed when the session closes or when the
+// process exits without closing it.  The paths live in preallocated
+// slots so the signal handler can unlink them without allocating or
+// locking; a slot's path is valid while in_use is set.
+typedef struct XmaStatsFile
+{
+    XmaStatsRegion *stats;
+    int32_t         in_use;
+    char            path[512];
+} XmaStatsFile;
+
+static std::mutex g_stats_files_mutex;
+static XmaStatsFile g_stats_files[XMA_STATS_MAX_FILES];
+
+static uint64_t
+xma_stats_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+XmaStatsRegion*
+xma_stats_open(const char *prefix,
+               const char *vendor,
+               int32_t     session_type,
+               int32_t     dev_index,
+               int32_t     cu_index,
+               int32_t     channel_id,
+               int32_t     session_id)
+{
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s-%s-%d-%d-%d-%d-%d", XMA_STATS_PATH,
+             prefix, vendor, dev_index, cu_index, channel_id,
+             (int32_t)getpid(), session_id);
+
+    // Build the region in a private file and rename it into place below,
+    // a file left by an earlier owner of the name is never truncated
+    // under a mapping of that file
+    char tname[512];
+    snprintf(tname, sizeof(tname), "%s/.stats-XXXXXX", XMA_STATS_PATH);
+    umask(0);
+    mkdir(XMA_STATS_PATH, 0777);
+    int fd = mkstemp(tname);
+    if (fd < 0) {
+        xma_logmsg(XMA_INFO_LOG, XMA_STATS_MOD,
+                   "statsfile %s failed to open\n", fname);
+        return NULL;
+    }
+    fchmod(fd, 0666);
+
+    // The new file is empty, growing it zero fills the region
+    if (ftruncate(fd, sizeof(XmaStatsRegion)) < 0) {
+        xma_logmsg(XMA_INFO_LOG, XMA_STATS_MOD,
+                   "statsfile %s failed to resize\n", fname);
+        close(fd);
+        unlink(tname);
+        return NULL;
+    }
+
+    void *addr = mmap(NULL, sizeof(XmaStatsRegion), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if (addr == MAP_FAILED) {
+        xma_logmsg(XMA_INFO_LOG, XMA_STATS_MOD,
+                   "statsfile %s failed to map\n", fname);
+        unlink(tname);
+        return NULL;
+    }
+
+    XmaStatsRegion *stats = (XmaStatsRegion*)addr;
+    stats->version = XMA_STATS_VERSION;
+    stats->size = sizeof(XmaStatsRegion);
+    stats->session_type = session_type;
+    stats->dev_index = dev_index;
+    stats->cu_index = cu_index;
+    stats->channel_id = channel_id;
+    stats->last_pid_in_use = getpid();
+    // Publish magic last so readers never see a partial header
+    __atomic_store_n(&stats->magic, XMA_STATS_MAGIC, __ATOMIC_RELEASE);
+
+    if (rename(tname, fname) < 0) {
+        xma_logmsg(XMA_INFO_LOG, XMA_STATS_MOD,
+                   "statsfile %s failed to rename\n", fname);
+        munmap(addr, sizeof(XmaStatsRegion));
+        unlink(tname);
+        return NULL;
+    }
+
+    std::lock_guard<std::mutex> lk(g_stats_files_mutex);
+    for (int32_t i = 0; i < XMA_STATS_MAX_FILES; i++) {
+        XmaStatsFile *file = &g_stats_files[i];
+        if (file->stats)
+            continue;
+        file->stats = stats;
+        strncpy(file->path, fname, sizeof(file->path));
+        __atomic_store_n(&file->in_use, 1, __ATOMIC_RELEASE);
+        return stats;
+    }
+
+    xma_logmsg(XMA_INFO_LOG, XMA_STATS_MOD,
+               "statsfile %s not created, too many open sessions\n", fname);
+    unlink(fname);
+    munmap(addr, sizeof(XmaStatsRegion));
+    return NULL;
+}
+
+void
+xma_stats_input(XmaStatsRegion *stats,
+                uint64_t        pixels,
+                uint64_t        bits)
+{
+    if (!stats)
+        return;
+    __atomic_store_n(&stats->last_received_input_ts, xma_stats_now(), __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->received_frame_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->received_pixel_count, pixels, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->received_bit_count, bits, __ATOMIC_RELAXED);
+}
+
+void
+xma_stats_output(XmaStatsRegion *stats,
+                 uint64_t        pixels,
+                 uint64_t        bits)
+{
+    if (!stats)
+        return;
+    __atomic_store_n(&stats->last_received_output_ts, xma_stats_now(), __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->output_frame_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->output_pixel_count, pixels, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->output_bit_count, bits, __ATOMIC_RELAXED);
+}
+
+void
+xma_stats_close(XmaStatsRegion *stats)
+{
+    if (!stats)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lk(g_stats_files_mutex);
+        for (int32_t i = 0; i < XMA_STATS_MAX_FILES; i++) {
+            XmaStatsFile *file = &g_stats_files[i];
+            if (file->stats != stats)
+                continue;
+            if (__atomic_exchange_n(&file->in_use, 0, __ATOMIC_ACQ_REL))
+                unlink(file->path);
+            file->stats = NULL;
+            break;
+        }
+    }
+    munmap(stats, sizeof(XmaStatsRegion));
+}
+
+void
+xma_stats_cleanup(void)
+{
+    // Also called from the XMA signal handler, so only async-signal-safe
+    // calls: no locking and no freeing.  Slots stay owned by their
+    // sessions, a later xma_stats_close() only releases the slot.
+    for (int32_t i = 0; i < XMA_STATS_MAX_FILES; i++) {
+        XmaStatsFile *file = &g_stats_files[i];
+        if (__atomic_exchange_n(&file->in_use, 0, __ATOMIC_ACQ_REL))
+            unlink(file->path);
+    }
+}
@@ -18,6 +18,7 @@
 #include "xrt.h"
 #include "ert.h"
 #include "lib/xmahw_lib.h"
+#include "lib/xmaframepool.h"
 //#include "lib/xmares.h"
 
 #include <cstdio>
@@ -25,6 +26,8 @@
 #include <cstring>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <mutex>
 using namespace std;
 
 #define XMAPLUGIN_MOD "xmapluginlib"
@@ -195,6 +198,59 @@ xma_plg_buffer_read(XmaSession s_handle,
     return XMA_SUCCESS;
 }
 
+// Plane allocator of device backed frame pools, arg is a copy of
+// the session owning the pool and priv the plane's XmaBufferObj
+static void*
+xma_plg_frame_pool_alloc(void *arg, size_t size, void **priv)
+{
+    XmaSession *session = (XmaSession*) arg;
+    XmaBufferObj *b_obj = new XmaBufferObj(xma_plg_buffer_alloc(*session, size, false));
+    if (!b_obj->data) {
+        xma_plg_buffer_free(*session, *b_obj);
+        delete b_obj;
+        return NULL;
+    }
+    *priv = b_obj;
+    return b_obj->data;
+}
+
+static void
+xma_plg_frame_pool_free(void *arg, void *buffer, size_t size, void *priv)
+{
+    XmaSession *session = (XmaSession*) arg;
+    XmaBufferObj *b_obj = (XmaBufferObj*) priv;
+    xma_plg_buffer_free(*session, *b_obj);
+    delete b_obj;
+}
+
+static void
+xma_plg_frame_pool_release(void *arg)
+{
+    delete (XmaSession*) arg;
+}
+
+XmaFramePool*
+xma_plg_frame_pool_create(XmaSession s_handle, XmaFrameProperties *frame_props)
+{
+    XmaFramePoolAllocator allocator;
+    allocator.alloc = xma_plg_frame_pool_alloc;
+    allocator.free = xma_plg_frame_pool_free;
+    allocator.release = xma_plg_frame_pool_release;
+    allocator.arg = new XmaSession(s_handle);
+    allocator.buffer_type = XMA_DEVICE_BUFFER_TYPE;
+
+    XmaFramePool *pool = xma_frame_pool_create_with(frame_props, &allocator);
+    if (!pool)
+        delete (XmaSession*) allocator.arg;
+    return pool;
+}
+
+XmaBufferObj*
+xma_plg_frame_buffer_obj(XmaFrame *frame, int32_t plane)
+{
+    return (XmaBufferObj*) xma_frame_pool_plane_priv(frame, plane);
+}
+
 int32_t
 xma_plg_register_prep_write(XmaSession  s_handle,
                        void         *src,
@@ -230,34 +286,35 @@ xma_plg_register_prep_write(XmaSession  s_handle,
 
 int32_t xma_plg_kernel_lock_regmap(XmaSession s_handle)
 {
+    XmaHwKernel* kernel = s_handle.hw_session.kernel_info;
+    std::lock_guard<std::mutex> lk(kernel->reg_map_mutex);
+
     /* Only acquire the lock if we don't already own it */
-    if (s_handle.hw_session.kernel_info->reg_map_locked) {
-        if (s_handle.session_id == s_handle.hw_session.kernel_info->locked_by_session_id && s_handle.session_type == s_handle.hw_session.kernel_info->locked_by_session_type) {
+    if (kernel->reg_map_locked) {
+        if (s_handle.session_id == kernel->locked_by_session_id && s_handle.session_type == kernel->locked_by_session_type) {
             return XMA_SUCCESS;
         } else {
             return XMA_ERROR;
         }
     }
-    bool expected = false;
-    bool desired = true;
-    while (!(s_handle.hw_session.kernel_info->reg_map_locked).compare_exchange_weak(expected, desired)) {
-        expected = false;
-    }
     //reg map lock acquired
-
-    s_handle.hw_session.kernel_info->locked_by_session_id = s_handle.session_id;
-    s_handle.hw_session.kernel_info->locked_by_session_type = s_handle.session_type;
+    kernel->locked_by_session_id = s_handle.session_id;
+    kernel->locked_by_session_type = s_handle.session_type;
+    kernel->reg_map_locked = true;
 
     return XMA_SUCCESS;
 }
 
 int32_t xma_plg_kernel_unlock_regmap(XmaSession s_handle)
 {
+    XmaHwKernel* kernel = s_handle.hw_session.kernel_info;
+    std::lock_guard<std::mutex> lk(kernel->reg_map_mutex);
+
     /* Only unlock if this session owns it */
-    if (s_handle.hw_session.kernel_info->reg_map_locked) {
-        if (s_handle.session_id == s_handle.hw_session.kernel_info->locked_by_session_id && s_handle.session_type == s_handle.hw_session.kernel_info->locked_by_session_type) {
-            s_handle.hw_session.kernel_info->reg_map_locked = false;
-            s_handle.hw_session.kernel_info->locked_by_session_id = -1;
+    if (kernel->reg_map_locked) {
+        if (s_handle.session_id == kernel->locked_by_session_id && s_handle.session_type == kernel->locked_by_session_type) {
+            kernel->reg_map_locked = false;
+            kernel->locked_by_session_id = -1;
 
             return XMA_SUCCESS;
         } else {
@@ -267,75 +324,149 @@ int32_t xma_plg_kernel_unlock_regmap(XmaSession s_handle)
     return XMA_SUCCESS;
 }
 
-int32_t xma_plg_execbo_avail_get(XmaSession s_handle)
+/* Completions of a session, created on first use.  Caller must hold
+ * execbo_mutex.
+ */
+static XmaHwSessionCompletions* execbo_session(XmaHwKernel* kernel, int32_t session_id,
+                                               XmaSessionType session_type, bool create)
+{
+    for (auto& sc : kernel->completed)
+    {
+        if (sc.session_id == session_id && sc.session_type == session_type)
+            return &sc;
+    }
+    if (!create)
+        return NULL;
+    kernel->completed.emplace_back();
+    XmaHwSessionCompletions& sc = kernel->completed.back();
+    sc.session_id = session_id;
+    sc.session_type = session_type;
+    sc.count = 0;
+    sc.failed_without_item = 0;
+    return &sc;
+}
+
+/* Record a finished work item for its session.  Every completion is
+ * counted, but only the id and status of the most recent
+ * MAX_COMPLETED_PER_SESSION are kept so that a session that never
+ * waits for its work items does not grow without bound.  Caller must
+ * hold execbo_mutex.
+ */
+static void execbo_complete(XmaHwKernel* kernel, const XmaHwKernelCompletion& item)
 {
-    int32_t i;
-    int32_t rc = -1;
-    bool    found = false;
-    bool expected = false;
-    bool desired = true;
+    XmaHwSessionCompletions* sc = execbo_session(kernel, item.session_id, item.session_type, true);
+    if (sc->items.size() >= MAX_COMPLETED_PER_SESSION)
+    {
+        if (sc->items.front().status != XMA_SUCCESS)
+            sc->failed_without_item++;
+        sc->items.pop_front();
+    }
+    sc->items.push_back(item);
+    sc->count++;
+}
+
+/* Pick up the oldest finished work item of a session.  Returns false if
+ * the session has none.  Caller must hold execbo_mutex.
+ */
+static bool execbo_take(XmaHwKernel* kernel, const XmaSession& s_handle,
+                        int32_t* status, int32_t* work_item_id)
+{
+    XmaHwSessionCompletions* sc =
+        execbo_session(kernel, s_handle.session_id, s_handle.session_type, false);
+    if (!sc || !sc->count)
+        return false;
 
-    for (i = 0; i < MAX_EXECBO_POOL_SIZE; i++)
+    if (sc->count > sc->items.size())
     {
+        // Completion whose id is no longer kept, report failures first
+        *status = XMA_SUCCESS;
+        if (sc->failed_without_item)
+        {
+            sc->failed_without_item--;
+            *status = XMA_ERROR;
+        }
+        if (work_item_id)
+            *work_item_id = -1;
+    }
+    else
+    {
+        *status = sc->items.front().status;
+        if (work_item_id)
+            *work_item_id = sc->items.front().work_item_id;
+        sc->items.pop_front();
+    }
+    sc->count--;
+    return true;
+}
+
+/* Move finished execBOs from the submitted list to the free stack and
+ * record their work items as completed.  Caller must hold execbo_mutex.
+ * Returns number of work items completed.
+ */
+static int32_t execbo_harvest(XmaHwKernel* kernel)
+{
+    int32_t done = 0;
+    int32_t kept = 0;
+    for (int32_t i = 0; i < kernel->execbo_submitted_count; i++)
+    {
+        int32_t bo_idx = kernel->execbo_submitted[i];
         ert_start_kernel_cmd *cu_cmd = 
-            (ert_start_kernel_cmd*)s_handle.hw_session.kernel_info->kernel_execbo_data[i];
-        if (s_handle.hw_session.kernel_info->kernel_execbo_inuse[i])
+            (ert_start_kernel_cmd*)kernel->kernel_execbo_data[bo_idx];
+        XmaHwKernelCompletion& item = kernel->execbo_work_item[bo_idx];
+        switch(cu_cmd->state)
         {
-            switch(cu_cmd->state)
-            {
-                case ERT_CMD_STATE_NEW:
-                case ERT_CMD_STATE_QUEUED:
-                case ERT_CMD_STATE_RUNNING:
-                    continue;
+            case ERT_CMD_STATE_COMPLETED:
+                item.status = XMA_SUCCESS;
                 break;
-                case ERT_CMD_STATE_COMPLETED:
-                    found = true;
-                    expected = false;
-                    desired = true;
-                    while (!(s_handle.hw_session.kernel_info->kernel_complete_locked).compare_exchange_weak(expected, desired)) {
-                        expected = false;
-                    }
-                    //kernel completion lock acquired
-
-                    // Update count of completed work items
-                    s_handle.hw_session.kernel_info->kernel_complete_count++;
-
-                    //Release completion lock
-                    s_handle.hw_session.kernel_info->kernel_complete_locked = false;
+            case ERT_CMD_STATE_ERROR:
+            case ERT_CMD_STATE_ABORT:
+                xma_logmsg(XMA_ERROR_LOG, XMAPLUGIN_MOD,
+                           "Work item %d failed\n", item.work_item_id);
+                item.status = XMA_ERROR;
                 break;
-                case ERT_CMD_STATE_ERROR:
-                case ERT_CMD_STATE_ABORT:
-                    xma_logmsg(XMA_ERROR_LOG, XMAPLUGIN_MOD,
-                               "Could not find free execBO cmd buffer\n");
-                break;
-            }
+            default:
+                // Still queued or running, keep in submission order
+                kernel->execbo_submitted[kept++] = bo_idx;
+                continue;
         }
-        else
-            found = true;
-
-        if (found)
-            break;
-    }
-    if (found)
-    {
-        s_handle.hw_session.kernel_info->kernel_execbo_inuse[i] = true;
-        rc = i;
+        // Nobody is left to pick up work items of a destroyed session
+        if (item.session_id != -1) {
+            execbo_complete(kernel, item);
+            done++;
+        }
+        kernel->kernel_execbo_inuse[bo_idx] = false;
+        kernel->execbo_free[kernel->execbo_free_count++] = bo_idx;
     }
+    kernel->execbo_submitted_count = kept;
+    return done;
+}
+
+int32_t xma_plg_execbo_avail_get(XmaSession s_handle)
+{
+    XmaHwKernel* kernel = s_handle.hw_session.kernel_info;
+    std::lock_guard<std::mutex> lk(kernel->execbo_mutex);
 
-    return rc;
+    if (!kernel->execbo_free_count && execbo_harvest(kernel))
+        kernel->execbo_done.notify_all();
+    if (!kernel->execbo_free_count)
+        return -1;
+
+    int32_t bo_idx = kernel->execbo_free[--kernel->execbo_free_count];
+    kernel->kernel_execbo_inuse[bo_idx] = true;
+    return bo_idx;
 }
 
 int32_t
-xma_plg_schedule_work_item(XmaSession s_handle)
+xma_plg_schedule_work_item_id(XmaSession s_handle, int32_t* work_item_id)
 {
-    uint8_t *src = (uint8_t*)s_handle.hw_session.kernel_info->reg_map;
+    XmaHwKernel* kernel = s_handle.hw_session.kernel_info;
+    uint8_t *src = (uint8_t*)kernel->reg_map;
     //size_t  size = s_handle.hw_session.kernel_info->max_offset;
     size_t  size = MAX_KERNEL_REGMAP_SIZE;//Max regmap in xmahw.h is 4KB; execBO size is 4096; Supported max regmap size is 4032 Bytes only
     int32_t bo_idx;
-    int32_t rc = XMA_SUCCESS;
     
-    if (s_handle.hw_session.kernel_info->reg_map_locked) {
-        if (s_handle.session_id != s_handle.hw_session.kernel_info->locked_by_session_id || s_handle.session_type != s_handle.hw_session.kernel_info->locked_by_session_type) {
+    if (kernel->reg_map_locked) {
+        if (s_handle.session_id != kernel->locked_by_session_id || s_handle.session_type != kernel->locked_by_session_type) {
             xma_logmsg(XMA_ERROR_LOG, XMAPLUGIN_MOD, "regamp is locked by another session\n");
             return XMA_ERROR;
         }
@@ -346,89 +477,108 @@ xma_plg_schedule_work_item(XmaSession s_handle)
 
     // Find an available execBO buffer
     bo_idx = xma_plg_execbo_avail_get(s_handle);
-    if (bo_idx == -1)
-        rc = XMA_ERROR;
-    else
-    {
-        // Setup ert_start_kernel_cmd 
-        ert_start_kernel_cmd *cu_cmd = 
-            (ert_start_kernel_cmd*)s_handle.hw_session.kernel_info->kernel_execbo_data[bo_idx];
-        cu_cmd->state = ERT_CMD_STATE_NEW;
-        cu_cmd->opcode = ERT_START_CU;
+    if (bo_idx == -1) {
+        xma_logmsg(XMA_ERROR_LOG, XMAPLUGIN_MOD, "Could not find free execBO cmd buffer\n");
+        return XMA_ERROR;
+    }
+
+    // Setup ert_start_kernel_cmd 
+    ert_start_kernel_cmd *cu_cmd = 
+        (ert_start_kernel_cmd*)kernel->kernel_execbo_data[bo_idx];
+    cu_cmd->state = ERT_CMD_STATE_NEW;
+    cu_cmd->opcode = ERT_START_CU;
+
+    // Copy reg_map into execBO buffer 
+    memcpy(cu_cmd->data, src, size);
+
+    // Set count to size in 32-bit words + 1 
+    cu_cmd->count = (size >> 2) + 1;
 
-        // Copy reg_map into execBO buffer 
-        memcpy(cu_cmd->data, src, size);
+    {
+        std::lock_guard<std::mutex> lk(kernel->execbo_mutex);
+        XmaHwKernelCompletion& item = kernel->execbo_work_item[bo_idx];
+        item.work_item_id = kernel->next_work_item_id++;
+        item.session_id = s_handle.session_id;
+        item.session_type = s_handle.session_type;
+        item.status = XMA_SUCCESS;
+        if (work_item_id)
+            *work_item_id = item.work_item_id;
 
-        // Set count to size in 32-bit words + 1 
-        cu_cmd->count = (size >> 2) + 1;
-     
         if (xclExecBuf(s_handle.hw_session.dev_handle, 
-                       s_handle.hw_session.kernel_info->kernel_execbo_handle[bo_idx]) != 0)
+                       kernel->kernel_execbo_handle[bo_idx]) != 0)
         {
             xma_logmsg(XMA_ERROR_LOG, XMAPLUGIN_MOD,
                        "Failed to submit kernel start with xclExecBuf\n");
-            rc = XMA_ERROR;
+            kernel->kernel_execbo_inuse[bo_idx] = false;
+            kernel->execbo_free[kernel->execbo_free_count++] = bo_idx;
+            return XMA_ERROR;
         }
+        kernel->execbo_submitted[kernel->execbo_submitted_count++] = bo_idx;
     }
          
-    return rc;
+    return XMA_SUCCESS;
 }
 
-int32_t xma_plg_is_work_item_done(XmaSession s_handle, int32_t timeout_ms)
+int32_t
+xma_plg_schedule_work_item(XmaSession s_handle)
 {
-    bool expected = false;
-    bool desired = true;
-    while (!(s_handle.hw_session.kernel_info->kernel_complete_locked).compare_exchange_weak(expected, desired)) {
-        expected = false;
-    }
-    //kernel completion lock acquired
+    return xma_plg_schedule_work_item_id(s_handle, NULL);
+}
 
-    int32_t current_count = s_handle.hw_session.kernel_info->kernel_complete_count;
-    int32_t count = 0;
+int32_t xma_plg_is_work_item_done_id(XmaSession s_handle, int32_t timeout_ms, int32_t* work_item_id)
+{
+    XmaHwKernel* kernel = s_handle.hw_session.kernel_info;
+    // A negative timeout is passed through to xclExecWait as is
+    bool forever = timeout_ms < 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max<int32_t>(0, timeout_ms));
+    std::unique_lock<std::mutex> lk(kernel->execbo_mutex);
 
-    // Keep track of the number of kernel completions
-    while (count == 0)
+    while (true)
     {
-        // Look for inuse commands that have completed and increment the count
-        for (int32_t i = 0; i < MAX_EXECBO_POOL_SIZE; i++)
-        {
-            if (s_handle.hw_session.kernel_info->kernel_execbo_inuse[i])
-            {
-                ert_start_kernel_cmd *cu_cmd = 
-                    (ert_start_kernel_cmd*)s_handle.hw_session.kernel_info->kernel_execbo_data[i];
-                if (cu_cmd->state == ERT_CMD_STATE_COMPLETED)
-                {
-                    // Increment completed kernel count and make BO buffer available
-                    count++;
-                    s_handle.hw_session.kernel_info->kernel_execbo_inuse[i] = false;
-                } 
-            }
-        }
+        if (execbo_harvest(kernel))
+            kernel->execbo_done.notify_all();
 
-        if (count)
-            break;
+        // Oldest finished work item of this session
+        int32_t status = XMA_SUCCESS;
+        if (execbo_take(kernel, s_handle, &status, work_item_id))
+            return status;
 
-        // Wait for a notification
-        if (xclExecWait(s_handle.hw_session.dev_handle, timeout_ms) <= 0)
+        auto now = std::chrono::steady_clock::now();
+        if (!forever && now >= deadline)
             break;
+
+        if (kernel->exec_waiting)
+        {
+            // Another session is blocked in xclExecWait for this kernel,
+            // sleep until it harvests completions
+            if (forever)
+                kernel->execbo_done.wait(lk);
+            else
+                kernel->execbo_done.wait_until(lk, deadline);
+            continue;
+        }
+
+        kernel->exec_waiting = true;
+        lk.unlock();
+        int32_t wait_ms = timeout_ms;
+        if (!forever)
+        {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+            wait_ms = std::max<int32_t>(1, remaining);
+        }
+        xclExecWait(s_handle.hw_session.dev_handle, wait_ms);
+        lk.lock();
+        kernel->exec_waiting = false;
+        // Let a sleeping session take over the xclExecWait if needed
+        kernel->execbo_done.notify_all();
     }
-    current_count += count;
-    if (current_count)
-    {
-        current_count--;
-        s_handle.hw_session.kernel_info->kernel_complete_count = current_count;
-        
-        //Release completion lock
-        s_handle.hw_session.kernel_info->kernel_complete_locked = false;
-        return XMA_SUCCESS;
-    }
-    else
-    {
-        //Release completion lock
-        s_handle.hw_session.kernel_info->kernel_complete_locked = false;
-        xma_logmsg(XMA_ERROR_LOG, XMAPLUGIN_MOD,
-                    "Could not find completed work item\n");
-        return XMA_ERROR;
-    }
+
+    xma_logmsg(XMA_ERROR_LOG, XMAPLUGIN_MOD,
+                "Could not find completed work item\n");
+    return XMA_ERROR;
+}
+
+int32_t xma_plg_is_work_item_done(XmaSession s_handle, int32_t timeout_ms)
+{
+    return xma_plg_is_work_item_done_id(s_handle, timeout_ms, NULL);
 }
-    
\ No newline at end of file
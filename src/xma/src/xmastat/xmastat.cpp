@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2019, Xilinx Inc - All rights reserved
+ * Xilinx SDAccel Media Accelerator API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+// xmastat - print statistics of XMA sessions
+//
+// Usage: xmastat [-i seconds] [statsfile ...]
+//
+// Without statsfile arguments all stats files in XMA_STATS_PATH are
+// printed.  With -i the statistics are printed every seconds until
+// interrupted.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "lib/xmastats.h"
+
+static const char*
+session_type_str(int32_t type)
+{
+    // Order of XmaSessionType
+    static const char *names[] = {"scaler", "encoder", "decoder", "filter", "kernel"};
+    if (type < 0 || type >= (int32_t)(sizeof(names) / sizeof(names[0])))
+        return "unknown";
+    return names[type];
+}
+
+// Copy the region of a stats file, false if the file is not a stats file
+static bool
+read_stats(const std::string& fname, XmaStatsRegion *stats)
+{
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    // A file being created is truncated before it is sized, touching
+    // the mapping beyond end of file would raise SIGBUS
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(XmaStatsRegion)) {
+        close(fd);
+        return false;
+    }
+
+    void *addr = mmap(NULL, sizeof(XmaStatsRegion), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+
+    const XmaStatsRegion *region = (const XmaStatsRegion*)addr;
+    bool valid = __atomic_load_n(&region->magic, __ATOMIC_ACQUIRE) == XMA_STATS_MAGIC
+        && region->version == XMA_STATS_VERSION
+        && region->size == sizeof(XmaStatsRegion);
+    if (valid)
+        memcpy(stats, region, sizeof(XmaStatsRegion));
+    munmap(addr, sizeof(XmaStatsRegion));
+    return valid;
+}
+
+static void
+print_stats(const std::string& fname, const XmaStatsRegion& stats)
+{
+    printf("%s\n", fname.c_str());
+    printf("session_type             :%s\n", session_type_str(stats.session_type));
+    printf("dev_index                :%d\n", stats.dev_index);
+    printf("cu_index                 :%d\n", stats.cu_index);
+    printf("channel_id               :%d\n", stats.channel_id);
+    printf("last_pid_in_use          :%" PRIu64 "\n", stats.last_pid_in_use);
+    printf("last_received_input_ts   :%" PRIu64 "\n", stats.last_received_input_ts);
+    printf("last_received_output_ts  :%" PRIu64 "\n", stats.last_received_output_ts);
+    printf("received_frame_count     :%" PRIu64 "\n", stats.received_frame_count);
+    printf("received_pixel_count     :%" PRIu64 "\n", stats.received_pixel_count);
+    printf("received_bit_count       :%" PRIu64 "\n", stats.received_bit_count);
+    printf("output_frame_count       :%" PRIu64 "\n", stats.output_frame_count);
+    printf("output_pixel_count       :%" PRIu64 "\n", stats.output_pixel_count);
+    printf("output_bit_count         :%" PRIu64 "\n", stats.output_bit_count);
+    printf("\n");
+}
+
+static std::vector<std::string>
+list_stats_files()
+{
+    std::vector<std::string> files;
+    DIR *dir = opendir(XMA_STATS_PATH);
+    if (!dir)
+        return files;
+    while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] != '.')
+            files.push_back(std::string(XMA_STATS_PATH) + "/" + entry->d_name);
+    }
+    closedir(dir);
+    return files;
+}
+
+static void
+usage()
+{
+    printf("usage: xmastat [-i seconds] [statsfile ...]\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned int interval = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "hi:")) != -1) {
+        switch (opt) {
+        case 'i':
+            interval = strtoul(optarg, NULL, 0);
+            break;
+        case 'h':
+            usage();
+            return 0;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    std::vector<std::string> args(argv + optind, argv + argc);
+    do {
+        auto files = args.empty() ? list_stats_files() : args;
+        for (auto& fname : files) {
+            XmaStatsRegion stats;
+            if (read_stats(fname, &stats))
+                print_stats(fname, stats);
+            else if (!args.empty())
+                fprintf(stderr, "xmastat: %s is not an XMA stats file\n", fname.c_str());
+        }
+        fflush(stdout);
+    } while (interval && sleep(interval) == 0);
+
+    return 0;
+}
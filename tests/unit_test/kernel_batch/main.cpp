@@ -0,0 +1,178 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CL/cl_ext_xilinx.h>
+#include <CL/cl.h>
+#include <fstream>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <chrono>
+
+// Compare launch rate of N clSetKernelArg + clEnqueueTask launches
+// with one xclEnqueueKernelBatch of N launches.  Each launch
+// increments one element of a buffer, so after both runs every
+// element must be 2.
+
+using data_type = int;
+
+static void
+throw_if_error(cl_int errcode, const char* msg=nullptr)
+{
+  if (!errcode)
+    return;
+  std::string err = "errcode '";
+  err.append(std::to_string(errcode)).append("'");
+  if (msg)
+    err.append(" ").append(msg);
+  throw std::runtime_error(err);
+}
+
+static void
+throw_if_error(cl_int errcode, const std::string& msg)
+{
+  throw_if_error(errcode,msg.c_str());
+}
+
+using clock_type = std::chrono::high_resolution_clock;
+
+static double
+launches_per_sec(size_t launches, clock_type::time_point start, clock_type::time_point end)
+{
+  auto usec = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+  return usec ? launches * 1000000.0 / usec : 0;
+}
+
+static void
+run_test(cl_context context, cl_command_queue queue, cl_program program, size_t launches)
+{
+  cl_int err = CL_SUCCESS;
+  cl_kernel kernel = clCreateKernel(program,"addone",&err);
+  throw_if_error(err,"failed to create kernel");
+
+  std::vector<data_type> data(launches,0);
+  cl_mem buffer = clCreateBuffer(context,CL_MEM_READ_WRITE|CL_MEM_COPY_HOST_PTR,launches*sizeof(data_type),data.data(),&err);
+  throw_if_error(err,"failed to create buffer");
+  throw_if_error(clSetKernelArg(kernel,0,sizeof(cl_mem),&buffer),"failed to set buffer arg");
+
+  // Individual launches
+  auto start = clock_type::now();
+  for (size_t idx=0; idx<launches; ++idx) {
+    int arg = static_cast<int>(idx);
+    throw_if_error(clSetKernelArg(kernel,1,sizeof(int),&arg),"failed to set idx arg");
+    throw_if_error(clEnqueueTask(queue,kernel,0,nullptr,nullptr),"failed to enqueue task");
+  }
+  throw_if_error(clFinish(queue));
+  auto end = clock_type::now();
+  std::cout << "clEnqueueTask:         " << launches_per_sec(launches,start,end) << " launches/sec\n";
+
+  // Batched launches, each launch overrides the idx argument
+  std::vector<int> idx(launches);
+  std::vector<xcl_kernel_arg> args(launches);
+  std::vector<xcl_kernel_launch> batch(launches);
+  for (size_t i=0; i<launches; ++i) {
+    idx[i] = static_cast<int>(i);
+    args[i] = {1,sizeof(int),&idx[i]};
+    batch[i] = {1,&args[i]};
+  }
+
+  start = clock_type::now();
+  cl_event event = nullptr;
+  throw_if_error(xclEnqueueKernelBatch(queue,kernel,launches,batch.data(),0,nullptr,&event),"failed to enqueue batch");
+  throw_if_error(clWaitForEvents(1,&event));
+  end = clock_type::now();
+  std::cout << "xclEnqueueKernelBatch: " << launches_per_sec(launches,start,end) << " launches/sec\n";
+  clReleaseEvent(event);
+
+  throw_if_error(clEnqueueReadBuffer(queue,buffer,CL_TRUE,0,launches*sizeof(data_type),data.data(),0,nullptr,nullptr));
+  auto bad = std::find_if(data.begin(),data.end(),[](data_type v) { return v != 2; });
+  if (bad != data.end())
+    throw std::runtime_error("bad value at index " + std::to_string(bad-data.begin()) + ": " + std::to_string(*bad));
+
+  clReleaseMemObject(buffer);
+  clReleaseKernel(kernel);
+}
+
+int
+run(int argc, char** argv)
+{
+  if (argc < 2)
+    throw std::runtime_error("usage: host.exe <xclbin> [launches]");
+
+  size_t launches = (argc > 2) ? std::stoul(argv[2]) : 1000;
+
+  // Init OCL
+  cl_int err = CL_SUCCESS;
+  cl_platform_id platform = nullptr;
+  throw_if_error(clGetPlatformIDs(1,&platform,nullptr));
+
+  cl_uint num_devices = 0;
+  throw_if_error(clGetDeviceIDs(platform,CL_DEVICE_TYPE_ACCELERATOR,0,nullptr,&num_devices));
+  throw_if_error(num_devices==0,"no devices");
+  std::vector<cl_device_id> devices(num_devices);
+  throw_if_error(clGetDeviceIDs(platform,CL_DEVICE_TYPE_ACCELERATOR,num_devices,devices.data(),nullptr));
+  cl_device_id device = devices.front();
+
+  cl_context context = clCreateContext(0,1,&device,nullptr,nullptr,&err);
+  throw_if_error(err);
+
+  // In order queue.  Batched launches still run concurrently, which
+  // is valid since each launch writes only its own buffer element
+  cl_command_queue queue = clCreateCommandQueue(context,device,0,&err);
+  throw_if_error(err,"failed to create command queue");
+
+  // Read xclbin and create program
+  std::string fnm = argv[1];
+  std::ifstream stream(fnm);
+  stream.seekg(0,stream.end);
+  size_t size = stream.tellg();
+  stream.seekg(0,stream.beg);
+  std::vector<char> xclbin(size);
+  stream.read(xclbin.data(),size);
+  const unsigned char* data = reinterpret_cast<unsigned char*>(xclbin.data());
+  cl_int status = CL_SUCCESS;
+  cl_program program = clCreateProgramWithBinary(context,1,&device,&size,&data,&status,&err);
+  throw_if_error(err,"failed to create program");
+
+  run_test(context,queue,program,launches);
+
+  clReleaseProgram(program);
+  clReleaseCommandQueue(queue);
+  clReleaseContext(context);
+  std::for_each(devices.begin(),devices.end(),[](cl_device_id d){clReleaseDevice(d);});
+
+  return 0;
+}
+
+int
+main(int argc, char* argv[])
+{
+  try {
+    run(argc,argv);
+    std::cout << "TEST SUCCESS\n";
+    return 0;
+  }
+  catch (const std::exception& ex) {
+    std::cout << "TEST FAILED: " << ex.what() << "\n";
+  }
+  catch (...) {
+    std::cout << "TEST FAILED\n";
+  }
+
+  return 1;
+}